@@ -0,0 +1,64 @@
+#include "Backend.h"
+
+using namespace std::chrono;
+
+// ============================================================================
+
+bool parsePresentMode(const std::string& name, PresentMode& mode)
+{
+  if (name == "vsync") {
+    mode = PresentMode::VSYNC;
+  } else if (name == "immediate") {
+    mode = PresentMode::IMMEDIATE;
+  } else if (name == "tearing") {
+    mode = PresentMode::TEARING;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// ============================================================================
+
+const char* getPresentModeName(PresentMode mode)
+{
+  switch (mode) {
+  case PresentMode::VSYNC:
+    return "vsync";
+  case PresentMode::IMMEDIATE:
+    return "immediate";
+  case PresentMode::TEARING:
+    return "tearing";
+  }
+  return "unknown";
+}
+
+// ============================================================================
+
+void waitFence(Fence& fence, uint64_t fenceValue, milliseconds duration)
+{
+  // only block when the GPU has not yet reached the desired value.
+  if (fence.getCompletedValue() < fenceValue) {
+    fence.wait(fenceValue, duration);
+  }
+}
+
+// ============================================================================
+
+uint64_t signalFence(CommandQueue& commandQueue, Fence& fence, uint64_t& value)
+{
+  // increment the fence value to indicate a new signal.
+  uint64_t signalValue = ++value;
+
+  // signal the fence with the incremented signal value.
+  commandQueue.signal(fence, signalValue);
+  return signalValue;
+}
+
+// ============================================================================
+
+void flush(CommandQueue& commandQueue, Fence& fence, uint64_t& value)
+{
+  auto signalValue = signalFence(commandQueue, fence, value);
+  waitFence(fence, signalValue, milliseconds::max());
+}
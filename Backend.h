@@ -0,0 +1,135 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// ============================================================================
+// A thin abstraction over the parts of the graphics API which drive the frame
+// loop. The DirectX 12 implementation lives in DXBackend and a CPU-only null
+// implementation lives in NullBackend so the frame loop can also be executed
+// and measured on machines without a GPU.
+// ============================================================================
+
+// the types of command lists and the queues which execute them.
+enum class CommandListType
+{
+  DIRECT,
+  COMPUTE,
+  COPY
+};
+
+// the ways of presenting the swap chain buffers.
+enum class PresentMode
+{
+  // wait for the vertical blank, so the frame rate is limited by the refresh rate and the frames never tear.
+  VSYNC,
+  // present without waiting. in a window the compositor still shows the latest frame at its next vertical blank.
+  IMMEDIATE,
+  // present without waiting and let the display switch the buffer in the middle of a refresh. requires a swap chain
+  // which was created with the tearing support and behaves like IMMEDIATE otherwise.
+  TEARING
+};
+
+// the timing of the vertical blanks of the display that the swap chain presents to.
+struct VblankTiming
+{
+  // the time of a recent vertical blank.
+  std::chrono::steady_clock::time_point time;
+  // the time between two vertical blanks.
+  std::chrono::microseconds interval;
+};
+
+// ============================================================================
+
+class Fence
+{
+public:
+  virtual ~Fence() {}
+
+  // get the most recent value that the GPU has reached.
+  virtual uint64_t getCompletedValue() const = 0;
+
+  // wait until the fence has reached the given value or the duration has elapsed.
+  virtual bool wait(uint64_t value, std::chrono::milliseconds duration) = 0;
+};
+
+// ============================================================================
+
+class CommandList
+{
+public:
+  virtual ~CommandList() {}
+};
+
+// ============================================================================
+
+class CommandQueue
+{
+public:
+  virtual ~CommandQueue() {}
+
+  // submit the given command lists for the execution.
+  virtual void executeCommandLists(unsigned int count, CommandList* const* commandLists) = 0;
+
+  // set the fence to the given value after all previously submitted work has completed.
+  virtual void signal(Fence& fence, uint64_t value) = 0;
+
+  // make the queue wait on the GPU until the fence has reached the given value.
+  virtual void wait(Fence& fence, uint64_t value) = 0;
+};
+
+// ============================================================================
+
+class SwapChain
+{
+public:
+  virtual ~SwapChain() {}
+
+  // get the amount of buffers in the swap chain.
+  virtual unsigned int getBufferCount() const = 0;
+
+  // get the index of the currently active back buffer.
+  virtual unsigned int getCurrentBackBufferIndex() const = 0;
+
+  // wait until the swap chain can queue another frame. swap chains without a frame latency limit return immediately.
+  virtual void waitForNextFrame() = 0;
+
+  // present the current back buffer in the given mode.
+  virtual void present(PresentMode mode) = 0;
+
+  // get the timing of the vertical blanks. returns false if the swap chain does not know it (yet).
+  virtual bool getVblankTiming(VblankTiming& timing) = 0;
+};
+
+// ============================================================================
+
+class Device
+{
+public:
+  virtual ~Device() {}
+
+  // create a new command queue which executes the given type of command lists.
+  virtual std::unique_ptr<CommandQueue> createCommandQueue(CommandListType type) = 0;
+
+  // create a new fence with the initial value of zero.
+  virtual std::unique_ptr<Fence> createFence() = 0;
+};
+
+// ============================================================================
+
+// get the present mode with the given name (vsync, immediate or tearing). returns false if the name is unknown.
+bool parsePresentMode(const std::string& name, PresentMode& mode);
+
+// get the name of the present mode.
+const char* getPresentModeName(PresentMode mode);
+
+// wait until the fence has reached the given value or the duration has elapsed.
+void waitFence(Fence& fence, uint64_t fenceValue, std::chrono::milliseconds duration);
+
+// increment the fence value and signal the fence with it from the queue.
+uint64_t signalFence(CommandQueue& commandQueue, Fence& fence, uint64_t& value);
+
+// wait until all work submitted into the queue has been completed.
+void flush(CommandQueue& commandQueue, Fence& fence, uint64_t& value);
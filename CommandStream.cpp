@@ -0,0 +1,755 @@
+#include "CommandStream.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+using namespace std::chrono;
+
+// ============================================================================
+
+// the maximum size of a variable length 64-bit integer.
+static const size_t MAX_VARINT_SIZE = 10;
+
+// the maximum size of a single encoded barrier (resource, states and split).
+static const size_t MAX_BARRIER_SIZE = MAX_VARINT_SIZE + 3 * 5;
+
+// the amount of barriers of a command that are decoded on the stack. larger batches are decoded into the heap.
+static const size_t MAX_LOCAL_BARRIERS = 64;
+
+// the names of the command types in the order of the enumeration.
+static const char* COMMAND_TYPE_NAMES[] = {
+  "SetGraphicsRootSignature",
+  "SetPipelineState",
+  "RSSetViewports",
+  "RSSetScissorRects",
+  "ResourceBarrier",
+  "OMSetRenderTargets",
+  "ClearRenderTargetView",
+  "IASetPrimitiveTopology",
+  "IASetVertexBuffers",
+  "IASetIndexBuffer",
+  "DrawInstanced",
+  "DrawIndexedInstanced",
+  "EndQuery",
+  "ResolveQueryData",
+  "SetDescriptorHeaps",
+  "SetGraphicsRootDescriptorTable"
+};
+
+// ============================================================================
+
+// write an unsigned integer with seven bits per byte where the highest bit marks the following bytes.
+static uint8_t* writeVarint(uint8_t* position, uint64_t value)
+{
+  while (value >= 0x80) {
+    *position++ = static_cast<uint8_t>(value | 0x80);
+    value >>= 7;
+  }
+  *position++ = static_cast<uint8_t>(value);
+  return position;
+}
+
+// ============================================================================
+
+// write the difference to the last value and update the last value. small differences in both directions take a single byte.
+static uint8_t* writeDelta(uint8_t* position, uint64_t& last, uint64_t value)
+{
+  auto delta = value - last;
+  last = value;
+  // interleave the positive and negative differences (zigzag) so that their magnitude decides the size.
+  return writeVarint(position, (delta << 1) ^ ((delta >> 63) != 0 ? ~0ull : 0ull));
+}
+
+// ============================================================================
+
+// write the difference of a 32-bit value to the last value and update the last value.
+static uint8_t* writeDelta32(uint8_t* position, uint32_t& last, uint32_t value)
+{
+  auto delta = value - last;
+  last = value;
+  return writeVarint(position, (delta << 1) ^ ((delta >> 31) != 0 ? ~0u : 0u));
+}
+
+// ============================================================================
+
+// write the bits of the float XORed with the bits of the last float and update the last bits.
+static uint8_t* writeFloat(uint8_t* position, uint32_t& last, float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  auto result = writeVarint(position, bits ^ last);
+  last = bits;
+  return result;
+}
+
+// ============================================================================
+
+// a position in a stream which is checked against the end of the stream.
+struct StreamReader
+{
+  const uint8_t* position;
+  const uint8_t* end;
+};
+
+// ============================================================================
+
+static uint64_t readVarint(StreamReader& reader)
+{
+  uint64_t value = 0;
+  for (auto shift = 0u; shift < 64; shift += 7) {
+    if (reader.position == reader.end) {
+      throw new std::runtime_error("Command stream is truncated");
+    }
+    auto byte = *reader.position++;
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      return value;
+    }
+  }
+  throw new std::runtime_error("Command stream contains an invalid integer");
+}
+
+// ============================================================================
+
+static uint64_t readDelta(StreamReader& reader, uint64_t& last)
+{
+  auto zigzag = readVarint(reader);
+  last += (zigzag >> 1) ^ ((zigzag & 1) != 0 ? ~0ull : 0ull);
+  return last;
+}
+
+// ============================================================================
+
+static uint32_t readDelta32(StreamReader& reader, uint32_t& last)
+{
+  auto zigzag = static_cast<uint32_t>(readVarint(reader));
+  last += (zigzag >> 1) ^ ((zigzag & 1) != 0 ? ~0u : 0u);
+  return last;
+}
+
+// ============================================================================
+
+static float readFloat(StreamReader& reader, uint32_t& last)
+{
+  last ^= static_cast<uint32_t>(readVarint(reader));
+  float value;
+  memcpy(&value, &last, sizeof(value));
+  return value;
+}
+
+// ============================================================================
+
+const char* getCommandTypeName(CommandType type)
+{
+  return COMMAND_TYPE_NAMES[static_cast<size_t>(type)];
+}
+
+// ============================================================================
+
+void CommandSink::resourceBarrier(const BarrierList& barriers)
+{
+  if (!barriers.empty()) {
+    resourceBarrier(static_cast<unsigned int>(barriers.size()), barriers.data());
+  }
+}
+
+// ============================================================================
+
+CommandRecorder::CommandRecorder() : mSize(0), mCommandCount(0), mState()
+{
+}
+
+// ============================================================================
+
+void CommandRecorder::reset()
+{
+  mSize = 0;
+  mCommandCount = 0;
+  mState = CommandStreamState();
+}
+
+// ============================================================================
+
+const uint8_t* CommandRecorder::getData() const
+{
+  return mData.data();
+}
+
+// ============================================================================
+
+size_t CommandRecorder::getSize() const
+{
+  return mSize;
+}
+
+// ============================================================================
+
+unsigned int CommandRecorder::getCommandCount() const
+{
+  return mCommandCount;
+}
+
+// ============================================================================
+
+void CommandRecorder::setRootSignature(const void* rootSignature)
+{
+  auto position = begin(CommandType::SET_ROOT_SIGNATURE, MAX_VARINT_SIZE);
+  position = writeDelta(position, mState.rootSignature, reinterpret_cast<uintptr_t>(rootSignature));
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::setPipelineState(const void* pipelineState)
+{
+  auto position = begin(CommandType::SET_PIPELINE_STATE, MAX_VARINT_SIZE);
+  position = writeDelta(position, mState.pipelineState, reinterpret_cast<uintptr_t>(pipelineState));
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::setViewport(const CommandViewport& viewport)
+{
+  auto position = begin(CommandType::SET_VIEWPORT, 6 * 5);
+  position = writeFloat(position, mState.viewport[0], viewport.topLeftX);
+  position = writeFloat(position, mState.viewport[1], viewport.topLeftY);
+  position = writeFloat(position, mState.viewport[2], viewport.width);
+  position = writeFloat(position, mState.viewport[3], viewport.height);
+  position = writeFloat(position, mState.viewport[4], viewport.minDepth);
+  position = writeFloat(position, mState.viewport[5], viewport.maxDepth);
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::setScissorRect(const CommandRect& rect)
+{
+  auto position = begin(CommandType::SET_SCISSOR_RECT, 4 * 5);
+  position = writeDelta32(position, mState.rect[0], static_cast<uint32_t>(rect.left));
+  position = writeDelta32(position, mState.rect[1], static_cast<uint32_t>(rect.top));
+  position = writeDelta32(position, mState.rect[2], static_cast<uint32_t>(rect.right));
+  position = writeDelta32(position, mState.rect[3], static_cast<uint32_t>(rect.bottom));
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::resourceBarrier(unsigned int count, const ResourceBarrier* barriers)
+{
+  auto position = begin(CommandType::RESOURCE_BARRIER, 5 + count * MAX_BARRIER_SIZE);
+  position = writeVarint(position, count);
+  for (auto i = 0u; i < count; i++) {
+    position = writeDelta(position, mState.resource, reinterpret_cast<uintptr_t>(barriers[i].resource));
+    position = writeVarint(position, barriers[i].before);
+    position = writeVarint(position, barriers[i].after);
+    position = writeVarint(position, static_cast<uint64_t>(barriers[i].split));
+  }
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::setRenderTarget(uint64_t descriptor)
+{
+  auto position = begin(CommandType::SET_RENDER_TARGET, MAX_VARINT_SIZE);
+  position = writeDelta(position, mState.descriptor, descriptor);
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::clearRenderTarget(uint64_t descriptor, const float color[4])
+{
+  auto position = begin(CommandType::CLEAR_RENDER_TARGET, MAX_VARINT_SIZE + 4 * 5);
+  position = writeDelta(position, mState.descriptor, descriptor);
+  for (auto i = 0; i < 4; i++) {
+    position = writeFloat(position, mState.color[i], color[i]);
+  }
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::setPrimitiveTopology(PrimitiveTopology topology)
+{
+  auto position = begin(CommandType::SET_PRIMITIVE_TOPOLOGY, 5);
+  position = writeVarint(position, topology);
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::setVertexBuffer(unsigned int slot, const CommandVertexBufferView& view)
+{
+  auto position = begin(CommandType::SET_VERTEX_BUFFER, 3 * 5 + MAX_VARINT_SIZE);
+  position = writeVarint(position, slot);
+  position = writeDelta(position, mState.address, view.address);
+  position = writeVarint(position, view.size);
+  position = writeVarint(position, view.stride);
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::setIndexBuffer(const CommandIndexBufferView& view)
+{
+  auto position = begin(CommandType::SET_INDEX_BUFFER, 2 * 5 + MAX_VARINT_SIZE);
+  position = writeDelta(position, mState.address, view.address);
+  position = writeVarint(position, view.size);
+  position = writeVarint(position, view.indexSize);
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance)
+{
+  auto position = begin(CommandType::DRAW_INSTANCED, 4 * 5);
+  position = writeDelta32(position, mState.draw[0], vertexCountPerInstance);
+  position = writeDelta32(position, mState.draw[1], instanceCount);
+  position = writeDelta32(position, mState.draw[2], startVertex);
+  position = writeDelta32(position, mState.draw[3], startInstance);
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+  auto position = begin(CommandType::DRAW_INDEXED_INSTANCED, 5 * 5);
+  position = writeDelta32(position, mState.drawIndexed[0], indexCountPerInstance);
+  position = writeDelta32(position, mState.drawIndexed[1], instanceCount);
+  position = writeDelta32(position, mState.drawIndexed[2], startIndex);
+  position = writeDelta32(position, mState.drawIndexed[3], static_cast<uint32_t>(baseVertex));
+  position = writeDelta32(position, mState.drawIndexed[4], startInstance);
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::endTimestampQuery(const void* queryHeap, uint32_t index)
+{
+  auto position = begin(CommandType::END_TIMESTAMP_QUERY, MAX_VARINT_SIZE + 5);
+  position = writeDelta(position, mState.queryHeap, reinterpret_cast<uintptr_t>(queryHeap));
+  position = writeDelta32(position, mState.query, index);
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::resolveTimestampQueries(const void* queryHeap, uint32_t firstIndex, uint32_t count, const void* destination, uint64_t destinationOffset)
+{
+  auto position = begin(CommandType::RESOLVE_TIMESTAMP_QUERIES, 3 * MAX_VARINT_SIZE + 2 * 5);
+  position = writeDelta(position, mState.queryHeap, reinterpret_cast<uintptr_t>(queryHeap));
+  position = writeDelta32(position, mState.query, firstIndex);
+  position = writeVarint(position, count);
+  position = writeDelta(position, mState.resource, reinterpret_cast<uintptr_t>(destination));
+  position = writeVarint(position, destinationOffset);
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::setDescriptorHeap(const void* descriptorHeap)
+{
+  auto position = begin(CommandType::SET_DESCRIPTOR_HEAP, MAX_VARINT_SIZE);
+  position = writeDelta(position, mState.descriptorHeap, reinterpret_cast<uintptr_t>(descriptorHeap));
+  end(position);
+}
+
+// ============================================================================
+
+void CommandRecorder::setRootDescriptorTable(uint32_t parameter, uint64_t descriptor)
+{
+  auto position = begin(CommandType::SET_ROOT_DESCRIPTOR_TABLE, 5 + MAX_VARINT_SIZE);
+  position = writeVarint(position, parameter);
+  position = writeDelta(position, mState.gpuDescriptor, descriptor);
+  end(position);
+}
+
+// ============================================================================
+
+uint8_t* CommandRecorder::begin(CommandType type, size_t maxSize)
+{
+  // grow the buffer geometrically, so the amortized cost stays constant and a reused recorder never grows.
+  if (mSize + 1 + maxSize > mData.size()) {
+    mData.resize(std::max(mData.size() * 2, mSize + 1 + maxSize));
+  }
+  auto position = &mData[mSize];
+  *position++ = static_cast<uint8_t>(type);
+  return position;
+}
+
+// ============================================================================
+
+void CommandRecorder::end(uint8_t* position)
+{
+  mSize = static_cast<size_t>(position - mData.data());
+  mCommandCount++;
+}
+
+// ============================================================================
+
+// a decoded command with the arguments of its type.
+struct DecodedCommand
+{
+  CommandType type;
+  const void* object;
+  CommandViewport viewport;
+  CommandRect rect;
+  unsigned int barrierCount;
+  const ResourceBarrier* barriers;
+  uint64_t descriptor;
+  float color[4];
+  PrimitiveTopology topology;
+  unsigned int slot;
+  CommandVertexBufferView vertexBufferView;
+  CommandIndexBufferView indexBufferView;
+  uint32_t arguments[5];
+  const void* destination;
+  uint64_t destinationOffset;
+};
+
+// ============================================================================
+
+// decode the next command of the stream. the barriers are decoded into the local array when they fit into it and into the vector otherwise.
+static void decodeCommand(StreamReader& reader, CommandStreamState& state, DecodedCommand& command, ResourceBarrier* localBarriers, std::vector<ResourceBarrier>& heapBarriers)
+{
+  auto type = *reader.position++;
+  if (type >= static_cast<uint8_t>(CommandType::COUNT)) {
+    throw new std::runtime_error("Command stream contains an unknown command");
+  }
+  command.type = static_cast<CommandType>(type);
+  switch (command.type) {
+    case CommandType::SET_ROOT_SIGNATURE:
+      command.object = reinterpret_cast<const void*>(static_cast<uintptr_t>(readDelta(reader, state.rootSignature)));
+      break;
+    case CommandType::SET_PIPELINE_STATE:
+      command.object = reinterpret_cast<const void*>(static_cast<uintptr_t>(readDelta(reader, state.pipelineState)));
+      break;
+    case CommandType::SET_VIEWPORT:
+      command.viewport.topLeftX = readFloat(reader, state.viewport[0]);
+      command.viewport.topLeftY = readFloat(reader, state.viewport[1]);
+      command.viewport.width = readFloat(reader, state.viewport[2]);
+      command.viewport.height = readFloat(reader, state.viewport[3]);
+      command.viewport.minDepth = readFloat(reader, state.viewport[4]);
+      command.viewport.maxDepth = readFloat(reader, state.viewport[5]);
+      break;
+    case CommandType::SET_SCISSOR_RECT:
+      command.rect.left = static_cast<int32_t>(readDelta32(reader, state.rect[0]));
+      command.rect.top = static_cast<int32_t>(readDelta32(reader, state.rect[1]));
+      command.rect.right = static_cast<int32_t>(readDelta32(reader, state.rect[2]));
+      command.rect.bottom = static_cast<int32_t>(readDelta32(reader, state.rect[3]));
+      break;
+    case CommandType::RESOURCE_BARRIER: {
+      // every barrier takes at least four bytes, which bounds the count of a corrupted stream.
+      auto count = readVarint(reader);
+      if (count > static_cast<uint64_t>(reader.end - reader.position) / 4) {
+        throw new std::runtime_error("Command stream is truncated");
+      }
+      auto barriers = localBarriers;
+      if (count > MAX_LOCAL_BARRIERS) {
+        heapBarriers.resize(static_cast<size_t>(count));
+        barriers = heapBarriers.data();
+      }
+      for (auto i = 0u; i < count; i++) {
+        auto& barrier = barriers[i];
+        barrier.resource = reinterpret_cast<const void*>(static_cast<uintptr_t>(readDelta(reader, state.resource)));
+        barrier.before = static_cast<ResourceStates>(readVarint(reader));
+        barrier.after = static_cast<ResourceStates>(readVarint(reader));
+        barrier.split = static_cast<BarrierSplit>(readVarint(reader));
+      }
+      command.barrierCount = static_cast<unsigned int>(count);
+      command.barriers = barriers;
+      break;
+    }
+    case CommandType::SET_RENDER_TARGET:
+      command.descriptor = readDelta(reader, state.descriptor);
+      break;
+    case CommandType::CLEAR_RENDER_TARGET:
+      command.descriptor = readDelta(reader, state.descriptor);
+      for (auto i = 0; i < 4; i++) {
+        command.color[i] = readFloat(reader, state.color[i]);
+      }
+      break;
+    case CommandType::SET_PRIMITIVE_TOPOLOGY:
+      command.topology = static_cast<PrimitiveTopology>(readVarint(reader));
+      break;
+    case CommandType::SET_VERTEX_BUFFER:
+      command.slot = static_cast<unsigned int>(readVarint(reader));
+      command.vertexBufferView.address = readDelta(reader, state.address);
+      command.vertexBufferView.size = static_cast<uint32_t>(readVarint(reader));
+      command.vertexBufferView.stride = static_cast<uint32_t>(readVarint(reader));
+      break;
+    case CommandType::SET_INDEX_BUFFER:
+      command.indexBufferView.address = readDelta(reader, state.address);
+      command.indexBufferView.size = static_cast<uint32_t>(readVarint(reader));
+      command.indexBufferView.indexSize = static_cast<uint32_t>(readVarint(reader));
+      break;
+    case CommandType::DRAW_INSTANCED:
+      for (auto i = 0; i < 4; i++) {
+        command.arguments[i] = readDelta32(reader, state.draw[i]);
+      }
+      break;
+    case CommandType::DRAW_INDEXED_INSTANCED:
+      for (auto i = 0; i < 5; i++) {
+        command.arguments[i] = readDelta32(reader, state.drawIndexed[i]);
+      }
+      break;
+    case CommandType::END_TIMESTAMP_QUERY:
+      command.object = reinterpret_cast<const void*>(static_cast<uintptr_t>(readDelta(reader, state.queryHeap)));
+      command.arguments[0] = readDelta32(reader, state.query);
+      break;
+    case CommandType::RESOLVE_TIMESTAMP_QUERIES:
+      command.object = reinterpret_cast<const void*>(static_cast<uintptr_t>(readDelta(reader, state.queryHeap)));
+      command.arguments[0] = readDelta32(reader, state.query);
+      command.arguments[1] = static_cast<uint32_t>(readVarint(reader));
+      command.destination = reinterpret_cast<const void*>(static_cast<uintptr_t>(readDelta(reader, state.resource)));
+      command.destinationOffset = readVarint(reader);
+      break;
+    case CommandType::SET_DESCRIPTOR_HEAP:
+      command.object = reinterpret_cast<const void*>(static_cast<uintptr_t>(readDelta(reader, state.descriptorHeap)));
+      break;
+    case CommandType::SET_ROOT_DESCRIPTOR_TABLE:
+      command.slot = static_cast<unsigned int>(readVarint(reader));
+      command.descriptor = readDelta(reader, state.gpuDescriptor);
+      break;
+    case CommandType::COUNT:
+      break;
+  }
+}
+
+// ============================================================================
+
+// issue the decoded command into the sink.
+static void issueCommand(const DecodedCommand& command, CommandSink& sink)
+{
+  auto& arguments = command.arguments;
+  switch (command.type) {
+    case CommandType::SET_ROOT_SIGNATURE:
+      sink.setRootSignature(command.object);
+      break;
+    case CommandType::SET_PIPELINE_STATE:
+      sink.setPipelineState(command.object);
+      break;
+    case CommandType::SET_VIEWPORT:
+      sink.setViewport(command.viewport);
+      break;
+    case CommandType::SET_SCISSOR_RECT:
+      sink.setScissorRect(command.rect);
+      break;
+    case CommandType::RESOURCE_BARRIER:
+      sink.resourceBarrier(command.barrierCount, command.barriers);
+      break;
+    case CommandType::SET_RENDER_TARGET:
+      sink.setRenderTarget(command.descriptor);
+      break;
+    case CommandType::CLEAR_RENDER_TARGET:
+      sink.clearRenderTarget(command.descriptor, command.color);
+      break;
+    case CommandType::SET_PRIMITIVE_TOPOLOGY:
+      sink.setPrimitiveTopology(command.topology);
+      break;
+    case CommandType::SET_VERTEX_BUFFER:
+      sink.setVertexBuffer(command.slot, command.vertexBufferView);
+      break;
+    case CommandType::SET_INDEX_BUFFER:
+      sink.setIndexBuffer(command.indexBufferView);
+      break;
+    case CommandType::DRAW_INSTANCED:
+      sink.drawInstanced(arguments[0], arguments[1], arguments[2], arguments[3]);
+      break;
+    case CommandType::DRAW_INDEXED_INSTANCED:
+      sink.drawIndexedInstanced(arguments[0], arguments[1], arguments[2], static_cast<int32_t>(arguments[3]), arguments[4]);
+      break;
+    case CommandType::END_TIMESTAMP_QUERY:
+      sink.endTimestampQuery(command.object, arguments[0]);
+      break;
+    case CommandType::RESOLVE_TIMESTAMP_QUERIES:
+      sink.resolveTimestampQueries(command.object, arguments[0], arguments[1], command.destination, command.destinationOffset);
+      break;
+    case CommandType::SET_DESCRIPTOR_HEAP:
+      sink.setDescriptorHeap(command.object);
+      break;
+    case CommandType::SET_ROOT_DESCRIPTOR_TABLE:
+      sink.setRootDescriptorTable(command.slot, command.descriptor);
+      break;
+    case CommandType::COUNT:
+      break;
+  }
+}
+
+// ============================================================================
+
+void replayCommandStream(const uint8_t* data, size_t size, CommandSink& sink, CommandReplayStats* stats)
+{
+  StreamReader reader = { data, data + size };
+  CommandStreamState state = {};
+  DecodedCommand command = {};
+  ResourceBarrier localBarriers[MAX_LOCAL_BARRIERS];
+  std::vector<ResourceBarrier> heapBarriers;
+  while (reader.position != reader.end) {
+    decodeCommand(reader, state, command, localBarriers, heapBarriers);
+
+    // only the sink call is timed, so the statistics show the cost of the backend without the decoding.
+    if (stats != nullptr) {
+      auto start = steady_clock::now();
+      issueCommand(command, sink);
+      auto index = static_cast<size_t>(command.type);
+      stats->times[index] += duration_cast<nanoseconds>(steady_clock::now() - start);
+      stats->counts[index]++;
+    } else {
+      issueCommand(command, sink);
+    }
+  }
+}
+
+// ============================================================================
+
+void mergeCommandReplayStats(CommandReplayStats& stats, const CommandReplayStats& other)
+{
+  for (auto i = 0u; i < static_cast<size_t>(CommandType::COUNT); i++) {
+    stats.counts[i] += other.counts[i];
+    stats.times[i] += other.times[i];
+  }
+}
+
+// ============================================================================
+
+void printCommandReplayStats(const CommandReplayStats& stats, std::ostream& out)
+{
+  auto flags = out.flags();
+  out << std::left << std::setw(26) << "command" << std::right << std::setw(10) << "count" << std::setw(12) << "total us" << std::setw(10) << "avg ns" << std::endl;
+  for (auto i = 0u; i < static_cast<size_t>(CommandType::COUNT); i++) {
+    if (stats.counts[i] == 0) {
+      continue;
+    }
+    out << std::left << std::setw(26) << COMMAND_TYPE_NAMES[i] << std::right << std::setw(10) << stats.counts[i]
+      << std::setw(12) << stats.times[i].count() / 1000 << std::setw(10) << stats.times[i].count() / stats.counts[i] << std::endl;
+  }
+  out.flags(flags);
+}
+
+// ============================================================================
+
+void CommandCapture::clear()
+{
+  mData.clear();
+  mEnds.clear();
+}
+
+// ============================================================================
+
+void CommandCapture::addStream(const CommandRecorder& recorder)
+{
+  mData.insert(mData.end(), recorder.getData(), recorder.getData() + recorder.getSize());
+  mEnds.push_back(mData.size());
+}
+
+// ============================================================================
+
+unsigned int CommandCapture::getStreamCount() const
+{
+  return static_cast<unsigned int>(mEnds.size());
+}
+
+// ============================================================================
+
+const uint8_t* CommandCapture::getStreamData(unsigned int index) const
+{
+  return mData.data() + (index > 0 ? mEnds[index - 1] : 0);
+}
+
+// ============================================================================
+
+size_t CommandCapture::getStreamSize(unsigned int index) const
+{
+  return mEnds[index] - (index > 0 ? mEnds[index - 1] : 0);
+}
+
+// ============================================================================
+
+size_t CommandCapture::getSize() const
+{
+  return mData.size();
+}
+
+// ============================================================================
+
+void CommandCapture::replay(CommandSink& sink, CommandReplayStats* stats) const
+{
+  for (auto i = 0u; i < getStreamCount(); i++) {
+    replayCommandStream(getStreamData(i), getStreamSize(i), sink, stats);
+  }
+}
+
+// ============================================================================
+
+void CommandCapture::write(const std::string& path) const
+{
+  std::ofstream stream(path, std::ios::binary);
+  if (!stream) {
+    std::cout << "std::ofstream: " << path << std::endl;
+    throw new std::runtime_error("Failed to open the command capture file");
+  }
+
+  // the capture is written in the native (little-endian) layout like the other caches.
+  uint32_t header[] = { MAGIC, VERSION, getStreamCount() };
+  stream.write(reinterpret_cast<const char*>(header), sizeof(header));
+  for (auto end : mEnds) {
+    auto value = static_cast<uint64_t>(end);
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+  stream.write(reinterpret_cast<const char*>(mData.data()), mData.size());
+  if (!stream) {
+    throw new std::runtime_error("Failed to write the command capture file");
+  }
+}
+
+// ============================================================================
+
+bool CommandCapture::read(const std::string& path)
+{
+  clear();
+  std::ifstream stream(path, std::ios::binary);
+  uint32_t header[3];
+  if (!stream || !stream.read(reinterpret_cast<char*>(header), sizeof(header))) {
+    return false;
+  }
+  if (header[0] != MAGIC || header[1] != VERSION) {
+    return false;
+  }
+
+  // reject the stream ends which are not ascending before reading the data.
+  uint64_t size = 0;
+  for (auto i = 0u; i < header[2]; i++) {
+    uint64_t end;
+    if (!stream.read(reinterpret_cast<char*>(&end), sizeof(end)) || end < size) {
+      clear();
+      return false;
+    }
+    mEnds.push_back(static_cast<size_t>(end));
+    size = end;
+  }
+
+  // reject the data which does not fit into the rest of the file before allocating it, so a corrupt end cannot
+  // request an arbitrary amount of memory.
+  auto position = stream.tellg();
+  stream.seekg(0, std::ios::end);
+  auto fileSize = stream.tellg();
+  if (position < 0 || fileSize < position || size > static_cast<uint64_t>(fileSize - position) || !stream.seekg(position)) {
+    clear();
+    return false;
+  }
+  mData.resize(static_cast<size_t>(size));
+  if (size > 0 && !stream.read(reinterpret_cast<char*>(mData.data()), size)) {
+    clear();
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,259 @@
+#pragma once
+
+#include "ResourceStateTracker.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// ============================================================================
+
+// the primitive topology of the draws. the values match the D3D_PRIMITIVE_TOPOLOGY.
+typedef uint32_t PrimitiveTopology;
+
+static const PrimitiveTopology PRIMITIVE_TOPOLOGY_TRIANGLE_LIST = 4;
+
+// the viewport in pixels with its depth range (see D3D12_VIEWPORT).
+struct CommandViewport
+{
+  float topLeftX;
+  float topLeftY;
+  float width;
+  float height;
+  float minDepth;
+  float maxDepth;
+};
+
+// the scissor rectangle in pixels (see D3D12_RECT).
+struct CommandRect
+{
+  int32_t left;
+  int32_t top;
+  int32_t right;
+  int32_t bottom;
+};
+
+// a vertex buffer bound by its GPU virtual address (see D3D12_VERTEX_BUFFER_VIEW).
+struct CommandVertexBufferView
+{
+  uint64_t address;
+  uint32_t size;
+  uint32_t stride;
+};
+
+// an index buffer bound by its GPU virtual address with 2 or 4 byte indices (see D3D12_INDEX_BUFFER_VIEW).
+struct CommandIndexBufferView
+{
+  uint64_t address;
+  uint32_t size;
+  uint32_t indexSize;
+};
+
+// the types of the commands in the command streams.
+enum class CommandType : uint8_t
+{
+  SET_ROOT_SIGNATURE,
+  SET_PIPELINE_STATE,
+  SET_VIEWPORT,
+  SET_SCISSOR_RECT,
+  RESOURCE_BARRIER,
+  SET_RENDER_TARGET,
+  CLEAR_RENDER_TARGET,
+  SET_PRIMITIVE_TOPOLOGY,
+  SET_VERTEX_BUFFER,
+  SET_INDEX_BUFFER,
+  DRAW_INSTANCED,
+  DRAW_INDEXED_INSTANCED,
+  END_TIMESTAMP_QUERY,
+  RESOLVE_TIMESTAMP_QUERIES,
+  SET_DESCRIPTOR_HEAP,
+  SET_ROOT_DESCRIPTOR_TABLE,
+  COUNT
+};
+
+// get the name of the command type for the reports.
+const char* getCommandTypeName(CommandType type);
+
+// ============================================================================
+// The command list calls of the frame in a backend independent form.
+//
+// The objects are identified by their native pointers, the descriptors by
+// their CPU handles and the buffers by their GPU virtual addresses, so a
+// backend can forward the calls without any lookups. The backends implement
+// the sink next to their command lists and the command recorder implements it
+// to capture the calls, so the frame is recorded through the same interface
+// whether it is captured or not.
+// ============================================================================
+class CommandSink
+{
+public:
+  virtual ~CommandSink() {}
+
+  virtual void setRootSignature(const void* rootSignature) = 0;
+  virtual void setPipelineState(const void* pipelineState) = 0;
+  virtual void setViewport(const CommandViewport& viewport) = 0;
+  virtual void setScissorRect(const CommandRect& rect) = 0;
+  virtual void resourceBarrier(unsigned int count, const ResourceBarrier* barriers) = 0;
+  virtual void setRenderTarget(uint64_t descriptor) = 0;
+  virtual void clearRenderTarget(uint64_t descriptor, const float color[4]) = 0;
+  virtual void setPrimitiveTopology(PrimitiveTopology topology) = 0;
+  virtual void setVertexBuffer(unsigned int slot, const CommandVertexBufferView& view) = 0;
+  virtual void setIndexBuffer(const CommandIndexBufferView& view) = 0;
+  virtual void drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance) = 0;
+  virtual void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) = 0;
+  // write the GPU timestamp into the query with the given index in the query heap.
+  virtual void endTimestampQuery(const void* queryHeap, uint32_t index) = 0;
+  // copy the 64-bit values of the given queries into the destination buffer at the given offset.
+  virtual void resolveTimestampQueries(const void* queryHeap, uint32_t firstIndex, uint32_t count, const void* destination, uint64_t destinationOffset) = 0;
+  // bind the shader visible heap of the shader resource descriptors.
+  virtual void setDescriptorHeap(const void* descriptorHeap) = 0;
+  // bind the descriptor table of the root parameter by the GPU handle of its first descriptor in the bound heap.
+  virtual void setRootDescriptorTable(uint32_t parameter, uint64_t descriptor) = 0;
+
+  // record the given barriers unless there are none.
+  void resourceBarrier(const BarrierList& barriers);
+};
+
+// ============================================================================
+
+// the values that the commands of a stream are encoded against. each field holds the last value of its kind.
+struct CommandStreamState
+{
+  uint64_t rootSignature;
+  uint64_t pipelineState;
+  uint32_t viewport[6];
+  uint32_t rect[4];
+  uint64_t resource;
+  uint64_t descriptor;
+  uint32_t color[4];
+  uint64_t address;
+  uint32_t draw[4];
+  uint32_t drawIndexed[5];
+  uint64_t queryHeap;
+  uint32_t query;
+  uint64_t descriptorHeap;
+  uint64_t gpuDescriptor;
+};
+
+// ============================================================================
+// A recorder which serializes the command list calls into a byte stream.
+//
+// Each command is a single byte type followed by its arguments, which are
+// stored as variable length integers relative to the previous value of the
+// same kind: handles and addresses as the difference to the last one, floats
+// as the XOR of their bits with the last one and the draw arguments as the
+// difference to the last draw. The repeated state of a frame therefore
+// mostly encodes into a byte per argument. The stream buffer keeps its
+// capacity when the recorder is reset, so recording the same frame again
+// does not allocate any memory.
+// ============================================================================
+class CommandRecorder : public CommandSink
+{
+public:
+  CommandRecorder();
+
+  // remove the recorded commands and start a new stream.
+  void reset();
+
+  // get the recorded stream.
+  const uint8_t* getData() const;
+  size_t getSize() const;
+
+  // get the amount of recorded commands.
+  unsigned int getCommandCount() const;
+
+  void setRootSignature(const void* rootSignature) override;
+  void setPipelineState(const void* pipelineState) override;
+  void setViewport(const CommandViewport& viewport) override;
+  void setScissorRect(const CommandRect& rect) override;
+  void resourceBarrier(unsigned int count, const ResourceBarrier* barriers) override;
+  void setRenderTarget(uint64_t descriptor) override;
+  void clearRenderTarget(uint64_t descriptor, const float color[4]) override;
+  void setPrimitiveTopology(PrimitiveTopology topology) override;
+  void setVertexBuffer(unsigned int slot, const CommandVertexBufferView& view) override;
+  void setIndexBuffer(const CommandIndexBufferView& view) override;
+  void drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance) override;
+  void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+  void endTimestampQuery(const void* queryHeap, uint32_t index) override;
+  void resolveTimestampQueries(const void* queryHeap, uint32_t firstIndex, uint32_t count, const void* destination, uint64_t destinationOffset) override;
+  void setDescriptorHeap(const void* descriptorHeap) override;
+  void setRootDescriptorTable(uint32_t parameter, uint64_t descriptor) override;
+
+  using CommandSink::resourceBarrier;
+
+private:
+  // make room for a command of the given maximum size and write its type. returns the position of its arguments.
+  uint8_t* begin(CommandType type, size_t maxSize);
+
+  // finish the command whose arguments end at the given position.
+  void end(uint8_t* position);
+
+  std::vector<uint8_t> mData;
+  size_t mSize;
+  unsigned int mCommandCount;
+  CommandStreamState mState;
+};
+
+// ============================================================================
+
+// the amount and the CPU time of the replayed commands of each type.
+struct CommandReplayStats
+{
+  uint64_t counts[static_cast<size_t>(CommandType::COUNT)];
+  std::chrono::nanoseconds times[static_cast<size_t>(CommandType::COUNT)];
+};
+
+// decode the stream and issue its commands into the sink. the time of each command is added into the statistics when given.
+void replayCommandStream(const uint8_t* data, size_t size, CommandSink& sink, CommandReplayStats* stats = nullptr);
+
+// add the statistics of another replay into the statistics.
+void mergeCommandReplayStats(CommandReplayStats& stats, const CommandReplayStats& other);
+
+// print the amount, the total and the average time of the replayed commands by their type.
+void printCommandReplayStats(const CommandReplayStats& stats, std::ostream& out);
+
+// ============================================================================
+// A captured frame as the command streams of its command lists in their
+// submission order, which can be written into a file and replayed later.
+// ============================================================================
+class CommandCapture
+{
+public:
+  // the identifier at the beginning of the capture file.
+  static const uint32_t MAGIC = 0x53444d43; // "CMDS"
+  // the version of the capture file format.
+  static const uint32_t VERSION = 1;
+
+  // remove all streams.
+  void clear();
+
+  // append a copy of the recorded stream of a command list.
+  void addStream(const CommandRecorder& recorder);
+
+  // get the amount of streams.
+  unsigned int getStreamCount() const;
+
+  // get the stream with the given index.
+  const uint8_t* getStreamData(unsigned int index) const;
+  size_t getStreamSize(unsigned int index) const;
+
+  // get the total size of the streams.
+  size_t getSize() const;
+
+  // replay the streams in their order into the sink.
+  void replay(CommandSink& sink, CommandReplayStats* stats = nullptr) const;
+
+  // write the capture into a file.
+  void write(const std::string& path) const;
+
+  // read the capture from a file. returns false if the file is missing or is not a valid capture.
+  bool read(const std::string& path);
+
+private:
+  std::vector<uint8_t> mData;
+  // the end of each stream in the data.
+  std::vector<size_t> mEnds;
+};
@@ -0,0 +1,68 @@
+#include "CpuFeatures.h"
+
+#if defined(SIMD_X86)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+// ============================================================================
+
+SimdLevel getSupportedSimdLevel()
+{
+  #if defined(SIMD_X86)
+  static const auto level = [] {
+    // check the SSE4.1, F16C, AVX and OSXSAVE bits and that the OS preserves the AVX registers.
+    unsigned int registers[4] = {};
+    #if defined(_MSC_VER)
+    __cpuidex(reinterpret_cast<int*>(registers), 1, 0);
+    #else
+    __cpuid_count(1, 0, registers[0], registers[1], registers[2], registers[3]);
+    #endif
+    auto sse41 = (registers[2] & (1u << 19)) != 0;
+    auto f16c = (registers[2] & (1u << 29)) != 0;
+    auto avx = (registers[2] & (1u << 28)) != 0 && (registers[2] & (1u << 27)) != 0;
+    if (!sse41 || !f16c || !avx) {
+      return SimdLevel::SCALAR;
+    }
+    #if defined(_MSC_VER)
+    auto xcr0 = _xgetbv(0);
+    #else
+    unsigned int xcr0Low = 0;
+    unsigned int xcr0High = 0;
+    __asm__("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0));
+    auto xcr0 = xcr0Low;
+    #endif
+    if ((xcr0 & 0x6) != 0x6) {
+      return SimdLevel::SCALAR;
+    }
+
+    // check the AVX2 bit from the extended features.
+    #if defined(_MSC_VER)
+    __cpuidex(reinterpret_cast<int*>(registers), 7, 0);
+    #else
+    __cpuid_count(7, 0, registers[0], registers[1], registers[2], registers[3]);
+    #endif
+    return (registers[1] & (1u << 5)) != 0 ? SimdLevel::AVX2 : SimdLevel::SSE41;
+  }();
+  return level;
+  #else
+  return SimdLevel::SCALAR;
+  #endif
+}
+
+// ============================================================================
+
+const char* getSimdLevelName(SimdLevel level)
+{
+  switch (level) {
+  case SimdLevel::SSE41:
+    return "SSE4.1";
+  case SimdLevel::AVX2:
+    return "AVX2";
+  default:
+    return "scalar";
+  }
+}
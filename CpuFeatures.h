@@ -0,0 +1,26 @@
+#pragma once
+
+// the SIMD kernels are only available on x86. the functions using the instructions are
+// compiled for their own target, so that the rest of the code runs on any x86 CPU.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SIMD_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#define TARGET_SSE41
+#define TARGET_AVX2
+#else
+#define TARGET_SSE41 __attribute__((target("sse4.1,f16c")))
+#define TARGET_AVX2 __attribute__((target("avx2,f16c")))
+#endif
+#endif
+
+// ============================================================================
+
+// the instruction sets of the SIMD kernels.
+enum class SimdLevel { SCALAR, SSE41, AVX2 };
+
+// get the best instruction set supported by the CPU. the SIMD kernels may also use the F16C conversions.
+SimdLevel getSupportedSimdLevel();
+
+// get the name of the instruction set.
+const char* getSimdLevelName(SimdLevel level);
@@ -0,0 +1,731 @@
+#include "DXBackend.h"
+
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+using namespace Microsoft::WRL;
+using namespace std::chrono;
+
+// ============================================================================
+
+DXFence::DXFence(ComPtr<ID3D12Fence> fence) : mFence(fence), mEvent(createEvent())
+{
+}
+
+// ============================================================================
+
+DXFence::~DXFence()
+{
+  CloseHandle(mEvent);
+}
+
+// ============================================================================
+
+uint64_t DXFence::getCompletedValue() const
+{
+  return mFence->GetCompletedValue();
+}
+
+// ============================================================================
+
+bool DXFence::wait(uint64_t value, milliseconds duration)
+{
+  // specify which event to trigger after fence has been finished.
+  auto result = mFence->SetEventOnCompletion(value, mEvent);
+  if (FAILED(result)) {
+    std::cout << "fence->SetEventOnCompletion: " << result << std::endl;
+    throw new std::runtime_error("Failed to set event for fence completion");
+  }
+
+  // wait for a signal or until the given duration has elapsed.
+  auto timeout = duration == milliseconds::max() ? INFINITE : static_cast<DWORD>(duration.count());
+  return WaitForSingleObject(mEvent, timeout) == WAIT_OBJECT_0;
+}
+
+// ============================================================================
+
+ComPtr<ID3D12Fence> DXFence::get() const
+{
+  return mFence;
+}
+
+// ============================================================================
+
+DXCommandList::DXCommandList(ComPtr<ID3D12GraphicsCommandList> commandList) : mCommandList(commandList)
+{
+}
+
+// ============================================================================
+
+ComPtr<ID3D12GraphicsCommandList> DXCommandList::get() const
+{
+  return mCommandList;
+}
+
+// ============================================================================
+
+void DXCommandList::setRootSignature(const void* rootSignature)
+{
+  mCommandList->SetGraphicsRootSignature(static_cast<ID3D12RootSignature*>(const_cast<void*>(rootSignature)));
+}
+
+// ============================================================================
+
+void DXCommandList::setPipelineState(const void* pipelineState)
+{
+  mCommandList->SetPipelineState(static_cast<ID3D12PipelineState*>(const_cast<void*>(pipelineState)));
+}
+
+// ============================================================================
+
+void DXCommandList::setViewport(const CommandViewport& viewport)
+{
+  D3D12_VIEWPORT dxViewport = { viewport.topLeftX, viewport.topLeftY, viewport.width, viewport.height, viewport.minDepth, viewport.maxDepth };
+  mCommandList->RSSetViewports(1, &dxViewport);
+}
+
+// ============================================================================
+
+void DXCommandList::setScissorRect(const CommandRect& rect)
+{
+  D3D12_RECT dxRect = { rect.left, rect.top, rect.right, rect.bottom };
+  mCommandList->RSSetScissorRects(1, &dxRect);
+}
+
+// ============================================================================
+
+void DXCommandList::resourceBarrier(unsigned int count, const ResourceBarrier* barriers)
+{
+  if (count > mBarriers.size()) {
+    mBarriers.resize(count);
+  }
+  for (auto i = 0u; i < count; i++) {
+    mBarriers[i] = toDXBarrier(barriers[i]);
+  }
+  mCommandList->ResourceBarrier(count, mBarriers.data());
+}
+
+// ============================================================================
+
+void DXCommandList::setRenderTarget(uint64_t descriptor)
+{
+  D3D12_CPU_DESCRIPTOR_HANDLE handle = { static_cast<SIZE_T>(descriptor) };
+  mCommandList->OMSetRenderTargets(1, &handle, false, nullptr);
+}
+
+// ============================================================================
+
+void DXCommandList::clearRenderTarget(uint64_t descriptor, const float color[4])
+{
+  D3D12_CPU_DESCRIPTOR_HANDLE handle = { static_cast<SIZE_T>(descriptor) };
+  mCommandList->ClearRenderTargetView(handle, color, 0, nullptr);
+}
+
+// ============================================================================
+
+void DXCommandList::setPrimitiveTopology(PrimitiveTopology topology)
+{
+  mCommandList->IASetPrimitiveTopology(static_cast<D3D12_PRIMITIVE_TOPOLOGY>(topology));
+}
+
+// ============================================================================
+
+void DXCommandList::setVertexBuffer(unsigned int slot, const CommandVertexBufferView& view)
+{
+  D3D12_VERTEX_BUFFER_VIEW dxView = { view.address, view.size, view.stride };
+  mCommandList->IASetVertexBuffers(slot, 1, &dxView);
+}
+
+// ============================================================================
+
+void DXCommandList::setIndexBuffer(const CommandIndexBufferView& view)
+{
+  D3D12_INDEX_BUFFER_VIEW dxView = { view.address, view.size, view.indexSize == 2 ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT };
+  mCommandList->IASetIndexBuffer(&dxView);
+}
+
+// ============================================================================
+
+void DXCommandList::drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance)
+{
+  mCommandList->DrawInstanced(vertexCountPerInstance, instanceCount, startVertex, startInstance);
+}
+
+// ============================================================================
+
+void DXCommandList::drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance)
+{
+  mCommandList->DrawIndexedInstanced(indexCountPerInstance, instanceCount, startIndex, baseVertex, startInstance);
+}
+
+// ============================================================================
+
+void DXCommandList::endTimestampQuery(const void* queryHeap, uint32_t index)
+{
+  auto dxQueryHeap = static_cast<ID3D12QueryHeap*>(const_cast<void*>(queryHeap));
+  mCommandList->EndQuery(dxQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, index);
+}
+
+// ============================================================================
+
+void DXCommandList::resolveTimestampQueries(const void* queryHeap, uint32_t firstIndex, uint32_t count, const void* destination, uint64_t destinationOffset)
+{
+  auto dxQueryHeap = static_cast<ID3D12QueryHeap*>(const_cast<void*>(queryHeap));
+  auto buffer = static_cast<ID3D12Resource*>(const_cast<void*>(destination));
+  mCommandList->ResolveQueryData(dxQueryHeap, D3D12_QUERY_TYPE_TIMESTAMP, firstIndex, count, buffer, destinationOffset);
+}
+
+// ============================================================================
+
+void DXCommandList::setDescriptorHeap(const void* descriptorHeap)
+{
+  ID3D12DescriptorHeap* heaps[] = { static_cast<ID3D12DescriptorHeap*>(const_cast<void*>(descriptorHeap)) };
+  mCommandList->SetDescriptorHeaps(1, heaps);
+}
+
+// ============================================================================
+
+void DXCommandList::setRootDescriptorTable(uint32_t parameter, uint64_t descriptor)
+{
+  D3D12_GPU_DESCRIPTOR_HANDLE handle = { descriptor };
+  mCommandList->SetGraphicsRootDescriptorTable(parameter, handle);
+}
+
+// ============================================================================
+
+DXCommandQueue::DXCommandQueue(ComPtr<ID3D12CommandQueue> commandQueue) : mCommandQueue(commandQueue)
+{
+}
+
+// ============================================================================
+
+void DXCommandQueue::executeCommandLists(unsigned int count, CommandList* const* commandLists)
+{
+  // gather the native command lists and submit them into the command queue.
+  mNativeCommandLists.clear();
+  for (auto i = 0u; i < count; i++) {
+    mNativeCommandLists.push_back(static_cast<DXCommandList*>(commandLists[i])->get().Get());
+  }
+  mCommandQueue->ExecuteCommandLists(count, mNativeCommandLists.data());
+}
+
+// ============================================================================
+
+void DXCommandQueue::signal(Fence& fence, uint64_t value)
+{
+  auto result = mCommandQueue->Signal(static_cast<DXFence&>(fence).get().Get(), value);
+  if (FAILED(result)) {
+    std::cout << "commandQueue->Signal: " << result << std::endl;
+    throw new std::runtime_error("Failed to signal fence");
+  }
+}
+
+// ============================================================================
+
+void DXCommandQueue::wait(Fence& fence, uint64_t value)
+{
+  auto result = mCommandQueue->Wait(static_cast<DXFence&>(fence).get().Get(), value);
+  if (FAILED(result)) {
+    std::cout << "commandQueue->Wait: " << result << std::endl;
+    throw new std::runtime_error("Failed to wait fence");
+  }
+}
+
+// ============================================================================
+
+ComPtr<ID3D12CommandQueue> DXCommandQueue::get() const
+{
+  return mCommandQueue;
+}
+
+// ============================================================================
+
+DXSwapChain::DXSwapChain(ComPtr<IDXGISwapChain4> swapChain)
+  : mSwapChain(swapChain),
+    mBufferCount(0),
+    mTearing(false),
+    mFrameLatencyWaitableObject(nullptr),
+    mSyncRefreshCount(0),
+    mSyncQPCTime(),
+    mVblankInterval(microseconds::zero())
+{
+  // get the amount of buffers and the flags from the swap chain descriptor.
+  DXGI_SWAP_CHAIN_DESC1 descriptor = {};
+  auto result = mSwapChain->GetDesc1(&descriptor);
+  if (FAILED(result)) {
+    std::cout << "swapChain->GetDesc1: " << result << std::endl;
+    throw new std::runtime_error("Failed to get swap chain descriptor");
+  }
+  mBufferCount = descriptor.BufferCount;
+  mTearing = (descriptor.Flags & DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING) != 0;
+  if ((descriptor.Flags & DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT) != 0) {
+    mFrameLatencyWaitableObject = mSwapChain->GetFrameLatencyWaitableObject();
+  }
+}
+
+// ============================================================================
+
+DXSwapChain::~DXSwapChain()
+{
+  if (mFrameLatencyWaitableObject) {
+    CloseHandle(mFrameLatencyWaitableObject);
+  }
+}
+
+// ============================================================================
+
+unsigned int DXSwapChain::getBufferCount() const
+{
+  return mBufferCount;
+}
+
+// ============================================================================
+
+unsigned int DXSwapChain::getCurrentBackBufferIndex() const
+{
+  return mSwapChain->GetCurrentBackBufferIndex();
+}
+
+// ============================================================================
+
+void DXSwapChain::waitForNextFrame()
+{
+  // the object is signaled when the amount of queued frames drops below the maximum frame latency. the timeout only
+  // guards against a lost signal (e.g. when the window is minimized).
+  if (mFrameLatencyWaitableObject) {
+    WaitForSingleObjectEx(mFrameLatencyWaitableObject, 1000, TRUE);
+  }
+}
+
+// ============================================================================
+
+void DXSwapChain::present(PresentMode mode)
+{
+  auto syncInterval = mode == PresentMode::VSYNC ? 1u : 0u;
+  auto flags = mode == PresentMode::TEARING && mTearing ? DXGI_PRESENT_ALLOW_TEARING : 0u;
+  auto result = mSwapChain->Present(syncInterval, flags);
+  if (FAILED(result)) {
+    std::cout << "swapChain->Present: " << result << std::endl;
+    throw new std::runtime_error("Failed to present swap chain buffer");
+  }
+}
+
+// ============================================================================
+
+void DXSwapChain::resize(unsigned int width, unsigned int height)
+{
+  // keep the amount of buffers, their format and the flags that the swap chain was created with.
+  DXGI_SWAP_CHAIN_DESC1 descriptor = {};
+  auto result = mSwapChain->GetDesc1(&descriptor);
+  if (FAILED(result)) {
+    std::cout << "swapChain->GetDesc1: " << result << std::endl;
+    throw new std::runtime_error("Failed to get swap chain descriptor");
+  }
+  result = mSwapChain->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, descriptor.Flags);
+  if (FAILED(result)) {
+    std::cout << "swapChain->ResizeBuffers: " << result << std::endl;
+    throw new std::runtime_error("Failed to resize swap chain buffers");
+  }
+}
+
+// ============================================================================
+
+bool DXSwapChain::getVblankTiming(VblankTiming& timing)
+{
+  // the statistics are not available for the first frames and after the presentation mode changes, which is not an
+  // error for the pacing.
+  DXGI_FRAME_STATISTICS statistics = {};
+  if (FAILED(mSwapChain->GetFrameStatistics(&statistics)) || statistics.SyncRefreshCount == 0) {
+    return false;
+  }
+
+  // measure the refresh interval between two statistics of different vertical blanks.
+  LARGE_INTEGER frequency;
+  QueryPerformanceFrequency(&frequency);
+  if (mSyncRefreshCount != 0 && statistics.SyncRefreshCount > mSyncRefreshCount) {
+    auto ticks = (statistics.SyncQPCTime.QuadPart - mSyncQPCTime.QuadPart) / (statistics.SyncRefreshCount - mSyncRefreshCount);
+    mVblankInterval = microseconds(ticks * 1000000 / frequency.QuadPart);
+  }
+  mSyncRefreshCount = statistics.SyncRefreshCount;
+  mSyncQPCTime = statistics.SyncQPCTime;
+  if (mVblankInterval <= microseconds::zero()) {
+    return false;
+  }
+
+  // the steady clock counts the performance counter in nanoseconds, so the time of the vertical blank converts the
+  // same way (split into whole seconds to avoid the overflow).
+  auto counter = statistics.SyncQPCTime.QuadPart;
+  auto time = nanoseconds((counter / frequency.QuadPart) * 1000000000 + (counter % frequency.QuadPart) * 1000000000 / frequency.QuadPart);
+  timing.time = steady_clock::time_point(duration_cast<steady_clock::duration>(time));
+  timing.interval = mVblankInterval;
+  return true;
+}
+
+// ============================================================================
+
+ComPtr<IDXGISwapChain4> DXSwapChain::get() const
+{
+  return mSwapChain;
+}
+
+// ============================================================================
+
+DXCopyRecorder::DXCopyRecorder(ComPtr<ID3D12Device> device, ComPtr<ID3D12Resource> uploadBuffer, unsigned int commandListCount)
+  : mUploadBuffer(uploadBuffer)
+{
+  for (auto i = 0u; i < commandListCount; i++) {
+    ComPtr<ID3D12CommandAllocator> commandAllocator;
+    auto result = device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&commandAllocator));
+    if (FAILED(result)) {
+      std::cout << "device->CreateCommandAllocator: " << result << std::endl;
+      throw new std::runtime_error("Failed to create copy command allocator");
+    }
+
+    // the command lists are created in the recording state, so they are closed until their first batch.
+    ComPtr<ID3D12GraphicsCommandList> commandList;
+    result = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, commandAllocator.Get(), nullptr, IID_PPV_ARGS(&commandList));
+    if (FAILED(result)) {
+      std::cout << "device->CreateCommandList: " << result << std::endl;
+      throw new std::runtime_error("Failed to create copy command list");
+    }
+    result = commandList->Close();
+    if (FAILED(result)) {
+      std::cout << "commandList->Close: " << result << std::endl;
+      throw new std::runtime_error("Failed to close the copy command list");
+    }
+    mCommandAllocators.push_back(commandAllocator);
+    mCommandLists.push_back(DXCommandList(commandList));
+  }
+}
+
+// ============================================================================
+
+unsigned int DXCopyRecorder::getCommandListCount() const
+{
+  return static_cast<unsigned int>(mCommandLists.size());
+}
+
+// ============================================================================
+
+void DXCopyRecorder::begin(unsigned int index)
+{
+  auto result = mCommandAllocators[index]->Reset();
+  if (FAILED(result)) {
+    std::cout << "commandAllocator->Reset: " << result << std::endl;
+    throw new std::runtime_error("Copy command allocator reset failed");
+  }
+  result = mCommandLists[index].get()->Reset(mCommandAllocators[index].Get(), nullptr);
+  if (FAILED(result)) {
+    std::cout << "commandList->Reset: " << result << std::endl;
+    throw new std::runtime_error("Copy command list reset failed");
+  }
+}
+
+// ============================================================================
+
+void DXCopyRecorder::copyBuffer(unsigned int index, void* destination, uint64_t destinationOffset, const UploadAllocation& source)
+{
+  auto buffer = static_cast<ID3D12Resource*>(destination);
+  mCommandLists[index].get()->CopyBufferRegion(buffer, destinationOffset, mUploadBuffer.Get(), source.offset, source.size);
+}
+
+// ============================================================================
+
+CommandList& DXCopyRecorder::end(unsigned int index)
+{
+  auto result = mCommandLists[index].get()->Close();
+  if (FAILED(result)) {
+    std::cout << "commandList->Close: " << result << std::endl;
+    throw new std::runtime_error("Failed to close the copy command list");
+  }
+  return mCommandLists[index];
+}
+
+// ============================================================================
+
+DXResidencyBackend::DXResidencyBackend(ComPtr<ID3D12Device> device, ComPtr<IDXGIAdapter4> adapter)
+  : mDevice(device), mAdapter(adapter)
+{
+}
+
+// ============================================================================
+
+MemoryBudget DXResidencyBackend::queryBudget()
+{
+  DXGI_QUERY_VIDEO_MEMORY_INFO info = {};
+  auto result = mAdapter->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info);
+  if (FAILED(result)) {
+    std::cout << "adapter->QueryVideoMemoryInfo: " << result << std::endl;
+    throw new std::runtime_error("Failed to query the video memory budget");
+  }
+  return { info.Budget, info.CurrentUsage };
+}
+
+// ============================================================================
+
+void DXResidencyBackend::makeResident(unsigned int count, const void* const* objects)
+{
+  getPageables(count, objects);
+  auto result = mDevice->MakeResident(count, mPageables.data());
+  if (FAILED(result)) {
+    std::cout << "device->MakeResident: " << result << std::endl;
+    throw new std::runtime_error("Failed to make the resources resident");
+  }
+}
+
+// ============================================================================
+
+void DXResidencyBackend::evict(unsigned int count, const void* const* objects)
+{
+  getPageables(count, objects);
+  auto result = mDevice->Evict(count, mPageables.data());
+  if (FAILED(result)) {
+    std::cout << "device->Evict: " << result << std::endl;
+    throw new std::runtime_error("Failed to evict the resources");
+  }
+}
+
+// ============================================================================
+
+void DXResidencyBackend::getPageables(unsigned int count, const void* const* objects)
+{
+  mPageables.clear();
+  for (auto i = 0u; i < count; i++) {
+    mPageables.push_back(static_cast<ID3D12Resource*>(const_cast<void*>(objects[i])));
+  }
+}
+
+// ============================================================================
+
+DXDevice::DXDevice(ComPtr<ID3D12Device> device) : mDevice(device)
+{
+}
+
+// ============================================================================
+
+std::unique_ptr<CommandQueue> DXDevice::createCommandQueue(CommandListType type)
+{
+  // create a descriptor for the command queue.
+  D3D12_COMMAND_QUEUE_DESC descriptor = {};
+  descriptor.Type = toDXCommandListType(type);
+  descriptor.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
+  descriptor.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+  descriptor.NodeMask = 0;
+
+  // try to create a new command queue for the target device.
+  ComPtr<ID3D12CommandQueue> commandQueue;
+  auto result = mDevice->CreateCommandQueue(&descriptor, IID_PPV_ARGS(&commandQueue));
+  if (FAILED(result)) {
+    std::cout << "device->CreateCommandQueue: " << result << std::endl;
+    throw new std::runtime_error("Failed to create command queue");
+  }
+
+  return std::unique_ptr<CommandQueue>(new DXCommandQueue(commandQueue));
+}
+
+// ============================================================================
+
+std::unique_ptr<Fence> DXDevice::createFence()
+{
+  // try to create a new fence for the target device.
+  ComPtr<ID3D12Fence> fence;
+  auto result = mDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence));
+  if (FAILED(result)) {
+    std::cout << "device->CreateFence: " << result << std::endl;
+    throw new std::runtime_error("Failed to create a new fence");
+  }
+
+  return std::unique_ptr<Fence>(new DXFence(fence));
+}
+
+// ============================================================================
+
+ComPtr<ID3D12Device> DXDevice::get() const
+{
+  return mDevice;
+}
+
+// ============================================================================
+
+DXPipelineCache::DXPipelineCache(ComPtr<ID3D12Device> device, uint64_t deviceId)
+  : mDevice(device), mLibrary(deviceId), mCachedCount(0), mCompiledCount(0)
+{
+}
+
+// ============================================================================
+
+ComPtr<ID3D12PipelineState> DXPipelineCache::getPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& descriptor, uint64_t rootSignatureHash)
+{
+  // share the pipeline states with identical descriptors.
+  auto hash = hashDXPipelineState(descriptor, rootSignatureHash);
+  auto it = mPipelineStates.find(hash);
+  if (it != mPipelineStates.end()) {
+    return it->second;
+  }
+
+  // try to create the pipeline state from the cached blob first.
+  ComPtr<ID3D12PipelineState> pipelineState;
+  HRESULT result = E_FAIL;
+  auto blob = mLibrary.find(hash);
+  if (blob != nullptr && !blob->empty()) {
+    auto cachedDescriptor = descriptor;
+    cachedDescriptor.CachedPSO = { blob->data(), blob->size() };
+    result = mDevice->CreateGraphicsPipelineState(&cachedDescriptor, IID_PPV_ARGS(&pipelineState));
+    if (SUCCEEDED(result)) {
+      mCachedCount++;
+    } else {
+      // the driver rejects the blobs of other driver versions, so just compile the state again.
+      std::cout << "device->CreateGraphicsPipelineState (cached): " << result << std::endl;
+    }
+  }
+
+  // compile the pipeline state and store its blob into the library.
+  if (FAILED(result)) {
+    auto compiledDescriptor = descriptor;
+    compiledDescriptor.CachedPSO = {};
+    result = mDevice->CreateGraphicsPipelineState(&compiledDescriptor, IID_PPV_ARGS(&pipelineState));
+    if (FAILED(result)) {
+      std::cout << "device->CreateGraphicsPipelineState: " << result << std::endl;
+      throw new std::runtime_error("Failed to create a new graphics pipeline state");
+    }
+    mCompiledCount++;
+
+    ComPtr<ID3DBlob> cachedBlob;
+    result = pipelineState->GetCachedBlob(&cachedBlob);
+    if (SUCCEEDED(result)) {
+      mLibrary.store(hash, cachedBlob->GetBufferPointer(), cachedBlob->GetBufferSize());
+    } else {
+      std::cout << "pipelineState->GetCachedBlob: " << result << std::endl;
+    }
+  }
+
+  mPipelineStates[hash] = pipelineState;
+  return pipelineState;
+}
+
+// ============================================================================
+
+PipelineLibrary& DXPipelineCache::getLibrary()
+{
+  return mLibrary;
+}
+
+// ============================================================================
+
+unsigned int DXPipelineCache::getCachedCount() const
+{
+  return mCachedCount;
+}
+
+// ============================================================================
+
+unsigned int DXPipelineCache::getCompiledCount() const
+{
+  return mCompiledCount;
+}
+
+// ============================================================================
+
+uint64_t hashDXPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& descriptor, uint64_t rootSignatureHash)
+{
+  PipelineHasher hasher;
+  hasher.add(rootSignatureHash);
+
+  // the shaders are identified by the hashes of their bytecode.
+  for (auto shader : { &descriptor.VS, &descriptor.PS, &descriptor.DS, &descriptor.HS, &descriptor.GS }) {
+    hasher.add(hashBytes(shader->pShaderBytecode, shader->BytecodeLength));
+  }
+
+  // the blend state of each render target.
+  auto& blend = descriptor.BlendState;
+  hasher.add(blend.AlphaToCoverageEnable).add(blend.IndependentBlendEnable);
+  for (auto& target : blend.RenderTarget) {
+    hasher.add(target.BlendEnable).add(target.LogicOpEnable);
+    hasher.add(target.SrcBlend).add(target.DestBlend).add(target.BlendOp);
+    hasher.add(target.SrcBlendAlpha).add(target.DestBlendAlpha).add(target.BlendOpAlpha);
+    hasher.add(target.LogicOp).add(target.RenderTargetWriteMask);
+  }
+  hasher.add(descriptor.SampleMask);
+
+  // the rasterizer state.
+  auto& rasterizer = descriptor.RasterizerState;
+  hasher.add(rasterizer.FillMode).add(rasterizer.CullMode).add(rasterizer.FrontCounterClockwise);
+  hasher.add(rasterizer.DepthBias).add(rasterizer.DepthBiasClamp).add(rasterizer.SlopeScaledDepthBias);
+  hasher.add(rasterizer.DepthClipEnable).add(rasterizer.MultisampleEnable).add(rasterizer.AntialiasedLineEnable);
+  hasher.add(rasterizer.ForcedSampleCount).add(rasterizer.ConservativeRaster);
+
+  // the depth stencil state.
+  auto& depthStencil = descriptor.DepthStencilState;
+  hasher.add(depthStencil.DepthEnable).add(depthStencil.DepthWriteMask).add(depthStencil.DepthFunc);
+  hasher.add(depthStencil.StencilEnable).add(depthStencil.StencilReadMask).add(depthStencil.StencilWriteMask);
+  for (auto face : { &depthStencil.FrontFace, &depthStencil.BackFace }) {
+    hasher.add(face->StencilFailOp).add(face->StencilDepthFailOp).add(face->StencilPassOp).add(face->StencilFunc);
+  }
+
+  // the input layout.
+  hasher.add(descriptor.InputLayout.NumElements);
+  for (auto i = 0u; i < descriptor.InputLayout.NumElements; i++) {
+    auto& element = descriptor.InputLayout.pInputElementDescs[i];
+    hasher.addString(element.SemanticName).add(element.SemanticIndex).add(element.Format);
+    hasher.add(element.InputSlot).add(element.AlignedByteOffset);
+    hasher.add(element.InputSlotClass).add(element.InstanceDataStepRate);
+  }
+
+  // the primitive and the render target formats.
+  hasher.add(descriptor.IBStripCutValue).add(descriptor.PrimitiveTopologyType);
+  hasher.add(descriptor.NumRenderTargets);
+  for (auto i = 0u; i < descriptor.NumRenderTargets; i++) {
+    hasher.add(descriptor.RTVFormats[i]);
+  }
+  hasher.add(descriptor.DSVFormat).add(descriptor.SampleDesc.Count).add(descriptor.SampleDesc.Quality);
+  hasher.add(descriptor.NodeMask).add(descriptor.Flags);
+  return hasher.get();
+}
+
+// ============================================================================
+
+D3D12_RESOURCE_BARRIER toDXBarrier(const ResourceBarrier& barrier)
+{
+  // the tracked states use the same values as the native states, so they can be cast directly.
+  D3D12_RESOURCE_BARRIER dxBarrier = {};
+  dxBarrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+  dxBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+  if (barrier.split == BarrierSplit::BEGIN) {
+    dxBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY;
+  } else if (barrier.split == BarrierSplit::END) {
+    dxBarrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_END_ONLY;
+  }
+  dxBarrier.Transition.pResource = static_cast<ID3D12Resource*>(const_cast<void*>(barrier.resource));
+  dxBarrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+  dxBarrier.Transition.StateBefore = static_cast<D3D12_RESOURCE_STATES>(barrier.before);
+  dxBarrier.Transition.StateAfter = static_cast<D3D12_RESOURCE_STATES>(barrier.after);
+  return dxBarrier;
+}
+
+// ============================================================================
+
+D3D12_COMMAND_LIST_TYPE toDXCommandListType(CommandListType type)
+{
+  switch (type) {
+    case CommandListType::COMPUTE:
+      return D3D12_COMMAND_LIST_TYPE_COMPUTE;
+    case CommandListType::COPY:
+      return D3D12_COMMAND_LIST_TYPE_COPY;
+    default:
+      return D3D12_COMMAND_LIST_TYPE_DIRECT;
+  }
+}
+
+// ============================================================================
+
+HANDLE createEvent()
+{
+  auto event = CreateEvent(nullptr, false, false, nullptr);
+  if (event == nullptr) {
+    std::cout << "CreateEvent failed" << std::endl;
+    throw new std::runtime_error("Failed to create new event");
+  }
+
+  return event;
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+// include windows headers without unnecessary APIs.
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <wrl.h>
+
+#include <d3d12.h>
+#include <dxgi1_6.h>
+
+#include "Backend.h"
+#include "CommandStream.h"
+#include "PipelineCache.h"
+#include "ResidencyManager.h"
+#include "ResourceStateTracker.h"
+#include "UploadQueue.h"
+
+#include <unordered_map>
+#include <vector>
+
+// ============================================================================
+// The DirectX 12 implementation of the backend. Each object wraps the native
+// interface, which can be accessed with get() when the DirectX specific code
+// (e.g. command list recording) needs to use it directly.
+// ============================================================================
+
+class DXFence : public Fence
+{
+public:
+  DXFence(Microsoft::WRL::ComPtr<ID3D12Fence> fence);
+  ~DXFence();
+
+  DXFence(const DXFence&) = delete;
+  DXFence& operator=(const DXFence&) = delete;
+
+  uint64_t getCompletedValue() const override;
+  bool wait(uint64_t value, std::chrono::milliseconds duration) override;
+
+  Microsoft::WRL::ComPtr<ID3D12Fence> get() const;
+
+private:
+  Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
+  HANDLE mEvent;
+};
+
+// ============================================================================
+
+// the commands issued into the list are forwarded into the native command list.
+class DXCommandList : public CommandList, public CommandSink
+{
+public:
+  DXCommandList(Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList);
+
+  Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> get() const;
+
+  void setRootSignature(const void* rootSignature) override;
+  void setPipelineState(const void* pipelineState) override;
+  void setViewport(const CommandViewport& viewport) override;
+  void setScissorRect(const CommandRect& rect) override;
+  void resourceBarrier(unsigned int count, const ResourceBarrier* barriers) override;
+  void setRenderTarget(uint64_t descriptor) override;
+  void clearRenderTarget(uint64_t descriptor, const float color[4]) override;
+  void setPrimitiveTopology(PrimitiveTopology topology) override;
+  void setVertexBuffer(unsigned int slot, const CommandVertexBufferView& view) override;
+  void setIndexBuffer(const CommandIndexBufferView& view) override;
+  void drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance) override;
+  void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+  void endTimestampQuery(const void* queryHeap, uint32_t index) override;
+  void resolveTimestampQueries(const void* queryHeap, uint32_t firstIndex, uint32_t count, const void* destination, uint64_t destinationOffset) override;
+  void setDescriptorHeap(const void* descriptorHeap) override;
+  void setRootDescriptorTable(uint32_t parameter, uint64_t descriptor) override;
+
+  using CommandSink::resourceBarrier;
+
+private:
+  Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> mCommandList;
+  // the native barriers reused between the calls.
+  std::vector<D3D12_RESOURCE_BARRIER> mBarriers;
+};
+
+// ============================================================================
+
+class DXCommandQueue : public CommandQueue
+{
+public:
+  DXCommandQueue(Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue);
+
+  void executeCommandLists(unsigned int count, CommandList* const* commandLists) override;
+  void signal(Fence& fence, uint64_t value) override;
+  void wait(Fence& fence, uint64_t value) override;
+
+  Microsoft::WRL::ComPtr<ID3D12CommandQueue> get() const;
+
+private:
+  Microsoft::WRL::ComPtr<ID3D12CommandQueue> mCommandQueue;
+  // the native command lists of the last submission. reused to avoid allocations.
+  std::vector<ID3D12CommandList*> mNativeCommandLists;
+};
+
+// ============================================================================
+
+// the tearing and the frame latency waiting are enabled by the flags that the swap chain was created with.
+class DXSwapChain : public SwapChain
+{
+public:
+  DXSwapChain(Microsoft::WRL::ComPtr<IDXGISwapChain4> swapChain);
+  ~DXSwapChain();
+
+  DXSwapChain(const DXSwapChain&) = delete;
+  DXSwapChain& operator=(const DXSwapChain&) = delete;
+
+  unsigned int getBufferCount() const override;
+  unsigned int getCurrentBackBufferIndex() const override;
+  void waitForNextFrame() override;
+  void present(PresentMode mode) override;
+  bool getVblankTiming(VblankTiming& timing) override;
+
+  // resize the buffers to the given size. the buffers must not be referenced anymore, neither by the CPU nor by the GPU.
+  void resize(unsigned int width, unsigned int height);
+
+  Microsoft::WRL::ComPtr<IDXGISwapChain4> get() const;
+
+private:
+  Microsoft::WRL::ComPtr<IDXGISwapChain4> mSwapChain;
+  unsigned int mBufferCount;
+  bool mTearing;
+  // the object signaled when the swap chain accepts another frame or nullptr if the swap chain is not waitable.
+  HANDLE mFrameLatencyWaitableObject;
+  // the vertical blank of the previous frame statistics and the measured refresh interval.
+  UINT mSyncRefreshCount;
+  LARGE_INTEGER mSyncQPCTime;
+  std::chrono::microseconds mVblankInterval;
+};
+
+// ============================================================================
+
+class DXDevice : public Device
+{
+public:
+  DXDevice(Microsoft::WRL::ComPtr<ID3D12Device> device);
+
+  std::unique_ptr<CommandQueue> createCommandQueue(CommandListType type) override;
+  std::unique_ptr<Fence> createFence() override;
+
+  Microsoft::WRL::ComPtr<ID3D12Device> get() const;
+
+private:
+  Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+};
+
+// ============================================================================
+
+// the copies are recorded into copy command lists with an allocator of their own, from the upload buffer which backs
+// the upload ring into the destination buffers (ID3D12Resource pointers).
+class DXCopyRecorder : public CopyRecorder
+{
+public:
+  DXCopyRecorder(Microsoft::WRL::ComPtr<ID3D12Device> device, Microsoft::WRL::ComPtr<ID3D12Resource> uploadBuffer, unsigned int commandListCount);
+
+  unsigned int getCommandListCount() const override;
+  void begin(unsigned int index) override;
+  void copyBuffer(unsigned int index, void* destination, uint64_t destinationOffset, const UploadAllocation& source) override;
+  CommandList& end(unsigned int index) override;
+
+private:
+  Microsoft::WRL::ComPtr<ID3D12Resource> mUploadBuffer;
+  std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> mCommandAllocators;
+  std::vector<DXCommandList> mCommandLists;
+};
+
+// ============================================================================
+
+// the budget is the local segment of the adapter and the objects are resources (ID3D12Resource pointers), which are
+// paged with a single call of the device for all of them.
+class DXResidencyBackend : public ResidencyBackend
+{
+public:
+  DXResidencyBackend(Microsoft::WRL::ComPtr<ID3D12Device> device, Microsoft::WRL::ComPtr<IDXGIAdapter4> adapter);
+
+  MemoryBudget queryBudget() override;
+  void makeResident(unsigned int count, const void* const* objects) override;
+  void evict(unsigned int count, const void* const* objects) override;
+
+private:
+  // convert the objects into the pageable objects of a call.
+  void getPageables(unsigned int count, const void* const* objects);
+
+  Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+  Microsoft::WRL::ComPtr<IDXGIAdapter4> mAdapter;
+  std::vector<ID3D12Pageable*> mPageables;
+};
+
+// ============================================================================
+// A cache of the graphics pipeline states keyed by the hash of their full
+// descriptor. The states are shared at runtime and the driver compiled blobs
+// are kept in a pipeline library, so the library can be saved and loaded on
+// the next launch to skip the shader compilation in the driver.
+// ============================================================================
+
+class DXPipelineCache
+{
+public:
+  DXPipelineCache(Microsoft::WRL::ComPtr<ID3D12Device> device, uint64_t deviceId);
+
+  // get an existing pipeline state or create a new one with the given descriptor.
+  Microsoft::WRL::ComPtr<ID3D12PipelineState> getPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& descriptor, uint64_t rootSignatureHash);
+
+  // get the library of the driver compiled pipeline state blobs.
+  PipelineLibrary& getLibrary();
+
+  // get the amount of pipeline states which were created with or without a cached blob.
+  unsigned int getCachedCount() const;
+  unsigned int getCompiledCount() const;
+
+private:
+  Microsoft::WRL::ComPtr<ID3D12Device> mDevice;
+  PipelineLibrary mLibrary;
+  std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<ID3D12PipelineState>> mPipelineStates;
+  unsigned int mCachedCount;
+  unsigned int mCompiledCount;
+};
+
+// ============================================================================
+
+// get a stable hash of the graphics pipeline state descriptor. the root signature is identified by the hash of its serialized blob.
+uint64_t hashDXPipelineState(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& descriptor, uint64_t rootSignatureHash);
+
+// convert the tracked transition into a native transition barrier.
+D3D12_RESOURCE_BARRIER toDXBarrier(const ResourceBarrier& barrier);
+
+// get the DirectX 12 command list type matching the given type.
+D3D12_COMMAND_LIST_TYPE toDXCommandListType(CommandListType type);
+
+// create a new auto-reset event to wait for the fence completions.
+HANDLE createEvent();
@@ -0,0 +1,158 @@
+#include "DescriptorAllocator.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// ============================================================================
+
+DescriptorAllocator::DescriptorAllocator(unsigned int pageSize, unsigned int descriptorSize, CreatePageFunc createPage)
+  : mPageSizeClass(getDescriptorSizeClass(pageSize)),
+    mDescriptorSize(descriptorSize),
+    mCreatePage(createPage),
+    mAllocatedCount(0),
+    mFreeBlockCount(0)
+{
+  if (pageSize == 0) {
+    throw new std::runtime_error("Descriptor allocator page size must be greater than zero");
+  }
+  for (auto& freeList : mFreeLists) {
+    freeList = INVALID_BLOCK;
+  }
+}
+
+// ============================================================================
+
+DescriptorRange DescriptorAllocator::allocate(unsigned int count)
+{
+  if (count == 0) {
+    throw new std::runtime_error("Cannot allocate an empty descriptor range");
+  }
+
+  // find the smallest free block which holds the range.
+  auto sizeClass = getDescriptorSizeClass(count);
+  auto blockClass = sizeClass;
+  while (blockClass < SIZE_CLASS_COUNT && mFreeLists[blockClass] == INVALID_BLOCK) {
+    blockClass++;
+  }
+
+  // create a new page as a single free block when no free block is large enough.
+  if (blockClass == SIZE_CLASS_COUNT) {
+    blockClass = std::max(mPageSizeClass, sizeClass);
+    auto page = mCreatePage(1u << blockClass);
+    auto firstBlock = static_cast<uint32_t>(mBlocks.size());
+    mPages.push_back({ page.cpuHandle, page.gpuHandle, blockClass, firstBlock });
+    mBlocks.resize(mBlocks.size() + (1ull << blockClass), { INVALID_BLOCK, INVALID_BLOCK, 0, 0 });
+    pushFreeBlock(firstBlock, static_cast<unsigned int>(mPages.size() - 1), blockClass);
+  }
+
+  // take the first block and split it, keeping the lower half and releasing the upper half each time.
+  auto block = mFreeLists[blockClass];
+  auto pageIndex = mBlocks[block].page;
+  removeFreeBlock(block);
+  while (blockClass > sizeClass) {
+    blockClass--;
+    pushFreeBlock(block + (1u << blockClass), pageIndex, blockClass);
+  }
+
+  auto& page = mPages[pageIndex];
+  auto offset = static_cast<uint64_t>(block - page.firstBlock) * mDescriptorSize;
+  mAllocatedCount += 1u << sizeClass;
+  return { page.cpuHandle + offset, page.gpuHandle != 0 ? page.gpuHandle + offset : 0, count, sizeClass, pageIndex };
+}
+
+// ============================================================================
+
+void DescriptorAllocator::free(const DescriptorRange& range)
+{
+  if (range.page >= mPages.size()) {
+    throw new std::runtime_error("Descriptor range does not belong to the allocator");
+  }
+
+  // merge the block with its buddy as long as the buddy is free, up to the whole page.
+  auto& page = mPages[range.page];
+  auto offset = static_cast<unsigned int>((range.cpuHandle - page.cpuHandle) / mDescriptorSize);
+  auto sizeClass = range.sizeClass;
+  while (sizeClass < page.sizeClass) {
+    auto buddy = page.firstBlock + (offset ^ (1u << sizeClass));
+    if (mBlocks[buddy].freeClass != sizeClass + 1) {
+      break;
+    }
+    removeFreeBlock(buddy);
+    offset &= ~(1u << sizeClass);
+    sizeClass++;
+  }
+  pushFreeBlock(page.firstBlock + offset, range.page, sizeClass);
+  mAllocatedCount -= 1u << range.sizeClass;
+}
+
+// ============================================================================
+
+unsigned int DescriptorAllocator::getDescriptorSize() const
+{
+  return mDescriptorSize;
+}
+
+// ============================================================================
+
+unsigned int DescriptorAllocator::getPageCount() const
+{
+  return static_cast<unsigned int>(mPages.size());
+}
+
+// ============================================================================
+
+unsigned int DescriptorAllocator::getAllocatedCount() const
+{
+  return mAllocatedCount;
+}
+
+// ============================================================================
+
+unsigned int DescriptorAllocator::getFreeBlockCount() const
+{
+  return mFreeBlockCount;
+}
+
+// ============================================================================
+
+void DescriptorAllocator::pushFreeBlock(uint32_t block, unsigned int page, unsigned int sizeClass)
+{
+  auto& entry = mBlocks[block];
+  entry.next = mFreeLists[sizeClass];
+  entry.previous = INVALID_BLOCK;
+  entry.page = page;
+  entry.freeClass = static_cast<uint8_t>(sizeClass + 1);
+  if (entry.next != INVALID_BLOCK) {
+    mBlocks[entry.next].previous = block;
+  }
+  mFreeLists[sizeClass] = block;
+  mFreeBlockCount++;
+}
+
+// ============================================================================
+
+void DescriptorAllocator::removeFreeBlock(uint32_t block)
+{
+  auto& entry = mBlocks[block];
+  if (entry.previous != INVALID_BLOCK) {
+    mBlocks[entry.previous].next = entry.next;
+  } else {
+    mFreeLists[entry.freeClass - 1] = entry.next;
+  }
+  if (entry.next != INVALID_BLOCK) {
+    mBlocks[entry.next].previous = entry.previous;
+  }
+  entry.freeClass = 0;
+  mFreeBlockCount--;
+}
+
+// ============================================================================
+
+unsigned int getDescriptorSizeClass(unsigned int count)
+{
+  auto sizeClass = 0u;
+  while (sizeClass < 31 && (1u << sizeClass) < count) {
+    sizeClass++;
+  }
+  return sizeClass;
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// ============================================================================
+
+// a contiguous range of descriptors allocated from the descriptor allocator.
+struct DescriptorRange
+{
+  // the CPU handle of the first descriptor in the range.
+  uint64_t cpuHandle;
+  // the GPU handle of the first descriptor in the range, or zero when the page is not shader-visible.
+  uint64_t gpuHandle;
+  // the amount of descriptors requested for the range.
+  unsigned int count;
+  // the power-of-two size class the range was allocated from.
+  unsigned int sizeClass;
+  // the index of the page (i.e. the descriptor heap) the range was allocated from.
+  unsigned int page;
+};
+
+// the first handles of a page created for the descriptor allocator.
+struct DescriptorPage
+{
+  uint64_t cpuHandle;
+  // the GPU handle of a shader-visible page (e.g. a CBV_SRV_UAV heap), or zero.
+  uint64_t gpuHandle;
+};
+
+// ============================================================================
+// A paged allocator for descriptor handles.
+//
+// The descriptors are carved from pages (descriptor heaps) which are created
+// on demand, so the amount of descriptors is not fixed up front. Ranges are
+// rounded up to a power-of-two size class and managed as buddy blocks: an
+// allocation splits the smallest larger free block when its own class has
+// none, and a release merges the block with its free buddy, so the pages do
+// not fragment into small blocks and a new page is only created when no free
+// block holds the range. The free blocks are linked into a list per size
+// class through an array with an entry for each descriptor, which also marks
+// the free blocks, so a block is taken, released and merged with its buddy in
+// constant time and without touching the heap. Shader-visible pages also have
+// GPU handles, which
+// are tracked for the ranges. The heap creation is delegated to a callback,
+// which keeps the allocator itself independent of the graphics API.
+// ============================================================================
+class DescriptorAllocator
+{
+public:
+  // the callback that creates a new page with the given amount of descriptors and returns its first handles.
+  typedef std::function<DescriptorPage(unsigned int descriptorCount)> CreatePageFunc;
+
+  // the page size is rounded up to a power of two.
+  DescriptorAllocator(unsigned int pageSize, unsigned int descriptorSize, CreatePageFunc createPage);
+
+  // allocate a contiguous range of the given amount of descriptors.
+  DescriptorRange allocate(unsigned int count = 1);
+
+  // release the given range so it can be reused.
+  void free(const DescriptorRange& range);
+
+  // get the CPU handle of the descriptor at the given index in the range.
+  uint64_t getCpuHandle(const DescriptorRange& range, unsigned int index) const
+  {
+    return range.cpuHandle + static_cast<uint64_t>(index) * mDescriptorSize;
+  }
+
+  // get the GPU handle of the descriptor at the given index in a range of a shader-visible page.
+  uint64_t getGpuHandle(const DescriptorRange& range, unsigned int index) const
+  {
+    return range.gpuHandle + static_cast<uint64_t>(index) * mDescriptorSize;
+  }
+
+  // get the size of a single descriptor (i.e. the handle increment size).
+  unsigned int getDescriptorSize() const;
+
+  // get the amount of pages that have been created.
+  unsigned int getPageCount() const;
+
+  // get the amount of descriptors in the currently allocated ranges (including rounding).
+  unsigned int getAllocatedCount() const;
+
+  // get the amount of free blocks, which is the amount of pages when all ranges have been released.
+  unsigned int getFreeBlockCount() const;
+
+private:
+  // the amount of power-of-two size classes.
+  static const unsigned int SIZE_CLASS_COUNT = 32;
+
+  // the index which ends a free list.
+  static const uint32_t INVALID_BLOCK = 0xffffffff;
+
+  // a created page, the size class of its descriptor count and the index of the block of its first descriptor.
+  struct Page
+  {
+    uint64_t cpuHandle;
+    uint64_t gpuHandle;
+    unsigned int sizeClass;
+    uint32_t firstBlock;
+  };
+
+  // the block which starts at a descriptor of a page. a free block is linked into the free list of its size class.
+  struct Block
+  {
+    uint32_t next;
+    uint32_t previous;
+    uint32_t page;
+    // the size class of the block plus one when the block is free, or zero.
+    uint8_t freeClass;
+  };
+
+  // link the free block at the given index into the free list of the size class.
+  void pushFreeBlock(uint32_t block, unsigned int page, unsigned int sizeClass);
+
+  // unlink the free block at the given index from its free list.
+  void removeFreeBlock(uint32_t block);
+
+  unsigned int mPageSizeClass;
+  unsigned int mDescriptorSize;
+  CreatePageFunc mCreatePage;
+  unsigned int mAllocatedCount;
+  std::vector<Page> mPages;
+  // the blocks of all pages, one for each descriptor, which are only appended to when a page is created.
+  std::vector<Block> mBlocks;
+  // the first free block of each size class.
+  uint32_t mFreeLists[SIZE_CLASS_COUNT];
+  unsigned int mFreeBlockCount;
+};
+
+// ============================================================================
+
+// get the smallest power-of-two size class which holds the given amount of descriptors.
+unsigned int getDescriptorSizeClass(unsigned int count);
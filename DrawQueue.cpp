@@ -0,0 +1,165 @@
+#include "DrawQueue.h"
+
+#include <cstring>
+#include <utility>
+
+// ============================================================================
+
+// the shifts of the key fields.
+static const auto DRAW_KEY_MESH_SHIFT = DRAW_KEY_DEPTH_BITS;
+static const auto DRAW_KEY_MATERIAL_SHIFT = DRAW_KEY_MESH_SHIFT + DRAW_KEY_MESH_BITS;
+static const auto DRAW_KEY_PIPELINE_SHIFT = DRAW_KEY_MATERIAL_SHIFT + DRAW_KEY_MATERIAL_BITS;
+static const auto DRAW_KEY_PASS_SHIFT = DRAW_KEY_PIPELINE_SHIFT + DRAW_KEY_PIPELINE_BITS;
+
+// the amount of bits sorted by each radix sort pass. 8-bit digits keep the histograms in the L1 cache.
+static const auto RADIX_BITS = 8u;
+static const auto RADIX_SIZE = 1u << RADIX_BITS;
+static const auto RADIX_PASS_COUNT = 64u / RADIX_BITS;
+
+// ============================================================================
+
+static uint64_t getKeyField(uint64_t key, unsigned int shift, unsigned int bits)
+{
+  return (key >> shift) & ((1ull << bits) - 1);
+}
+
+// ============================================================================
+
+uint64_t makeDrawKey(unsigned int pass, unsigned int pipeline, unsigned int material, unsigned int mesh, float depth)
+{
+  // the bits of a non-negative float increase with its value, so the highest bits order the depths.
+  uint32_t depthBits;
+  memcpy(&depthBits, &depth, sizeof(depthBits));
+  depthBits = depth > 0.f ? depthBits >> (32 - DRAW_KEY_DEPTH_BITS) : 0;
+
+  return (getKeyField(pass, 0, DRAW_KEY_PASS_BITS) << DRAW_KEY_PASS_SHIFT)
+    | (getKeyField(pipeline, 0, DRAW_KEY_PIPELINE_BITS) << DRAW_KEY_PIPELINE_SHIFT)
+    | (getKeyField(material, 0, DRAW_KEY_MATERIAL_BITS) << DRAW_KEY_MATERIAL_SHIFT)
+    | (getKeyField(mesh, 0, DRAW_KEY_MESH_BITS) << DRAW_KEY_MESH_SHIFT)
+    | depthBits;
+}
+
+// ============================================================================
+
+unsigned int getDrawKeyPass(uint64_t key)
+{
+  return static_cast<unsigned int>(getKeyField(key, DRAW_KEY_PASS_SHIFT, DRAW_KEY_PASS_BITS));
+}
+
+// ============================================================================
+
+unsigned int getDrawKeyPipeline(uint64_t key)
+{
+  return static_cast<unsigned int>(getKeyField(key, DRAW_KEY_PIPELINE_SHIFT, DRAW_KEY_PIPELINE_BITS));
+}
+
+// ============================================================================
+
+unsigned int getDrawKeyMaterial(uint64_t key)
+{
+  return static_cast<unsigned int>(getKeyField(key, DRAW_KEY_MATERIAL_SHIFT, DRAW_KEY_MATERIAL_BITS));
+}
+
+// ============================================================================
+
+unsigned int getDrawKeyMesh(uint64_t key)
+{
+  return static_cast<unsigned int>(getKeyField(key, DRAW_KEY_MESH_SHIFT, DRAW_KEY_MESH_BITS));
+}
+
+// ============================================================================
+
+void radixSortDrawItems(std::vector<DrawItem>& items, std::vector<DrawItem>& scratch)
+{
+  // build the histograms of all digits with a single pass over the keys.
+  auto count = items.size();
+  static_assert(RADIX_PASS_COUNT * RADIX_BITS == 64, "The digits must cover the whole key");
+  uint32_t histograms[RADIX_PASS_COUNT * RADIX_SIZE] = {};
+  for (auto& item : items) {
+    for (auto pass = 0u; pass < RADIX_PASS_COUNT; pass++) {
+      histograms[pass * RADIX_SIZE + ((item.key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1))]++;
+    }
+  }
+
+  // scatter the items by each digit from the least significant one to the most significant one.
+  scratch.resize(count);
+  auto source = &items;
+  auto destination = &scratch;
+  for (auto pass = 0u; pass < RADIX_PASS_COUNT; pass++) {
+    // skip the digits which are the same in all keys (e.g. the unused key fields).
+    auto histogram = &histograms[pass * RADIX_SIZE];
+    auto shift = pass * RADIX_BITS;
+    if (count == 0 || histogram[((*source)[0].key >> shift) & (RADIX_SIZE - 1)] == count) {
+      continue;
+    }
+
+    // turn the counts into the offsets of the buckets.
+    auto offset = 0u;
+    for (auto digit = 0u; digit < RADIX_SIZE; digit++) {
+      auto digitCount = histogram[digit];
+      histogram[digit] = offset;
+      offset += digitCount;
+    }
+
+    auto input = source->data();
+    auto output = destination->data();
+    for (size_t i = 0; i < count; i++) {
+      output[histogram[(input[i].key >> shift) & (RADIX_SIZE - 1)]++] = input[i];
+    }
+    std::swap(source, destination);
+  }
+
+  // the sorted items end up in the scratch buffer after an odd amount of scatters.
+  if (source != &items) {
+    items.swap(scratch);
+  }
+}
+
+// ============================================================================
+
+void DrawQueue::clear()
+{
+  mItems.clear();
+  mBatches.clear();
+  mInstances.clear();
+}
+
+// ============================================================================
+
+void DrawQueue::sort()
+{
+  radixSortDrawItems(mItems, mScratch);
+
+  // merge the consecutive draws whose keys only differ by the depth.
+  mBatches.clear();
+  mInstances.resize(mItems.size());
+  for (auto i = 0u; i < mItems.size(); i++) {
+    auto& item = mItems[i];
+    if (mBatches.empty() || (mBatches.back().key >> DRAW_KEY_DEPTH_BITS) != (item.key >> DRAW_KEY_DEPTH_BITS)) {
+      mBatches.push_back({ item.key, i, 0 });
+    }
+    mBatches.back().instanceCount++;
+    mInstances[i] = item.instance;
+  }
+}
+
+// ============================================================================
+
+size_t DrawQueue::getItemCount() const
+{
+  return mItems.size();
+}
+
+// ============================================================================
+
+const std::vector<DrawBatch>& DrawQueue::getBatches() const
+{
+  return mBatches;
+}
+
+// ============================================================================
+
+const std::vector<uint32_t>& DrawQueue::getInstances() const
+{
+  return mInstances;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+
+// the bit layout of the draw sort keys from the most significant field to the least significant one.
+static const unsigned int DRAW_KEY_PASS_BITS = 4;
+static const unsigned int DRAW_KEY_PIPELINE_BITS = 12;
+static const unsigned int DRAW_KEY_MATERIAL_BITS = 16;
+static const unsigned int DRAW_KEY_MESH_BITS = 16;
+static const unsigned int DRAW_KEY_DEPTH_BITS = 16;
+
+// a single draw pushed into the draw queue.
+struct DrawItem
+{
+  // the packed sort key (see makeDrawKey).
+  uint64_t key;
+  // the index of the per-instance data of the draw.
+  uint32_t instance;
+};
+
+// consecutive draws with the same pass, pipeline, material and mesh merged into a single instanced draw.
+struct DrawBatch
+{
+  uint64_t key;
+  // the range of the batch in the sorted instance indices.
+  uint32_t firstInstance;
+  uint32_t instanceCount;
+};
+
+// ============================================================================
+
+// pack the sort key of a draw. the depth must be non-negative and the draws are sorted from the front to the back.
+uint64_t makeDrawKey(unsigned int pass, unsigned int pipeline, unsigned int material, unsigned int mesh, float depth);
+
+// get the fields of a draw sort key.
+unsigned int getDrawKeyPass(uint64_t key);
+unsigned int getDrawKeyPipeline(uint64_t key);
+unsigned int getDrawKeyMaterial(uint64_t key);
+unsigned int getDrawKeyMesh(uint64_t key);
+
+// sort the items by their keys with a stable LSD radix sort. the scratch buffer is resized to the amount of items.
+void radixSortDrawItems(std::vector<DrawItem>& items, std::vector<DrawItem>& scratch);
+
+// ============================================================================
+// A queue of draws ordered by 64-bit sort keys.
+//
+// The callers push their draws in any order, each with a key which packs the
+// pass, pipeline state, material, mesh and depth of the draw. The queue sorts
+// the draws by their keys and merges the consecutive draws which differ only
+// by their depth into instanced batches, so that the recording only changes
+// the bound state when the corresponding field of the key changes.
+// ============================================================================
+class DrawQueue
+{
+public:
+  // add a draw into the queue.
+  void push(uint64_t key, uint32_t instance)
+  {
+    mItems.push_back({ key, instance });
+  }
+
+  // remove all draws and batches so that the queue can be reused.
+  void clear();
+
+  // sort the draws and merge them into the batches.
+  void sort();
+
+  // get the amount of draws in the queue.
+  size_t getItemCount() const;
+
+  // get the sorted and merged batches.
+  const std::vector<DrawBatch>& getBatches() const;
+
+  // get the instance indices of the draws in the order of the batches.
+  const std::vector<uint32_t>& getInstances() const;
+
+private:
+  std::vector<DrawItem> mItems;
+  std::vector<DrawItem> mScratch;
+  std::vector<DrawBatch> mBatches;
+  std::vector<uint32_t> mInstances;
+};
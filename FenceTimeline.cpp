@@ -0,0 +1,150 @@
+#include "FenceTimeline.h"
+
+#include <algorithm>
+
+using namespace std::chrono;
+
+// ============================================================================
+
+FenceTimeline::FenceTimeline(CommandQueue& queue, Fence& fence, uint64_t& fenceValue)
+  : mQueue(queue),
+    mFence(fence),
+    mFenceValue(fenceValue),
+    mCompletedValue(fence.getCompletedValue()),
+    mRetiredCount(0),
+    mFirst(0)
+{
+}
+
+// ============================================================================
+
+CommandQueue& FenceTimeline::getQueue() const
+{
+  return mQueue;
+}
+
+// ============================================================================
+
+Fence& FenceTimeline::getFence() const
+{
+  return mFence;
+}
+
+// ============================================================================
+
+uint64_t FenceTimeline::signal()
+{
+  return signalFence(mQueue, mFence, mFenceValue);
+}
+
+// ============================================================================
+
+uint64_t FenceTimeline::getNextValue() const
+{
+  return mFenceValue + 1;
+}
+
+// ============================================================================
+
+uint64_t FenceTimeline::getLastValue() const
+{
+  return mFenceValue;
+}
+
+// ============================================================================
+
+uint64_t FenceTimeline::getCompletedValue() const
+{
+  return mCompletedValue;
+}
+
+// ============================================================================
+
+bool FenceTimeline::isCompleted(uint64_t value) const
+{
+  return value <= mCompletedValue || value <= mFence.getCompletedValue();
+}
+
+// ============================================================================
+
+void FenceTimeline::onCompleted(uint64_t value, const CompletionFunc& callback)
+{
+  insert(value, callback, nullptr);
+}
+
+// ============================================================================
+
+void FenceTimeline::reserve(size_t entryCount)
+{
+  mEntries.reserve(entryCount);
+}
+
+// ============================================================================
+
+unsigned int FenceTimeline::poll()
+{
+  // read the fence once for the whole batch.
+  mCompletedValue = std::max(mCompletedValue, mFence.getCompletedValue());
+
+  // the entry is moved out of the vector first, so its callback may register new entries.
+  auto count = 0u;
+  while (mFirst < mEntries.size() && mEntries[mFirst].value <= mCompletedValue) {
+    auto entry = std::move(mEntries[mFirst]);
+    mFirst++;
+    mRetiredCount++;
+    count++;
+    if (entry.callback) {
+      entry.callback();
+    }
+  }
+
+  // remove the retired entries at once, which keeps the capacity of the vector.
+  mEntries.erase(mEntries.begin(), mEntries.begin() + mFirst);
+  mFirst = 0;
+  return count;
+}
+
+// ============================================================================
+
+void FenceTimeline::wait(uint64_t value)
+{
+  waitFence(mFence, value, milliseconds::max());
+  poll();
+}
+
+// ============================================================================
+
+void FenceTimeline::flush()
+{
+  wait(signal());
+}
+
+// ============================================================================
+
+size_t FenceTimeline::getPendingCount() const
+{
+  return mEntries.size() - mFirst;
+}
+
+// ============================================================================
+
+uint64_t FenceTimeline::getRetiredCount() const
+{
+  return mRetiredCount;
+}
+
+// ============================================================================
+
+void FenceTimeline::insert(uint64_t value, const CompletionFunc& callback, std::unique_ptr<ReleasedObject> object)
+{
+  // the entries are almost always registered for the latest values, so they are usually just appended.
+  Entry entry = { value, callback, std::move(object) };
+  if (mEntries.size() == mFirst || mEntries.back().value <= value) {
+    mEntries.push_back(std::move(entry));
+  } else {
+    auto position = std::upper_bound(mEntries.begin() + mFirst, mEntries.end(), value, [](uint64_t value, const Entry& entry) {
+      return value < entry.value;
+    });
+    mEntries.insert(position, std::move(entry));
+  }
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "Backend.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// The timeline of the fence values signaled from a command queue.
+//
+// The timeline hands out the fence values of the queue and keeps the work
+// which has to wait for the GPU until a value has been completed: callbacks
+// (e.g. the release of a descriptor range or of upload ring memory) and
+// objects whose destruction is deferred (e.g. resources and command
+// allocators the GPU may still use). The entries are kept sorted by their
+// fence value and are retired in batches by polling the timeline once per
+// frame, which reads the fence only once, so the code which retires
+// something never has to wait for the GPU. The counter of the fence values
+// is shared with the callers of signalFence, so the frame loop can keep
+// signaling the same fence. The retired entries are removed from a vector
+// whose capacity is kept and can be reserved for the frames in flight, so a
+// frame registers its entries without touching the heap even when the GPU
+// falls behind. The timeline is not thread-safe.
+// ============================================================================
+class FenceTimeline
+{
+public:
+  // the callback that is invoked once the GPU has completed its fence value.
+  typedef std::function<void()> CompletionFunc;
+
+  FenceTimeline(CommandQueue& queue, Fence& fence, uint64_t& fenceValue);
+
+  // get the queue and the fence of the timeline.
+  CommandQueue& getQueue() const;
+  Fence& getFence() const;
+
+  // signal the next fence value from the queue and return it.
+  uint64_t signal();
+
+  // get the value that the next signal will use, i.e. the value which completes the work submitted from now on.
+  uint64_t getNextValue() const;
+
+  // get the last signaled value.
+  uint64_t getLastValue() const;
+
+  // get the completed value as of the last poll.
+  uint64_t getCompletedValue() const;
+
+  // check whether the GPU has completed the given value by reading the fence.
+  bool isCompleted(uint64_t value) const;
+
+  // invoke the callback by the first poll after the GPU has completed the given value. the callbacks of a value are
+  // invoked in their registration order and may register new entries.
+  void onCompleted(uint64_t value, const CompletionFunc& callback);
+
+  // keep the object (e.g. a ComPtr or a unique_ptr) alive until the GPU has completed the given value.
+  template <typename T>
+  void release(uint64_t value, T object)
+  {
+    insert(value, CompletionFunc(), std::unique_ptr<ReleasedObject>(new ReleasedValue<T>(std::move(object))));
+  }
+
+  // reserve room for the given amount of entries waiting for the GPU, so registering them does not allocate.
+  void reserve(size_t entryCount);
+
+  // retire the entries whose values the GPU has completed. returns the amount of retired entries.
+  unsigned int poll();
+
+  // wait on the CPU until the GPU has completed the given value and retire the completed entries.
+  void wait(uint64_t value);
+
+  // signal the queue, wait until all submitted work has been completed and retire all entries.
+  void flush();
+
+  // get the amount of entries waiting for the GPU and the amount of entries retired so far.
+  size_t getPendingCount() const;
+  uint64_t getRetiredCount() const;
+
+private:
+  // the type erased owner of an object whose destruction is deferred.
+  struct ReleasedObject
+  {
+    virtual ~ReleasedObject() {}
+  };
+
+  template <typename T>
+  struct ReleasedValue : ReleasedObject
+  {
+    ReleasedValue(T object) : value(std::move(object)) {}
+
+    T value;
+  };
+
+  // a callback or a released object waiting for its fence value.
+  struct Entry
+  {
+    uint64_t value;
+    CompletionFunc callback;
+    std::unique_ptr<ReleasedObject> object;
+  };
+
+  // insert the entry after all entries with the same or an earlier value.
+  void insert(uint64_t value, const CompletionFunc& callback, std::unique_ptr<ReleasedObject> object);
+
+  CommandQueue& mQueue;
+  Fence& mFence;
+  uint64_t& mFenceValue;
+  uint64_t mCompletedValue;
+  uint64_t mRetiredCount;
+  std::vector<Entry> mEntries;
+  // the first entry which has not been retired by the running poll.
+  size_t mFirst;
+};
@@ -0,0 +1,156 @@
+#include "FrameLoop.h"
+#include "HeapCounter.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <thread>
+
+using namespace std::chrono;
+
+// the amount of command lists per frame that the frame loop makes room for before the first frame.
+static const auto INITIAL_COMMAND_LIST_CAPACITY = 64u;
+
+// the remaining time of the pacing delay below which the frame loop spins instead of sleeping, because the sleeps
+// overshoot by up to the timer resolution of the OS.
+static const auto PACING_SPIN_TIME = microseconds(2000);
+
+// ============================================================================
+
+FrameLoopStats runFrameLoop(
+  CommandQueue& commandQueue,
+  Fence& fence,
+  uint64_t& fenceValue,
+  SwapChain& swapChain,
+  FrameScheduler& frameScheduler,
+  PresentMode presentMode,
+  const BeginFrameFunc& beginFrame,
+  const RecordFrameFunc& recordFrame,
+  const EndFrameFunc& endFrame,
+  FramePacer* framePacer)
+{
+  FrameLoopStats stats = {};
+  stats.minFrameTime = microseconds::max();
+
+  // the command lists of the current frame. reused to avoid allocations and reserved up front, so the first frame
+  // does not count the growth of the vector.
+  std::vector<CommandList*> commandLists;
+  commandLists.reserve(INITIAL_COMMAND_LIST_CAPACITY);
+
+  auto loopStart = steady_clock::now();
+  auto frameStart = loopStart;
+  auto frameAllocationCount = getHeapAllocationCount();
+
+  // the pacer works with the times since the start of the loop. the fence is polled for the completed frames while
+  // the loop waits, so the GPU times are measured with about the precision of the polling.
+  auto getLoopTime = [&] {
+    return duration_cast<microseconds>(steady_clock::now() - loopStart);
+  };
+  auto completeFrames = [&] {
+    framePacer->completeFrames(fence.getCompletedValue(), getLoopTime());
+  };
+
+  while (beginFrame()) {
+    PROFILE_SCOPE("frame");
+
+    // wait until the swap chain accepts another frame when it limits the frame latency.
+    {
+      PROFILE_SCOPE("wait swap chain");
+      swapChain.waitForNextFrame();
+    }
+
+    // wait only if the GPU is still using the resources of this frame slot.
+    {
+      PROFILE_SCOPE("wait fence");
+      waitFence(fence, frameScheduler.getPendingFenceValue(), milliseconds::max());
+    }
+
+    // delay the start of the CPU work as planned by the pacer.
+    if (framePacer) {
+      PROFILE_SCOPE("pace frame");
+      VblankTiming vblankTiming;
+      if (presentMode == PresentMode::VSYNC && swapChain.getVblankTiming(vblankTiming)) {
+        framePacer->setVblankTiming(duration_cast<microseconds>(vblankTiming.time - loopStart), vblankTiming.interval);
+      }
+      completeFrames();
+      auto startTime = framePacer->planFrame(getLoopTime());
+      for (auto remainingTime = startTime - getLoopTime(); remainingTime > microseconds::zero(); remainingTime = startTime - getLoopTime()) {
+        if (remainingTime > PACING_SPIN_TIME) {
+          std::this_thread::sleep_for(std::min(remainingTime - PACING_SPIN_TIME, PACING_SPIN_TIME));
+        } else {
+          std::this_thread::yield();
+        }
+        completeFrames();
+      }
+    }
+    auto cpuStart = steady_clock::now();
+
+    // record the commands into the currently active back buffer.
+    {
+      PROFILE_SCOPE("record frame");
+      commandLists.clear();
+      recordFrame(frameScheduler.getFrameIndex(), swapChain.getCurrentBackBufferIndex(), commandLists);
+    }
+
+    // submit all recorded command lists in order with a single call.
+    {
+      PROFILE_SCOPE("execute command lists");
+      auto count = static_cast<unsigned int>(commandLists.size());
+      commandQueue.executeCommandLists(count, commandLists.data());
+    }
+    auto submitTime = steady_clock::now();
+    if (framePacer) {
+      completeFrames();
+    }
+
+    // present the rendered frame to the screen.
+    {
+      PROFILE_SCOPE("present");
+      swapChain.present(presentMode);
+    }
+
+    // mark the frame to be completed when the GPU reaches the signaled fence value.
+    {
+      PROFILE_SCOPE("signal fence");
+      auto frameFenceValue = signalFence(commandQueue, fence, fenceValue);
+      frameScheduler.submitFrame(frameFenceValue);
+      if (framePacer) {
+        framePacer->submitFrame(frameFenceValue, duration_cast<microseconds>(submitTime - cpuStart), duration_cast<microseconds>(submitTime - loopStart));
+      }
+      if (endFrame) {
+        endFrame(frameFenceValue);
+      }
+    }
+
+    // gather the frame time from the beginning of the previous frame.
+    auto now = steady_clock::now();
+    auto frameTime = duration_cast<microseconds>(now - frameStart);
+    stats.minFrameTime = std::min(stats.minFrameTime, frameTime);
+    stats.maxFrameTime = std::max(stats.maxFrameTime, frameTime);
+    stats.frameCount++;
+    frameStart = now;
+
+    // gather the heap allocations made by all threads since the previous frame.
+    auto allocationCount = getHeapAllocationCount();
+    auto frameAllocations = allocationCount - frameAllocationCount;
+    stats.heapAllocations += frameAllocations;
+    stats.maxFrameHeapAllocations = std::max(stats.maxFrameHeapAllocations, frameAllocations);
+    frameAllocationCount = allocationCount;
+  }
+
+  stats.totalTime = duration_cast<microseconds>(steady_clock::now() - loopStart);
+  return stats;
+}
+
+// ============================================================================
+
+microseconds getAverageFrameTime(const FrameLoopStats& stats)
+{
+  return stats.totalTime / std::max(stats.frameCount, 1u);
+}
+
+// ============================================================================
+
+double getAverageFrameHeapAllocations(const FrameLoopStats& stats)
+{
+  return static_cast<double>(stats.heapAllocations) / std::max(stats.frameCount, 1u);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "Backend.h"
+#include "FramePacer.h"
+#include "FrameScheduler.h"
+
+#include <chrono>
+#include <functional>
+#include <vector>
+
+// ============================================================================
+
+// the frame time statistics gathered while running the frame loop.
+struct FrameLoopStats
+{
+  unsigned int frameCount;
+  std::chrono::microseconds totalTime;
+  std::chrono::microseconds minFrameTime;
+  std::chrono::microseconds maxFrameTime;
+  // the heap allocations made on all threads during the frames (see HeapCounter.h).
+  uint64_t heapAllocations;
+  uint64_t maxFrameHeapAllocations;
+};
+
+// ============================================================================
+
+// the callback that is invoked at the beginning of each frame. returning false stops the loop.
+typedef std::function<bool()> BeginFrameFunc;
+
+// the callback that records the commands for the frame slot and back buffer with the given indices.
+// the recorded command lists are appended into the given vector in their submission order.
+typedef std::function<void(unsigned int frameIndex, unsigned int bufferIndex, std::vector<CommandList*>& commandLists)> RecordFrameFunc;
+
+// the callback that is invoked with the fence value which was signaled after the frame.
+typedef std::function<void(uint64_t fenceValue)> EndFrameFunc;
+
+// ============================================================================
+
+// run the frame loop until the begin frame callback requests it to stop. the start of each frame is delayed as
+// planned by the frame pacer when one is given.
+FrameLoopStats runFrameLoop(
+  CommandQueue& commandQueue,
+  Fence& fence,
+  uint64_t& fenceValue,
+  SwapChain& swapChain,
+  FrameScheduler& frameScheduler,
+  PresentMode presentMode,
+  const BeginFrameFunc& beginFrame,
+  const RecordFrameFunc& recordFrame,
+  const EndFrameFunc& endFrame = EndFrameFunc(),
+  FramePacer* framePacer = nullptr);
+
+// get the average frame time from the gathered frame loop statistics.
+std::chrono::microseconds getAverageFrameTime(const FrameLoopStats& stats);
+
+// get the average amount of heap allocations per frame from the gathered frame loop statistics.
+double getAverageFrameHeapAllocations(const FrameLoopStats& stats);
@@ -0,0 +1,271 @@
+#include "FramePacer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std::chrono;
+
+// the weights of a new sample in the smoothed average and in the smoothed deviation (the same as in TCP).
+static const auto AVERAGE_GAIN = 1.0 / 8.0;
+static const auto DEVIATION_GAIN = 1.0 / 4.0;
+
+// the multiple of the deviation which is added on top of the average in the predictions.
+static const auto DEVIATION_FACTOR = 2.0;
+
+// the bounds of the safety margin before the deadline.
+static const auto MIN_MARGIN = microseconds(500);
+static const auto MAX_MARGIN = microseconds(8000);
+
+// the amount that the margin grows by on each missed deadline without v-sync.
+static const auto MARGIN_STEP = microseconds(500);
+
+// the fraction of the margin above the minimum that is removed on each frame completed in time without v-sync.
+static const auto MARGIN_DECAY = 64;
+
+// the fraction of the margin above the minimum that is removed on each completed frame with v-sync, where the margin
+// holds the largest recent overshoot of the predictions. a missed deadline repeats a whole refresh, so the overshoot
+// of a rare spike is held for about a thousand frames.
+static const auto VBLANK_MARGIN_DECAY = 1024;
+
+// ============================================================================
+
+FrameTimePredictor::FrameTimePredictor() : mAverage(0.0), mDeviation(0.0), mSampleCount(0)
+{
+}
+
+// ============================================================================
+
+void FrameTimePredictor::addSample(microseconds time)
+{
+  auto sample = static_cast<double>(time.count());
+  if (mSampleCount == 0) {
+    // start with a large deviation, so the first predictions rather overestimate the frame time.
+    mAverage = sample;
+    mDeviation = sample / 2.0;
+  } else {
+    mDeviation += (std::abs(sample - mAverage) - mDeviation) * DEVIATION_GAIN;
+    mAverage += (sample - mAverage) * AVERAGE_GAIN;
+  }
+  mSampleCount++;
+}
+
+// ============================================================================
+
+microseconds FrameTimePredictor::predict() const
+{
+  return microseconds(static_cast<microseconds::rep>(std::ceil(mAverage + mDeviation * DEVIATION_FACTOR)));
+}
+
+// ============================================================================
+
+microseconds FrameTimePredictor::getAverage() const
+{
+  return microseconds(static_cast<microseconds::rep>(mAverage));
+}
+
+// ============================================================================
+
+microseconds FrameTimePredictor::getDeviation() const
+{
+  return microseconds(static_cast<microseconds::rep>(mDeviation));
+}
+
+// ============================================================================
+
+FramePacer::FramePacer()
+  : mVblankTime(microseconds::zero()),
+    mVblankInterval(microseconds::zero()),
+    mMargin(MIN_MARGIN),
+    mTargetTime(microseconds::min()),
+    mGpuEndTime(microseconds::zero()),
+    mCompletionTime(microseconds::zero()),
+    mPendingFrames(),
+    mFirstPendingFrame(0),
+    mPendingFrameCount(0),
+    mCompletedFrameCount(0),
+    mMissedFrameCount(0)
+{
+}
+
+// ============================================================================
+
+void FramePacer::setVblankTiming(microseconds time, microseconds interval)
+{
+  mVblankTime = time;
+  mVblankInterval = interval;
+}
+
+// ============================================================================
+
+microseconds FramePacer::planFrame(microseconds now)
+{
+  updateGpuEndTime(now);
+  auto cpuTime = mCpuTime.predict();
+  auto gpuTime = mGpuTime.predict();
+
+  microseconds startTime;
+  if (mVblankInterval > microseconds::zero()) {
+    // target the vertical blank that the frame makes on average when the CPU starts it right away, but not the one of
+    // the previous frame. the pacer never targets a later one, so it delays the frames only within their slack and
+    // does not lower the frame rate when the predictions are pessimistic after a spike.
+    auto averageEndTime = std::max(now + mCpuTime.getAverage(), mGpuEndTime) + mGpuTime.getAverage();
+    auto targetTime = getNextVblank(averageEndTime);
+    if (mTargetTime != microseconds::min()) {
+      targetTime = std::max(targetTime, getNextVblank(mTargetTime + mVblankInterval / 2));
+    }
+    mTargetTime = targetTime;
+    // start the frame as late as the predicted times and the margin allow.
+    startTime = targetTime - mMargin - gpuTime - cpuTime;
+  } else {
+    // submit the frame just before the GPU finishes the previous ones, so it does not wait in the queue.
+    mTargetTime = std::max(now + cpuTime, mGpuEndTime) + gpuTime + mMargin;
+    startTime = mGpuEndTime - mMargin - cpuTime;
+  }
+  return std::max(startTime, now);
+}
+
+// ============================================================================
+
+void FramePacer::submitFrame(uint64_t fenceValue, microseconds cpuTime, microseconds submitTime)
+{
+  if (mPendingFrameCount == MAX_PENDING_FRAMES) {
+    throw new std::runtime_error("Too many frames pending in the frame pacer");
+  }
+  auto& frame = mPendingFrames[(mFirstPendingFrame + mPendingFrameCount) % MAX_PENDING_FRAMES];
+  frame.cpuOvershoot = getOvershoot(mCpuTime, cpuTime);
+  mCpuTime.addSample(cpuTime);
+  frame.fenceValue = fenceValue;
+  frame.submitTime = submitTime;
+  frame.targetTime = mTargetTime;
+  mPendingFrameCount++;
+  updateGpuEndTime(submitTime);
+}
+
+// ============================================================================
+
+void FramePacer::completeFrames(uint64_t completedFenceValue, microseconds now)
+{
+  auto count = 0u;
+  while (count < mPendingFrameCount && mPendingFrames[(mFirstPendingFrame + count) % MAX_PENDING_FRAMES].fenceValue <= completedFenceValue) {
+    count++;
+  }
+  if (count == 0) {
+    return;
+  }
+
+  // the GPU started the first frame when it was submitted or when the previous one was completed. when several frames
+  // are completed at once, their time is split evenly between them.
+  auto startTime = std::max(mPendingFrames[mFirstPendingFrame].submitTime, mCompletionTime);
+  auto gpuTime = std::max(now - startTime, microseconds::zero()) / count;
+
+  // with v-sync, a spike which misses its vertical blank even without any delay tells nothing about how much the next
+  // frames may be delayed, so the margin holds the largest overshoot of the predicted CPU and GPU time instead of
+  // growing on the missed deadlines.
+  auto vsync = mVblankInterval > microseconds::zero();
+  for (auto i = 0u; i < count; i++) {
+    auto& frame = mPendingFrames[mFirstPendingFrame];
+    auto overshoot = std::max(frame.cpuOvershoot, microseconds::zero()) + getOvershoot(mGpuTime, gpuTime);
+    mGpuTime.addSample(gpuTime);
+    auto missed = now > frame.targetTime;
+    if (missed) {
+      mMissedFrameCount++;
+    }
+    if (vsync) {
+      mMargin -= (mMargin - MIN_MARGIN) / VBLANK_MARGIN_DECAY;
+      mMargin = std::min(std::max(mMargin, overshoot), MAX_MARGIN);
+    } else if (missed) {
+      mMargin = std::min(mMargin + MARGIN_STEP, MAX_MARGIN);
+    } else {
+      mMargin -= (mMargin - MIN_MARGIN) / MARGIN_DECAY;
+    }
+    mCompletedFrameCount++;
+    mFirstPendingFrame = (mFirstPendingFrame + 1) % MAX_PENDING_FRAMES;
+    mPendingFrameCount--;
+  }
+  mCompletionTime = now;
+  updateGpuEndTime(now);
+}
+
+// ============================================================================
+
+microseconds FramePacer::getTargetTime() const
+{
+  return mTargetTime;
+}
+
+// ============================================================================
+
+microseconds FramePacer::getPredictedCpuTime() const
+{
+  return mCpuTime.predict();
+}
+
+// ============================================================================
+
+microseconds FramePacer::getPredictedGpuTime() const
+{
+  return mGpuTime.predict();
+}
+
+// ============================================================================
+
+microseconds FramePacer::getMargin() const
+{
+  return mMargin;
+}
+
+// ============================================================================
+
+uint64_t FramePacer::getCompletedFrameCount() const
+{
+  return mCompletedFrameCount;
+}
+
+// ============================================================================
+
+uint64_t FramePacer::getMissedFrameCount() const
+{
+  return mMissedFrameCount;
+}
+
+// ============================================================================
+
+microseconds FramePacer::getNextVblank(microseconds time) const
+{
+  // round up in both directions from the known vertical blank (the division truncates towards zero).
+  auto offset = (time - mVblankTime).count();
+  auto interval = mVblankInterval.count();
+  auto count = offset / interval;
+  if (count * interval < offset) {
+    count++;
+  }
+  return mVblankTime + microseconds(count * interval);
+}
+
+// ============================================================================
+
+microseconds FramePacer::getOvershoot(const FrameTimePredictor& predictor, microseconds time)
+{
+  // the predictor has no prediction before its first sample.
+  auto prediction = predictor.predict();
+  return prediction > microseconds::zero() ? time - prediction : microseconds::zero();
+}
+
+// ============================================================================
+
+void FramePacer::updateGpuEndTime(microseconds now)
+{
+  // the GPU executes the pending frames in order, each one from its submission or the end of the previous one. the
+  // first one has not been completed yet, so it is running at least until now.
+  auto gpuTime = mGpuTime.predict();
+  auto endTime = mCompletionTime;
+  for (auto i = 0u; i < mPendingFrameCount; i++) {
+    auto& frame = mPendingFrames[(mFirstPendingFrame + i) % MAX_PENDING_FRAMES];
+    endTime = std::max(endTime, frame.submitTime) + gpuTime;
+    if (i == 0) {
+      endTime = std::max(endTime, now);
+    }
+  }
+  mGpuEndTime = endTime;
+}
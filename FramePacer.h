@@ -0,0 +1,129 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+// ============================================================================
+// A predictor of the time of the next frame from the recent frame times.
+//
+// The predictor keeps a smoothed average of the samples and of their mean
+// deviation from it, like the retransmission timer of TCP does with the
+// round trip times, and predicts the average plus a multiple of the
+// deviation. A steady workload is therefore predicted tightly and a noisy
+// one with a safety distance, without keeping any history around.
+// ============================================================================
+class FrameTimePredictor
+{
+public:
+  FrameTimePredictor();
+
+  // add the measured time of a frame.
+  void addSample(std::chrono::microseconds time);
+
+  // get the time predicted for the next frame. zero until the first sample.
+  std::chrono::microseconds predict() const;
+
+  // get the smoothed average and the smoothed mean deviation of the samples.
+  std::chrono::microseconds getAverage() const;
+  std::chrono::microseconds getDeviation() const;
+
+private:
+  double mAverage;
+  double mDeviation;
+  uint64_t mSampleCount;
+};
+
+// ============================================================================
+// A controller which delays the start of the CPU work of each frame to
+// reduce the latency between the input and the presentation.
+//
+// Without it, the CPU starts a frame as soon as a frame slot and the swap
+// chain allow it, and the frame then waits in the GPU and present queues,
+// so the input sampled at its start is shown frames later. The pacer
+// predicts the CPU and GPU time of the next frame and plans its start as
+// late as possible: with v-sync so that the GPU finishes a safety margin
+// before the targeted vertical blank, and without v-sync so that the CPU
+// submits the frame just when the GPU becomes idle. Without v-sync the margin
+// grows when a frame misses its deadline and shrinks slowly otherwise. With
+// v-sync, where a missed deadline repeats a whole refresh, the margin holds
+// the largest recent overshoot of the predicted frame time and shrinks much
+// slower, so the pacer delays the frames only within the slack that the
+// spikes leave.
+//
+// The times are durations since an arbitrary origin and the pacer never reads
+// a clock itself, so the frame loop feeds it with the measured times and the
+// simulations with simulated ones.
+// ============================================================================
+class FramePacer
+{
+public:
+  // the maximum amount of submitted frames that the GPU has not completed yet.
+  static const unsigned int MAX_PENDING_FRAMES = 16;
+
+  FramePacer();
+
+  // set the time of a vertical blank and the refresh interval that the frames are targeted at. a zero interval
+  // (the default) paces the frames only against the GPU.
+  void setVblankTiming(std::chrono::microseconds time, std::chrono::microseconds interval);
+
+  // plan the frame which could start at the given time. returns the time at which its CPU work should start.
+  std::chrono::microseconds planFrame(std::chrono::microseconds now);
+
+  // report the planned frame as submitted with the fence value signaled after it and its CPU time.
+  void submitFrame(uint64_t fenceValue, std::chrono::microseconds cpuTime, std::chrono::microseconds submitTime);
+
+  // report the fence value that the GPU had completed at the given time.
+  void completeFrames(uint64_t completedFenceValue, std::chrono::microseconds now);
+
+  // get the time that the last planned frame is targeted to be completed by.
+  std::chrono::microseconds getTargetTime() const;
+
+  // get the predicted CPU and GPU time of the next frame.
+  std::chrono::microseconds getPredictedCpuTime() const;
+  std::chrono::microseconds getPredictedGpuTime() const;
+
+  // get the current safety margin before the deadline.
+  std::chrono::microseconds getMargin() const;
+
+  // get the amount of completed frames and the amount of them that were completed after their target time.
+  uint64_t getCompletedFrameCount() const;
+  uint64_t getMissedFrameCount() const;
+
+private:
+  // a submitted frame which the GPU has not completed yet.
+  struct PendingFrame
+  {
+    uint64_t fenceValue;
+    std::chrono::microseconds submitTime;
+    std::chrono::microseconds targetTime;
+    // the amount that the CPU time exceeded its prediction.
+    std::chrono::microseconds cpuOvershoot;
+  };
+
+  // get the first vertical blank at or after the given time.
+  std::chrono::microseconds getNextVblank(std::chrono::microseconds time) const;
+
+  // get the amount that the time exceeds the prediction of the predictor, or zero without a prediction.
+  static std::chrono::microseconds getOvershoot(const FrameTimePredictor& predictor, std::chrono::microseconds time);
+
+  // update the predicted time when the GPU finishes the pending frames.
+  void updateGpuEndTime(std::chrono::microseconds now);
+
+  FrameTimePredictor mCpuTime;
+  FrameTimePredictor mGpuTime;
+  std::chrono::microseconds mVblankTime;
+  std::chrono::microseconds mVblankInterval;
+  std::chrono::microseconds mMargin;
+  // the target of the last planned frame.
+  std::chrono::microseconds mTargetTime;
+  // the time when the GPU is predicted to finish all pending frames.
+  std::chrono::microseconds mGpuEndTime;
+  // the time when the GPU completed the last frame.
+  std::chrono::microseconds mCompletionTime;
+  // the pending frames in a ring in their submission order.
+  PendingFrame mPendingFrames[MAX_PENDING_FRAMES];
+  unsigned int mFirstPendingFrame;
+  unsigned int mPendingFrameCount;
+  uint64_t mCompletedFrameCount;
+  uint64_t mMissedFrameCount;
+};
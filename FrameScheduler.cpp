@@ -0,0 +1,53 @@
+#include "FrameScheduler.h"
+
+#include <stdexcept>
+
+// ============================================================================
+
+FrameScheduler::FrameScheduler(unsigned int framesInFlight) : mFrameIndex(0), mLastFenceValue(0)
+{
+  if (framesInFlight == 0) {
+    throw new std::runtime_error("Frame scheduler requires at least one frame in flight");
+  }
+  mFenceValues.resize(framesInFlight, 0);
+}
+
+// ============================================================================
+
+unsigned int FrameScheduler::getFramesInFlight() const
+{
+  return static_cast<unsigned int>(mFenceValues.size());
+}
+
+// ============================================================================
+
+unsigned int FrameScheduler::getFrameIndex() const
+{
+  return mFrameIndex;
+}
+
+// ============================================================================
+
+uint64_t FrameScheduler::getPendingFenceValue() const
+{
+  return mFenceValues[mFrameIndex];
+}
+
+// ============================================================================
+
+uint64_t FrameScheduler::getLastFenceValue() const
+{
+  return mLastFenceValue;
+}
+
+// ============================================================================
+
+void FrameScheduler::submitFrame(uint64_t fenceValue)
+{
+  // store the fence value so we know when the slot can be reused.
+  mFenceValues[mFrameIndex] = fenceValue;
+  mLastFenceValue = fenceValue;
+
+  // proceed to next frame slot in a round-robin manner.
+  mFrameIndex = (mFrameIndex + 1) % getFramesInFlight();
+}
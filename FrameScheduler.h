@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// A scheduler which keeps track of the frames being processed by the GPU.
+//
+// Each frame slot owns its own set of per-frame resources (e.g. a command
+// allocator). A slot may be reused only after the fence value that was
+// signaled at the end of its previous frame has been reached by the GPU. This
+// allows the CPU to record up to N frames ahead of the GPU instead of waiting
+// for the GPU to finish each frame before recording the next one.
+// ============================================================================
+class FrameScheduler
+{
+public:
+  FrameScheduler(unsigned int framesInFlight);
+
+  // get the maximum amount of frames that may be in flight at once.
+  unsigned int getFramesInFlight() const;
+
+  // get the index of the frame slot used by the current frame.
+  unsigned int getFrameIndex() const;
+
+  // get the fence value which must be completed before the current slot can be reused.
+  uint64_t getPendingFenceValue() const;
+
+  // get the fence value that was signaled after the most recently submitted frame.
+  uint64_t getLastFenceValue() const;
+
+  // mark the current frame as submitted with the given fence value and move to the next slot.
+  void submitFrame(uint64_t fenceValue);
+
+private:
+  // the index of the frame slot used by the current frame.
+  unsigned int mFrameIndex;
+  // the fence values signaled at the end of the latest frame of each slot.
+  std::vector<uint64_t> mFenceValues;
+  // the fence value that was signaled after the most recently submitted frame.
+  uint64_t mLastFenceValue;
+};
@@ -0,0 +1,384 @@
+#include "FrustumCuller.h"
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+// ============================================================================
+
+// the visible indices of a group of eight objects for each of the visibility masks.
+struct CompactTable
+{
+  uint8_t indices[256][8];
+  uint8_t counts[256];
+};
+
+// ============================================================================
+
+static const CompactTable& getCompactTable()
+{
+  static const auto table = [] {
+    CompactTable table = {};
+    for (auto mask = 0u; mask < 256; mask++) {
+      for (auto bit = 0u; bit < 8; bit++) {
+        if ((mask & (1u << bit)) != 0) {
+          table.indices[mask][table.counts[mask]++] = static_cast<uint8_t>(bit);
+        }
+      }
+    }
+    return table;
+  }();
+  return table;
+}
+
+// ============================================================================
+
+static float getPlaneDistance(const Plane& plane, float x, float y, float z)
+{
+  return plane.normal[0] * x + plane.normal[1] * y + plane.normal[2] * z + plane.distance;
+}
+
+// ============================================================================
+
+static float getBoxRadius(const Plane& plane, float extentX, float extentY, float extentZ)
+{
+  // the distance from the center to the box corner which is furthest behind the plane.
+  return std::abs(plane.normal[0]) * extentX + std::abs(plane.normal[1]) * extentY + std::abs(plane.normal[2]) * extentZ;
+}
+
+// ============================================================================
+
+// the structure of arrays of the bounds which is passed to the kernels.
+struct CullingBounds
+{
+  const float* centerX;
+  const float* centerY;
+  const float* centerZ;
+  const float* radius;
+  const float* extentX;
+  const float* extentY;
+  const float* extentZ;
+};
+
+// ============================================================================
+
+static uint32_t cullScalar(const CullingBounds& bounds, const Frustum& frustum, BoundsType type, uint32_t begin, uint32_t end, uint32_t* output)
+{
+  auto count = 0u;
+  for (auto i = begin; i < end; i++) {
+    auto visible = true;
+    for (auto& plane : frustum.planes) {
+      auto distance = getPlaneDistance(plane, bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i]);
+      auto radius = type == BoundsType::SPHERE ? bounds.radius[i] : getBoxRadius(plane, bounds.extentX[i], bounds.extentY[i], bounds.extentZ[i]);
+      visible = visible && distance >= -radius;
+    }
+
+    // write the index unconditionally and only advance over the visible ones.
+    output[count] = i;
+    count += visible ? 1 : 0;
+  }
+  return count;
+}
+
+// ============================================================================
+
+#if defined(SIMD_X86)
+
+// the frustum planes broadcast into all lanes of the SSE registers.
+struct PlanesSSE41
+{
+  __m128 normalX[6];
+  __m128 normalY[6];
+  __m128 normalZ[6];
+  __m128 distance[6];
+  __m128 absNormalX[6];
+  __m128 absNormalY[6];
+  __m128 absNormalZ[6];
+};
+
+// ============================================================================
+
+template <BoundsType TYPE>
+TARGET_SSE41 static __m128 testBoundsSSE41(const CullingBounds& bounds, const PlanesSSE41& planes, uint32_t i)
+{
+  // evaluate the distances in the same order as the scalar kernel so that the results are identical.
+  auto centerX = _mm_loadu_ps(bounds.centerX + i);
+  auto centerY = _mm_loadu_ps(bounds.centerY + i);
+  auto centerZ = _mm_loadu_ps(bounds.centerZ + i);
+  auto negativeRadius = TYPE == BoundsType::SPHERE ? _mm_xor_ps(_mm_loadu_ps(bounds.radius + i), _mm_set1_ps(-0.f)) : _mm_setzero_ps();
+  auto extentX = TYPE == BoundsType::BOX ? _mm_loadu_ps(bounds.extentX + i) : _mm_setzero_ps();
+  auto extentY = TYPE == BoundsType::BOX ? _mm_loadu_ps(bounds.extentY + i) : _mm_setzero_ps();
+  auto extentZ = TYPE == BoundsType::BOX ? _mm_loadu_ps(bounds.extentZ + i) : _mm_setzero_ps();
+  auto visible = _mm_castsi128_ps(_mm_set1_epi32(-1));
+  for (auto plane = 0; plane < 6; plane++) {
+    auto distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(
+      _mm_mul_ps(planes.normalX[plane], centerX),
+      _mm_mul_ps(planes.normalY[plane], centerY)),
+      _mm_mul_ps(planes.normalZ[plane], centerZ)),
+      planes.distance[plane]);
+    if (TYPE == BoundsType::BOX) {
+      negativeRadius = _mm_xor_ps(_mm_add_ps(_mm_add_ps(
+        _mm_mul_ps(planes.absNormalX[plane], extentX),
+        _mm_mul_ps(planes.absNormalY[plane], extentY)),
+        _mm_mul_ps(planes.absNormalZ[plane], extentZ)), _mm_set1_ps(-0.f));
+    }
+    visible = _mm_and_ps(visible, _mm_cmpge_ps(distance, negativeRadius));
+  }
+  return visible;
+}
+
+// ============================================================================
+
+template <BoundsType TYPE>
+TARGET_SSE41 static uint32_t cullSSE41(const CullingBounds& bounds, const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* output)
+{
+  auto& table = getCompactTable();
+  PlanesSSE41 planes;
+  for (auto plane = 0; plane < 6; plane++) {
+    auto& normal = frustum.planes[plane].normal;
+    planes.normalX[plane] = _mm_set1_ps(normal[0]);
+    planes.normalY[plane] = _mm_set1_ps(normal[1]);
+    planes.normalZ[plane] = _mm_set1_ps(normal[2]);
+    planes.distance[plane] = _mm_set1_ps(frustum.planes[plane].distance);
+    planes.absNormalX[plane] = _mm_set1_ps(std::abs(normal[0]));
+    planes.absNormalY[plane] = _mm_set1_ps(std::abs(normal[1]));
+    planes.absNormalZ[plane] = _mm_set1_ps(std::abs(normal[2]));
+  }
+  auto count = 0u;
+  auto i = begin;
+  for (; i + 8 <= end; i += 8) {
+    // test eight objects per iteration as two halves of four.
+    auto mask = _mm_movemask_ps(testBoundsSSE41<TYPE>(bounds, planes, i)) | (_mm_movemask_ps(testBoundsSSE41<TYPE>(bounds, planes, i + 4)) << 4);
+
+    // write the indices of the visible objects to the front of the next eight output slots.
+    auto base = _mm_set1_epi32(static_cast<int>(i));
+    auto indices = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(table.indices[mask]));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + count), _mm_add_epi32(base, _mm_cvtepu8_epi32(indices)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + count + 4), _mm_add_epi32(base, _mm_cvtepu8_epi32(_mm_srli_si128(indices, 4))));
+    count += table.counts[mask];
+  }
+  return count + cullScalar(bounds, frustum, TYPE, i, end, output + count);
+}
+
+// ============================================================================
+
+template <BoundsType TYPE>
+TARGET_AVX2 static uint32_t cullAVX2(const CullingBounds& bounds, const Frustum& frustum, uint32_t begin, uint32_t end, uint32_t* output)
+{
+  auto& table = getCompactTable();
+  // broadcast the planes once for all objects.
+  __m256 normalX[6], normalY[6], normalZ[6], distances[6], absNormalX[6], absNormalY[6], absNormalZ[6];
+  for (auto plane = 0; plane < 6; plane++) {
+    auto& normal = frustum.planes[plane].normal;
+    normalX[plane] = _mm256_set1_ps(normal[0]);
+    normalY[plane] = _mm256_set1_ps(normal[1]);
+    normalZ[plane] = _mm256_set1_ps(normal[2]);
+    distances[plane] = _mm256_set1_ps(frustum.planes[plane].distance);
+    absNormalX[plane] = _mm256_set1_ps(std::abs(normal[0]));
+    absNormalY[plane] = _mm256_set1_ps(std::abs(normal[1]));
+    absNormalZ[plane] = _mm256_set1_ps(std::abs(normal[2]));
+  }
+  auto count = 0u;
+  auto i = begin;
+  for (; i + 8 <= end; i += 8) {
+    auto centerX = _mm256_loadu_ps(bounds.centerX + i);
+    auto centerY = _mm256_loadu_ps(bounds.centerY + i);
+    auto centerZ = _mm256_loadu_ps(bounds.centerZ + i);
+    auto negativeRadius = TYPE == BoundsType::SPHERE ? _mm256_xor_ps(_mm256_loadu_ps(bounds.radius + i), _mm256_set1_ps(-0.f)) : _mm256_setzero_ps();
+    auto extentX = TYPE == BoundsType::BOX ? _mm256_loadu_ps(bounds.extentX + i) : _mm256_setzero_ps();
+    auto extentY = TYPE == BoundsType::BOX ? _mm256_loadu_ps(bounds.extentY + i) : _mm256_setzero_ps();
+    auto extentZ = TYPE == BoundsType::BOX ? _mm256_loadu_ps(bounds.extentZ + i) : _mm256_setzero_ps();
+    auto visible = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+    for (auto plane = 0; plane < 6; plane++) {
+      auto distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(
+        _mm256_mul_ps(normalX[plane], centerX),
+        _mm256_mul_ps(normalY[plane], centerY)),
+        _mm256_mul_ps(normalZ[plane], centerZ)),
+        distances[plane]);
+      if (TYPE == BoundsType::BOX) {
+        negativeRadius = _mm256_xor_ps(_mm256_add_ps(_mm256_add_ps(
+          _mm256_mul_ps(absNormalX[plane], extentX),
+          _mm256_mul_ps(absNormalY[plane], extentY)),
+          _mm256_mul_ps(absNormalZ[plane], extentZ)), _mm256_set1_ps(-0.f));
+      }
+      visible = _mm256_and_ps(visible, _mm256_cmp_ps(distance, negativeRadius, _CMP_GE_OQ));
+    }
+    auto mask = _mm256_movemask_ps(visible);
+
+    // write the indices of the visible objects to the front of the next eight output slots.
+    auto indices = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(table.indices[mask])));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + count), _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), indices));
+    count += table.counts[mask];
+  }
+  return count + cullScalar(bounds, frustum, TYPE, i, end, output + count);
+}
+
+#endif
+
+// ============================================================================
+
+FrustumCuller::FrustumCuller() : mVisibleCount(0)
+{
+}
+
+// ============================================================================
+
+uint32_t FrustumCuller::addSphere(float x, float y, float z, float radius)
+{
+  auto index = getCount();
+  mCenterX.push_back(0.f);
+  mCenterY.push_back(0.f);
+  mCenterZ.push_back(0.f);
+  mRadius.push_back(0.f);
+  mExtentX.push_back(0.f);
+  mExtentY.push_back(0.f);
+  mExtentZ.push_back(0.f);
+  setSphere(index, x, y, z, radius);
+  return index;
+}
+
+// ============================================================================
+
+uint32_t FrustumCuller::addBox(float x, float y, float z, float extentX, float extentY, float extentZ)
+{
+  auto index = addSphere(x, y, z, 0.f);
+  setBox(index, x, y, z, extentX, extentY, extentZ);
+  return index;
+}
+
+// ============================================================================
+
+void FrustumCuller::setSphere(uint32_t index, float x, float y, float z, float radius)
+{
+  mCenterX[index] = x;
+  mCenterY[index] = y;
+  mCenterZ[index] = z;
+  mRadius[index] = radius;
+  mExtentX[index] = radius;
+  mExtentY[index] = radius;
+  mExtentZ[index] = radius;
+}
+
+// ============================================================================
+
+void FrustumCuller::setBox(uint32_t index, float x, float y, float z, float extentX, float extentY, float extentZ)
+{
+  mCenterX[index] = x;
+  mCenterY[index] = y;
+  mCenterZ[index] = z;
+  mRadius[index] = std::sqrt(extentX * extentX + extentY * extentY + extentZ * extentZ);
+  mExtentX[index] = extentX;
+  mExtentY[index] = extentY;
+  mExtentZ[index] = extentZ;
+}
+
+// ============================================================================
+
+void FrustumCuller::clear()
+{
+  mCenterX.clear();
+  mCenterY.clear();
+  mCenterZ.clear();
+  mRadius.clear();
+  mExtentX.clear();
+  mExtentY.clear();
+  mExtentZ.clear();
+  mVisibleCount = 0;
+}
+
+// ============================================================================
+
+uint32_t FrustumCuller::getCount() const
+{
+  return static_cast<uint32_t>(mCenterX.size());
+}
+
+// ============================================================================
+
+uint32_t FrustumCuller::cull(const Frustum& frustum, BoundsType type, JobSystem* jobSystem, SimdLevel level)
+{
+  // the output never holds more indices than there are objects, so it only grows with them.
+  auto count = getCount();
+  mVisible.resize(count);
+  if (jobSystem == nullptr || count < PARALLEL_THRESHOLD) {
+    mVisibleCount = cullRange(frustum, type, level, 0, count, mVisible.data());
+    return mVisibleCount;
+  }
+
+  // cull each range into its own part of the output, which is possible as the kernels never write past the
+  // objects they have tested, and move the visible indices of the ranges together afterwards.
+  auto rangeSize = RANGE_SIZE;
+  auto rangeCount = (count + rangeSize - 1) / rangeSize;
+  // the ranges are passed by reference, so the function of the jobs does not allocate for the captures.
+  mRangeCounts.resize(rangeCount);
+  auto cullRanges = [&](unsigned int beginRange, unsigned int endRange) {
+    for (auto range = beginRange; range < endRange; range++) {
+      auto begin = range * rangeSize;
+      auto end = std::min(begin + rangeSize, count);
+      mRangeCounts[range] = cullRange(frustum, type, level, begin, end, mVisible.data() + begin);
+    }
+  };
+  jobSystem->parallelFor(rangeCount, 1, std::ref(cullRanges));
+  mVisibleCount = mRangeCounts[0];
+  for (auto range = 1u; range < rangeCount; range++) {
+    memmove(mVisible.data() + mVisibleCount, mVisible.data() + range * rangeSize, mRangeCounts[range] * sizeof(uint32_t));
+    mVisibleCount += mRangeCounts[range];
+  }
+  return mVisibleCount;
+}
+
+// ============================================================================
+
+const uint32_t* FrustumCuller::getVisibleIndices() const
+{
+  return mVisible.data();
+}
+
+// ============================================================================
+
+uint32_t FrustumCuller::getVisibleCount() const
+{
+  return mVisibleCount;
+}
+
+// ============================================================================
+
+uint32_t FrustumCuller::cullRange(const Frustum& frustum, BoundsType type, SimdLevel level, uint32_t begin, uint32_t end, uint32_t* output) const
+{
+  CullingBounds bounds = { mCenterX.data(), mCenterY.data(), mCenterZ.data(), mRadius.data(), mExtentX.data(), mExtentY.data(), mExtentZ.data() };
+  #if defined(SIMD_X86)
+  auto sphere = type == BoundsType::SPHERE;
+  if (level == SimdLevel::AVX2) {
+    return sphere ? cullAVX2<BoundsType::SPHERE>(bounds, frustum, begin, end, output) : cullAVX2<BoundsType::BOX>(bounds, frustum, begin, end, output);
+  }
+  if (level == SimdLevel::SSE41) {
+    return sphere ? cullSSE41<BoundsType::SPHERE>(bounds, frustum, begin, end, output) : cullSSE41<BoundsType::BOX>(bounds, frustum, begin, end, output);
+  }
+  #endif
+  return cullScalar(bounds, frustum, type, begin, end, output);
+}
+
+// ============================================================================
+
+Frustum makeFrustum(const float viewProjection[16])
+{
+  // combine the rows of the matrix as in "Fast Extraction of Viewing Frustum Planes" (Gribb, Hartmann).
+  auto row = [&](int index, int component) { return viewProjection[index * 4 + component]; };
+  static const int ROWS[6] = { 0, 0, 1, 1, 2, 2 };
+  static const float SIGNS[6] = { 1.f, -1.f, 1.f, -1.f, 1.f, -1.f };
+  Frustum frustum;
+  for (auto i = 0; i < 6; i++) {
+    // the near plane is the depth row alone as the D3D depth starts from zero.
+    float plane[4];
+    for (auto component = 0; component < 4; component++) {
+      auto w = i == 4 ? 0.f : row(3, component);
+      plane[component] = w + SIGNS[i] * row(ROWS[i], component);
+    }
+    auto length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+    auto scale = length > 0.f ? 1.f / length : 0.f;
+    frustum.planes[i] = { { plane[0] * scale, plane[1] * scale, plane[2] * scale }, plane[3] * scale };
+  }
+  return frustum;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "CpuFeatures.h"
+
+#include <cstdint>
+#include <vector>
+
+class JobSystem;
+
+// ============================================================================
+
+// a plane where the points in front of it (i.e. inside the frustum) have a non-negative distance.
+struct Plane
+{
+  float normal[3];
+  float distance;
+};
+
+// the six planes of a view frustum in the order left, right, bottom, top, near and far.
+struct Frustum
+{
+  Plane planes[6];
+};
+
+// the shape of the bounds that is tested against the frustum.
+enum class BoundsType { SPHERE, BOX };
+
+// ============================================================================
+// A frustum culler for large amounts of object bounds.
+//
+// Each object has a bounding sphere and an axis-aligned bounding box sharing
+// the same center, stored as a structure of arrays so that the SIMD kernels
+// test eight objects per iteration against all planes with plain loads. The
+// visible objects are compacted into a list of indices which keeps the order
+// of the objects. Large object counts are split into fixed ranges which are
+// culled in parallel in place and merged afterwards.
+// ============================================================================
+class FrustumCuller
+{
+public:
+  // the amount of objects from which the culling is split across the job system.
+  static const uint32_t PARALLEL_THRESHOLD = 65536;
+  // the amount of objects in each of the parallel ranges. must be a multiple of eight.
+  static const uint32_t RANGE_SIZE = 16384;
+
+  FrustumCuller();
+
+  // add an object with a bounding sphere. the box of the object encloses the sphere.
+  uint32_t addSphere(float x, float y, float z, float radius);
+
+  // add an object with a bounding box of the given half extents. the sphere of the object encloses the box.
+  uint32_t addBox(float x, float y, float z, float extentX, float extentY, float extentZ);
+
+  // update the bounds of an object.
+  void setSphere(uint32_t index, float x, float y, float z, float radius);
+  void setBox(uint32_t index, float x, float y, float z, float extentX, float extentY, float extentZ);
+
+  // remove all objects.
+  void clear();
+
+  // get the amount of objects.
+  uint32_t getCount() const;
+
+  // test the objects against the frustum and collect the indices of the visible ones. returns the amount of visible objects.
+  uint32_t cull(const Frustum& frustum, BoundsType type, JobSystem* jobSystem = nullptr, SimdLevel level = getSupportedSimdLevel());
+
+  // get the indices of the objects that were visible in the last culling in an ascending order.
+  const uint32_t* getVisibleIndices() const;
+
+  // get the amount of objects that were visible in the last culling.
+  uint32_t getVisibleCount() const;
+
+private:
+  // cull the given range of objects and write the visible indices to the given output. returns the amount of visible objects.
+  uint32_t cullRange(const Frustum& frustum, BoundsType type, SimdLevel level, uint32_t begin, uint32_t end, uint32_t* output) const;
+
+  std::vector<float> mCenterX;
+  std::vector<float> mCenterY;
+  std::vector<float> mCenterZ;
+  std::vector<float> mRadius;
+  std::vector<float> mExtentX;
+  std::vector<float> mExtentY;
+  std::vector<float> mExtentZ;
+  // the visible indices, sized for all objects so that the ranges can be culled in place.
+  std::vector<uint32_t> mVisible;
+  uint32_t mVisibleCount;
+  // the amount of visible objects of each range of the parallel culling.
+  std::vector<uint32_t> mRangeCounts;
+};
+
+// ============================================================================
+
+// extract the normalized frustum planes from a row-major view-projection matrix that transforms column vectors
+// into the D3D clip space (the depth is within [0, w]).
+Frustum makeFrustum(const float viewProjection[16]);
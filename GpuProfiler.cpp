@@ -0,0 +1,197 @@
+#include "GpuProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std::chrono;
+
+// ============================================================================
+
+GpuProfiler::GpuProfiler(unsigned int framesInFlight, unsigned int maxRegionsPerFrame, const void* queryHeap, const void* readbackBuffer, const uint64_t* readbackData)
+  : mMaxRegionsPerFrame(maxRegionsPerFrame),
+    mQueryHeap(queryHeap),
+    mReadbackBuffer(readbackBuffer),
+    mReadbackData(readbackData),
+    mFrames(framesInFlight),
+    mFrameIndex(0),
+    mGpuCalibration(0),
+    mProfileCalibration(0),
+    mProfileTicksPerGpuTick(0.0),
+    mRing(createProfileRing("GPU")),
+    mReadCount(0),
+    mDroppedCount(0)
+{
+  if (framesInFlight == 0 || maxRegionsPerFrame == 0) {
+    throw new std::runtime_error("GPU profiler requires at least one frame slot and region");
+  }
+
+  // the regions are stored up front, so the frames do not allocate.
+  for (auto& frame : mFrames) {
+    frame.names.resize(maxRegionsPerFrame);
+    frame.ended.resize(maxRegionsPerFrame);
+    frame.regionCount = 0;
+    frame.resolved = false;
+  }
+  mLastFrameRegions.reserve(maxRegionsPerFrame);
+}
+
+// ============================================================================
+
+unsigned int GpuProfiler::getQueryCount(unsigned int framesInFlight, unsigned int maxRegionsPerFrame)
+{
+  return framesInFlight * maxRegionsPerFrame * 2;
+}
+
+// ============================================================================
+
+uint64_t GpuProfiler::getReadbackSize(unsigned int framesInFlight, unsigned int maxRegionsPerFrame)
+{
+  return getQueryCount(framesInFlight, maxRegionsPerFrame) * sizeof(uint64_t);
+}
+
+// ============================================================================
+
+void GpuProfiler::calibrate(uint64_t gpuFrequency, uint64_t gpuTimestamp, uint64_t profileTimestamp)
+{
+  if (gpuFrequency == 0) {
+    throw new std::runtime_error("GPU timestamp frequency must be greater than zero");
+  }
+  mGpuCalibration = gpuTimestamp;
+  mProfileCalibration = profileTimestamp;
+  mProfileTicksPerGpuTick = getProfileTicksPerMicrosecond() * 1e6 / gpuFrequency;
+}
+
+// ============================================================================
+
+void GpuProfiler::beginFrame(unsigned int frameIndex)
+{
+  if (frameIndex >= mFrames.size()) {
+    throw new std::runtime_error("GPU profiler frame index is out of range");
+  }
+  readFrame(frameIndex);
+  mFrameIndex = frameIndex;
+  auto& frame = mFrames[frameIndex];
+  frame.regionCount = 0;
+  frame.resolved = false;
+}
+
+// ============================================================================
+
+unsigned int GpuProfiler::beginRegion(CommandSink& sink, const char* name)
+{
+  auto& frame = mFrames[mFrameIndex];
+  if (frame.regionCount == mMaxRegionsPerFrame || frame.resolved) {
+    mDroppedCount++;
+    return INVALID_REGION;
+  }
+  auto region = frame.regionCount++;
+  frame.names[region] = name;
+  frame.ended[region] = false;
+  sink.endTimestampQuery(mQueryHeap, getQueryIndex(region));
+  return region;
+}
+
+// ============================================================================
+
+void GpuProfiler::endRegion(CommandSink& sink, unsigned int region)
+{
+  auto& frame = mFrames[mFrameIndex];
+  if (region >= frame.regionCount || frame.ended[region] || frame.resolved) {
+    return;
+  }
+  frame.ended[region] = true;
+  sink.endTimestampQuery(mQueryHeap, getQueryIndex(region) + 1);
+}
+
+// ============================================================================
+
+void GpuProfiler::resolve(CommandSink& sink)
+{
+  auto& frame = mFrames[mFrameIndex];
+  if (frame.regionCount > 0 && !frame.resolved) {
+    // the queries of the regions are contiguous from the first query of the slot.
+    auto firstQuery = getQueryIndex(0);
+    sink.resolveTimestampQueries(mQueryHeap, firstQuery, frame.regionCount * 2, mReadbackBuffer, firstQuery * sizeof(uint64_t));
+  }
+  frame.resolved = true;
+}
+
+// ============================================================================
+
+const std::vector<ProfileEvent>& GpuProfiler::getLastFrameRegions() const
+{
+  return mLastFrameRegions;
+}
+
+// ============================================================================
+
+microseconds GpuProfiler::getLastFrameTime() const
+{
+  if (mLastFrameRegions.empty()) {
+    return microseconds::zero();
+  }
+  auto begin = UINT64_MAX;
+  auto end = 0ull;
+  for (auto& region : mLastFrameRegions) {
+    begin = std::min<uint64_t>(begin, region.begin);
+    end = std::max<uint64_t>(end, region.end);
+  }
+  return microseconds(static_cast<microseconds::rep>((end - begin) / getProfileTicksPerMicrosecond()));
+}
+
+// ============================================================================
+
+uint64_t GpuProfiler::getReadCount() const
+{
+  return mReadCount;
+}
+
+// ============================================================================
+
+uint64_t GpuProfiler::getDroppedCount() const
+{
+  return mDroppedCount;
+}
+
+// ============================================================================
+
+unsigned int GpuProfiler::getQueryIndex(unsigned int region) const
+{
+  return (mFrameIndex * mMaxRegionsPerFrame + region) * 2;
+}
+
+// ============================================================================
+
+void GpuProfiler::readFrame(unsigned int frameIndex)
+{
+  auto& frame = mFrames[frameIndex];
+  if (!frame.resolved || frame.regionCount == 0) {
+    return;
+  }
+
+  // convert the timestamps of the regions and push them into the GPU timeline of the profiler.
+  mLastFrameRegions.clear();
+  auto timestamps = mReadbackData + frameIndex * mMaxRegionsPerFrame * 2;
+  for (auto region = 0u; region < frame.regionCount; region++) {
+    auto begin = timestamps[region * 2];
+    auto end = timestamps[region * 2 + 1];
+    if (!frame.ended[region] || end < begin) {
+      mDroppedCount++;
+      continue;
+    }
+    ProfileEvent event = { frame.names[region], toProfileTimestamp(begin), toProfileTimestamp(end) };
+    mRing.push(event.name, event.begin, event.end);
+    mLastFrameRegions.push_back(event);
+    mReadCount++;
+  }
+}
+
+// ============================================================================
+
+uint64_t GpuProfiler::toProfileTimestamp(uint64_t gpuTimestamp) const
+{
+  // the difference is signed, as the timestamps of the frames may precede the calibration.
+  auto delta = static_cast<double>(static_cast<int64_t>(gpuTimestamp - mGpuCalibration));
+  return mProfileCalibration + static_cast<uint64_t>(static_cast<int64_t>(std::llround(delta * mProfileTicksPerGpuTick)));
+}
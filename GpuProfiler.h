@@ -0,0 +1,100 @@
+#pragma once
+
+#include "CommandStream.h"
+#include "Profiler.h"
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+// A profiler of the GPU time of the named regions of the frames.
+//
+// A region is bracketed by two timestamp queries which are written by the
+// GPU when it reaches them in the command lists. Each frame slot owns its own
+// range of queries in the query heap and of the readback buffer, and the
+// queries of a frame are resolved into its range at the end of the frame. The
+// results of a slot are read when the slot is reused, i.e. after the frame
+// scheduler has waited for its fence, so reading them never stalls. The GPU
+// timestamps are converted into the profiler ticks with a calibration pair,
+// so the regions are pushed into a ring of the CPU profiler and show up in
+// its statistics and as a separate track in the same trace as the CPU stages.
+// The recording is not thread-safe, so the regions are recorded into the
+// command lists which are recorded on the main thread.
+// ============================================================================
+class GpuProfiler
+{
+public:
+  // the region which is returned when the queries of the frame have been exhausted. ending it is ignored.
+  static const unsigned int INVALID_REGION = ~0u;
+
+  // the query heap must hold getQueryCount queries and the mapped readback buffer getReadbackSize bytes.
+  GpuProfiler(unsigned int framesInFlight, unsigned int maxRegionsPerFrame, const void* queryHeap, const void* readbackBuffer, const uint64_t* readbackData);
+
+  // get the amount of timestamp queries and the size of the readback buffer for the given amount of slots and regions.
+  static unsigned int getQueryCount(unsigned int framesInFlight, unsigned int maxRegionsPerFrame);
+  static uint64_t getReadbackSize(unsigned int framesInFlight, unsigned int maxRegionsPerFrame);
+
+  // set the frequency of the GPU timestamps in ticks per second and a GPU timestamp and a profiler timestamp which
+  // were taken at the same time.
+  void calibrate(uint64_t gpuFrequency, uint64_t gpuTimestamp, uint64_t profileTimestamp);
+
+  // read the results of the previous frame of the slot and begin a new frame in it. the GPU must have completed the
+  // previous frame of the slot.
+  void beginFrame(unsigned int frameIndex);
+
+  // write the timestamp at the beginning of a new region. returns the region to end.
+  unsigned int beginRegion(CommandSink& sink, const char* name);
+
+  // write the timestamp at the end of the region.
+  void endRegion(CommandSink& sink, unsigned int region);
+
+  // resolve the queries of the frame into the readback buffer. must be recorded after the last region has ended.
+  void resolve(CommandSink& sink);
+
+  // get the regions of the last read frame in the profiler ticks.
+  const std::vector<ProfileEvent>& getLastFrameRegions() const;
+
+  // get the time between the beginning of the first and the end of the last region of the last read frame.
+  std::chrono::microseconds getLastFrameTime() const;
+
+  // get the amount of regions read so far and the amount of regions dropped because their queries were exhausted,
+  // they were not ended or their timestamps were invalid.
+  uint64_t getReadCount() const;
+  uint64_t getDroppedCount() const;
+
+private:
+  // the regions of a frame slot.
+  struct Frame
+  {
+    std::vector<const char*> names;
+    // the regions whose end has been written.
+    std::vector<bool> ended;
+    unsigned int regionCount;
+    bool resolved;
+  };
+
+  // get the index of the first query of the region in the current frame.
+  unsigned int getQueryIndex(unsigned int region) const;
+
+  // read the resolved regions of the frame in the slot.
+  void readFrame(unsigned int frameIndex);
+
+  // convert a GPU timestamp into the profiler ticks.
+  uint64_t toProfileTimestamp(uint64_t gpuTimestamp) const;
+
+  unsigned int mMaxRegionsPerFrame;
+  const void* mQueryHeap;
+  const void* mReadbackBuffer;
+  const uint64_t* mReadbackData;
+  std::vector<Frame> mFrames;
+  unsigned int mFrameIndex;
+  // the calibration pair and the amount of profiler ticks per GPU tick.
+  uint64_t mGpuCalibration;
+  uint64_t mProfileCalibration;
+  double mProfileTicksPerGpuTick;
+  ProfileRing& mRing;
+  std::vector<ProfileEvent> mLastFrameRegions;
+  uint64_t mReadCount;
+  uint64_t mDroppedCount;
+};
@@ -0,0 +1,121 @@
+#include "Headless.h"
+#include "MeshFile.h"
+#include "Profiler.h"
+#include "Simulation.h"
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+
+using namespace std::chrono;
+
+// ============================================================================
+
+// the CPU time consumed by each stub draw call in the simulated parallel recording.
+static const auto SIMULATED_DRAW_TIME = microseconds(1);
+
+// the amount of times that a command capture is replayed to measure its cost.
+static const auto REPLAY_COUNT = 1000u;
+
+// ============================================================================
+
+std::vector<Vertex> getTriangleVertices()
+{
+  // the vertex shader passes the positions through, so the triangle is given directly in the clip space.
+  return {
+    {{  0.0f,  0.5f, 0.0f }, { 1.f, 0.f, 0.f, 1.f }},
+    {{  0.5f, -0.5f, 0.0f }, { 0.f, 1.f, 0.f, 1.f }},
+    {{ -0.5f, -0.5f, 0.0f }, { 0.f, 0.f, 1.f, 1.f }}
+  };
+}
+
+// ============================================================================
+
+bool parseVertexLayoutOption(int argc, char* argv[], VertexLayout& layout)
+{
+  parseVertexLayout(DEFAULT_VERTEX_LAYOUT, layout);
+  for (auto i = 1; i + 1 < argc; i++) {
+    if (std::string(argv[i]) == "--vertex-layout" && !parseVertexLayout(argv[i + 1], layout)) {
+      std::cout << "unknown vertex layout: " << argv[i + 1] << std::endl;
+      return false;
+    }
+  }
+  return true;
+}
+
+// ============================================================================
+
+bool runHeadlessCommand(int argc, char* argv[], int& exitCode)
+{
+  exitCode = 0;
+
+  // measure frame loop throughput without a GPU when requested.
+  if (argc > 1 && std::string(argv[1]) == "--simulate") {
+    simulateFrameLoops(DEFAULT_BUFFER_COUNT, FRAMES_IN_FLIGHT + 1, std::cout);
+    simulateParallelRecording(DRAW_COUNT, DRAWS_PER_COMMAND_LIST, std::thread::hardware_concurrency(), SIMULATED_DRAW_TIME, std::cout);
+    simulateInitGraph(std::thread::hardware_concurrency(), std::cout);
+    simulateResourceStateTracking(256, 100000, std::cout);
+    simulateRenderGraph(1920, 1080, 1000, std::cout);
+    simulateMeshLoading(1024 * 1024, std::cout);
+    simulateVertexEncoding(1024 * 1024, std::cout);
+    simulateMeshOptimizer(4, std::cout);
+    simulateDrawQueue(100000, std::cout);
+    simulateDrawQueue(1000000, std::cout);
+    simulateFrustumCulling(1000000, std::cout);
+    simulateSoftwareRasterizer(1920, 1080, 100000, std::cout);
+    simulateCommandStream(DRAW_COUNT, DRAWS_PER_COMMAND_LIST, std::cout);
+    simulateFrameAllocations(DRAW_COUNT, DRAWS_PER_COMMAND_LIST, FRAMES_IN_FLIGHT, std::cout);
+    simulateFramePacing(FRAMES_IN_FLIGHT, std::cout);
+    simulateDescriptorAllocator(100000, std::cout);
+    simulateFenceTimeline(FRAMES_IN_FLIGHT, std::cout);
+    simulateUploadRing(FRAMES_IN_FLIGHT, std::cout);
+    simulateUploadQueue(FRAMES_IN_FLIGHT, std::cout);
+    simulateProfiler(1000000, std::cout);
+    simulateGpuProfiler(FRAMES_IN_FLIGHT, std::cout);
+    simulateDynamicResolution(FRAMES_IN_FLIGHT, std::cout);
+    simulateResidency(FRAMES_IN_FLIGHT, std::cout);
+    simulatePipelineLibrary(256, std::cout);
+    simulateShaderCache(64, std::cout);
+
+    // report the frame stages of all simulated runs.
+    printProfileStats(std::cout);
+    writeChromeTrace(TRACE_FILE);
+    return true;
+  }
+
+  // replay a captured frame against the null backend when requested.
+  if (argc > 2 && std::string(argv[1]) == "--replay") {
+    exitCode = replayCommandCapture(argv[2], REPLAY_COUNT, std::cout) ? 0 : 1;
+    return true;
+  }
+
+  // the software rendering and the mesh conversion use the selected packed vertex layout.
+  auto render = argc > 2 && std::string(argv[1]) == "--render";
+  auto convertMesh = argc > 3 && std::string(argv[1]) == "--convert-mesh";
+  if (!render && !convertMesh) {
+    return false;
+  }
+  VertexLayout vertexLayout;
+  if (!parseVertexLayoutOption(argc, argv, vertexLayout)) {
+    exitCode = 1;
+    return true;
+  }
+
+  // render the frame with the software backend into an image when requested.
+  if (render) {
+    renderSoftwareFrame(getTriangleVertices(), vertexLayout, DRAW_COUNT, WIDTH, HEIGHT, argv[2], std::cout);
+    return true;
+  }
+
+  // convert a Wavefront OBJ file into a mesh file when requested.
+  convertObjToMeshFile(argv[2], argv[3], vertexLayout, std::cout);
+  MeshFile meshFile;
+  if (!meshFile.open(argv[3])) {
+    std::cout << "failed to open the converted mesh file: " << argv[3] << std::endl;
+    exitCode = 1;
+    return true;
+  }
+  std::cout << "converted " << argv[2] << " into " << argv[3] << " with " << meshFile.getMesh().vertexCount << " vertices and " << meshFile.getMesh().indexCount << " indices" << std::endl;
+  return true;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "VertexFormat.h"
+
+#include <vector>
+
+// ============================================================================
+// The commands of the sandbox which need neither a window nor a GPU.
+//
+// The simulations, the replay of a command capture, the software rendering
+// and the mesh conversion only use the portable sources, so they are kept
+// out of the Windows entry point. The Windows build hands the arguments to
+// them before it creates the window, and the portable build (see
+// CMakeLists.txt) runs them from its own entry point on any platform.
+// ============================================================================
+
+// the initial width and height of the window, which is also the size of the software rendered image.
+static const auto WIDTH = 800;
+static const auto HEIGHT = 600;
+
+// the amount of swap chain buffers unless another amount is selected.
+static const auto DEFAULT_BUFFER_COUNT = 2u;
+
+// the maximum amount of frames that the CPU may record ahead of the GPU.
+static const auto FRAMES_IN_FLIGHT = 2u;
+
+// the packed vertex layout of the triangles and the converted meshes unless another one is selected.
+static const auto DEFAULT_VERTEX_LAYOUT = "half";
+
+// the amount of draw calls recorded in each frame.
+static const auto DRAW_COUNT = 4096u;
+
+// the amount of draw calls recorded into each of the parallel recorded command lists.
+static const auto DRAWS_PER_COMMAND_LIST = 256u;
+
+// the name of the file where the profiled frame stages are written.
+static const auto TRACE_FILE = "frame-trace.json";
+
+// ============================================================================
+
+// get the vertices of the triangle which is drawn unless a mesh file is given.
+std::vector<Vertex> getTriangleVertices();
+
+// select the vertex layout given with --vertex-layout, or the default one. returns false if the layout is unknown.
+bool parseVertexLayoutOption(int argc, char* argv[], VertexLayout& layout);
+
+// run the command that the arguments request (--simulate, --replay, --render or --convert-mesh) and set its exit
+// code. returns false if the arguments do not request any of them.
+bool runHeadlessCommand(int argc, char* argv[], int& exitCode);
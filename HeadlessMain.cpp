@@ -0,0 +1,23 @@
+#include "Headless.h"
+
+#include <iostream>
+
+// ============================================================================
+// The entry point of the portable build, which only has the commands that
+// need neither a window nor a GPU. The renderer itself is Main.cpp, which
+// requires Windows and Direct3D 12.
+// ============================================================================
+
+int main(int argc, char* argv[])
+{
+  auto exitCode = 0;
+  if (runHeadlessCommand(argc, argv, exitCode)) {
+    return exitCode;
+  }
+  std::cout << "usage: " << argv[0] << " --simulate" << std::endl;
+  std::cout << "       " << argv[0] << " --replay <capture file>" << std::endl;
+  std::cout << "       " << argv[0] << " --render <image file> [--vertex-layout <layout>]" << std::endl;
+  std::cout << "       " << argv[0] << " --convert-mesh <obj file> <mesh file> [--vertex-layout <layout>]" << std::endl;
+  std::cout << "the renderer itself requires Windows and Direct3D 12." << std::endl;
+  return 1;
+}
@@ -0,0 +1,214 @@
+#include "HeapCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// ============================================================================
+
+// the amount of allocations since the start of the program. a plain global avoids any static initialization order issues.
+static std::atomic<uint64_t> sAllocationCount(0);
+
+// ============================================================================
+
+// allocate the memory from the C runtime and count the allocation.
+static void* allocate(size_t size)
+{
+  sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+  auto memory = std::malloc(size > 0 ? size : 1);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+// ============================================================================
+
+#if defined(__cpp_aligned_new)
+// allocate the over-aligned memory (e.g. of the types declared with alignas) and count the allocation. returns
+// nullptr when the allocation fails.
+static void* allocateAligned(size_t size, std::align_val_t alignment) noexcept
+{
+  sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+#if defined(_WIN32)
+  return _aligned_malloc(size > 0 ? size : 1, static_cast<size_t>(alignment));
+#else
+  void* memory = nullptr;
+  if (posix_memalign(&memory, static_cast<size_t>(alignment), size > 0 ? size : 1) != 0) {
+    return nullptr;
+  }
+  return memory;
+#endif
+}
+
+// ============================================================================
+
+// release the memory of an over-aligned allocation.
+static void freeAligned(void* memory) noexcept
+{
+#if defined(_WIN32)
+  _aligned_free(memory);
+#else
+  std::free(memory);
+#endif
+}
+#endif
+
+// ============================================================================
+
+uint64_t getHeapAllocationCount()
+{
+  return sAllocationCount.load(std::memory_order_relaxed);
+}
+
+// ============================================================================
+
+void* operator new(size_t size)
+{
+  return allocate(size);
+}
+
+// ============================================================================
+
+void* operator new[](size_t size)
+{
+  return allocate(size);
+}
+
+// ============================================================================
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+  sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size > 0 ? size : 1);
+}
+
+// ============================================================================
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+  sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+  return std::malloc(size > 0 ? size : 1);
+}
+
+// ============================================================================
+
+void operator delete(void* memory) noexcept
+{
+  std::free(memory);
+}
+
+// ============================================================================
+
+void operator delete[](void* memory) noexcept
+{
+  std::free(memory);
+}
+
+// ============================================================================
+
+void operator delete(void* memory, size_t) noexcept
+{
+  std::free(memory);
+}
+
+// ============================================================================
+
+void operator delete[](void* memory, size_t) noexcept
+{
+  std::free(memory);
+}
+
+// ============================================================================
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept
+{
+  std::free(memory);
+}
+
+// ============================================================================
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept
+{
+  std::free(memory);
+}
+
+#if defined(__cpp_aligned_new)
+// ============================================================================
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+  auto memory = allocateAligned(size, alignment);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+// ============================================================================
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+  auto memory = allocateAligned(size, alignment);
+  if (memory == nullptr) {
+    throw std::bad_alloc();
+  }
+  return memory;
+}
+
+// ============================================================================
+
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return allocateAligned(size, alignment);
+}
+
+// ============================================================================
+
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+  return allocateAligned(size, alignment);
+}
+
+// ============================================================================
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+  freeAligned(memory);
+}
+
+// ============================================================================
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+  freeAligned(memory);
+}
+
+// ============================================================================
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+  freeAligned(memory);
+}
+
+// ============================================================================
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+  freeAligned(memory);
+}
+
+// ============================================================================
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  freeAligned(memory);
+}
+
+// ============================================================================
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept
+{
+  freeAligned(memory);
+}
+#endif
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+// ============================================================================
+// A counter of the heap allocations made through the global operator new.
+//
+// The operators are replaced for the whole program, so every allocation of
+// the STL containers, std::function and the application itself is counted
+// on all threads, including the over-aligned allocations when the compiler
+// supports them. The frame loop samples the counter at the frame boundaries
+// to report the allocations per frame, which is how the regressions back to
+// the heap are caught in the hot loop. The malloc calls of the C runtime and
+// the drivers are not counted.
+// ============================================================================
+
+// get the amount of heap allocations since the start of the program.
+uint64_t getHeapAllocationCount();
@@ -0,0 +1,274 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// ============================================================================
+
+// the job system and the index of the worker that the current thread belongs to.
+static thread_local const JobSystem* sWorkerSystem = nullptr;
+static thread_local unsigned int sWorkerIndex = 0;
+
+// ============================================================================
+
+JobDeque::JobDeque() : mTop(0), mBottom(0), mJobs(new std::atomic<Job*>[CAPACITY])
+{
+}
+
+// ============================================================================
+
+bool JobDeque::push(Job* job)
+{
+  auto bottom = mBottom.load(std::memory_order_relaxed);
+  auto top = mTop.load(std::memory_order_acquire);
+  if (bottom - top >= CAPACITY) {
+    return false;
+  }
+  mJobs[bottom & (CAPACITY - 1)].store(job, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  mBottom.store(bottom + 1, std::memory_order_relaxed);
+  return true;
+}
+
+// ============================================================================
+
+Job* JobDeque::pop()
+{
+  // reserve the bottom job before checking whether a thief has taken it.
+  auto bottom = mBottom.load(std::memory_order_relaxed) - 1;
+  mBottom.store(bottom, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto top = mTop.load(std::memory_order_relaxed);
+  if (top > bottom) {
+    // the deque was empty.
+    mBottom.store(bottom + 1, std::memory_order_relaxed);
+    return nullptr;
+  }
+
+  auto job = mJobs[bottom & (CAPACITY - 1)].load(std::memory_order_relaxed);
+  if (top == bottom) {
+    // the last job may also be stolen, so race for it with the thieves.
+    if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      job = nullptr;
+    }
+    mBottom.store(bottom + 1, std::memory_order_relaxed);
+  }
+  return job;
+}
+
+// ============================================================================
+
+Job* JobDeque::steal()
+{
+  auto top = mTop.load(std::memory_order_acquire);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  auto bottom = mBottom.load(std::memory_order_acquire);
+  if (top >= bottom) {
+    return nullptr;
+  }
+
+  auto job = mJobs[top & (CAPACITY - 1)].load(std::memory_order_relaxed);
+  if (!mTop.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+    return nullptr;
+  }
+  return job;
+}
+
+// ============================================================================
+
+JobSystem::JobSystem(unsigned int workerCount) : mQueuedJobs(0), mRunning(true)
+{
+  workerCount = std::max(workerCount, 1u);
+  for (auto i = 0u; i < workerCount; i++) {
+    mDeques.push_back(std::unique_ptr<JobDeque>(new JobDeque()));
+    mPools.push_back(std::unique_ptr<JobPool>(new JobPool()));
+  }
+
+  // the creating thread acts as the worker zero.
+  sWorkerSystem = this;
+  sWorkerIndex = 0;
+  for (auto i = 1u; i < workerCount; i++) {
+    mThreads.push_back(std::thread(&JobSystem::work, this, i));
+  }
+}
+
+// ============================================================================
+
+JobSystem::~JobSystem()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRunning = false;
+  }
+  mWakeup.notify_all();
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
+  if (sWorkerSystem == this) {
+    sWorkerSystem = nullptr;
+  }
+}
+
+// ============================================================================
+
+unsigned int JobSystem::getWorkerCount() const
+{
+  return static_cast<unsigned int>(mDeques.size());
+}
+
+// ============================================================================
+
+unsigned int JobSystem::getWorkerIndex() const
+{
+  if (sWorkerSystem != this) {
+    throw new std::runtime_error("The calling thread is not a worker of the job system");
+  }
+  return sWorkerIndex;
+}
+
+// ============================================================================
+
+void JobSystem::run(const std::function<void()>& function, JobCounter* counter)
+{
+  auto job = allocateJob(getWorkerIndex());
+  job->function = function;
+  job->counter = counter;
+  if (counter != nullptr) {
+    counter->fetch_add(1);
+  }
+
+  // execute the job immediately if the deque of the worker is full.
+  mQueuedJobs.fetch_add(1);
+  if (!mDeques[getWorkerIndex()]->push(job)) {
+    mQueuedJobs.fetch_sub(1);
+    execute(job);
+    return;
+  }
+
+  // wake up an idle worker to steal the job.
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+  }
+  mWakeup.notify_one();
+}
+
+// ============================================================================
+
+void JobSystem::wait(const JobCounter& counter)
+{
+  // help executing jobs instead of blocking while the counter is non-zero.
+  while (counter.load() > 0) {
+    if (!runPendingJob()) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+// ============================================================================
+
+bool JobSystem::runPendingJob()
+{
+  auto job = findJob(getWorkerIndex());
+  if (job == nullptr) {
+    return false;
+  }
+  execute(job);
+  return true;
+}
+
+// ============================================================================
+
+void JobSystem::parallelFor(unsigned int count, unsigned int batchSize, const std::function<void(unsigned int begin, unsigned int end)>& function)
+{
+  JobCounter counter(0);
+  batchSize = std::max(batchSize, 1u);
+  for (auto begin = 0u; begin < count; begin += batchSize) {
+    auto end = std::min(begin + batchSize, count);
+    run([&function, begin, end] { function(begin, end); }, &counter);
+  }
+  wait(counter);
+}
+
+// ============================================================================
+
+void JobSystem::work(unsigned int workerIndex)
+{
+  sWorkerSystem = this;
+  sWorkerIndex = workerIndex;
+  while (true) {
+    auto job = findJob(workerIndex);
+    if (job != nullptr) {
+      execute(job);
+      continue;
+    }
+
+    // sleep until there are queued jobs or the job system is being destroyed.
+    std::unique_lock<std::mutex> lock(mMutex);
+    mWakeup.wait(lock, [&] { return mQueuedJobs.load() > 0 || !mRunning; });
+    if (!mRunning) {
+      return;
+    }
+  }
+}
+
+// ============================================================================
+
+Job* JobSystem::findJob(unsigned int workerIndex)
+{
+  // prefer the own deque and then try to steal from the others in a round-robin order.
+  auto job = mDeques[workerIndex]->pop();
+  auto workerCount = getWorkerCount();
+  for (auto i = 1u; job == nullptr && i < workerCount; i++) {
+    job = mDeques[(workerIndex + i) % workerCount]->steal();
+  }
+  if (job != nullptr) {
+    mQueuedJobs.fetch_sub(1);
+  }
+  return job;
+}
+
+// ============================================================================
+
+void JobSystem::execute(Job* job)
+{
+  job->function();
+
+  // release the captured state before the counter, so nothing refers to it when the waiter resumes.
+  job->function = nullptr;
+  auto counter = job->counter;
+  releaseJob(job);
+  if (counter != nullptr) {
+    counter->fetch_sub(1);
+  }
+}
+
+// ============================================================================
+
+Job* JobSystem::allocateJob(unsigned int workerIndex)
+{
+  auto& pool = *mPools[workerIndex];
+  if (pool.freeJobs.empty()) {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.freeJobs.swap(pool.returnedJobs);
+  }
+  if (pool.freeJobs.empty()) {
+    pool.jobs.push_back(std::unique_ptr<Job>(new Job{ nullptr, nullptr, workerIndex }));
+    return pool.jobs.back().get();
+  }
+  auto job = pool.freeJobs.back();
+  pool.freeJobs.pop_back();
+  return job;
+}
+
+// ============================================================================
+
+void JobSystem::releaseJob(Job* job)
+{
+  auto& pool = *mPools[job->owner];
+  if (job->owner == sWorkerIndex) {
+    pool.freeJobs.push_back(job);
+  } else {
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    pool.returnedJobs.push_back(job);
+  }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+
+// a counter which tracks the amount of unfinished jobs in a group.
+typedef std::atomic<unsigned int> JobCounter;
+
+// a single unit of work executed by the job system.
+struct Job
+{
+  std::function<void()> function;
+  JobCounter* counter;
+  // the worker whose pool the job returns to once it has been executed.
+  unsigned int owner;
+};
+
+// ============================================================================
+// A fixed size Chase-Lev work-stealing deque.
+//
+// The owning worker pushes and pops jobs at the bottom without any locks,
+// while other workers steal jobs from the top. The implementation follows
+// "Correct and Efficient Work-Stealing for Weak Memory Models" (Le et al.).
+// ============================================================================
+class JobDeque
+{
+public:
+  // the maximum amount of jobs in the deque. must be a power of two.
+  static const int64_t CAPACITY = 4096;
+
+  JobDeque();
+
+  // push a job at the bottom. returns false if the deque is full. owner only.
+  bool push(Job* job);
+
+  // pop a job from the bottom. returns nullptr if the deque is empty. owner only.
+  Job* pop();
+
+  // steal a job from the top. returns nullptr if the deque is empty or the race was lost.
+  Job* steal();
+
+private:
+  std::atomic<int64_t> mTop;
+  std::atomic<int64_t> mBottom;
+  std::unique_ptr<std::atomic<Job*>[]> mJobs;
+};
+
+// ============================================================================
+// A job system with one worker per core and a work-stealing deque per worker.
+//
+// The thread which creates the job system becomes the worker zero and takes
+// part in executing the jobs while it waits for them to finish. Jobs can only
+// be submitted from the worker threads. The jobs are taken from a pool of the
+// submitting worker and returned to it after the execution, so a steady
+// frame submits its jobs without touching the heap.
+// ============================================================================
+class JobSystem
+{
+public:
+  JobSystem(unsigned int workerCount = std::thread::hardware_concurrency());
+  ~JobSystem();
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  // get the amount of workers including the thread which created the job system.
+  unsigned int getWorkerCount() const;
+
+  // get the index of the calling worker thread.
+  unsigned int getWorkerIndex() const;
+
+  // submit a new job which decrements the counter (if any) when it has been executed.
+  void run(const std::function<void()>& function, JobCounter* counter);
+
+  // execute jobs until the counter reaches zero.
+  void wait(const JobCounter& counter);
+
+  // execute a single job from the own deque or steal one. returns false if no job was found.
+  bool runPendingJob();
+
+  // split the given range into batches, execute them in parallel and wait for them to finish.
+  void parallelFor(unsigned int count, unsigned int batchSize, const std::function<void(unsigned int begin, unsigned int end)>& function);
+
+private:
+  // the function executed by each of the worker threads.
+  void work(unsigned int workerIndex);
+
+  // try to find a job from the own deque or steal one from the other workers.
+  Job* findJob(unsigned int workerIndex);
+
+  // execute the given job and release it.
+  void execute(Job* job);
+
+  // take a job from the pool of the worker or create a new one if the pool is empty.
+  Job* allocateJob(unsigned int workerIndex);
+
+  // return the job into the pool of its owner.
+  void releaseJob(Job* job);
+
+  // the jobs of a worker. the owner takes and returns its jobs without locking, while the other workers return the
+  // jobs they have executed into a locked list which the owner takes over once its own list runs out.
+  struct JobPool
+  {
+    std::vector<std::unique_ptr<Job>> jobs;
+    std::vector<Job*> freeJobs;
+    std::mutex mutex;
+    std::vector<Job*> returnedJobs;
+  };
+
+  std::vector<std::unique_ptr<JobDeque>> mDeques;
+  std::vector<std::unique_ptr<JobPool>> mPools;
+  std::vector<std::thread> mThreads;
+  std::atomic<int> mQueuedJobs;
+  std::atomic<bool> mRunning;
+  std::mutex mMutex;
+  std::condition_variable mWakeup;
+};
@@ -0,0 +1,77 @@
+#include "LinearArena.h"
+
+#include <algorithm>
+
+// ============================================================================
+
+LinearArena::LinearArena(size_t capacity)
+  : mBlock(new uint8_t[capacity]), mCapacity(capacity), mOffset(0), mOverflowSize(0), mOverflowCount(0)
+{
+}
+
+// ============================================================================
+
+void* LinearArena::allocate(size_t size, size_t alignment)
+{
+  // align the absolute address, because the block itself is only aligned for the fundamental types.
+  auto base = reinterpret_cast<uintptr_t>(mBlock.get());
+  auto start = ((base + mOffset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1)) - base;
+  if (start + size <= mCapacity) {
+    mOffset = start + size;
+    return mBlock.get() + start;
+  }
+
+  // serve the allocation from the heap until the next reset grows the block.
+  std::unique_ptr<uint8_t[]> overflow(new uint8_t[size + alignment - 1]);
+  auto address = (reinterpret_cast<uintptr_t>(overflow.get()) + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+  mOverflows.push_back(std::move(overflow));
+  mOverflowSize += size + alignment - 1;
+  mOverflowCount++;
+  return reinterpret_cast<void*>(address);
+}
+
+// ============================================================================
+
+void LinearArena::deallocate(void* memory, size_t size)
+{
+  // only the allocation at the end of the block can be taken back, which covers the containers local to a loop
+  // body. everything else is released by the reset.
+  auto end = static_cast<uint8_t*>(memory) + size;
+  if (end == mBlock.get() + mOffset) {
+    mOffset = static_cast<size_t>(static_cast<uint8_t*>(memory) - mBlock.get());
+  }
+}
+
+// ============================================================================
+
+void LinearArena::reset()
+{
+  if (mOverflowSize > 0) {
+    mCapacity = std::max(mCapacity * 2, mOffset + mOverflowSize);
+    mBlock.reset(new uint8_t[mCapacity]);
+    mOverflows.clear();
+    mOverflowSize = 0;
+  }
+  mOffset = 0;
+}
+
+// ============================================================================
+
+size_t LinearArena::getCapacity() const
+{
+  return mCapacity;
+}
+
+// ============================================================================
+
+size_t LinearArena::getUsedSize() const
+{
+  return mOffset + mOverflowSize;
+}
+
+// ============================================================================
+
+uint64_t LinearArena::getOverflowCount() const
+{
+  return mOverflowCount;
+}
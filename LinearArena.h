@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// ============================================================================
+// A linear (bump) allocator for the transient CPU allocations of a frame.
+//
+// The allocations are carved out of a single block by advancing an offset
+// and they are all released at once when the arena is reset. The frame loop
+// keeps an arena for each frame in flight (and worker) and resets it when the
+// fence of its previous frame has been reached, which is the same life time
+// as the command allocators have. Allocations which don't fit into the block
+// are served from the heap for the rest of the frame and the block is grown
+// to the peak usage on the next reset, so a steady frame stops touching the
+// heap after its first frames. The arena is not thread-safe.
+// ============================================================================
+class LinearArena
+{
+public:
+  LinearArena(size_t capacity);
+
+  LinearArena(const LinearArena&) = delete;
+  LinearArena& operator=(const LinearArena&) = delete;
+  LinearArena(LinearArena&&) = default;
+  LinearArena& operator=(LinearArena&&) = default;
+
+  // allocate memory with the given alignment, which must be a power of two.
+  void* allocate(size_t size, size_t alignment);
+
+  // release the given allocation. only the most recent allocation is actually released, the others are kept until the reset.
+  void deallocate(void* memory, size_t size);
+
+  // release all allocations and grow the block if the previous frame did not fit into it.
+  void reset();
+
+  // get the size of the block.
+  size_t getCapacity() const;
+
+  // get the amount of memory allocated since the last reset including the overflowing allocations.
+  size_t getUsedSize() const;
+
+  // get the amount of allocations since the creation which did not fit into the block.
+  uint64_t getOverflowCount() const;
+
+private:
+  std::unique_ptr<uint8_t[]> mBlock;
+  size_t mCapacity;
+  size_t mOffset;
+  // the allocations served from the heap since the last reset and their total size.
+  std::vector<std::unique_ptr<uint8_t[]>> mOverflows;
+  size_t mOverflowSize;
+  uint64_t mOverflowCount;
+};
+
+// ============================================================================
+
+// an STL allocator which allocates from a linear arena. a default constructed allocator uses the heap, so the
+// containers using it can still be used outside of the frame (e.g. in the tools and simulations).
+template<class T>
+class ArenaAllocator
+{
+public:
+  typedef T value_type;
+
+  ArenaAllocator() : mArena(nullptr)
+  {
+  }
+
+  ArenaAllocator(LinearArena& arena) : mArena(&arena)
+  {
+  }
+
+  template<class U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : mArena(other.getArena())
+  {
+  }
+
+  T* allocate(size_t count)
+  {
+    if (mArena == nullptr) {
+      return static_cast<T*>(::operator new(count * sizeof(T)));
+    }
+    return static_cast<T*>(mArena->allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* memory, size_t count)
+  {
+    if (mArena == nullptr) {
+      ::operator delete(memory);
+    } else {
+      mArena->deallocate(memory, count * sizeof(T));
+    }
+  }
+
+  // get the arena of the allocator or nullptr if it uses the heap.
+  LinearArena* getArena() const
+  {
+    return mArena;
+  }
+
+private:
+  LinearArena* mArena;
+};
+
+template<class T, class U>
+bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+  return a.getArena() == b.getArena();
+}
+
+template<class T, class U>
+bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+{
+  return a.getArena() != b.getArena();
+}
+
+// a vector whose memory comes from a linear arena (or the heap when default constructed).
+template<class T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
@@ -1,891 +1,1844 @@
-// include windows headers without unnecessary APIs.
-#define WIN32_LEAN_AND_MEAN
-#include <Windows.h>
-#include <wrl.h>
-
-// undefine min macro and use the std::min from the <algorithm>
-#if defined(min)
-#undef min
-#endif
-
-// undefine max macro and use the std::max from the <algorithm>
-#if defined(max)
-#undef max
-#endif
-
-// a helper macro to allow writing shader code as a multiline string.
-#define SHADER(CODE) #CODE
-
-// include the required DirectX headers.
-#include <d3d12.h>
-#include <dxgi1_6.h>
-#include <d3dcompiler.h>
-
-#include <algorithm>
-#include <array>
-#include <chrono>
-#include <iostream>
-#include <vector>
-
-// ============================================================================
-
-#pragma comment(lib, "d3d12.lib")
-#pragma comment(lib, "dxgi.lib")
-#pragma comment(lib, "d3dcompiler.lib")
-
-// ============================================================================
-
-using namespace Microsoft::WRL;
-using namespace std::chrono;
-
-// ============================================================================
-
-// the name of the window class required by the WINAPI.
-static const auto CLASS_NAME = "DX12-SANDBOX-WC";
-
-// the initial width of the window.
-static const auto WIDTH = 800;
-// the initial height of the window.
-static const auto HEIGHT = 600;
-
-// the amount of swap chain buffers.
-static const auto BUFFER_COUNT = 2;
-
-// ============================================================================
-
-struct Vertex
-{
-  std::array<float, 3> position;
-  std::array<float, 4> color;
-};
-
-// ============================================================================
-
-LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
-{
-  switch (msg) {
-    case WM_CLOSE:
-      DestroyWindow(hwnd);
-      break;
-    case WM_DESTROY:
-      PostQuitMessage(0);
-      break;
-    case WM_KEYDOWN:
-      switch (wParam) {
-        case VK_ESCAPE:
-          PostQuitMessage(0);
-          break;
-      }
-      break;
-    default:
-      return DefWindowProc(hwnd, msg, wParam, lParam);
-  }
-  return 0;
-}
-
-// ============================================================================
-
-void registerWindowClass()
-{
-  // construct a new empty window class descriptor.
-  WNDCLASSEX windowClass = {};
-
-  // specify the desired window class definitions.
-  windowClass.cbClsExtra = 0;
-  windowClass.cbSize = sizeof(WNDCLASSEX);
-  windowClass.cbWndExtra = 0;
-  windowClass.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
-  windowClass.hCursor = LoadCursor(nullptr, IDC_ARROW);
-  windowClass.hIcon = LoadIcon(nullptr, IDI_APPLICATION);
-  windowClass.hIconSm = LoadIcon(GetModuleHandle(nullptr), nullptr);
-  windowClass.hInstance = GetModuleHandle(nullptr);
-  windowClass.lpfnWndProc = WndProc;
-  windowClass.lpszMenuName = nullptr;
-  windowClass.lpszClassName = CLASS_NAME;
-  windowClass.style = CS_HREDRAW | CS_VREDRAW;
-
-  // try to register the window class and check results.
-  if (RegisterClassEx(&windowClass) == 0) {
-    std::cout << "RegisterClassEx: " << GetLastError() << std::endl;
-    throw new std::runtime_error("Window class registration failed");
-  }
-}
-
-// ============================================================================
-
-void unregisterWindowClass()
-{
-  // try to unregister the window class and check results.
-  if (UnregisterClass(CLASS_NAME, GetModuleHandle(nullptr)) == 0) {
-    std::cout << "UnregisterClass: " << GetLastError() << std::endl;
-    throw new std::runtime_error("Window class unregistration failed");
-  }
-}
-
-// ============================================================================
-
-HWND createWindow()
-{
-  // construct a new window with the desired definitions.
-  HWND hwnd = CreateWindowEx(
-    WS_EX_CLIENTEDGE,
-    CLASS_NAME,
-    "DirectX 12 - Sandbox",
-    WS_OVERLAPPEDWINDOW,
-    CW_USEDEFAULT,
-    CW_USEDEFAULT,
-    WIDTH,
-    HEIGHT,
-    nullptr,
-    nullptr,
-    GetModuleHandle(nullptr),
-    nullptr);
-
-  // check how the operation succeeded.
-  if (hwnd == nullptr) {
-    std::cout << "CreateWindowEx: " << GetLastError() << std::endl;
-    throw new std::runtime_error("Window creation failed");
-  }
-
-  // operation succeeded...
-  return hwnd;
-}
-
-// ============================================================================
-
-void destroyWindow(HWND hwnd)
-{
-  // try to destroy the given window and check results.
-  if (IsWindow(hwnd) && DestroyWindow(hwnd) == 0) {
-    std::cout << "DestroyWindow: " << GetLastError() << std::endl;
-    throw new std::runtime_error("Window destruction failed");
-  }
-}
-
-// ============================================================================
-
-void enableDXDebugging()
-{
-  // try to catch a reference to the DX12 debug layer.
-  ComPtr<ID3D12Debug> debug;
-  auto result = D3D12GetDebugInterface(IID_PPV_ARGS(&debug));
-  if (FAILED(result)) {
-    std::cout << "D3D12GetDebugInterface: " << result << std::endl;
-    throw new std::runtime_error("Failed to access DX12 debug layer");
-  }
-
-  // enable the debugging layer.
-  debug->EnableDebugLayer();
-}
-
-// ============================================================================
-
-ComPtr<IDXGIAdapter4> selectDXGIAdapter()
-{
-  // specify debug flag when building in a debug mode.
-  auto flags = 0u;
-  #if defined(_DEBUG)
-  flags = DXGI_CREATE_FACTORY_DEBUG;
-  #endif
-
-  // try to create a factory for DXGI instances.
-  ComPtr<IDXGIFactory4> factory;
-  auto result = CreateDXGIFactory2(flags, IID_PPV_ARGS(&factory));
-  if (FAILED(result)) {
-    std::cout << "CreateDXGIFactory2: " << result << std::endl;
-    throw new std::runtime_error("DXGI factory creation failed");
-  }
-
-  // enumerate adapters and find the one with most dedicated video memory.
-  auto maxVideoMemory = 0u;
-  ComPtr<IDXGIAdapter1> adapter1;
-  ComPtr<IDXGIAdapter4> adapter4;
-  for (auto i = 0u; factory->EnumAdapters1(i, &adapter1) != DXGI_ERROR_NOT_FOUND; ++i) {
-    // get the adapter descriptor info item.
-    DXGI_ADAPTER_DESC1 descriptor;
-    adapter1->GetDesc1(&descriptor);
-
-    // skip software emulation based adapters.
-    if ((descriptor.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) != 0)
-      continue;
-
-    // skip adapters that cannot be created.
-    if (FAILED(D3D12CreateDevice(adapter1.Get(), D3D_FEATURE_LEVEL_12_0, __uuidof(ID3D12Device), nullptr)))
-      continue;
-
-    // skip adapters which have less memory than the current maximum.
-    if (descriptor.DedicatedVideoMemory < maxVideoMemory)
-      continue;
-
-    // we found a good candidate as the selected adapter.
-    result = adapter1.As(&adapter4);
-    if (FAILED(result)) {
-      std::cout << "IDXGIAdapter1.As: " << result << std::endl;
-      throw new std::runtime_error("Failed to cast DXGIAdapter1 to DXGIAdapter4");
-    }
-  }
-
-  // return the result.
-  return adapter4;
-}
-
-// ============================================================================
-
-ComPtr<ID3D12Device> createDXDevice(ComPtr<IDXGIAdapter4> adapter)
-{
-  // try to create a new DX12 device from the provided adapter.
-  ComPtr<ID3D12Device2> device;
-  auto result = D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device));
-  if (FAILED(result)) {
-    std::cout << "D3D12CreateDevice: " << result << std::endl;
-    throw new std::runtime_error("Failed to create DX12 device");
-  }
-
-  #if defined(_DEBUG)
-  // try to access the DX12 device info queue.
-  ComPtr<ID3D12InfoQueue> infoQueue;
-  if (SUCCEEDED(device.As(&infoQueue))) {
-    // tell queue that we want to break when something goes wrong.
-    infoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_CORRUPTION, true);
-    infoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_ERROR, true);
-    infoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_WARNING, true);
-
-    // create an array of severity levels to be ignored.
-    std::vector<D3D12_MESSAGE_SEVERITY> severities = { D3D12_MESSAGE_SEVERITY_INFO };
-
-    // create an array to ignore non-critical warnings.
-    std::vector<D3D12_MESSAGE_ID> deniedIds = {
-      D3D12_MESSAGE_ID_CLEARDEPTHSTENCILVIEW_MISMATCHINGCLEARVALUE,
-      D3D12_MESSAGE_ID_MAP_INVALID_NULLRANGE,
-      D3D12_MESSAGE_ID_UNMAP_INVALID_NULLRANGE
-    };
-
-    // construct a queue filter to ignore certain severity levels and warnings.
-    D3D12_INFO_QUEUE_FILTER filter = {};
-    filter.DenyList.NumSeverities = severities.size();
-    filter.DenyList.pSeverityList = &severities[0];
-    filter.DenyList.NumIDs = deniedIds.size();
-    filter.DenyList.pIDList = &deniedIds[0];
-
-    // try to activate the created queue filter.
-    result = infoQueue->PushStorageFilter(&filter);
-    if (FAILED(result)) {
-      std::cout << "infoQueue->PushStorageFilter: " << result << std::endl;
-      throw new std::runtime_error("Failed to activate DX12 info queue filter");
-    }
-  }
-  #endif
-
-  return device;
-}
-
-// ============================================================================
-
-ComPtr<ID3D12CommandQueue> createDXCommandQueue(ComPtr<ID3D12Device> device)
-{
-  // create a descriptor for the command queue.
-  D3D12_COMMAND_QUEUE_DESC descriptor = {};
-  descriptor.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
-  descriptor.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
-  descriptor.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-  descriptor.NodeMask = 0;
-
-  // try to create a new command queue for the target device.
-  ComPtr<ID3D12CommandQueue> commandQueue;
-  auto result = device->CreateCommandQueue(&descriptor, IID_PPV_ARGS(&commandQueue));
-  if (FAILED(result)) {
-    std::cout << "device->CreateCommandQueue: " << result << std::endl;
-    throw new std::runtime_error("Failed to create command queue");
-  }
-
-  return commandQueue;
-}
-
-// ============================================================================
-
-ComPtr<IDXGISwapChain4> createDXGISwapChain(HWND hwnd, ComPtr<ID3D12CommandQueue> commandQueue)
-{
-  // specify debug flag when building in a debug mode.
-  auto flags = 0u;
-  #if defined(_DEBUG)
-  flags = DXGI_CREATE_FACTORY_DEBUG;
-  #endif
-
-  // try to create a factory for DXGI instances.
-  ComPtr<IDXGIFactory4> factory;
-  auto result = CreateDXGIFactory2(flags, IID_PPV_ARGS(&factory));
-  if (FAILED(result)) {
-    std::cout << "CreateDXGIFactory2: " << result << std::endl;
-    throw new std::runtime_error("DXGI factory creation failed");
-  }
-
-  // create a descriptor for the swap chain.
-  DXGI_SWAP_CHAIN_DESC1 descriptor = {};
-  descriptor.Width = WIDTH;
-  descriptor.Height = HEIGHT;
-  descriptor.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-  descriptor.Stereo = false;
-  descriptor.SampleDesc = { 1, 0 };
-  descriptor.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-  descriptor.BufferCount = BUFFER_COUNT;
-  descriptor.Scaling = DXGI_SCALING_STRETCH;
-  descriptor.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-  descriptor.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
-  descriptor.Flags = 0;
-
-  // try to create the swap chain.
-  ComPtr<IDXGISwapChain1> swapChain;
-  result = factory->CreateSwapChainForHwnd(commandQueue.Get(), hwnd, &descriptor, nullptr, nullptr, &swapChain);
-  if (FAILED(result)) {
-    std::cout << "factory->CreateSwapChainForHwnd: " << result << std::endl;
-    throw new std::runtime_error("Failed to create DXGI swap chain");
-  }
-
-  // cast the created swap chain into correct version.
-  ComPtr<IDXGISwapChain4> swapChain4;
-  result = swapChain.As(&swapChain4);
-  if (FAILED(result)) {
-    std::cout << "swapChain.As: " << result << std::endl;
-    throw new std::runtime_error("Failed to cast DXGISwapChain1 to DXGISwapChain4");
-  }
-
-  return swapChain4;
-}
-
-// ============================================================================
-
-ComPtr<ID3D12DescriptorHeap> createDXDescriptorHeap(ComPtr<ID3D12Device> device, D3D12_DESCRIPTOR_HEAP_TYPE type)
-{
-  // create a descriptor for the descriptor heap.
-  D3D12_DESCRIPTOR_HEAP_DESC descriptor = {};
-  descriptor.NumDescriptors = BUFFER_COUNT;
-  descriptor.Type = type;
-
-  // try to create the descriptor heap.
-  ComPtr<ID3D12DescriptorHeap> descriptorHeap;
-  auto result = device->CreateDescriptorHeap(&descriptor, IID_PPV_ARGS(&descriptorHeap));
-  if (FAILED(result)) {
-    std::cout << "device->CreateDescriptorHeap: " << result << std::endl;
-    throw new std::runtime_error("Failed to create descriptor heap");
-  }
-
-  return descriptorHeap;
-}
-
-// ============================================================================
-
-std::vector<ComPtr<ID3D12CommandAllocator>> createDXCommandAllocators(ComPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type)
-{
-  // try to create new command allocators.
-  std::vector<ComPtr<ID3D12CommandAllocator>> commandAllocators;
-  for (int i = 0; i < BUFFER_COUNT; i++) {
-    ComPtr<ID3D12CommandAllocator> allocator;
-    auto result = device->CreateCommandAllocator(type, IID_PPV_ARGS(&allocator));
-    if (FAILED(result)) {
-      std::cout << "device->CreateCommandAllocator: " << result << std::endl;
-      throw new std::runtime_error("Failed to create command allocator");
-    }
-    commandAllocators.push_back(allocator);
-  }
-  return commandAllocators;
-}
-
-// ============================================================================
-
-ComPtr<ID3D12GraphicsCommandList> createDXCommandList(ComPtr<ID3D12Device> device, ComPtr<ID3D12CommandAllocator> commandAllocator, ComPtr<ID3D12PipelineState> state)
-{
-  // try to create a new command list.
-  ComPtr<ID3D12GraphicsCommandList> commandList;
-  auto result = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator.Get(), state.Get(), IID_PPV_ARGS(&commandList));
-  if (FAILED(result)) {
-    std::cout << "device->CreateCommandList: " << result << std::endl;
-    throw new std::runtime_error("Failed to create command list");
-  }
-
-  // close the command list to stop recording commands for now.
-  result = commandList->Close();
-  if (FAILED(result)) {
-    std::cout << "commandList->Close: " << result << std::endl;
-  }
-
-  return commandList;
-}
-
-// ============================================================================
-
-ComPtr<ID3D12Fence> createDXFence(ComPtr<ID3D12Device> device)
-{
-  // try to create a new fence for the target device.
-  ComPtr<ID3D12Fence> fence;
-  auto result = device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence));
-  if (FAILED(result)) {
-    std::cout << "device->CreateFence: " << result << std::endl;
-    throw new std::runtime_error("Failed to create a new fence");
-  }
-
-  return fence;
-}
-
-// ============================================================================
-
-HANDLE createEvent()
-{
-  auto event = CreateEvent(nullptr, false, false, nullptr);
-  if (event == nullptr) {
-    std::cout << "CreateEvent failed" << std::endl;
-    throw new std::runtime_error("Failed to create new event");
-  }
-
-  return event;
-}
-
-// ============================================================================
-
-void waitFence(ComPtr<ID3D12Fence> fence, uint64_t fenceValue, HANDLE event, milliseconds duration)
-{
-  if (fence->GetCompletedValue() < fenceValue)
-  {
-    // specify which event to trigger after fence has been finished.
-    auto result = fence->SetEventOnCompletion(fenceValue, event);
-    if (FAILED(result)) {
-      std::cout << "fence->SetEventOnCompletion: " << result << std::endl;
-      throw new std::runtime_error("Failed to set event for fence completion");
-    }
-
-    // wait for a signal or until the given duration has elapsed.
-    WaitForSingleObject(event, static_cast<DWORD>(duration.count()));
-  }
-}
-
-// ============================================================================
-
-uint64_t signalFence(ComPtr<ID3D12CommandQueue> commandQueue, ComPtr<ID3D12Fence> fence, uint64_t& value)
-{
-  // increment the fence value to indicate a new signal.
-  uint64_t signalValue = ++value;
-
-  // try to signal the fence with the incremented signal value.
-  auto result = commandQueue->Signal(fence.Get(), signalValue);
-  if (FAILED(result)) {
-    std::cout << "commandQueue->Signal: " << result << std::endl;
-    throw new std::runtime_error("Failed to signal fence");
-  }
-
-  return signalValue;
-}
-
-// ============================================================================
-
-void flush(ComPtr<ID3D12CommandQueue> commandQueue, ComPtr<ID3D12Fence> fence, uint64_t& value, HANDLE event)
-{
-  auto signalValue = signalFence(commandQueue, fence, value);
-  waitFence(fence, signalValue, event, milliseconds::max());
-}
-
-// ============================================================================
-
-std::vector<ComPtr<ID3D12Resource>> createRenderTargets(ComPtr<ID3D12Device> device, ComPtr<IDXGISwapChain4> swapChain, ComPtr<ID3D12DescriptorHeap> descriptorHeap)
-{
-  // get the size of the render target descriptor and the position where heap starts.
-  auto descriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-  auto rtvHeap = descriptorHeap->GetCPUDescriptorHandleForHeapStart();
-
-  // construct a new render tager view for each buffer.
-  std::vector<ComPtr<ID3D12Resource>> renderTargets;
-  for (int i = 0; i < BUFFER_COUNT; i++) {
-    // get a buffer pointer from the swap chain.
-    ComPtr<ID3D12Resource> buffer;
-    auto result = swapChain->GetBuffer(i, IID_PPV_ARGS(&buffer));
-    if (FAILED(result)) {
-      std::cout << "swapChain->GetBuffer: " << result << std::endl;
-      throw new std::runtime_error("Failed to get buffer pointer from the swap chain");
-    }
-
-    // create a new render target view and add it into the buffer list.
-    device->CreateRenderTargetView(buffer.Get(), nullptr, rtvHeap);
-    renderTargets.push_back(buffer);
-
-    // proceed rtv heap pointer to point on the next descriptor.
-    rtvHeap.ptr += descriptorSize;
-  }
-
-  return renderTargets;
-}
-
-// ============================================================================
-
-ComPtr<ID3D12RootSignature> createRootSignature(ComPtr<ID3D12Device> device)
-{
-  // create a desciptor for the root signature.
-  D3D12_ROOT_SIGNATURE_DESC descriptor = {};
-  descriptor.NumParameters = 0;
-  descriptor.pParameters = nullptr;
-  descriptor.NumStaticSamplers = 0;
-  descriptor.pStaticSamplers = nullptr;
-  descriptor.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
-
-  // try to serialize a new root signature. 
-  ComPtr<ID3DBlob> signature;
-  ComPtr<ID3DBlob> error;
-  auto result = D3D12SerializeRootSignature(&descriptor, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error);
-  if (FAILED(result)) {
-    std::cout << "D3D12SerializeRootSignature: " << result << std::endl;
-    throw new std::runtime_error("Failed to create root signature");
-  }
-
-  // try to create the new root signature.
-  ComPtr<ID3D12RootSignature> rootSignature;
-  result = device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature));
-  if (FAILED(result)) {
-    std::cout << "device->CreateRootSignature: " << result << std::endl;
-    throw new std::runtime_error("Failed to create root signature");
-  }
-
-  return rootSignature;
-}
-
-// ============================================================================
-
-ComPtr<ID3D12PipelineState> createPipelineState(ComPtr<ID3D12Device> device, ComPtr<ID3D12RootSignature> rootSignature)
-{
-  // enable debug flags if debug mode is being used.
-  #if defined(_DEBUG)
-  unsigned int flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-  #else
-  unsigned int flags = 0;
-  #endif
-
-  // the source code for our shaders.
-  auto src = SHADER(
-    struct PSInput
-    {
-      float4 position : SV_POSITION;
-      float4 color : COLOR;
-    };
-
-    PSInput VSMain(float4 position : POSITION, float4 color : COLOR)
-    {
-      PSInput result;
-      result.position = position;
-      result.color = color;
-      return result;
-    }
-
-    float4 PSMain(PSInput input) : SV_TARGET
-    {
-      return input.color;
-    }
-  );
-
-  // try to compile the vertex shader.
-  ComPtr<ID3DBlob> vertexShader;
-  ComPtr<ID3DBlob> error;
-  auto result = D3DCompile(src, strlen(src), "", nullptr, nullptr, "VSMain", "vs_5_0", flags, 0, &vertexShader, &error);
-  if (FAILED(result)) {
-    std::cout << "D3DCompileFromFile (VS): " << result << std::endl;
-    if (error != nullptr) {
-      std::cout << (char*)error->GetBufferPointer() << std::endl;
-    }
-    throw new std::runtime_error("Failed to compile vertex shader");
-  }
-
-  // try to compile the pixel shader.
-  ComPtr<ID3DBlob> pixelShader;
-  result = D3DCompile(src, strlen(src), "", nullptr, nullptr, "PSMain", "ps_5_0", flags, 0, &pixelShader, &error);
-  if (FAILED(result)) {
-    std::cout << "D3DCompileFromFile (PS): " << result << std::endl;
-    if (error != nullptr) {
-      std::cout << (char*)error->GetBufferPointer() << std::endl;
-    }
-    throw new std::runtime_error("Failed to compile pixel shader");
-  }
-  
-  // define the layout for the input vertex data.
-  std::vector<D3D12_INPUT_ELEMENT_DESC> inputDescriptor = {
-    {
-      "POSITION",
-      0,
-      DXGI_FORMAT_R32G32B32_FLOAT,
-      0,
-      0,
-      D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
-      0
-    },
-    {
-      "COLOR",
-      0,
-      DXGI_FORMAT_R32G32B32A32_FLOAT,
-      0,
-      12,
-      D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA
-    }
-  };
-
-  // create a descriptor for the rasterizer state (derived from CD3DX12_RASTERIZER_DESC(CD3DX12_DEFAULT))
-  D3D12_RASTERIZER_DESC rasterizerDescriptor = {};
-  rasterizerDescriptor.FillMode = D3D12_FILL_MODE_SOLID;
-  rasterizerDescriptor.CullMode = D3D12_CULL_MODE_BACK;
-  rasterizerDescriptor.FrontCounterClockwise = false;
-  rasterizerDescriptor.DepthBias = D3D12_DEFAULT_DEPTH_BIAS;
-  rasterizerDescriptor.DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
-  rasterizerDescriptor.SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
-  rasterizerDescriptor.DepthClipEnable = true;
-  rasterizerDescriptor.MultisampleEnable = false;
-  rasterizerDescriptor.AntialiasedLineEnable = false;
-  rasterizerDescriptor.ForcedSampleCount = 0;
-  rasterizerDescriptor.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
-
-  // create a descriptor for the blend state (derived from CD3DX12_BLEND_DESC(CD3DX12_DEFAULT))
-  D3D12_BLEND_DESC blendDescriptor = {};
-  blendDescriptor.AlphaToCoverageEnable = false;
-  blendDescriptor.IndependentBlendEnable = false;
-  blendDescriptor.RenderTarget[0].BlendEnable = false;
-  blendDescriptor.RenderTarget[0].LogicOpEnable = false;
-  blendDescriptor.RenderTarget[0].SrcBlend = D3D12_BLEND_ONE;
-  blendDescriptor.RenderTarget[0].DestBlend = D3D12_BLEND_ZERO;
-  blendDescriptor.RenderTarget[0].BlendOp = D3D12_BLEND_OP_ADD;
-  blendDescriptor.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_ONE;
-  blendDescriptor.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_ZERO;
-  blendDescriptor.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_ADD;
-  blendDescriptor.RenderTarget[0].LogicOp = D3D12_LOGIC_OP_NOOP;
-  blendDescriptor.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
-
-  // create a desciptor for the pipeline state object.
-  D3D12_GRAPHICS_PIPELINE_STATE_DESC descriptor = {};
-  descriptor.InputLayout = { &inputDescriptor[0], inputDescriptor.size() };
-  descriptor.pRootSignature = rootSignature.Get();
-  descriptor.VS = { reinterpret_cast<UINT8*>(vertexShader->GetBufferPointer()), vertexShader->GetBufferSize() };
-  descriptor.PS = { reinterpret_cast<UINT8*>(pixelShader->GetBufferPointer()), pixelShader->GetBufferSize() };
-  descriptor.RasterizerState = rasterizerDescriptor;
-  descriptor.BlendState = blendDescriptor;
-  descriptor.DepthStencilState.DepthEnable = false;
-  descriptor.DepthStencilState.StencilEnable = false;
-  descriptor.SampleMask = UINT_MAX;
-  descriptor.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-  descriptor.NumRenderTargets = 1;
-  descriptor.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-  descriptor.SampleDesc.Count = 1;
-
-  // try to create a new pipelin state with the given descriptor.
-  ComPtr<ID3D12PipelineState> pipelineState;
-  result = device->CreateGraphicsPipelineState(&descriptor, IID_PPV_ARGS(&pipelineState));
-  if (FAILED(result)) {
-    std::cout << "device->CreateGraphicsPipelineState: " << result << std::endl;
-    throw new std::runtime_error("Failed to create a new graphics pipeline state");
-  }
-
-  return pipelineState;
-}
-
-// ============================================================================
-
-ComPtr<ID3D12Resource> createVertexBuffer(ComPtr<ID3D12Device> device, ComPtr<ID3D12CommandQueue> commandQueue)
-{
-  // construct the required vertices for a simple triangle.
-  std::vector<Vertex> vertices = {
-    {{  0.0f,  0.5f, 0.0f }, { 1.f, 0.f, 0.f, 1.f }},
-    {{  0.5f, -0.5f, 0.0f }, { 0.f, 1.f, 0.f, 1.f }},
-    {{ -0.5f, -0.5f, 0.0f }, { 0.f, 0.f, 1.f, 1.f }}
-  };
-
-  // construct properties for the upload heap.
-  D3D12_HEAP_PROPERTIES heapProperties = {};
-  heapProperties.Type = D3D12_HEAP_TYPE_UPLOAD;
-  heapProperties.CreationNodeMask = 1;
-  heapProperties.VisibleNodeMask = 1;
-  heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-  heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-
-  // construct a descriptor for a vertex buffer (derived from CD3DX12_RESOURCE_DESC).
-  D3D12_RESOURCE_DESC resourceDescriptor = {};
-  resourceDescriptor.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
-  resourceDescriptor.Alignment = 0;
-  resourceDescriptor.Width = sizeof(Vertex) * vertices.size();
-  resourceDescriptor.Height = 1;
-  resourceDescriptor.DepthOrArraySize = 1;
-  resourceDescriptor.MipLevels = 1;
-  resourceDescriptor.Format = DXGI_FORMAT_UNKNOWN;
-  resourceDescriptor.SampleDesc.Count = 1;
-  resourceDescriptor.SampleDesc.Quality = 0;
-  resourceDescriptor.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
-  resourceDescriptor.Flags = D3D12_RESOURCE_FLAG_NONE;
-
-  // allocate a new committed resource for the vertex buffer.
-  ComPtr<ID3D12Resource> vertexBuffer;
-  auto result = device->CreateCommittedResource(
-    &heapProperties,
-    D3D12_HEAP_FLAG_NONE,
-    &resourceDescriptor,
-    D3D12_RESOURCE_STATE_GENERIC_READ,
-    nullptr,
-    IID_PPV_ARGS(&vertexBuffer));
-  if (FAILED(result)) {
-    std::cout << "device->CreateCommittedResource: " << result << std::endl;
-    throw new std::runtime_error("Failed to create committed resource");
-  }
-
-  // assign the vertices into the vertex buffer.
-  unsigned char* data(0);
-  D3D12_RANGE range = {};
-  result = vertexBuffer->Map(0, &range, reinterpret_cast<void**>(&data));
-  if (FAILED(result)) {
-    std::cout << "vertexBuffer->Map: " << result << std::endl;
-    throw new std::runtime_error("Failed to map vertex buffer memory");
-  }
-  memcpy(data, &vertices[0], sizeof(Vertex) * vertices.size());
-  vertexBuffer->Unmap(0, nullptr);
-
-  // wait until the provided vertices have been uploaded to GPU.
-  auto fence = createDXFence(device);
-  uint64_t fenceValue = 1;
-  auto fenceEvent = createEvent();
-  flush(commandQueue, fence, fenceValue, fenceEvent);
-
-  return vertexBuffer;
-}
-
-// ============================================================================
-
-int main()
-{
-  #if defined(_DEBUG)
-  enableDXDebugging();
-  #endif
-
-  registerWindowClass();
-  auto hwnd = createWindow();
-  auto adapter = selectDXGIAdapter();
-  auto device = createDXDevice(adapter);
-  auto commandQueue = createDXCommandQueue(device);
-  auto swapChain = createDXGISwapChain(hwnd, commandQueue);
-  auto descriptorHeap = createDXDescriptorHeap(device, D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-  auto renderTargets = createRenderTargets(device, swapChain, descriptorHeap);
-  auto commandAllocators = createDXCommandAllocators(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
-  auto rootSignature = createRootSignature(device);
-  auto pipelineState = createPipelineState(device, rootSignature);
-  auto commandList = createDXCommandList(device, commandAllocators[0], pipelineState);
-  auto vertexBuffer = createVertexBuffer(device, commandQueue);
-  auto fence = createDXFence(device);
-  auto fenceEvent = createEvent();
-  uint64_t fenceValue = 0u;
-
-  // set the window visible.
-  ShowWindow(hwnd, SW_SHOW);
-
-  // get the index of the currently active back buffer.
-  auto bufferIndex = swapChain->GetCurrentBackBufferIndex();
-
-  // create a vertex buffer view from the vertex buffer definitionss.
-  D3D12_VERTEX_BUFFER_VIEW vertexBufferView;
-  vertexBufferView.BufferLocation = vertexBuffer->GetGPUVirtualAddress();
-  vertexBufferView.StrideInBytes = sizeof(Vertex);
-  vertexBufferView.SizeInBytes = sizeof(Vertex) * 3;
-
-  // create a viewport definition.
-  D3D12_VIEWPORT viewport = {};
-  viewport.MaxDepth = D3D12_MAX_DEPTH;
-  viewport.MinDepth = D3D12_MIN_DEPTH;
-  viewport.TopLeftX = 0;
-  viewport.TopLeftY = 0;
-  viewport.Width = WIDTH;
-  viewport.Height = HEIGHT;
-
-  // create a scissor rect definition.
-  D3D12_RECT scissorRect = {};
-  scissorRect.left = 0;
-  scissorRect.top = 0;
-  scissorRect.right = LONG_MAX;
-  scissorRect.bottom = LONG_MAX;
-  
-  // operate WINAPI cycle which runs until an exit message is received.
-  MSG msg = {};
-  while (msg.message != WM_QUIT) {
-    if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
-      TranslateMessage(&msg);
-      DispatchMessage(&msg);
-    }
-    
-    // reset the memory associated with command allocator.
-    auto result = commandAllocators[bufferIndex]->Reset();
-    if (FAILED(result)) {
-      std::cout << "commandAllocator->Reset: " << result << std::endl;
-      throw new std::runtime_error("Command allocator reset failed");
-    }
-
-    // reset the command list.
-    result = commandList->Reset(commandAllocators[bufferIndex].Get(), pipelineState.Get());
-    if (FAILED(result)) {
-      std::cout << "commandList->Reset: " << result << std::endl;
-      throw new std::runtime_error("Command list reset failed");
-    }
-
-    // define rendering instructions for the further commands.
-    commandList->SetGraphicsRootSignature(rootSignature.Get());
-    commandList->RSSetViewports(1, &viewport);
-    commandList->RSSetScissorRects(1, &scissorRect);
-    
-    // create a resource barrier to synchronize the back buffer for rendering.
-    D3D12_RESOURCE_BARRIER barrier;
-    barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-    barrier.Transition.pResource = renderTargets[bufferIndex].Get();
-    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_PRESENT;
-    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    commandList->ResourceBarrier(1, &barrier);
-    
-    // assign the back buffer as the rendering target.
-    auto rtvHandle = descriptorHeap->GetCPUDescriptorHandleForHeapStart();
-    auto rtvDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    if (bufferIndex == 1) {
-      rtvHandle.ptr += rtvDescriptorSize;
-    }
-
-    // define the back buffer as the render target.
-    commandList->OMSetRenderTargets(1, &rtvHandle, false, nullptr);
-
-    // clear the render target with the desired color.
-    float clearColor[] = { 0.5f, 0.5f, 0.5f, 0.5f };
-    commandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-    commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
-    commandList->DrawInstanced(3, 1, 0, 0);
-
-    // change the back buffer state to transition.
-    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
-    commandList->ResourceBarrier(1, &barrier);
-
-    // close the command list to finalize rendering.
-    result = commandList->Close();
-    if (FAILED(result)) {
-      std::cout << "commandList->Close: " << result << std::endl;
-      throw new std::runtime_error("Failed to close the command list");
-    }
-
-    // submit the command list into the command queue for the execution.
-    std::vector<ID3D12CommandList*> const commandLists = { commandList.Get() };
-    commandQueue->ExecuteCommandLists(1, &commandLists[0]);
-
-    // present the rendered frame to the screen with v-sync.
-    result = swapChain->Present(1, 0);
-    if (FAILED(result)) {
-      std::cout << "swapChain->Present: " << result << std::endl;
-      throw new std::runtime_error("Failed to present swap chain buffer");
-    }
-
-    // wait until the GPU has completed rendering.
-    signalFence(commandQueue, fence, fenceValue);
-    waitFence(fence, fenceValue, fenceEvent, milliseconds::max());
-
-    // proceed to next buffer in a round-robin manner.
-    bufferIndex = (bufferIndex + 1) % BUFFER_COUNT;
-  }
-
-  flush(commandQueue, fence, fenceValue, fenceEvent);
-
-  CloseHandle(fenceEvent);
-  destroyWindow(hwnd);
-  unregisterWindowClass();
-  return 0;
+// include windows headers without unnecessary APIs.
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#include <timeapi.h>
+#include <wrl.h>
+
+// undefine min macro and use the std::min from the <algorithm>
+#if defined(min)
+#undef min
+#endif
+
+// undefine max macro and use the std::max from the <algorithm>
+#if defined(max)
+#undef max
+#endif
+
+// a helper macro to allow writing shader code as a multiline string.
+#define SHADER(CODE) #CODE
+
+// include the required DirectX headers.
+#include <d3d12.h>
+#include <dxgi1_6.h>
+#include <d3dcompiler.h>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "CommandStream.h"
+#include "DescriptorAllocator.h"
+#include "DrawQueue.h"
+#include "FenceTimeline.h"
+#include "DXBackend.h"
+#include "FrameLoop.h"
+#include "FramePacer.h"
+#include "FrameScheduler.h"
+#include "FrustumCuller.h"
+#include "GpuProfiler.h"
+#include "Headless.h"
+#include "HeapCounter.h"
+#include "JobSystem.h"
+#include "LinearArena.h"
+#include "MeshFile.h"
+#include "PipelineCache.h"
+#include "Profiler.h"
+#include "RenderGraph.h"
+#include "ResidencyManager.h"
+#include "ResolutionController.h"
+#include "ResourceStateTracker.h"
+#include "ShaderCache.h"
+#include "Simulation.h"
+#include "TaskGraph.h"
+#include "UploadQueue.h"
+#include "UploadRing.h"
+#include "VertexFormat.h"
+
+// ============================================================================
+
+#pragma comment(lib, "d3d12.lib")
+#pragma comment(lib, "dxgi.lib")
+#pragma comment(lib, "d3dcompiler.lib")
+#pragma comment(lib, "winmm.lib")
+
+// ============================================================================
+
+using namespace Microsoft::WRL;
+using namespace std::chrono;
+
+// ============================================================================
+
+// the name of the window class required by the WINAPI.
+static const auto CLASS_NAME = "DX12-SANDBOX-WC";
+
+// the amount of descriptors in each page of the descriptor allocators.
+static const auto DESCRIPTOR_PAGE_SIZE = 256u;
+
+// the size of the persistently mapped upload buffer.
+static const auto UPLOAD_BUFFER_SIZE = 4ull * 1024 * 1024;
+
+// the initial size of the arena for the transient CPU allocations of each worker in each frame slot.
+static const auto FRAME_ARENA_SIZE = 64u * 1024;
+
+// the size of the chunks in which the meshes are streamed through the upload buffer.
+static const auto MESH_CHUNK_SIZE = 1024ull * 1024;
+
+// the size of the upload buffer of the copy queue and the amount of batches of copies which may be in flight at once.
+static const auto STREAM_BUFFER_SIZE = 8ull * 1024 * 1024;
+static const auto STREAM_COMMAND_LIST_COUNT = 4u;
+
+// the mesh identifiers in the draw sort keys.
+static const auto TRIANGLE_MESH = 0u;
+static const auto LOADED_MESH = 1u;
+
+// the name of the file where the driver compiled pipeline states are stored between the runs.
+static const auto PIPELINE_CACHE_FILE = "pipeline-cache.bin";
+
+// the name of the archive file where the compiled shaders are stored between the runs.
+static const auto SHADER_CACHE_FILE = "shader-cache.bin";
+
+// the frame whose command streams are captured when requested.
+static const auto CAPTURE_FRAME = 100u;
+
+// the maximum amount of GPU profiled regions in a frame.
+static const auto GPU_PROFILER_REGIONS = 8u;
+
+// the amount of frames after which the GPU timestamps are calibrated against the CPU timestamps again.
+static const auto GPU_CALIBRATION_INTERVAL = 256u;
+
+// the GPU frame time that the render resolution is scaled to hold unless another one is selected.
+static const auto DEFAULT_TARGET_FRAME_TIME = microseconds(16667);
+
+// the bounds of the render resolution as a fraction of the output size.
+static const auto MIN_RENDER_SCALE = 0.5;
+static const auto MAX_RENDER_SCALE = 1.0;
+
+// the color that the scene is cleared with, which is also its optimized clear value.
+static const float SCENE_CLEAR_COLOR[] = { 0.5f, 0.5f, 0.5f, 0.5f };
+
+// ============================================================================
+
+// the compiled shaders of the pipeline state.
+struct Shaders
+{
+  ShaderBlob vertexShader;
+  ShaderBlob pixelShader;
+  ShaderBlob upscaleVertexShader;
+  ShaderBlob upscalePixelShader;
+};
+
+// the size of the client area of the window. the window procedure marks it as resized and the frame loop resizes the
+// swap chain before the next frame.
+struct WindowState
+{
+  unsigned int width;
+  unsigned int height;
+  bool resized;
+};
+
+// a vertex of the triangle which upscales the scene into the back buffer, with the largest texture coordinates that
+// do not sample outside of the rendered region of the scene.
+struct UpscaleVertex
+{
+  float position[2];
+  float uv[2];
+  float uvMax[2];
+};
+
+// ============================================================================
+
+LRESULT CALLBACK WndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam)
+{
+  switch (msg) {
+    case WM_CLOSE:
+      DestroyWindow(hwnd);
+      break;
+    case WM_DESTROY:
+      PostQuitMessage(0);
+      break;
+    case WM_SIZE: {
+      // a minimized window keeps its size, as the swap chain buffers cannot be empty.
+      auto window = reinterpret_cast<WindowState*>(GetWindowLongPtr(hwnd, GWLP_USERDATA));
+      unsigned int width = LOWORD(lParam);
+      unsigned int height = HIWORD(lParam);
+      if (window && wParam != SIZE_MINIMIZED && width > 0 && height > 0 && (width != window->width || height != window->height)) {
+        window->width = width;
+        window->height = height;
+        window->resized = true;
+      }
+      break;
+    }
+    case WM_KEYDOWN:
+      switch (wParam) {
+        case VK_ESCAPE:
+          PostQuitMessage(0);
+          break;
+        case VK_F12:
+          // dump the profiled frame stages on demand.
+          writeChromeTrace(TRACE_FILE);
+          printProfileStats(std::cout);
+          break;
+      }
+      break;
+    default:
+      return DefWindowProc(hwnd, msg, wParam, lParam);
+  }
+  return 0;
+}
+
+// ============================================================================
+
+void registerWindowClass()
+{
+  // construct a new empty window class descriptor.
+  WNDCLASSEX windowClass = {};
+
+  // specify the desired window class definitions.
+  windowClass.cbClsExtra = 0;
+  windowClass.cbSize = sizeof(WNDCLASSEX);
+  windowClass.cbWndExtra = 0;
+  windowClass.hbrBackground = (HBRUSH)(COLOR_WINDOW + 1);
+  windowClass.hCursor = LoadCursor(nullptr, IDC_ARROW);
+  windowClass.hIcon = LoadIcon(nullptr, IDI_APPLICATION);
+  windowClass.hIconSm = LoadIcon(GetModuleHandle(nullptr), nullptr);
+  windowClass.hInstance = GetModuleHandle(nullptr);
+  windowClass.lpfnWndProc = WndProc;
+  windowClass.lpszMenuName = nullptr;
+  windowClass.lpszClassName = CLASS_NAME;
+  windowClass.style = CS_HREDRAW | CS_VREDRAW;
+
+  // try to register the window class and check results.
+  if (RegisterClassEx(&windowClass) == 0) {
+    std::cout << "RegisterClassEx: " << GetLastError() << std::endl;
+    throw new std::runtime_error("Window class registration failed");
+  }
+}
+
+// ============================================================================
+
+void unregisterWindowClass()
+{
+  // try to unregister the window class and check results.
+  if (UnregisterClass(CLASS_NAME, GetModuleHandle(nullptr)) == 0) {
+    std::cout << "UnregisterClass: " << GetLastError() << std::endl;
+    throw new std::runtime_error("Window class unregistration failed");
+  }
+}
+
+// ============================================================================
+
+HWND createWindow(WindowState& window)
+{
+  // construct a new window with the desired definitions.
+  HWND hwnd = CreateWindowEx(
+    WS_EX_CLIENTEDGE,
+    CLASS_NAME,
+    "DirectX 12 - Sandbox",
+    WS_OVERLAPPEDWINDOW,
+    CW_USEDEFAULT,
+    CW_USEDEFAULT,
+    WIDTH,
+    HEIGHT,
+    nullptr,
+    nullptr,
+    GetModuleHandle(nullptr),
+    nullptr);
+
+  // check how the operation succeeded.
+  if (hwnd == nullptr) {
+    std::cout << "CreateWindowEx: " << GetLastError() << std::endl;
+    throw new std::runtime_error("Window creation failed");
+  }
+
+  // let the window procedure track the size of the client area, which the swap chain is created with.
+  SetWindowLongPtr(hwnd, GWLP_USERDATA, reinterpret_cast<LONG_PTR>(&window));
+  RECT clientRect = {};
+  GetClientRect(hwnd, &clientRect);
+  window.width = static_cast<unsigned int>(clientRect.right - clientRect.left);
+  window.height = static_cast<unsigned int>(clientRect.bottom - clientRect.top);
+  window.resized = false;
+
+  // operation succeeded...
+  return hwnd;
+}
+
+// ============================================================================
+
+void destroyWindow(HWND hwnd)
+{
+  // try to destroy the given window and check results.
+  if (IsWindow(hwnd) && DestroyWindow(hwnd) == 0) {
+    std::cout << "DestroyWindow: " << GetLastError() << std::endl;
+    throw new std::runtime_error("Window destruction failed");
+  }
+}
+
+// ============================================================================
+
+void enableDXDebugging()
+{
+  // try to catch a reference to the DX12 debug layer.
+  ComPtr<ID3D12Debug> debug;
+  auto result = D3D12GetDebugInterface(IID_PPV_ARGS(&debug));
+  if (FAILED(result)) {
+    std::cout << "D3D12GetDebugInterface: " << result << std::endl;
+    throw new std::runtime_error("Failed to access DX12 debug layer");
+  }
+
+  // enable the debugging layer.
+  debug->EnableDebugLayer();
+}
+
+// ============================================================================
+
+ComPtr<IDXGIAdapter4> selectDXGIAdapter()
+{
+  // specify debug flag when building in a debug mode.
+  auto flags = 0u;
+  #if defined(_DEBUG)
+  flags = DXGI_CREATE_FACTORY_DEBUG;
+  #endif
+
+  // try to create a factory for DXGI instances.
+  ComPtr<IDXGIFactory4> factory;
+  auto result = CreateDXGIFactory2(flags, IID_PPV_ARGS(&factory));
+  if (FAILED(result)) {
+    std::cout << "CreateDXGIFactory2: " << result << std::endl;
+    throw new std::runtime_error("DXGI factory creation failed");
+  }
+
+  // enumerate adapters and find the one with most dedicated video memory.
+  auto maxVideoMemory = 0u;
+  ComPtr<IDXGIAdapter1> adapter1;
+  ComPtr<IDXGIAdapter4> adapter4;
+  for (auto i = 0u; factory->EnumAdapters1(i, &adapter1) != DXGI_ERROR_NOT_FOUND; ++i) {
+    // get the adapter descriptor info item.
+    DXGI_ADAPTER_DESC1 descriptor;
+    adapter1->GetDesc1(&descriptor);
+
+    // skip software emulation based adapters.
+    if ((descriptor.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) != 0)
+      continue;
+
+    // skip adapters that cannot be created.
+    if (FAILED(D3D12CreateDevice(adapter1.Get(), D3D_FEATURE_LEVEL_12_0, __uuidof(ID3D12Device), nullptr)))
+      continue;
+
+    // skip adapters which have less memory than the current maximum.
+    if (descriptor.DedicatedVideoMemory < maxVideoMemory)
+      continue;
+
+    // we found a good candidate as the selected adapter.
+    result = adapter1.As(&adapter4);
+    if (FAILED(result)) {
+      std::cout << "IDXGIAdapter1.As: " << result << std::endl;
+      throw new std::runtime_error("Failed to cast DXGIAdapter1 to DXGIAdapter4");
+    }
+  }
+
+  // return the result.
+  return adapter4;
+}
+
+// ============================================================================
+
+uint64_t getDXAdapterId(ComPtr<IDXGIAdapter4> adapter)
+{
+  // get the adapter descriptor info item.
+  DXGI_ADAPTER_DESC1 descriptor;
+  auto result = adapter->GetDesc1(&descriptor);
+  if (FAILED(result)) {
+    std::cout << "adapter->GetDesc1: " << result << std::endl;
+    throw new std::runtime_error("Failed to get adapter descriptor");
+  }
+
+  // get the version of the user mode driver, which invalidates the cached pipeline states.
+  LARGE_INTEGER driverVersion = {};
+  result = adapter->CheckInterfaceSupport(__uuidof(IDXGIDevice), &driverVersion);
+  if (FAILED(result)) {
+    std::cout << "adapter->CheckInterfaceSupport: " << result << std::endl;
+  }
+
+  PipelineHasher hasher;
+  hasher.add(descriptor.VendorId).add(descriptor.DeviceId).add(descriptor.SubSysId).add(descriptor.Revision);
+  return hasher.add(driverVersion.QuadPart).get();
+}
+
+// ============================================================================
+
+ComPtr<ID3D12Device> createDXDevice(ComPtr<IDXGIAdapter4> adapter)
+{
+  // try to create a new DX12 device from the provided adapter.
+  ComPtr<ID3D12Device2> device;
+  auto result = D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&device));
+  if (FAILED(result)) {
+    std::cout << "D3D12CreateDevice: " << result << std::endl;
+    throw new std::runtime_error("Failed to create DX12 device");
+  }
+
+  #if defined(_DEBUG)
+  // try to access the DX12 device info queue.
+  ComPtr<ID3D12InfoQueue> infoQueue;
+  if (SUCCEEDED(device.As(&infoQueue))) {
+    // tell queue that we want to break when something goes wrong.
+    infoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_CORRUPTION, true);
+    infoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_ERROR, true);
+    infoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_WARNING, true);
+
+    // create an array of severity levels to be ignored.
+    std::vector<D3D12_MESSAGE_SEVERITY> severities = { D3D12_MESSAGE_SEVERITY_INFO };
+
+    // create an array to ignore non-critical warnings.
+    std::vector<D3D12_MESSAGE_ID> deniedIds = {
+      D3D12_MESSAGE_ID_CLEARDEPTHSTENCILVIEW_MISMATCHINGCLEARVALUE,
+      D3D12_MESSAGE_ID_MAP_INVALID_NULLRANGE,
+      D3D12_MESSAGE_ID_UNMAP_INVALID_NULLRANGE
+    };
+
+    // construct a queue filter to ignore certain severity levels and warnings.
+    D3D12_INFO_QUEUE_FILTER filter = {};
+    filter.DenyList.NumSeverities = severities.size();
+    filter.DenyList.pSeverityList = &severities[0];
+    filter.DenyList.NumIDs = deniedIds.size();
+    filter.DenyList.pIDList = &deniedIds[0];
+
+    // try to activate the created queue filter.
+    result = infoQueue->PushStorageFilter(&filter);
+    if (FAILED(result)) {
+      std::cout << "infoQueue->PushStorageFilter: " << result << std::endl;
+      throw new std::runtime_error("Failed to activate DX12 info queue filter");
+    }
+  }
+  #endif
+
+  return device;
+}
+
+// ============================================================================
+
+ComPtr<IDXGISwapChain4> createDXGISwapChain(HWND hwnd, ComPtr<ID3D12CommandQueue> commandQueue, unsigned int width, unsigned int height, unsigned int bufferCount, PresentMode presentMode, unsigned int maxFrameLatency)
+{
+  // specify debug flag when building in a debug mode.
+  auto flags = 0u;
+  #if defined(_DEBUG)
+  flags = DXGI_CREATE_FACTORY_DEBUG;
+  #endif
+
+  // try to create a factory for DXGI instances.
+  ComPtr<IDXGIFactory4> factory;
+  auto result = CreateDXGIFactory2(flags, IID_PPV_ARGS(&factory));
+  if (FAILED(result)) {
+    std::cout << "CreateDXGIFactory2: " << result << std::endl;
+    throw new std::runtime_error("DXGI factory creation failed");
+  }
+
+  // create a descriptor for the swap chain.
+  DXGI_SWAP_CHAIN_DESC1 descriptor = {};
+  descriptor.Width = width;
+  descriptor.Height = height;
+  descriptor.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+  descriptor.Stereo = false;
+  descriptor.SampleDesc = { 1, 0 };
+  descriptor.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+  descriptor.BufferCount = bufferCount;
+  descriptor.Scaling = DXGI_SCALING_STRETCH;
+  descriptor.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+  descriptor.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
+  descriptor.Flags = 0;
+
+  // allow the tearing presents when they are requested and supported by the display and the driver.
+  if (presentMode == PresentMode::TEARING) {
+    ComPtr<IDXGIFactory5> factory5;
+    BOOL tearing = FALSE;
+    if (SUCCEEDED(factory.As(&factory5)) && SUCCEEDED(factory5->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &tearing, sizeof(tearing))) && tearing) {
+      descriptor.Flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+    } else {
+      std::cout << "tearing is not supported, presenting without it" << std::endl;
+    }
+  }
+
+  // make the swap chain signal an object when it accepts another frame, so the frame loop waits for it before it
+  // samples the input instead of blocking in the present with the frame already recorded.
+  if (maxFrameLatency > 0) {
+    descriptor.Flags |= DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+  }
+
+  // try to create the swap chain.
+  ComPtr<IDXGISwapChain1> swapChain;
+  result = factory->CreateSwapChainForHwnd(commandQueue.Get(), hwnd, &descriptor, nullptr, nullptr, &swapChain);
+  if (FAILED(result)) {
+    std::cout << "factory->CreateSwapChainForHwnd: " << result << std::endl;
+    throw new std::runtime_error("Failed to create DXGI swap chain");
+  }
+
+  // cast the created swap chain into correct version.
+  ComPtr<IDXGISwapChain4> swapChain4;
+  result = swapChain.As(&swapChain4);
+  if (FAILED(result)) {
+    std::cout << "swapChain.As: " << result << std::endl;
+    throw new std::runtime_error("Failed to cast DXGISwapChain1 to DXGISwapChain4");
+  }
+
+  // limit the amount of frames queued for the presentation.
+  if (maxFrameLatency > 0) {
+    result = swapChain4->SetMaximumFrameLatency(maxFrameLatency);
+    if (FAILED(result)) {
+      std::cout << "swapChain->SetMaximumFrameLatency: " << result << std::endl;
+      throw new std::runtime_error("Failed to set the maximum frame latency");
+    }
+  }
+
+  return swapChain4;
+}
+
+// ============================================================================
+
+ComPtr<ID3D12DescriptorHeap> createDXDescriptorHeap(ComPtr<ID3D12Device> device, D3D12_DESCRIPTOR_HEAP_TYPE type, unsigned int count, D3D12_DESCRIPTOR_HEAP_FLAGS flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE)
+{
+  // create a descriptor for the descriptor heap.
+  D3D12_DESCRIPTOR_HEAP_DESC descriptor = {};
+  descriptor.NumDescriptors = count;
+  descriptor.Type = type;
+  descriptor.Flags = flags;
+
+  // try to create the descriptor heap.
+  ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+  auto result = device->CreateDescriptorHeap(&descriptor, IID_PPV_ARGS(&descriptorHeap));
+  if (FAILED(result)) {
+    std::cout << "device->CreateDescriptorHeap: " << result << std::endl;
+    throw new std::runtime_error("Failed to create descriptor heap");
+  }
+
+  return descriptorHeap;
+}
+
+// ============================================================================
+
+DescriptorAllocator createDescriptorAllocator(ComPtr<ID3D12Device> device, D3D12_DESCRIPTOR_HEAP_TYPE type, std::vector<ComPtr<ID3D12DescriptorHeap>>& descriptorHeaps, D3D12_DESCRIPTOR_HEAP_FLAGS flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE)
+{
+  // query the handle increment size only once for the allocator.
+  auto descriptorSize = device->GetDescriptorHandleIncrementSize(type);
+
+  // create a new descriptor heap for each page of the allocator. the heaps are appended in the order of the pages, so
+  // the page of a range indexes the heaps when the allocator has a vector of its own.
+  return DescriptorAllocator(DESCRIPTOR_PAGE_SIZE, descriptorSize, [device, type, flags, &descriptorHeaps](unsigned int count) {
+    auto descriptorHeap = createDXDescriptorHeap(device, type, count, flags);
+    descriptorHeaps.push_back(descriptorHeap);
+    DescriptorPage page = { static_cast<uint64_t>(descriptorHeap->GetCPUDescriptorHandleForHeapStart().ptr), 0 };
+    if (flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) {
+      page.gpuHandle = descriptorHeap->GetGPUDescriptorHandleForHeapStart().ptr;
+    }
+    return page;
+  });
+}
+
+// ============================================================================
+
+D3D12_CPU_DESCRIPTOR_HANDLE getDXDescriptorHandle(const DescriptorAllocator& allocator, const DescriptorRange& range, unsigned int index)
+{
+  D3D12_CPU_DESCRIPTOR_HANDLE handle;
+  handle.ptr = static_cast<SIZE_T>(allocator.getCpuHandle(range, index));
+  return handle;
+}
+
+// ============================================================================
+
+std::vector<std::vector<ComPtr<ID3D12CommandAllocator>>> createDXCommandAllocators(ComPtr<ID3D12Device> device, D3D12_COMMAND_LIST_TYPE type, unsigned int frameCount, unsigned int workerCount)
+{
+  // try to create new command allocators for each worker of each frame slot.
+  std::vector<std::vector<ComPtr<ID3D12CommandAllocator>>> commandAllocators(frameCount);
+  for (auto& frameAllocators : commandAllocators) {
+    for (auto i = 0u; i < workerCount; i++) {
+      ComPtr<ID3D12CommandAllocator> allocator;
+      auto result = device->CreateCommandAllocator(type, IID_PPV_ARGS(&allocator));
+      if (FAILED(result)) {
+        std::cout << "device->CreateCommandAllocator: " << result << std::endl;
+        throw new std::runtime_error("Failed to create command allocator");
+      }
+      frameAllocators.push_back(allocator);
+    }
+  }
+  return commandAllocators;
+}
+
+// ============================================================================
+
+ComPtr<ID3D12GraphicsCommandList> createDXCommandList(ComPtr<ID3D12Device> device, ComPtr<ID3D12CommandAllocator> commandAllocator, ComPtr<ID3D12PipelineState> state)
+{
+  // try to create a new command list.
+  ComPtr<ID3D12GraphicsCommandList> commandList;
+  auto result = device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator.Get(), state.Get(), IID_PPV_ARGS(&commandList));
+  if (FAILED(result)) {
+    std::cout << "device->CreateCommandList: " << result << std::endl;
+    throw new std::runtime_error("Failed to create command list");
+  }
+
+  // close the command list to stop recording commands for now.
+  result = commandList->Close();
+  if (FAILED(result)) {
+    std::cout << "commandList->Close: " << result << std::endl;
+  }
+
+  return commandList;
+}
+
+// ============================================================================
+
+std::vector<DXCommandList> createDXCommandLists(ComPtr<ID3D12Device> device, ComPtr<ID3D12CommandAllocator> commandAllocator, ComPtr<ID3D12PipelineState> state, unsigned int count)
+{
+  std::vector<DXCommandList> commandLists;
+  for (auto i = 0u; i < count; i++) {
+    commandLists.push_back(DXCommandList(createDXCommandList(device, commandAllocator, state)));
+  }
+  return commandLists;
+}
+
+// ============================================================================
+
+void resetDXCommandList(ComPtr<ID3D12GraphicsCommandList> commandList, ComPtr<ID3D12CommandAllocator> commandAllocator, ComPtr<ID3D12PipelineState> state)
+{
+  auto result = commandList->Reset(commandAllocator.Get(), state.Get());
+  if (FAILED(result)) {
+    std::cout << "commandList->Reset: " << result << std::endl;
+    throw new std::runtime_error("Command list reset failed");
+  }
+}
+
+// ============================================================================
+
+void closeDXCommandList(ComPtr<ID3D12GraphicsCommandList> commandList)
+{
+  auto result = commandList->Close();
+  if (FAILED(result)) {
+    std::cout << "commandList->Close: " << result << std::endl;
+    throw new std::runtime_error("Failed to close the command list");
+  }
+}
+
+// ============================================================================
+
+std::vector<ComPtr<ID3D12Resource>> createRenderTargets(ComPtr<ID3D12Device> device, ComPtr<IDXGISwapChain4> swapChain, unsigned int bufferCount, const DescriptorAllocator& rtvAllocator, const DescriptorRange& rtvRange)
+{
+  // construct a new render tager view for each buffer.
+  std::vector<ComPtr<ID3D12Resource>> renderTargets;
+  for (auto i = 0u; i < bufferCount; i++) {
+    // get a buffer pointer from the swap chain.
+    ComPtr<ID3D12Resource> buffer;
+    auto result = swapChain->GetBuffer(i, IID_PPV_ARGS(&buffer));
+    if (FAILED(result)) {
+      std::cout << "swapChain->GetBuffer: " << result << std::endl;
+      throw new std::runtime_error("Failed to get buffer pointer from the swap chain");
+    }
+
+    // create a new render target view and add it into the buffer list.
+    device->CreateRenderTargetView(buffer.Get(), nullptr, getDXDescriptorHandle(rtvAllocator, rtvRange, i));
+    renderTargets.push_back(buffer);
+  }
+
+  return renderTargets;
+}
+
+// ============================================================================
+
+ComPtr<ID3D12RootSignature> createRootSignature(ComPtr<ID3D12Device> device, unsigned int parameterCount, const D3D12_ROOT_PARAMETER* parameters, unsigned int samplerCount, const D3D12_STATIC_SAMPLER_DESC* samplers, uint64_t& hash)
+{
+  // create a desciptor for the root signature.
+  D3D12_ROOT_SIGNATURE_DESC descriptor = {};
+  descriptor.NumParameters = parameterCount;
+  descriptor.pParameters = parameters;
+  descriptor.NumStaticSamplers = samplerCount;
+  descriptor.pStaticSamplers = samplers;
+  descriptor.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+  // try to serialize a new root signature. 
+  ComPtr<ID3DBlob> signature;
+  ComPtr<ID3DBlob> error;
+  auto result = D3D12SerializeRootSignature(&descriptor, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error);
+  if (FAILED(result)) {
+    std::cout << "D3D12SerializeRootSignature: " << result << std::endl;
+    throw new std::runtime_error("Failed to create root signature");
+  }
+
+  // try to create the new root signature.
+  ComPtr<ID3D12RootSignature> rootSignature;
+  result = device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature));
+  if (FAILED(result)) {
+    std::cout << "device->CreateRootSignature: " << result << std::endl;
+    throw new std::runtime_error("Failed to create root signature");
+  }
+
+  // identify the root signature by its serialized blob in the pipeline state hashes.
+  hash = hashBytes(signature->GetBufferPointer(), signature->GetBufferSize());
+  return rootSignature;
+}
+
+// ============================================================================
+
+ComPtr<ID3D12RootSignature> createUpscaleRootSignature(ComPtr<ID3D12Device> device, uint64_t& hash)
+{
+  // the scene is bound as the only shader resource of a descriptor table.
+  D3D12_DESCRIPTOR_RANGE range = {};
+  range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+  range.NumDescriptors = 1;
+  range.BaseShaderRegister = 0;
+  range.RegisterSpace = 0;
+  range.OffsetInDescriptorsFromTableStart = 0;
+
+  D3D12_ROOT_PARAMETER parameter = {};
+  parameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+  parameter.DescriptorTable.NumDescriptorRanges = 1;
+  parameter.DescriptorTable.pDescriptorRanges = &range;
+  parameter.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+  // the scene is filtered bilinearly with a static sampler, which does not need a sampler heap.
+  D3D12_STATIC_SAMPLER_DESC sampler = {};
+  sampler.Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+  sampler.AddressU = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+  sampler.AddressV = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+  sampler.AddressW = D3D12_TEXTURE_ADDRESS_MODE_CLAMP;
+  sampler.MipLODBias = 0.f;
+  sampler.MaxAnisotropy = 0;
+  sampler.ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+  sampler.BorderColor = D3D12_STATIC_BORDER_COLOR_TRANSPARENT_BLACK;
+  sampler.MinLOD = 0.f;
+  sampler.MaxLOD = D3D12_FLOAT32_MAX;
+  sampler.ShaderRegister = 0;
+  sampler.RegisterSpace = 0;
+  sampler.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+
+  return createRootSignature(device, 1, &parameter, 1, &sampler, hash);
+}
+
+// ============================================================================
+
+std::vector<uint8_t> compileDXShader(const ShaderDesc& desc)
+{
+  // build the null-terminated list of the preprocessor definitions.
+  std::vector<D3D_SHADER_MACRO> defines;
+  for (auto& define : desc.defines) {
+    defines.push_back({ define.name.c_str(), define.value.c_str() });
+  }
+  defines.push_back({ nullptr, nullptr });
+
+  // try to compile the shader.
+  ComPtr<ID3DBlob> shader;
+  ComPtr<ID3DBlob> error;
+  auto result = D3DCompile(desc.source, desc.sourceSize, "", &defines[0], nullptr, desc.entryPoint, desc.target, desc.flags, 0, &shader, &error);
+  if (FAILED(result)) {
+    std::cout << "D3DCompile (" << desc.entryPoint << "): " << result << std::endl;
+    if (error != nullptr) {
+      std::cout << (char*)error->GetBufferPointer() << std::endl;
+    }
+    throw new std::runtime_error("Failed to compile shader");
+  }
+
+  auto bytecode = static_cast<const uint8_t*>(shader->GetBufferPointer());
+  return std::vector<uint8_t>(bytecode, bytecode + shader->GetBufferSize());
+}
+
+// ============================================================================
+
+Shaders loadShaders(ShaderCache& shaderCache)
+{
+  // enable debug flags if debug mode is being used.
+  #if defined(_DEBUG)
+  unsigned int flags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+  #else
+  unsigned int flags = 0;
+  #endif
+
+  // the source code for our shaders.
+  auto src = SHADER(
+    struct PSInput
+    {
+      float4 position : SV_POSITION;
+      float4 color : COLOR;
+    };
+
+    PSInput VSMain(float4 position : POSITION, float4 color : COLOR)
+    {
+      PSInput result;
+      result.position = position;
+      result.color = color;
+      return result;
+    }
+
+    float4 PSMain(PSInput input) : SV_TARGET
+    {
+      return input.color;
+    }
+  );
+
+  // the source code for the upscaling of the rendered region of the scene into the back buffer.
+  auto upscaleSrc = SHADER(
+    Texture2D scene : register(t0);
+    SamplerState linearSampler : register(s0);
+
+    struct PSInput
+    {
+      float4 position : SV_POSITION;
+      float2 uv : TEXCOORD0;
+      float2 uvMax : TEXCOORD1;
+    };
+
+    PSInput VSUpscale(float2 position : POSITION, float2 uv : TEXCOORD0, float2 uvMax : TEXCOORD1)
+    {
+      PSInput result;
+      result.position = float4(position, 0.0, 1.0);
+      result.uv = uv;
+      result.uvMax = uvMax;
+      return result;
+    }
+
+    float4 PSUpscale(PSInput input) : SV_TARGET
+    {
+      return scene.Sample(linearSampler, min(input.uv, input.uvMax));
+    }
+  );
+
+  // get the compiled shaders from the cache, which compiles them only when they are missing.
+  auto vertexShader = shaderCache.getShader({ src, strlen(src), "VSMain", "vs_5_0", {}, flags });
+  auto pixelShader = shaderCache.getShader({ src, strlen(src), "PSMain", "ps_5_0", {}, flags });
+  auto upscaleVertexShader = shaderCache.getShader({ upscaleSrc, strlen(upscaleSrc), "VSUpscale", "vs_5_0", {}, flags });
+  auto upscalePixelShader = shaderCache.getShader({ upscaleSrc, strlen(upscaleSrc), "PSUpscale", "ps_5_0", {}, flags });
+  return { vertexShader, pixelShader, upscaleVertexShader, upscalePixelShader };
+}
+
+// ============================================================================
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> createDXInputLayout(const VertexLayout& vertexLayout)
+{
+  // the element formats use the DXGI_FORMAT values, so they can be cast directly.
+  std::vector<D3D12_INPUT_ELEMENT_DESC> inputDescriptor;
+  for (auto& element : getVertexElements(vertexLayout)) {
+    inputDescriptor.push_back({
+      element.semantic,
+      0,
+      static_cast<DXGI_FORMAT>(element.format),
+      0,
+      element.offset,
+      D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+      0
+    });
+  }
+  return inputDescriptor;
+}
+
+// ============================================================================
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> createDXUpscaleInputLayout()
+{
+  return {
+    { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(UpscaleVertex, position), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(UpscaleVertex, uv), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+    { "TEXCOORD", 1, DXGI_FORMAT_R32G32_FLOAT, 0, offsetof(UpscaleVertex, uvMax), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+  };
+}
+
+// ============================================================================
+
+ComPtr<ID3D12PipelineState> createPipelineState(DXPipelineCache& pipelineCache, ComPtr<ID3D12RootSignature> rootSignature, uint64_t rootSignatureHash, const ShaderBlob& vertexShader, const ShaderBlob& pixelShader, const std::vector<D3D12_INPUT_ELEMENT_DESC>& inputDescriptor)
+{
+  // create a descriptor for the rasterizer state (derived from CD3DX12_RASTERIZER_DESC(CD3DX12_DEFAULT))
+  D3D12_RASTERIZER_DESC rasterizerDescriptor = {};
+  rasterizerDescriptor.FillMode = D3D12_FILL_MODE_SOLID;
+  rasterizerDescriptor.CullMode = D3D12_CULL_MODE_BACK;
+  rasterizerDescriptor.FrontCounterClockwise = false;
+  rasterizerDescriptor.DepthBias = D3D12_DEFAULT_DEPTH_BIAS;
+  rasterizerDescriptor.DepthBiasClamp = D3D12_DEFAULT_DEPTH_BIAS_CLAMP;
+  rasterizerDescriptor.SlopeScaledDepthBias = D3D12_DEFAULT_SLOPE_SCALED_DEPTH_BIAS;
+  rasterizerDescriptor.DepthClipEnable = true;
+  rasterizerDescriptor.MultisampleEnable = false;
+  rasterizerDescriptor.AntialiasedLineEnable = false;
+  rasterizerDescriptor.ForcedSampleCount = 0;
+  rasterizerDescriptor.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+
+  // create a descriptor for the blend state (derived from CD3DX12_BLEND_DESC(CD3DX12_DEFAULT))
+  D3D12_BLEND_DESC blendDescriptor = {};
+  blendDescriptor.AlphaToCoverageEnable = false;
+  blendDescriptor.IndependentBlendEnable = false;
+  blendDescriptor.RenderTarget[0].BlendEnable = false;
+  blendDescriptor.RenderTarget[0].LogicOpEnable = false;
+  blendDescriptor.RenderTarget[0].SrcBlend = D3D12_BLEND_ONE;
+  blendDescriptor.RenderTarget[0].DestBlend = D3D12_BLEND_ZERO;
+  blendDescriptor.RenderTarget[0].BlendOp = D3D12_BLEND_OP_ADD;
+  blendDescriptor.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_ONE;
+  blendDescriptor.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_ZERO;
+  blendDescriptor.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_ADD;
+  blendDescriptor.RenderTarget[0].LogicOp = D3D12_LOGIC_OP_NOOP;
+  blendDescriptor.RenderTarget[0].RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+
+  // create a desciptor for the pipeline state object.
+  D3D12_GRAPHICS_PIPELINE_STATE_DESC descriptor = {};
+  descriptor.InputLayout = { &inputDescriptor[0], inputDescriptor.size() };
+  descriptor.pRootSignature = rootSignature.Get();
+  descriptor.VS = { vertexShader.data, vertexShader.size };
+  descriptor.PS = { pixelShader.data, pixelShader.size };
+  descriptor.RasterizerState = rasterizerDescriptor;
+  descriptor.BlendState = blendDescriptor;
+  descriptor.DepthStencilState.DepthEnable = false;
+  descriptor.DepthStencilState.StencilEnable = false;
+  descriptor.SampleMask = UINT_MAX;
+  descriptor.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+  descriptor.NumRenderTargets = 1;
+  descriptor.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+  descriptor.SampleDesc.Count = 1;
+
+  // get the pipeline state from the cache or create a new one with the given descriptor.
+  return pipelineCache.getPipelineState(descriptor, rootSignatureHash);
+}
+
+// ============================================================================
+
+ComPtr<ID3D12Resource> createDXBuffer(ComPtr<ID3D12Device> device, uint64_t size, D3D12_HEAP_TYPE heapType, D3D12_RESOURCE_STATES state)
+{
+  // construct properties for the heap.
+  D3D12_HEAP_PROPERTIES heapProperties = {};
+  heapProperties.Type = heapType;
+  heapProperties.CreationNodeMask = 1;
+  heapProperties.VisibleNodeMask = 1;
+  heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+  heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+
+  // construct a descriptor for a buffer (derived from CD3DX12_RESOURCE_DESC).
+  D3D12_RESOURCE_DESC resourceDescriptor = {};
+  resourceDescriptor.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+  resourceDescriptor.Alignment = 0;
+  resourceDescriptor.Width = size;
+  resourceDescriptor.Height = 1;
+  resourceDescriptor.DepthOrArraySize = 1;
+  resourceDescriptor.MipLevels = 1;
+  resourceDescriptor.Format = DXGI_FORMAT_UNKNOWN;
+  resourceDescriptor.SampleDesc.Count = 1;
+  resourceDescriptor.SampleDesc.Quality = 0;
+  resourceDescriptor.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+  resourceDescriptor.Flags = D3D12_RESOURCE_FLAG_NONE;
+
+  // allocate a new committed resource for the buffer.
+  ComPtr<ID3D12Resource> buffer;
+  auto result = device->CreateCommittedResource(
+    &heapProperties,
+    D3D12_HEAP_FLAG_NONE,
+    &resourceDescriptor,
+    state,
+    nullptr,
+    IID_PPV_ARGS(&buffer));
+  if (FAILED(result)) {
+    std::cout << "device->CreateCommittedResource: " << result << std::endl;
+    throw new std::runtime_error("Failed to create committed resource");
+  }
+
+  return buffer;
+}
+
+// ============================================================================
+
+uint64_t getDXResourceSize(ComPtr<ID3D12Device> device, ComPtr<ID3D12Resource> resource)
+{
+  // the size of the memory which the resource takes including its alignment.
+  auto descriptor = resource->GetDesc();
+  return device->GetResourceAllocationInfo(0, 1, &descriptor).SizeInBytes;
+}
+
+// ============================================================================
+
+ComPtr<ID3D12Resource> createSceneTarget(ComPtr<ID3D12Device> device, unsigned int width, unsigned int height, D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle, D3D12_CPU_DESCRIPTOR_HANDLE srvHandle)
+{
+  // construct properties for the heap.
+  D3D12_HEAP_PROPERTIES heapProperties = {};
+  heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
+  heapProperties.CreationNodeMask = 1;
+  heapProperties.VisibleNodeMask = 1;
+  heapProperties.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+  heapProperties.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+
+  // the scene target has the size of the back buffers and the scene is rendered into a region of it.
+  D3D12_RESOURCE_DESC resourceDescriptor = {};
+  resourceDescriptor.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+  resourceDescriptor.Alignment = 0;
+  resourceDescriptor.Width = width;
+  resourceDescriptor.Height = height;
+  resourceDescriptor.DepthOrArraySize = 1;
+  resourceDescriptor.MipLevels = 1;
+  resourceDescriptor.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+  resourceDescriptor.SampleDesc.Count = 1;
+  resourceDescriptor.SampleDesc.Quality = 0;
+  resourceDescriptor.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
+  resourceDescriptor.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+
+  // the clears of the scene use the optimized clear value.
+  D3D12_CLEAR_VALUE clearValue = {};
+  clearValue.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+  std::copy(SCENE_CLEAR_COLOR, SCENE_CLEAR_COLOR + 4, clearValue.Color);
+
+  // allocate a new committed resource for the scene, which rests in the state of the upscaling between the frames.
+  ComPtr<ID3D12Resource> sceneTarget;
+  auto result = device->CreateCommittedResource(
+    &heapProperties,
+    D3D12_HEAP_FLAG_NONE,
+    &resourceDescriptor,
+    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+    &clearValue,
+    IID_PPV_ARGS(&sceneTarget));
+  if (FAILED(result)) {
+    std::cout << "device->CreateCommittedResource: " << result << std::endl;
+    throw new std::runtime_error("Failed to create the scene target");
+  }
+
+  // create the views which render into and sample the scene.
+  device->CreateRenderTargetView(sceneTarget.Get(), nullptr, rtvHandle);
+  device->CreateShaderResourceView(sceneTarget.Get(), nullptr, srvHandle);
+  return sceneTarget;
+}
+
+// ============================================================================
+
+UploadRing createUploadRing(ComPtr<ID3D12Resource> uploadBuffer)
+{
+  // map the upload buffer persistently as upload heaps can stay mapped while the GPU uses them.
+  unsigned char* data(0);
+  D3D12_RANGE range = {};
+  auto result = uploadBuffer->Map(0, &range, reinterpret_cast<void**>(&data));
+  if (FAILED(result)) {
+    std::cout << "uploadBuffer->Map: " << result << std::endl;
+    throw new std::runtime_error("Failed to map upload buffer memory");
+  }
+
+  return UploadRing(uploadBuffer->GetDesc().Width, data, uploadBuffer->GetGPUVirtualAddress());
+}
+
+// ============================================================================
+
+ComPtr<ID3D12QueryHeap> createDXTimestampQueryHeap(ComPtr<ID3D12Device> device, unsigned int queryCount)
+{
+  D3D12_QUERY_HEAP_DESC descriptor = {};
+  descriptor.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+  descriptor.Count = queryCount;
+  descriptor.NodeMask = 0;
+
+  ComPtr<ID3D12QueryHeap> queryHeap;
+  auto result = device->CreateQueryHeap(&descriptor, IID_PPV_ARGS(&queryHeap));
+  if (FAILED(result)) {
+    std::cout << "device->CreateQueryHeap: " << result << std::endl;
+    throw new std::runtime_error("Failed to create timestamp query heap");
+  }
+  return queryHeap;
+}
+
+// ============================================================================
+
+const uint64_t* mapDXReadbackBuffer(ComPtr<ID3D12Resource> readbackBuffer)
+{
+  // map the readback buffer persistently. the profiler only reads the ranges of the frames the GPU has completed.
+  void* data(0);
+  auto result = readbackBuffer->Map(0, nullptr, &data);
+  if (FAILED(result)) {
+    std::cout << "readbackBuffer->Map: " << result << std::endl;
+    throw new std::runtime_error("Failed to map readback buffer memory");
+  }
+  return static_cast<const uint64_t*>(data);
+}
+
+// ============================================================================
+
+void calibrateDXGpuProfiler(GpuProfiler& gpuProfiler, ComPtr<ID3D12CommandQueue> commandQueue)
+{
+  UINT64 frequency = 0;
+  auto result = commandQueue->GetTimestampFrequency(&frequency);
+  if (FAILED(result)) {
+    std::cout << "commandQueue->GetTimestampFrequency: " << result << std::endl;
+    throw new std::runtime_error("Failed to get the timestamp frequency");
+  }
+  UINT64 gpuTimestamp = 0;
+  UINT64 cpuTimestamp = 0;
+  result = commandQueue->GetClockCalibration(&gpuTimestamp, &cpuTimestamp);
+  if (FAILED(result)) {
+    std::cout << "commandQueue->GetClockCalibration: " << result << std::endl;
+    throw new std::runtime_error("Failed to calibrate the timestamps");
+  }
+
+  // the calibration pairs the GPU timestamp with a QPC timestamp, so the profiler timestamp is moved back by the time
+  // elapsed since then.
+  auto profileTimestamp = getProfileTimestamp();
+  LARGE_INTEGER counter;
+  LARGE_INTEGER counterFrequency;
+  QueryPerformanceCounter(&counter);
+  QueryPerformanceFrequency(&counterFrequency);
+  auto elapsed = static_cast<double>(counter.QuadPart - static_cast<LONGLONG>(cpuTimestamp)) * 1e6 / counterFrequency.QuadPart;
+  gpuProfiler.calibrate(frequency, gpuTimestamp, profileTimestamp - static_cast<uint64_t>(elapsed * getProfileTicksPerMicrosecond()));
+}
+
+// ============================================================================
+
+UploadAllocation upload(UploadRing& uploadRing, const void* data, uint64_t size, uint64_t alignment)
+{
+  // sub-allocate the memory from the ring and copy the data into it.
+  UploadAllocation allocation;
+  if (!uploadRing.allocate(size, alignment, allocation)) {
+    std::cout << "uploadRing.allocate: " << size << " bytes" << std::endl;
+    throw new std::runtime_error("Upload ring is out of memory");
+  }
+  memcpy(allocation.cpuAddress, data, static_cast<size_t>(size));
+  return allocation;
+}
+
+// ============================================================================
+
+UploadTicket uploadDXMesh(const MeshDesc& mesh, ComPtr<ID3D12Resource> vertexBuffer, ComPtr<ID3D12Resource> indexBuffer, UploadQueue& uploadQueue)
+{
+  // copy the streams straight from the mapped file into the upload buffer of the copy queue and from there into the
+  // buffers. the buffers stay in the common state, from which the direct queue promotes them to the read states.
+  uploadQueue.upload(vertexBuffer.Get(), 0, mesh.vertices, mesh.vertexCount * mesh.vertexStride);
+  if (indexBuffer) {
+    uploadQueue.upload(indexBuffer.Get(), 0, mesh.indices, mesh.indexCount * mesh.indexSize);
+  }
+  return uploadQueue.submit();
+}
+
+// ============================================================================
+
+std::array<UpscaleVertex, 3> getUpscaleVertices(unsigned int renderWidth, unsigned int renderHeight, unsigned int targetWidth, unsigned int targetHeight)
+{
+  // a single triangle covers the back buffer, and the rendered region of the scene is stretched over the clip space.
+  // the texture coordinates stop half a texel before the end of the region, so the filter does not blend in the texels
+  // outside of it.
+  auto u = static_cast<float>(renderWidth) / targetWidth;
+  auto v = static_cast<float>(renderHeight) / targetHeight;
+  auto uMax = (renderWidth - 0.5f) / targetWidth;
+  auto vMax = (renderHeight - 0.5f) / targetHeight;
+  return {{
+    {{ -1.f, -1.f }, { 0.f, v }, { uMax, vMax }},
+    {{ -1.f,  3.f }, { 0.f, -v }, { uMax, vMax }},
+    {{  3.f, -1.f }, { 2.f * u, v }, { uMax, vMax }}
+  }};
+}
+
+// ============================================================================
+
+int main(int argc, char* argv[])
+{
+  // run the commands which need neither a window nor a GPU when requested.
+  auto exitCode = 0;
+  if (runHeadlessCommand(argc, argv, exitCode)) {
+    return exitCode;
+  }
+
+  // select the packed vertex layout.
+  VertexLayout vertexLayout;
+  if (!parseVertexLayoutOption(argc, argv, vertexLayout)) {
+    return 1;
+  }
+
+  // draw the given mesh file instead of the triangles and capture a frame into the given file.
+  std::string meshPath;
+  std::string capturePath;
+  for (auto i = 1; i + 1 < argc; i++) {
+    if (std::string(argv[i]) == "--mesh") {
+      meshPath = argv[i + 1];
+    } else if (std::string(argv[i]) == "--capture") {
+      capturePath = argv[i + 1];
+    }
+  }
+
+  // select the swap chain buffers, the present mode, the waitable frame latency, the frame pacing and the GPU frame time
+  // that the render resolution is scaled to hold (zero renders at the full resolution).
+  auto bufferCount = DEFAULT_BUFFER_COUNT;
+  auto presentMode = PresentMode::VSYNC;
+  auto maxFrameLatency = 0u;
+  auto pacing = false;
+  auto targetFrameTime = DEFAULT_TARGET_FRAME_TIME;
+  for (auto i = 1; i < argc; i++) {
+    std::string argument = argv[i];
+    if (argument == "--pace") {
+      pacing = true;
+    } else if (i + 1 < argc && argument == "--target-frame-time") {
+      targetFrameTime = microseconds(static_cast<microseconds::rep>(std::stod(argv[i + 1]) * 1000.0));
+    } else if (i + 1 < argc && argument == "--present" && !parsePresentMode(argv[i + 1], presentMode)) {
+      std::cout << "unknown present mode: " << argv[i + 1] << std::endl;
+      return 1;
+    } else if (i + 1 < argc && argument == "--buffers") {
+      bufferCount = std::stoul(argv[i + 1]);
+      if (bufferCount < 2 || bufferCount > DXGI_MAX_SWAP_CHAIN_BUFFERS) {
+        std::cout << "the amount of buffers must be between 2 and " << DXGI_MAX_SWAP_CHAIN_BUFFERS << std::endl;
+        return 1;
+      }
+    } else if (i + 1 < argc && argument == "--latency") {
+      maxFrameLatency = std::stoul(argv[i + 1]);
+      if (maxFrameLatency < 1 || maxFrameLatency > DXGI_MAX_SWAP_CHAIN_BUFFERS) {
+        std::cout << "the frame latency must be between 1 and " << DXGI_MAX_SWAP_CHAIN_BUFFERS << std::endl;
+        return 1;
+      }
+    }
+  }
+  std::cout << "present mode: " << getPresentModeName(presentMode) << ", buffers: " << bufferCount
+    << ", frame latency: " << (maxFrameLatency > 0 ? std::to_string(maxFrameLatency) : std::string("default"))
+    << ", pacing: " << (pacing ? "on" : "off") << ", target frame time: " << targetFrameTime.count() << "us" << std::endl;
+
+  #if defined(_DEBUG)
+  enableDXDebugging();
+  #endif
+
+  // the objects created by the initialization tasks.
+  JobSystem jobSystem;
+  WindowState window = {};
+  HWND hwnd = nullptr;
+  ComPtr<IDXGIAdapter4> adapter;
+  std::unique_ptr<DXDevice> device;
+  std::unique_ptr<CommandQueue> commandQueue;
+  std::unique_ptr<DXSwapChain> swapChain;
+  std::vector<ComPtr<ID3D12DescriptorHeap>> descriptorHeaps;
+  std::unique_ptr<DescriptorAllocator> rtvAllocator;
+  DescriptorRange rtvRange = {};
+  std::vector<ComPtr<ID3D12Resource>> renderTargets;
+  DescriptorRange sceneRtvRange = {};
+  std::vector<ComPtr<ID3D12DescriptorHeap>> srvHeaps;
+  std::unique_ptr<DescriptorAllocator> srvAllocator;
+  DescriptorRange sceneSrvRange = {};
+  ComPtr<ID3D12Resource> sceneTarget;
+  std::vector<std::vector<ComPtr<ID3D12CommandAllocator>>> commandAllocators;
+  std::unique_ptr<ShaderCache> shaderCache;
+  Shaders shaders = {};
+  std::unique_ptr<DXPipelineCache> pipelineCache;
+  uint64_t rootSignatureHash = 0u;
+  ComPtr<ID3D12RootSignature> rootSignature;
+  ComPtr<ID3D12PipelineState> pipelineState;
+  uint64_t upscaleRootSignatureHash = 0u;
+  ComPtr<ID3D12RootSignature> upscaleRootSignature;
+  ComPtr<ID3D12PipelineState> upscalePipelineState;
+  auto drawCommandListCount = (DRAW_COUNT + DRAWS_PER_COMMAND_LIST - 1) / DRAWS_PER_COMMAND_LIST;
+  std::vector<DXCommandList> commandLists;
+  std::vector<DXCommandList> fixupCommandLists;
+  ComPtr<ID3D12Resource> uploadBuffer;
+  std::unique_ptr<UploadRing> uploadRing;
+  std::unique_ptr<Fence> fence;
+  ComPtr<ID3D12QueryHeap> timestampQueryHeap;
+  ComPtr<ID3D12Resource> timestampReadbackBuffer;
+  std::unique_ptr<GpuProfiler> gpuProfiler;
+  std::unique_ptr<CommandQueue> copyQueue;
+  std::unique_ptr<Fence> copyFence;
+  uint64_t copyFenceValue = 0u;
+  std::unique_ptr<FenceTimeline> copyTimeline;
+  ComPtr<ID3D12Resource> streamBuffer;
+  std::unique_ptr<UploadRing> streamRing;
+  std::unique_ptr<DXCopyRecorder> copyRecorder;
+  std::unique_ptr<UploadQueue> uploadQueue;
+  MeshFile meshFile;
+  ComPtr<ID3D12Resource> meshVertexBuffer;
+  ComPtr<ID3D12Resource> meshIndexBuffer;
+
+  // declare the initialization tasks and their dependencies. the window and the swap chain are
+  // created on the main thread, because the window messages are dispatched by the thread which created it.
+  TaskGraph initGraph;
+  auto windowTask = initGraph.addTask("window", [&] {
+    registerWindowClass();
+    hwnd = createWindow(window);
+  }, {}, true);
+  auto adapterTask = initGraph.addTask("adapter", [&] {
+    adapter = selectDXGIAdapter();
+  });
+  auto deviceTask = initGraph.addTask("device", [&] {
+    device.reset(new DXDevice(createDXDevice(adapter)));
+  }, { adapterTask });
+  auto shadersTask = initGraph.addTask("shaders", [&] {
+    shaderCache.reset(new ShaderCache(SHADER_CACHE_FILE, compileDXShader));
+    shaders = loadShaders(*shaderCache);
+  });
+  auto commandQueueTask = initGraph.addTask("command queue", [&] {
+    commandQueue = device->createCommandQueue(CommandListType::DIRECT);
+  }, { deviceTask });
+  auto swapChainTask = initGraph.addTask("swap chain", [&] {
+    swapChain.reset(new DXSwapChain(createDXGISwapChain(hwnd, static_cast<DXCommandQueue&>(*commandQueue).get(), window.width, window.height, bufferCount, presentMode, maxFrameLatency)));
+  }, { windowTask, commandQueueTask }, true);
+  auto descriptorHeapsTask = initGraph.addTask("descriptor heaps", [&] {
+    rtvAllocator.reset(new DescriptorAllocator(createDescriptorAllocator(device->get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, descriptorHeaps)));
+    rtvRange = rtvAllocator->allocate(bufferCount);
+    sceneRtvRange = rtvAllocator->allocate(1);
+    srvAllocator.reset(new DescriptorAllocator(createDescriptorAllocator(device->get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, srvHeaps, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE)));
+    sceneSrvRange = srvAllocator->allocate(1);
+  }, { deviceTask });
+  initGraph.addTask("render targets", [&] {
+    renderTargets = createRenderTargets(device->get(), swapChain->get(), bufferCount, *rtvAllocator, rtvRange);
+    sceneTarget = createSceneTarget(device->get(), window.width, window.height, getDXDescriptorHandle(*rtvAllocator, sceneRtvRange, 0), getDXDescriptorHandle(*srvAllocator, sceneSrvRange, 0));
+  }, { swapChainTask, descriptorHeapsTask });
+  auto commandAllocatorsTask = initGraph.addTask("command allocators", [&] {
+    commandAllocators = createDXCommandAllocators(device->get(), D3D12_COMMAND_LIST_TYPE_DIRECT, FRAMES_IN_FLIGHT, jobSystem.getWorkerCount());
+  }, { deviceTask });
+  auto pipelineLibraryTask = initGraph.addTask("pipeline library", [&] {
+    pipelineCache.reset(new DXPipelineCache(device->get(), getDXAdapterId(adapter)));
+    pipelineCache->getLibrary().load(PIPELINE_CACHE_FILE);
+  }, { deviceTask });
+  auto rootSignatureTask = initGraph.addTask("root signature", [&] {
+    rootSignature = createRootSignature(device->get(), 0, nullptr, 0, nullptr, rootSignatureHash);
+    upscaleRootSignature = createUpscaleRootSignature(device->get(), upscaleRootSignatureHash);
+  }, { deviceTask });
+  auto meshTask = initGraph.addTask("mesh", [&] {
+    if (meshPath.empty()) {
+      return;
+    }
+    if (!meshFile.open(meshPath)) {
+      std::cout << "meshFile.open: " << meshPath << std::endl;
+      throw new std::runtime_error("Failed to open the mesh file");
+    }
+
+    // the pipeline state uses the vertex layout of the mesh.
+    auto& mesh = meshFile.getMesh();
+    vertexLayout = mesh.vertexLayout;
+    meshVertexBuffer = createDXBuffer(device->get(), mesh.vertexCount * mesh.vertexStride, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COMMON);
+    if (mesh.indexCount > 0) {
+      meshIndexBuffer = createDXBuffer(device->get(), mesh.indexCount * mesh.indexSize, D3D12_HEAP_TYPE_DEFAULT, D3D12_RESOURCE_STATE_COMMON);
+    }
+  }, { deviceTask });
+  auto pipelineStateTask = initGraph.addTask("pipeline state", [&] {
+    pipelineState = createPipelineState(*pipelineCache, rootSignature, rootSignatureHash, shaders.vertexShader, shaders.pixelShader, createDXInputLayout(vertexLayout));
+    upscalePipelineState = createPipelineState(*pipelineCache, upscaleRootSignature, upscaleRootSignatureHash, shaders.upscaleVertexShader, shaders.upscalePixelShader, createDXUpscaleInputLayout());
+  }, { shadersTask, pipelineLibraryTask, rootSignatureTask, meshTask });
+  initGraph.addTask("command lists", [&] {
+    commandLists = createDXCommandLists(device->get(), commandAllocators[0][0], pipelineState, drawCommandListCount + 3);
+    fixupCommandLists = createDXCommandLists(device->get(), commandAllocators[0][0], pipelineState, drawCommandListCount + 1);
+  }, { commandAllocatorsTask, pipelineStateTask });
+  initGraph.addTask("upload buffer", [&] {
+    uploadBuffer = createDXBuffer(device->get(), UPLOAD_BUFFER_SIZE, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
+    uploadRing.reset(new UploadRing(createUploadRing(uploadBuffer)));
+  }, { deviceTask });
+  initGraph.addTask("fence", [&] {
+    fence = device->createFence();
+  }, { deviceTask });
+  initGraph.addTask("gpu profiler", [&] {
+    timestampQueryHeap = createDXTimestampQueryHeap(device->get(), GpuProfiler::getQueryCount(FRAMES_IN_FLIGHT, GPU_PROFILER_REGIONS));
+    timestampReadbackBuffer = createDXBuffer(device->get(), GpuProfiler::getReadbackSize(FRAMES_IN_FLIGHT, GPU_PROFILER_REGIONS), D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST);
+    gpuProfiler.reset(new GpuProfiler(FRAMES_IN_FLIGHT, GPU_PROFILER_REGIONS, timestampQueryHeap.Get(), timestampReadbackBuffer.Get(), mapDXReadbackBuffer(timestampReadbackBuffer)));
+    calibrateDXGpuProfiler(*gpuProfiler, static_cast<DXCommandQueue&>(*commandQueue).get());
+  }, { commandQueueTask });
+  initGraph.addTask("upload queue", [&] {
+    copyQueue = device->createCommandQueue(CommandListType::COPY);
+    copyFence = device->createFence();
+    copyTimeline.reset(new FenceTimeline(*copyQueue, *copyFence, copyFenceValue));
+    streamBuffer = createDXBuffer(device->get(), STREAM_BUFFER_SIZE, D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ);
+    streamRing.reset(new UploadRing(createUploadRing(streamBuffer)));
+    copyRecorder.reset(new DXCopyRecorder(device->get(), streamBuffer, STREAM_COMMAND_LIST_COUNT));
+    uploadQueue.reset(new UploadQueue(*copyTimeline, *streamRing, *copyRecorder, MESH_CHUNK_SIZE));
+  }, { deviceTask });
+
+  // run the independent tasks in parallel and report which chain of tasks bounds the startup time.
+  initGraph.run(jobSystem);
+  initGraph.printReport(std::cout);
+  std::cout << "shaders: " << shaderCache->getHitCount() << " cached, " << shaderCache->getMissCount() << " compiled" << std::endl;
+  std::cout << "pipeline states: " << pipelineCache->getCachedCount() << " cached, " << pipelineCache->getCompiledCount() << " compiled" << std::endl;
+
+  // store the newly compiled shaders and pipeline states for the next launch.
+  if (shaderCache->isDirty()) {
+    shaderCache->save();
+  }
+  if (pipelineCache->getLibrary().isDirty()) {
+    pipelineCache->getLibrary().save(PIPELINE_CACHE_FILE);
+  }
+
+  // the timeline of the direct queue shares the fence value counter with the frame loop.
+  uint64_t fenceValue = 0u;
+  FenceTimeline frameTimeline(*commandQueue, *fence, fenceValue);
+  FrameScheduler frameScheduler(FRAMES_IN_FLIGHT);
+
+  // each frame in flight keeps its upload ring memory until the GPU completes it, so the bookkeeping is reserved for
+  // all of them, however far the GPU falls behind.
+  frameTimeline.reserve(FRAMES_IN_FLIGHT);
+  uploadRing->reserveFrames(FRAMES_IN_FLIGHT);
+
+  // keep the mesh buffers and the scene target within the memory budget of the adapter. the other resources are
+  // small or used by every frame anyway, so they are left resident.
+  DXResidencyBackend residencyBackend(device->get(), adapter);
+  ResidencyManager residencyManager(residencyBackend);
+  auto sceneResidency = residencyManager.add(sceneTarget.Get(), getDXResourceSize(device->get(), sceneTarget));
+  auto meshVertexResidency = ResidencyManager::INVALID_HANDLE;
+  auto meshIndexResidency = ResidencyManager::INVALID_HANDLE;
+  if (meshVertexBuffer) {
+    meshVertexResidency = residencyManager.add(meshVertexBuffer.Get(), getDXResourceSize(device->get(), meshVertexBuffer));
+  }
+  if (meshIndexBuffer) {
+    meshIndexResidency = residencyManager.add(meshIndexBuffer.Get(), getDXResourceSize(device->get(), meshIndexBuffer));
+  }
+
+  // stream the mesh into its buffers on the copy queue. the first frame waits for the ticket on the GPU, so only the
+  // chunks which do not fit into the upload buffer at once make the CPU wait for the copies.
+  CommandVertexBufferView meshVertexBufferView = {};
+  CommandIndexBufferView meshIndexBufferView = {};
+  UploadTicket meshTicket = {};
+  auto meshPending = false;
+  if (meshVertexBuffer) {
+    auto& mesh = meshFile.getMesh();
+    auto start = steady_clock::now();
+    meshTicket = uploadDXMesh(mesh, meshVertexBuffer, meshIndexBuffer, *uploadQueue);
+    meshPending = true;
+    auto time = duration_cast<microseconds>(steady_clock::now() - start);
+    std::cout << "mesh: " << mesh.vertexCount << " vertices, " << mesh.indexCount << " indices, queued at "
+      << meshFile.getFileSize() / (1024.0 * 1024.0) / (time.count() / 1e6) << "MB/s (" << uploadQueue->getStallCount() << " stalls)" << std::endl;
+
+    meshVertexBufferView.address = meshVertexBuffer->GetGPUVirtualAddress();
+    meshVertexBufferView.stride = mesh.vertexStride;
+    meshVertexBufferView.size = static_cast<uint32_t>(mesh.vertexCount * mesh.vertexStride);
+    if (meshIndexBuffer) {
+      meshIndexBufferView.address = meshIndexBuffer->GetGPUVirtualAddress();
+      meshIndexBufferView.indexSize = mesh.indexSize;
+      meshIndexBufferView.size = static_cast<uint32_t>(mesh.indexCount * mesh.indexSize);
+    }
+  }
+
+  // track the states of the back buffers and the scene target across the command lists.
+  ResourceStateRegistry resourceStates;
+  for (auto& renderTarget : renderTargets) {
+    resourceStates.setState(renderTarget.Get(), RESOURCE_STATE_PRESENT);
+  }
+  resourceStates.setState(sceneTarget.Get(), RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+  // the scene is rendered at a fraction of the size of the back buffers which holds the target GPU frame time.
+  auto outputWidth = window.width;
+  auto outputHeight = window.height;
+  ResolutionController resolutionController(targetFrameTime, MIN_RENDER_SCALE, MAX_RENDER_SCALE, FRAMES_IN_FLIGHT);
+  std::vector<ResourceStateTracker> resourceStateTrackers(drawCommandListCount);
+  DrawQueue drawQueue;
+  BarrierList barriers;
+
+  // the transient containers of each frame allocate from the arena of the frame slot and the worker.
+  std::vector<std::vector<LinearArena>> frameArenas(FRAMES_IN_FLIGHT);
+  for (auto& workerArenas : frameArenas) {
+    for (auto worker = 0u; worker < jobSystem.getWorkerCount(); worker++) {
+      workerArenas.emplace_back(FRAME_ARENA_SIZE);
+    }
+  }
+
+  // the triangles are drawn without a camera, so their bounds are culled in the clip space.
+  static const float CLIP_SPACE[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+  auto clipFrustum = makeFrustum(CLIP_SPACE);
+  FrustumCuller triangleCuller;
+  for (auto draw = 0u; draw < DRAW_COUNT; draw++) {
+    triangleCuller.addBox(0.f, 0.f, 0.f, 0.5f, 0.5f, 0.f);
+  }
+
+  // set the window visible.
+  ShowWindow(hwnd, SW_SHOW);
+
+  // construct the required vertices for a simple triangle.
+  auto vertices = getTriangleVertices();
+  std::vector<uint8_t> packedVertices(vertices.size() * getVertexStride(vertexLayout));
+  encodeVertices(vertices.data(), vertices.size(), vertexLayout, packedVertices.data());
+
+  // create a viewport definition. its size is the render size of each frame.
+  CommandViewport viewport = {};
+  viewport.maxDepth = D3D12_MAX_DEPTH;
+  viewport.minDepth = D3D12_MIN_DEPTH;
+  viewport.topLeftX = 0;
+  viewport.topLeftY = 0;
+  viewport.width = static_cast<float>(outputWidth);
+  viewport.height = static_cast<float>(outputHeight);
+  auto outputViewport = viewport;
+
+  // create a scissor rect definition.
+  CommandRect scissorRect = {};
+  scissorRect.left = 0;
+  scissorRect.top = 0;
+  scissorRect.right = INT32_MAX;
+  scissorRect.bottom = INT32_MAX;
+
+  // each command list (including the barrier fixups) has its own recorder when a frame is captured.
+  std::vector<CommandRecorder> recorders(commandLists.size() + fixupCommandLists.size());
+  std::vector<CommandReplayStats> replayStats(recorders.size());
+  CommandCapture capture;
+  auto frameNumber = 0u;
+  auto capturing = false;
+
+  // get the sink that the commands of the list are issued into, which is the recorder of the list on the captured frame.
+  auto beginCommands = [&](DXCommandList& commandList, unsigned int index) -> CommandSink& {
+    if (!capturing) {
+      return commandList;
+    }
+    recorders[index].reset();
+    return recorders[index];
+  };
+
+  // close the list. the captured stream is replayed into the list first, which measures the cost of each native call.
+  auto endCommands = [&](DXCommandList& commandList, unsigned int index) {
+    if (capturing) {
+      replayCommandStream(recorders[index].getData(), recorders[index].getSize(), commandList, &replayStats[index]);
+    }
+    closeDXCommandList(commandList.get());
+  };
+
+  // resize the back buffers and the scene target to the client area of the window. the buffers can be resized only
+  // once the GPU has completed the frames which use them, so the frames in flight are drained first, which is fine
+  // for such a rare event. the device and everything else stays as it is.
+  auto resizeBuffers = [&] {
+    PROFILE_SCOPE("resize buffers");
+    frameTimeline.flush();
+    for (auto& renderTarget : renderTargets) {
+      resourceStates.removeResource(renderTarget.Get());
+    }
+    resourceStates.removeResource(sceneTarget.Get());
+    residencyManager.remove(sceneResidency);
+    renderTargets.clear();
+    sceneTarget.Reset();
+
+    swapChain->resize(window.width, window.height);
+    renderTargets = createRenderTargets(device->get(), swapChain->get(), bufferCount, *rtvAllocator, rtvRange);
+    sceneTarget = createSceneTarget(device->get(), window.width, window.height, getDXDescriptorHandle(*rtvAllocator, sceneRtvRange, 0), getDXDescriptorHandle(*srvAllocator, sceneSrvRange, 0));
+    for (auto& renderTarget : renderTargets) {
+      resourceStates.setState(renderTarget.Get(), RESOURCE_STATE_PRESENT);
+    }
+    resourceStates.setState(sceneTarget.Get(), RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    sceneResidency = residencyManager.add(sceneTarget.Get(), getDXResourceSize(device->get(), sceneTarget));
+    outputWidth = window.width;
+    outputHeight = window.height;
+    outputViewport.width = static_cast<float>(outputWidth);
+    outputViewport.height = static_cast<float>(outputHeight);
+    window.resized = false;
+  };
+
+  // operate WINAPI cycle which runs until an exit message is received.
+  MSG msg = {};
+  auto beginFrame = [&] {
+    if (PeekMessage(&msg, nullptr, 0, 0, PM_REMOVE)) {
+      TranslateMessage(&msg);
+      DispatchMessage(&msg);
+    }
+    if (window.resized && msg.message != WM_QUIT) {
+      resizeBuffers();
+    }
+    return msg.message != WM_QUIT;
+  };
+
+  // record the rendering commands for the given frame slot and back buffer.
+  auto recordFrame = [&](unsigned int frameIndex, unsigned int bufferIndex, std::vector<CommandList*>& submission) {
+    // count every frame, so the calibration interval does not depend on whether a capture was requested.
+    auto frame = frameNumber++;
+    capturing = !capturePath.empty() && frame == CAPTURE_FRAME;
+
+    // read the GPU times of the previous frame of the slot, which the frame loop has waited for, and recalibrate the
+    // GPU timestamps from time to time as the clocks drift apart.
+    auto readCount = gpuProfiler->getReadCount();
+    gpuProfiler->beginFrame(frameIndex);
+    if (frame % GPU_CALIBRATION_INTERVAL == 0) {
+      calibrateDXGpuProfiler(*gpuProfiler, static_cast<DXCommandQueue&>(*commandQueue).get());
+    }
+
+    // scale the render resolution by the GPU time of the frame which has just been read.
+    if (gpuProfiler->getReadCount() != readCount) {
+      resolutionController.addFrameTime(gpuProfiler->getLastFrameTime());
+    }
+    auto renderWidth = outputWidth;
+    auto renderHeight = outputHeight;
+    resolutionController.getRenderSize(outputWidth, outputHeight, renderWidth, renderHeight);
+    viewport.width = static_cast<float>(renderWidth);
+    viewport.height = static_cast<float>(renderHeight);
+    auto frameRegion = GpuProfiler::INVALID_REGION;
+    auto drawRegion = GpuProfiler::INVALID_REGION;
+
+    // make the direct queue wait on the GPU for the streamed mesh before the first frame which draws it.
+    if (meshPending) {
+      uploadQueue->wait(*commandQueue, meshTicket);
+      meshPending = false;
+    }
+
+    // submit the list and append its stream into the capture in the same order.
+    auto submit = [&](DXCommandList& commandList, unsigned int index) {
+      submission.push_back(&commandList);
+      if (capturing) {
+        capture.addStream(recorders[index]);
+      }
+    };
+
+    // reset the memory associated with the command allocators and the arenas of each worker.
+    auto& frameAllocators = commandAllocators[frameIndex];
+    auto& workerArenas = frameArenas[frameIndex];
+    {
+      PROFILE_SCOPE("reset allocators");
+      for (auto& commandAllocator : frameAllocators) {
+        auto result = commandAllocator->Reset();
+        if (FAILED(result)) {
+          std::cout << "commandAllocator->Reset: " << result << std::endl;
+          throw new std::runtime_error("Command allocator reset failed");
+        }
+      }
+      for (auto& arena : workerArenas) {
+        arena.reset();
+      }
+    }
+
+    // retire the upload memory and the other entries of the frames and copies that the GPU has completed.
+    {
+      PROFILE_SCOPE("retire resources");
+      frameTimeline.poll();
+      copyTimeline->poll();
+    }
+
+    // mark the resources of the frame, which is completed by the next signal of the direct queue.
+    residencyManager.beginFrame(frameTimeline.getNextValue());
+    residencyManager.use(sceneResidency);
+    if (meshVertexResidency != ResidencyManager::INVALID_HANDLE) {
+      residencyManager.use(meshVertexResidency);
+    }
+    if (meshIndexResidency != ResidencyManager::INVALID_HANDLE) {
+      residencyManager.use(meshIndexResidency);
+    }
+
+    // upload the vertices for this frame and create a vertex buffer view for them unless a mesh is drawn.
+    auto vertexBufferView = meshVertexBufferView;
+    if (!meshVertexBuffer) {
+      auto vertexAllocation = upload(*uploadRing, packedVertices.data(), packedVertices.size(), sizeof(float));
+      vertexBufferView.address = vertexAllocation.gpuAddress;
+      vertexBufferView.stride = getVertexStride(vertexLayout);
+      vertexBufferView.size = static_cast<uint32_t>(vertexAllocation.size);
+    }
+
+    // upload the triangle which upscales the rendered region of the scene into the back buffer.
+    auto upscaleVertices = getUpscaleVertices(renderWidth, renderHeight, outputWidth, outputHeight);
+    auto upscaleAllocation = upload(*uploadRing, upscaleVertices.data(), sizeof(upscaleVertices), sizeof(float));
+    CommandVertexBufferView upscaleVertexBufferView = {};
+    upscaleVertexBufferView.address = upscaleAllocation.gpuAddress;
+    upscaleVertexBufferView.stride = sizeof(UpscaleVertex);
+    upscaleVertexBufferView.size = static_cast<uint32_t>(upscaleAllocation.size);
+
+    // cull the triangles. the mesh file does not store any bounds, so the mesh is always drawn.
+    auto visibleCount = 0u;
+    if (!meshVertexBuffer) {
+      PROFILE_SCOPE("cull draws");
+      visibleCount = triangleCuller.cull(clipFrustum, BoundsType::BOX, &jobSystem);
+    }
+
+    // queue the visible draws and sort them into instanced batches.
+    {
+      PROFILE_SCOPE("sort draws");
+      drawQueue.clear();
+      if (meshVertexBuffer) {
+        drawQueue.push(makeDrawKey(0, 0, 0, LOADED_MESH, 0.f), 0);
+      } else {
+        auto visibleIndices = triangleCuller.getVisibleIndices();
+        for (auto i = 0u; i < visibleCount; i++) {
+          drawQueue.push(makeDrawKey(0, 0, 0, TRIANGLE_MESH, 0.f), visibleIndices[i]);
+        }
+      }
+      drawQueue.sort();
+    }
+    auto& batches = drawQueue.getBatches();
+
+    // assign the scene target as the rendering target of the draws and the back buffer as the target of the upscaling.
+    auto rtvHandle = getDXDescriptorHandle(*rtvAllocator, rtvRange, bufferIndex);
+    auto sceneRtvHandle = getDXDescriptorHandle(*rtvAllocator, sceneRtvRange, 0);
+
+    // describe the frame as a render graph where the back buffer is imported from the swap chain and the scene target
+    // rests in the state of the upscaling between the frames. the graph lives in the arena of the recording worker
+    // and its passes are passed by reference, so building it does not touch the heap.
+    auto backBuffer = renderTargets[bufferIndex].Get();
+    auto scene = sceneTarget.Get();
+    RenderGraph frameGraph(workerArenas[jobSystem.getWorkerIndex()]);
+    auto backBufferResource = frameGraph.importResource("back buffer", RESOURCE_STATE_PRESENT, RESOURCE_STATE_PRESENT);
+    frameGraph.setResourceHandle(backBufferResource, backBuffer);
+    auto sceneResource = frameGraph.importResource("scene", RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraph.setResourceHandle(sceneResource, scene);
+
+    // record the barriers into a separate command list which is executed before the following command lists.
+    auto fixupCount = 0u;
+    auto submitBarriers = [&](const BarrierList& barriers) {
+      auto index = static_cast<unsigned int>(commandLists.size()) + fixupCount;
+      auto& fixupCommandList = fixupCommandLists[fixupCount++];
+      resetDXCommandList(fixupCommandList.get(), frameAllocators[0], pipelineState);
+      beginCommands(fixupCommandList, index).resourceBarrier(barriers);
+      endCommands(fixupCommandList, index);
+      submit(fixupCommandList, index);
+    };
+
+    // record the first command list which prepares and clears the scene target.
+    auto recordClear = [&](const RenderGraph::PassContext& context) {
+      PROFILE_SCOPE("record begin commands");
+      resetDXCommandList(commandLists.front().get(), frameAllocators[0], pipelineState);
+      auto& commandSink = beginCommands(commandLists.front(), 0);
+      frameRegion = gpuProfiler->beginRegion(commandSink, "gpu frame");
+      commandSink.resourceBarrier(context.barriers);
+      auto clearRegion = gpuProfiler->beginRegion(commandSink, "gpu clear");
+      commandSink.clearRenderTarget(sceneRtvHandle.ptr, SCENE_CLEAR_COLOR);
+      gpuProfiler->endRegion(commandSink, clearRegion);
+      // the draws are recorded in parallel, so their region spans from the end of this list to the upscaling.
+      drawRegion = gpuProfiler->beginRegion(commandSink, "gpu draws");
+      endCommands(commandLists.front(), 0);
+      submit(commandLists.front(), 0);
+    };
+    auto clearPass = frameGraph.addPass("clear", std::ref(recordClear));
+    frameGraph.write(clearPass, sceneResource, RESOURCE_STATE_RENDER_TARGET);
+
+    // record the draw calls in parallel where each worker uses its own command allocator.
+    auto recordDraws = [&](unsigned int begin, unsigned int end) {
+      auto& commandAllocator = frameAllocators[jobSystem.getWorkerIndex()];
+      BarrierList drawBarriers(workerArenas[jobSystem.getWorkerIndex()]);
+      for (auto i = begin; i < end; i++) {
+        PROFILE_SCOPE("record draw commands");
+        auto& commandList = commandLists[1 + i];
+        resetDXCommandList(commandList.get(), commandAllocator, pipelineState);
+        auto& commandSink = beginCommands(commandList, 1 + i);
+
+        // declare the states required by the draws. the scene target state is resolved at the submission.
+        auto& resourceStateTracker = resourceStateTrackers[i];
+        resourceStateTracker.reset();
+        resourceStateTracker.transition(scene, RESOURCE_STATE_RENDER_TARGET);
+        drawBarriers.clear();
+        resourceStateTracker.flush(drawBarriers);
+        commandSink.resourceBarrier(drawBarriers);
+
+        // define rendering instructions for the further commands.
+        commandSink.setRootSignature(rootSignature.Get());
+        commandSink.setViewport(viewport);
+        commandSink.setScissorRect(scissorRect);
+        commandSink.setRenderTarget(sceneRtvHandle.ptr);
+        commandSink.setPrimitiveTopology(PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+
+        // record an even share of the sorted batches and bind the buffers only when the mesh changes.
+        auto first = i * batches.size() / drawCommandListCount;
+        auto last = (i + 1) * batches.size() / drawCommandListCount;
+        auto boundMesh = ~0u;
+        for (auto batch = first; batch < last; batch++) {
+          auto& drawBatch = batches[batch];
+          auto mesh = getDrawKeyMesh(drawBatch.key);
+          if (mesh != boundMesh) {
+            commandSink.setVertexBuffer(0, vertexBufferView);
+            if (mesh == LOADED_MESH && meshIndexBuffer) {
+              commandSink.setIndexBuffer(meshIndexBufferView);
+            }
+            boundMesh = mesh;
+          }
+          if (mesh == LOADED_MESH && meshIndexBuffer) {
+            commandSink.drawIndexedInstanced(static_cast<uint32_t>(meshFile.getMesh().indexCount), drawBatch.instanceCount, 0, 0, drawBatch.firstInstance);
+          } else if (mesh == LOADED_MESH) {
+            commandSink.drawInstanced(static_cast<uint32_t>(meshFile.getMesh().vertexCount), drawBatch.instanceCount, 0, drawBatch.firstInstance);
+          } else {
+            commandSink.drawInstanced(static_cast<uint32_t>(vertices.size()), drawBatch.instanceCount, 0, drawBatch.firstInstance);
+          }
+        }
+        endCommands(commandList, 1 + i);
+      }
+    };
+    auto submitDraws = [&](const RenderGraph::PassContext& context) {
+      if (!context.barriers.empty()) {
+        submitBarriers(context.barriers);
+      }
+      jobSystem.parallelFor(drawCommandListCount, 1, std::ref(recordDraws));
+
+      // resolve the pending states of the draw command lists in their submission order.
+      PROFILE_SCOPE("resolve resource states");
+      for (auto i = 0u; i < drawCommandListCount; i++) {
+        barriers.clear();
+        resourceStateTrackers[i].resolve(resourceStates, barriers);
+        if (!barriers.empty()) {
+          submitBarriers(barriers);
+        }
+        submit(commandLists[1 + i], 1 + i);
+      }
+    };
+    auto drawPass = frameGraph.addPass("draw", std::ref(submitDraws));
+    frameGraph.write(drawPass, sceneResource, RESOURCE_STATE_RENDER_TARGET);
+
+    // record the command list which upscales the rendered region of the scene into the back buffer.
+    auto recordUpscale = [&](const RenderGraph::PassContext& context) {
+      PROFILE_SCOPE("record upscale commands");
+      auto index = static_cast<unsigned int>(commandLists.size() - 2);
+      auto& commandList = commandLists[index];
+      resetDXCommandList(commandList.get(), frameAllocators[0], upscalePipelineState);
+      auto& commandSink = beginCommands(commandList, index);
+      gpuProfiler->endRegion(commandSink, drawRegion);
+      commandSink.resourceBarrier(context.barriers);
+      auto upscaleRegion = gpuProfiler->beginRegion(commandSink, "gpu upscale");
+      commandSink.setRootSignature(upscaleRootSignature.Get());
+      commandSink.setDescriptorHeap(srvHeaps[sceneSrvRange.page].Get());
+      commandSink.setRootDescriptorTable(0, srvAllocator->getGpuHandle(sceneSrvRange, 0));
+      commandSink.setViewport(outputViewport);
+      commandSink.setScissorRect(scissorRect);
+      commandSink.setRenderTarget(rtvHandle.ptr);
+      commandSink.setPrimitiveTopology(PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+      commandSink.setVertexBuffer(0, upscaleVertexBufferView);
+      commandSink.drawInstanced(static_cast<uint32_t>(upscaleVertices.size()), 1, 0, 0);
+      gpuProfiler->endRegion(commandSink, upscaleRegion);
+      endCommands(commandList, index);
+      submit(commandList, index);
+    };
+    auto upscalePass = frameGraph.addPass("upscale", std::ref(recordUpscale));
+    frameGraph.read(upscalePass, sceneResource, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraph.write(upscalePass, backBufferResource, RESOURCE_STATE_RENDER_TARGET);
+
+    // execute the passes, which keeps the registry in sync with the barriers of the graph.
+    {
+      PROFILE_SCOPE("compile render graph");
+      frameGraph.compile();
+    }
+    BarrierList finalBarriers(workerArenas[jobSystem.getWorkerIndex()]);
+    frameGraph.execute(&resourceStates, finalBarriers);
+
+    // record the last command list which changes the back buffer state to presentation.
+    {
+      PROFILE_SCOPE("record end commands");
+      auto index = static_cast<unsigned int>(commandLists.size() - 1);
+      resetDXCommandList(commandLists.back().get(), frameAllocators[0], pipelineState);
+      auto& commandSink = beginCommands(commandLists.back(), index);
+      commandSink.resourceBarrier(finalBarriers);
+      gpuProfiler->endRegion(commandSink, frameRegion);
+      gpuProfiler->resolve(commandSink);
+      endCommands(commandLists.back(), index);
+      submit(commandLists.back(), index);
+    }
+
+    // page the resources of the frame in and the least recently used ones out before the frame is submitted.
+    {
+      PROFILE_SCOPE("commit residency");
+      residencyManager.commit(frameTimeline.getCompletedValue());
+    }
+
+    // write the captured frame and report the cost of the native calls which were replayed from it.
+    if (capturing) {
+      capture.write(capturePath);
+      CommandReplayStats stats = {};
+      for (auto& listStats : replayStats) {
+        mergeCommandReplayStats(stats, listStats);
+      }
+      std::cout << "captured frame " << CAPTURE_FRAME << " into " << capturePath << ": " << capture.getStreamCount() << " command lists, "
+        << capture.getSize() << " bytes" << std::endl;
+      printCommandReplayStats(stats, std::cout);
+      capture.clear();
+      capturing = false;
+    }
+  };
+
+  // tag the uploads of the frame with the fence value signaled after it and release them once it has been completed.
+  auto endFrame = [&](uint64_t frameFenceValue) {
+    uploadRing->finishFrame(frameFenceValue);
+    frameTimeline.onCompleted(frameFenceValue, [&uploadRing, frameFenceValue] { uploadRing->reclaim(frameFenceValue); });
+  };
+
+  // render frames in the selected present mode until the window is closed. the pacer sleeps in the steps of the
+  // system timer, so its resolution is raised for the loop.
+  FramePacer framePacer;
+  if (pacing) {
+    timeBeginPeriod(1);
+  }
+  auto stats = runFrameLoop(*commandQueue, *fence, fenceValue, *swapChain, frameScheduler, presentMode, beginFrame, recordFrame, endFrame, pacing ? &framePacer : nullptr);
+  if (pacing) {
+    timeEndPeriod(1);
+    std::cout << "paced frames: " << framePacer.getCompletedFrameCount() << " (missed: " << framePacer.getMissedFrameCount() << ")"
+      << " predicted cpu: " << framePacer.getPredictedCpuTime().count() << "us gpu: " << framePacer.getPredictedGpuTime().count() << "us"
+      << " margin: " << framePacer.getMargin().count() << "us" << std::endl;
+  }
+  std::cout << "average frame time: " << getAverageFrameTime(stats).count() << "us" << std::endl;
+  std::cout << "render scale: " << resolutionController.getScale() << " (" << resolutionController.getChangeCount() << " changes)"
+    << ", average GPU frame time: " << resolutionController.getAverageFrameTime().count() << "us" << std::endl;
+  std::cout << "residency: " << residencyManager.getResidentSize() / (1024 * 1024) << "MB of " << residencyManager.getTrackedSize() / (1024 * 1024)
+    << "MB resident, budget: " << residencyManager.getBudget().budget / (1024 * 1024) << "MB, " << residencyManager.getEvictedCount() << " evicted, "
+    << residencyManager.getMadeResidentCount() << " made resident, " << residencyManager.getOverBudgetCount() << " frames over budget" << std::endl;
+  std::cout << "heap allocations per frame: " << getAverageFrameHeapAllocations(stats) << " (max: " << stats.maxFrameHeapAllocations << ")" << std::endl;
+  printProfileStats(std::cout);
+
+  frameTimeline.flush();
+  uploadQueue->flush();
+
+  destroyWindow(hwnd);
+  unregisterWindowClass();
+  return 0;
 }
\ No newline at end of file
@@ -0,0 +1,154 @@
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ============================================================================
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile() : mData(nullptr), mSize(0), mFile(INVALID_HANDLE_VALUE), mMapping(nullptr)
+{
+}
+
+// ============================================================================
+
+bool MappedFile::open(const std::string& path)
+{
+  close();
+
+  // open the file and get its size.
+  mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (mFile == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(mFile, &size)) {
+    close();
+    return false;
+  }
+
+  // empty files cannot be mapped, but they are still valid files.
+  mSize = static_cast<size_t>(size.QuadPart);
+  if (mSize == 0) {
+    return true;
+  }
+
+  // map the whole file as read-only.
+  mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mMapping == nullptr) {
+    close();
+    return false;
+  }
+  mData = static_cast<const uint8_t*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+  if (mData == nullptr) {
+    close();
+    return false;
+  }
+  return true;
+}
+
+// ============================================================================
+
+void MappedFile::close()
+{
+  if (mData != nullptr) {
+    UnmapViewOfFile(mData);
+  }
+  if (mMapping != nullptr) {
+    CloseHandle(mMapping);
+  }
+  if (mFile != INVALID_HANDLE_VALUE) {
+    CloseHandle(mFile);
+  }
+  mData = nullptr;
+  mSize = 0;
+  mFile = INVALID_HANDLE_VALUE;
+  mMapping = nullptr;
+}
+
+#else
+
+// ============================================================================
+
+MappedFile::MappedFile() : mData(nullptr), mSize(0), mFile(-1)
+{
+}
+
+// ============================================================================
+
+bool MappedFile::open(const std::string& path)
+{
+  close();
+
+  // open the file and get its size.
+  mFile = ::open(path.c_str(), O_RDONLY);
+  if (mFile < 0) {
+    return false;
+  }
+  struct stat status;
+  if (fstat(mFile, &status) != 0) {
+    close();
+    return false;
+  }
+
+  // empty files cannot be mapped, but they are still valid files.
+  mSize = static_cast<size_t>(status.st_size);
+  if (mSize == 0) {
+    return true;
+  }
+
+  // map the whole file as read-only.
+  auto data = mmap(nullptr, mSize, PROT_READ, MAP_PRIVATE, mFile, 0);
+  if (data == MAP_FAILED) {
+    close();
+    return false;
+  }
+  mData = static_cast<const uint8_t*>(data);
+  return true;
+}
+
+// ============================================================================
+
+void MappedFile::close()
+{
+  if (mData != nullptr) {
+    munmap(const_cast<uint8_t*>(mData), mSize);
+  }
+  if (mFile >= 0) {
+    ::close(mFile);
+  }
+  mData = nullptr;
+  mSize = 0;
+  mFile = -1;
+}
+
+#endif
+
+// ============================================================================
+
+MappedFile::~MappedFile()
+{
+  close();
+}
+
+// ============================================================================
+
+const uint8_t* MappedFile::getData() const
+{
+  return mData;
+}
+
+// ============================================================================
+
+size_t MappedFile::getSize() const
+{
+  return mSize;
+}
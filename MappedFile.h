@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// ============================================================================
+// A read-only memory mapping of a whole file.
+//
+// The contents are paged in by the operating system on demand, so the data
+// can be used in place without reading or copying it into the heap first.
+// Uses the file mapping API on Windows and mmap elsewhere.
+// ============================================================================
+class MappedFile
+{
+public:
+  MappedFile();
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  // map the file at the given path. returns false if the file cannot be opened or mapped.
+  bool open(const std::string& path);
+
+  // unmap the file. the pointers into the mapped data become invalid.
+  void close();
+
+  // get the mapped contents of the file. nullptr if the file is not mapped or is empty.
+  const uint8_t* getData() const;
+
+  // get the size of the mapped file in bytes.
+  size_t getSize() const;
+
+private:
+  const uint8_t* mData;
+  size_t mSize;
+  #if defined(_WIN32)
+  void* mFile;
+  void* mMapping;
+  #else
+  int mFile;
+  #endif
+};
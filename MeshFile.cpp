@@ -0,0 +1,241 @@
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+// the fraction of the ACMR of the cache-ordered triangles which the overdraw optimization of the converted meshes may use.
+static const auto OVERDRAW_THRESHOLD = 1.05f;
+
+// ============================================================================
+
+MeshFile::MeshFile() : mMesh()
+{
+}
+
+// ============================================================================
+
+bool MeshFile::open(const std::string& path)
+{
+  close();
+  if (!mFile.open(path)) {
+    return false;
+  }
+
+  // reject files of other formats or versions.
+  auto data = mFile.getData();
+  auto size = static_cast<uint64_t>(mFile.getSize());
+  Header header;
+  if (size < sizeof(header)) {
+    close();
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != MAGIC || header.version != VERSION) {
+    close();
+    return false;
+  }
+
+  // reject unknown vertex layouts, unknown index sizes and truncated streams.
+  if (header.positionFormat > static_cast<uint32_t>(PositionFormat::SNORM16) || header.colorFormat > static_cast<uint32_t>(ColorFormat::UNORM8)) {
+    close();
+    return false;
+  }
+  VertexLayout vertexLayout = { static_cast<PositionFormat>(header.positionFormat), static_cast<ColorFormat>(header.colorFormat) };
+  if (header.vertexStride != getVertexStride(vertexLayout) || (header.indexSize != 0 && header.indexSize != 2 && header.indexSize != 4)) {
+    close();
+    return false;
+  }
+  if (header.vertexOffset > size || header.vertexCount > (size - header.vertexOffset) / header.vertexStride) {
+    close();
+    return false;
+  }
+  if (header.indexSize != 0 && (header.indexOffset > size || header.indexCount > (size - header.indexOffset) / header.indexSize)) {
+    close();
+    return false;
+  }
+
+  mMesh.vertices = data + header.vertexOffset;
+  mMesh.vertexCount = header.vertexCount;
+  mMesh.vertexStride = header.vertexStride;
+  mMesh.vertexLayout = vertexLayout;
+  mMesh.indices = header.indexSize != 0 ? data + header.indexOffset : nullptr;
+  mMesh.indexCount = header.indexSize != 0 ? header.indexCount : 0;
+  mMesh.indexSize = header.indexSize;
+  return true;
+}
+
+// ============================================================================
+
+void MeshFile::close()
+{
+  mFile.close();
+  mMesh = MeshDesc();
+}
+
+// ============================================================================
+
+const MeshDesc& MeshFile::getMesh() const
+{
+  return mMesh;
+}
+
+// ============================================================================
+
+uint64_t MeshFile::getFileSize() const
+{
+  return mFile.getSize();
+}
+
+// ============================================================================
+
+void writeMeshFile(std::ostream& stream, const MeshDesc& mesh)
+{
+  // place the streams at page-aligned offsets so that they can be mapped and copied in whole pages.
+  MeshFile::Header header = {};
+  header.magic = MeshFile::MAGIC;
+  header.version = MeshFile::VERSION;
+  header.vertexStride = mesh.vertexStride;
+  header.positionFormat = static_cast<uint32_t>(mesh.vertexLayout.position);
+  header.colorFormat = static_cast<uint32_t>(mesh.vertexLayout.color);
+  header.vertexCount = mesh.vertexCount;
+  header.indexCount = mesh.indexSize != 0 ? mesh.indexCount : 0;
+  header.vertexOffset = MeshFile::STREAM_ALIGNMENT;
+  auto vertexSize = header.vertexCount * header.vertexStride;
+
+  // a mesh without indices has no index stream, whose offset is then the end of the file.
+  if (header.indexCount > 0) {
+    header.indexSize = mesh.indexSize;
+    header.indexOffset = (header.vertexOffset + vertexSize + MeshFile::STREAM_ALIGNMENT - 1) & ~(MeshFile::STREAM_ALIGNMENT - 1);
+  } else {
+    header.indexOffset = header.vertexOffset + vertexSize;
+  }
+  auto indexSize = header.indexCount * header.indexSize;
+
+  static const char padding[MeshFile::STREAM_ALIGNMENT] = {};
+  stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  stream.write(padding, header.vertexOffset - sizeof(header));
+  stream.write(static_cast<const char*>(mesh.vertices), vertexSize);
+  if (indexSize > 0) {
+    stream.write(padding, header.indexOffset - header.vertexOffset - vertexSize);
+    stream.write(static_cast<const char*>(mesh.indices), indexSize);
+  }
+  if (!stream) {
+    throw new std::runtime_error("Failed to write the mesh file");
+  }
+}
+
+// ============================================================================
+
+void writeMeshFile(const std::string& path, const MeshDesc& mesh)
+{
+  std::ofstream stream(path, std::ios::binary);
+  if (!stream) {
+    std::cout << "std::ofstream: " << path << std::endl;
+    throw new std::runtime_error("Failed to open the mesh file");
+  }
+  writeMeshFile(stream, mesh);
+}
+
+// ============================================================================
+
+bool readObjMesh(std::istream& stream, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+  std::string line;
+  std::vector<uint32_t> face;
+  while (std::getline(stream, line)) {
+    std::istringstream tokens(line);
+    std::string type;
+    tokens >> type;
+    if (type == "v") {
+      // the vertex colors are a common extension, so use white for the vertices without them.
+      Vertex vertex = { { 0.f, 0.f, 0.f }, { 1.f, 1.f, 1.f, 1.f } };
+      if (!(tokens >> vertex.position[0] >> vertex.position[1] >> vertex.position[2])) {
+        return false;
+      }
+      float color[3];
+      if (tokens >> color[0] >> color[1] >> color[2]) {
+        vertex.color = { color[0], color[1], color[2], 1.f };
+      }
+      vertices.push_back(vertex);
+    } else if (type == "f") {
+      // only the position index of each "position/texcoord/normal" reference is used.
+      face.clear();
+      std::string reference;
+      while (tokens >> reference) {
+        auto index = std::atoll(reference.c_str());
+        if (index < 0) {
+          index += static_cast<long long>(vertices.size()) + 1;
+        }
+        if (index < 1 || index > static_cast<long long>(vertices.size())) {
+          return false;
+        }
+        face.push_back(static_cast<uint32_t>(index - 1));
+      }
+      if (face.size() < 3) {
+        return false;
+      }
+
+      // triangulate the polygon as a fan.
+      for (auto i = 2u; i < face.size(); i++) {
+        indices.push_back(face[0]);
+        indices.push_back(face[i - 1]);
+        indices.push_back(face[i]);
+      }
+    }
+  }
+  return true;
+}
+
+// ============================================================================
+
+void convertObjToMeshFile(const std::string& objPath, const std::string& meshPath, const VertexLayout& vertexLayout, std::ostream& out)
+{
+  std::ifstream stream(objPath);
+  if (!stream) {
+    std::cout << "std::ifstream: " << objPath << std::endl;
+    throw new std::runtime_error("Failed to open the OBJ file");
+  }
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+  if (!readObjMesh(stream, vertices, indices) || vertices.empty()) {
+    std::cout << "readObjMesh: " << objPath << std::endl;
+    throw new std::runtime_error("Failed to read the OBJ file");
+  }
+
+  // reorder the triangles for the vertex cache and the overdraw and the vertices by their first use.
+  if (!indices.empty()) {
+    auto before = analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+    auto overdrawBefore = analyzeOverdraw(indices.data(), indices.size(), vertices[0].position.data(), vertices.size(), sizeof(Vertex));
+    std::vector<uint32_t> cacheIndices(indices.size());
+    optimizeVertexCache(cacheIndices.data(), indices.data(), indices.size(), vertices.size());
+    optimizeOverdraw(indices.data(), cacheIndices.data(), cacheIndices.size(), vertices[0].position.data(), vertices.size(), sizeof(Vertex), OVERDRAW_THRESHOLD);
+    auto overdrawAfter = analyzeOverdraw(indices.data(), indices.size(), vertices[0].position.data(), vertices.size(), sizeof(Vertex));
+    std::vector<Vertex> fetchVertices(vertices.size());
+    fetchVertices.resize(optimizeVertexFetch(fetchVertices.data(), indices.data(), indices.size(), vertices.data(), vertices.size(), sizeof(Vertex)));
+    vertices.swap(fetchVertices);
+    auto after = analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+    out << "optimized " << indices.size() / 3 << " triangles: ACMR " << before.acmr << " -> " << after.acmr << ", ATVR " << before.atvr
+      << " -> " << after.atvr << ", overdraw " << overdrawBefore << " -> " << overdrawAfter << std::endl;
+  }
+
+  // pack the vertices and halve the size of the index stream when the vertices can be addressed with 16-bit indices.
+  std::vector<uint8_t> packedVertices(vertices.size() * getVertexStride(vertexLayout));
+  encodeVertices(vertices.data(), vertices.size(), vertexLayout, packedVertices.data());
+  MeshDesc mesh = { packedVertices.data(), vertices.size(), getVertexStride(vertexLayout), vertexLayout, indices.data(), indices.size(), 4 };
+  std::vector<uint16_t> shortIndices;
+  if (indices.empty()) {
+    mesh.indices = nullptr;
+    mesh.indexSize = 0;
+  } else if (vertices.size() <= std::numeric_limits<uint16_t>::max()) {
+    shortIndices.assign(indices.begin(), indices.end());
+    mesh.indices = shortIndices.data();
+    mesh.indexSize = 2;
+  }
+  writeMeshFile(meshPath, mesh);
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "MappedFile.h"
+#include "VertexFormat.h"
+
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// ============================================================================
+
+// the vertex and index streams of a mesh.
+struct MeshDesc
+{
+  const void* vertices;
+  uint64_t vertexCount;
+  uint32_t vertexStride;
+  VertexLayout vertexLayout;
+  // the indices are either 16-bit or 32-bit. the index size is zero for meshes without indices.
+  const void* indices;
+  uint64_t indexCount;
+  uint32_t indexSize;
+};
+
+// ============================================================================
+// A memory-mapped binary mesh file.
+//
+// The file consists of a versioned header followed by the vertex and index
+// streams, which both start at a page-aligned offset. The file is mapped and
+// only its header is validated when it is opened, so the streams can be
+// copied directly from the mapping into the upload buffer as the operating
+// system pages them in, without reading them into the heap first.
+// ============================================================================
+class MeshFile
+{
+public:
+  // the identifier at the beginning of the mesh file.
+  static const uint32_t MAGIC = 0x4853454d; // "MESH"
+  // the version of the mesh file format.
+  static const uint32_t VERSION = 2;
+  // the alignment of the streams in the file.
+  static const uint64_t STREAM_ALIGNMENT = 4096;
+
+  // the header at the beginning of the mesh file.
+  struct Header
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t vertexStride;
+    uint32_t indexSize;
+    uint32_t positionFormat;
+    uint32_t colorFormat;
+    uint64_t vertexCount;
+    uint64_t indexCount;
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+  };
+
+  MeshFile();
+
+  // map the mesh file at the given path. returns false if the file is missing, of another format or truncated.
+  bool open(const std::string& path);
+
+  // unmap the mesh file. the stream pointers become invalid.
+  void close();
+
+  // get the mapped streams of the mesh.
+  const MeshDesc& getMesh() const;
+
+  // get the size of the whole mesh file in bytes.
+  uint64_t getFileSize() const;
+
+private:
+  MappedFile mFile;
+  MeshDesc mMesh;
+};
+
+// ============================================================================
+
+// write the mesh into a mesh file (or a stream) in the native (little-endian) layout.
+void writeMeshFile(std::ostream& stream, const MeshDesc& mesh);
+void writeMeshFile(const std::string& path, const MeshDesc& mesh);
+
+// read the vertex positions (and the optional vertex colors) and the triangulated faces of a Wavefront OBJ file.
+// returns false if the file contains malformed vertices or faces.
+bool readObjMesh(std::istream& stream, std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// convert a Wavefront OBJ file into a mesh file with the packed vertex layout and with 16-bit indices when they are enough.
+// the streams are optimized for the vertex cache, the overdraw and the vertex fetch, and the statistics are reported.
+void convertObjToMeshFile(const std::string& objPath, const std::string& meshPath, const VertexLayout& vertexLayout, std::ostream& out);
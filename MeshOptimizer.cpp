@@ -0,0 +1,484 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+// the size of the LRU cache which the vertex cache optimization simulates, and the weights of the scores of Forsyth.
+static const auto OPTIMIZER_CACHE_SIZE = 32u;
+static const auto CACHE_DECAY_POWER = 1.5f;
+static const auto LAST_TRIANGLE_SCORE = 0.75f;
+static const auto VALENCE_BOOST_SCALE = 2.f;
+static const auto VALENCE_BOOST_POWER = 0.5f;
+// the valences beyond which the valence boost is considered constant.
+static const auto MAX_SCORED_VALENCE = 32u;
+// the line size and the amount of lines of the simulated cache of the vertex fetch.
+static const auto FETCH_LINE_SIZE = 64u;
+static const auto FETCH_CACHE_LINES = 64u;
+// the resolution of the rasterized views of the overdraw statistics.
+static const auto OVERDRAW_RESOLUTION = 256;
+// the amount of times that the overdraw optimization tightens its split threshold before it splits only at the hard
+// boundaries.
+static const auto MAX_SPLIT_ATTEMPTS = 4u;
+
+// ============================================================================
+
+// check that the index count describes whole triangles and that all indices reference the vertices.
+static void validateIndices(const uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+  if (indexCount % 3 != 0) {
+    throw new std::runtime_error("Index count must be a multiple of three");
+  }
+  for (size_t i = 0; i < indexCount; i++) {
+    if (indices[i] >= vertexCount) {
+      throw new std::runtime_error("Index references a vertex out of range");
+    }
+  }
+}
+
+// ============================================================================
+
+// a FIFO post-transform cache which tracks the time of the miss that loaded each vertex. a vertex is cached as long as
+// fewer than the cache size misses have happened since its own.
+class FifoCache
+{
+public:
+  FifoCache(size_t vertexCount, unsigned int cacheSize)
+    : mTimes(vertexCount, 0), mTime(cacheSize + 1), mCacheSize(cacheSize)
+  {
+  }
+
+  // access the vertex and return whether it was a miss.
+  bool access(uint32_t vertex)
+  {
+    if (mTime - mTimes[vertex] > mCacheSize) {
+      mTimes[vertex] = mTime++;
+      return true;
+    }
+    return false;
+  }
+
+  // flush the cache, so every vertex misses again.
+  void flush()
+  {
+    mTime += mCacheSize + 1;
+  }
+
+private:
+  std::vector<uint64_t> mTimes;
+  uint64_t mTime;
+  unsigned int mCacheSize;
+};
+
+// ============================================================================
+
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize)
+{
+  validateIndices(indices, indexCount, vertexCount);
+  FifoCache cache(vertexCount, cacheSize);
+  std::vector<bool> referenced(vertexCount, false);
+  auto referencedCount = 0ull;
+  VertexCacheStats stats = {};
+  for (size_t i = 0; i < indexCount; i++) {
+    if (cache.access(indices[i])) {
+      stats.transformedCount++;
+    }
+    if (!referenced[indices[i]]) {
+      referenced[indices[i]] = true;
+      referencedCount++;
+    }
+  }
+  stats.acmr = indexCount > 0 ? static_cast<double>(stats.transformedCount) / (indexCount / 3) : 0.0;
+  stats.atvr = referencedCount > 0 ? static_cast<double>(stats.transformedCount) / referencedCount : 0.0;
+  return stats;
+}
+
+// ============================================================================
+
+double analyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexStride)
+{
+  // only the vertices which miss the post-transform cache are fetched, through a FIFO cache of the stream lines.
+  validateIndices(indices, indexCount, vertexCount);
+  FifoCache vertexCache(vertexCount, VERTEX_CACHE_SIZE);
+  FifoCache lineCache((vertexCount * vertexStride + FETCH_LINE_SIZE - 1) / FETCH_LINE_SIZE, FETCH_CACHE_LINES);
+  std::vector<bool> referenced(vertexCount, false);
+  auto referencedCount = 0ull;
+  auto fetchedSize = 0ull;
+  for (size_t i = 0; i < indexCount; i++) {
+    auto vertex = indices[i];
+    if (!referenced[vertex]) {
+      referenced[vertex] = true;
+      referencedCount++;
+    }
+    if (!vertexCache.access(vertex)) {
+      continue;
+    }
+    auto firstLine = vertex * vertexStride / FETCH_LINE_SIZE;
+    auto lastLine = (vertex * vertexStride + vertexStride - 1) / FETCH_LINE_SIZE;
+    for (auto line = firstLine; line <= lastLine; line++) {
+      if (lineCache.access(static_cast<uint32_t>(line))) {
+        fetchedSize += FETCH_LINE_SIZE;
+      }
+    }
+  }
+  return referencedCount > 0 ? static_cast<double>(fetchedSize) / (referencedCount * vertexStride) : 0.0;
+}
+
+// ============================================================================
+
+double analyzeOverdraw(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride)
+{
+  validateIndices(indices, indexCount, vertexCount);
+  auto getPosition = [&](uint32_t vertex) {
+    return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+  };
+
+  // scale the bounds of the mesh uniformly into the views.
+  auto limit = std::numeric_limits<float>::max();
+  float minimum[3] = { limit, limit, limit };
+  float maximum[3] = { -limit, -limit, -limit };
+  for (size_t i = 0; i < indexCount; i++) {
+    auto position = getPosition(indices[i]);
+    for (auto axis = 0; axis < 3; axis++) {
+      minimum[axis] = std::min(minimum[axis], position[axis]);
+      maximum[axis] = std::max(maximum[axis], position[axis]);
+    }
+  }
+  auto extent = std::max(std::max(maximum[0] - minimum[0], maximum[1] - minimum[1]), maximum[2] - minimum[2]);
+  auto scale = extent > 0.f ? (OVERDRAW_RESOLUTION - 1) / extent : 0.f;
+
+  // each view looks along an axis, where the screen axes are the other two axes in the order which keeps the
+  // counter-clockwise triangles facing the viewer front-facing.
+  std::vector<float> depths(OVERDRAW_RESOLUTION * OVERDRAW_RESOLUTION);
+  auto shadedCount = 0ull;
+  auto coveredCount = 0ull;
+  for (auto view = 0; view < 6; view++) {
+    auto axis = view / 2;
+    auto uAxis = (axis + 1 + view % 2) % 3;
+    auto vAxis = (axis + 2 - view % 2) % 3;
+    auto depthSign = view % 2 == 0 ? -1.f : 1.f;
+    std::fill(depths.begin(), depths.end(), std::numeric_limits<float>::infinity());
+
+    for (size_t i = 0; i < indexCount; i += 3) {
+      float u[3], v[3], d[3];
+      for (auto corner = 0; corner < 3; corner++) {
+        auto position = getPosition(indices[i + corner]);
+        u[corner] = (position[uAxis] - minimum[uAxis]) * scale;
+        v[corner] = (position[vAxis] - minimum[vAxis]) * scale;
+        d[corner] = position[axis] * depthSign;
+      }
+      auto area = (u[1] - u[0]) * (v[2] - v[0]) - (u[2] - u[0]) * (v[1] - v[0]);
+      if (area <= 0.f) {
+        continue;
+      }
+
+      // test the pixel centers in the bounds of the triangle with the edge functions.
+      auto minX = std::max(0, static_cast<int>(std::floor(std::min(std::min(u[0], u[1]), u[2]))));
+      auto maxX = std::min(OVERDRAW_RESOLUTION - 1, static_cast<int>(std::ceil(std::max(std::max(u[0], u[1]), u[2]))));
+      auto minY = std::max(0, static_cast<int>(std::floor(std::min(std::min(v[0], v[1]), v[2]))));
+      auto maxY = std::min(OVERDRAW_RESOLUTION - 1, static_cast<int>(std::ceil(std::max(std::max(v[0], v[1]), v[2]))));
+      for (auto y = minY; y <= maxY; y++) {
+        auto py = y + 0.5f;
+        for (auto x = minX; x <= maxX; x++) {
+          auto px = x + 0.5f;
+          auto w0 = (u[2] - u[1]) * (py - v[1]) - (v[2] - v[1]) * (px - u[1]);
+          auto w1 = (u[0] - u[2]) * (py - v[2]) - (v[0] - v[2]) * (px - u[2]);
+          auto w2 = (u[1] - u[0]) * (py - v[0]) - (v[1] - v[0]) * (px - u[0]);
+          if (w0 < 0.f || w1 < 0.f || w2 < 0.f) {
+            continue;
+          }
+          auto depth = (w0 * d[0] + w1 * d[1] + w2 * d[2]) / area;
+          auto& stored = depths[y * OVERDRAW_RESOLUTION + x];
+          if (depth < stored) {
+            stored = depth;
+            shadedCount++;
+          }
+        }
+      }
+    }
+    for (auto depth : depths) {
+      coveredCount += depth != std::numeric_limits<float>::infinity() ? 1 : 0;
+    }
+  }
+  return coveredCount > 0 ? static_cast<double>(shadedCount) / coveredCount : 0.0;
+}
+
+// ============================================================================
+
+void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+  validateIndices(indices, indexCount, vertexCount);
+  auto triangleCount = indexCount / 3;
+
+  // the scores of the positions in the cache, where the vertices of the last triangle get a fixed score so that the
+  // next triangle does not prefer any of its edges, and the boosts of the vertices with few remaining triangles.
+  float cacheScores[OPTIMIZER_CACHE_SIZE];
+  for (auto position = 0u; position < OPTIMIZER_CACHE_SIZE; position++) {
+    cacheScores[position] = position < 3 ? LAST_TRIANGLE_SCORE :
+      std::pow(1.f - static_cast<float>(position - 3) / (OPTIMIZER_CACHE_SIZE - 3), CACHE_DECAY_POWER);
+  }
+  float valenceScores[MAX_SCORED_VALENCE + 1];
+  valenceScores[0] = 0.f;
+  for (auto valence = 1u; valence <= MAX_SCORED_VALENCE; valence++) {
+    valenceScores[valence] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(valence), -VALENCE_BOOST_POWER);
+  }
+  auto getVertexScore = [&](int cachePosition, uint32_t valence) {
+    if (valence == 0) {
+      return -1.f;
+    }
+    auto score = cachePosition >= 0 ? cacheScores[cachePosition] : 0.f;
+    return score + valenceScores[std::min(valence, MAX_SCORED_VALENCE)];
+  };
+
+  // the triangles of each vertex, where the first ones up to its valence are the triangles which remain.
+  std::vector<uint32_t> valences(vertexCount, 0);
+  for (size_t i = 0; i < indexCount; i++) {
+    valences[indices[i]]++;
+  }
+  std::vector<uint32_t> offsets(vertexCount + 1, 0);
+  for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+    offsets[vertex + 1] = offsets[vertex] + valences[vertex];
+  }
+  std::vector<uint32_t> triangles(indexCount);
+  std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+  for (size_t i = 0; i < indexCount; i++) {
+    triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+  }
+
+  std::vector<int> cachePositions(vertexCount, -1);
+  std::vector<float> vertexScores(vertexCount);
+  for (size_t vertex = 0; vertex < vertexCount; vertex++) {
+    vertexScores[vertex] = getVertexScore(-1, valences[vertex]);
+  }
+  std::vector<float> triangleScores(triangleCount);
+  for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+    auto index = indices + triangle * 3;
+    triangleScores[triangle] = vertexScores[index[0]] + vertexScores[index[1]] + vertexScores[index[2]];
+  }
+  std::vector<bool> emitted(triangleCount, false);
+
+  // the LRU cache holds three more vertices while it is updated.
+  uint32_t cache[OPTIMIZER_CACHE_SIZE + 3];
+  uint32_t nextCache[OPTIMIZER_CACHE_SIZE + 3];
+  auto cacheCount = 0u;
+  auto best = triangleCount > 0 ? static_cast<size_t>(std::max_element(triangleScores.begin(), triangleScores.end()) - triangleScores.begin()) : 0;
+  size_t cursor = 0;
+  for (size_t output = 0; output < triangleCount; output++) {
+    // when no triangle of the cache remains, continue with the next triangle in the input order.
+    if (best == triangleCount) {
+      while (emitted[cursor]) {
+        cursor++;
+      }
+      best = cursor;
+    }
+
+    // emit the triangle and remove it from the remaining triangles of its vertices.
+    auto index = indices + best * 3;
+    memcpy(destination + output * 3, index, 3 * sizeof(uint32_t));
+    emitted[best] = true;
+    for (auto corner = 0; corner < 3; corner++) {
+      auto vertex = index[corner];
+      auto first = triangles.begin() + offsets[vertex];
+      auto last = first + valences[vertex];
+      auto position = std::find(first, last, static_cast<uint32_t>(best));
+      *position = *(last - 1);
+      valences[vertex]--;
+    }
+
+    // move the vertices of the triangle to the front of the cache.
+    auto nextCount = 0u;
+    for (auto corner = 0; corner < 3; corner++) {
+      if (std::find(nextCache, nextCache + nextCount, index[corner]) == nextCache + nextCount) {
+        nextCache[nextCount++] = index[corner];
+      }
+    }
+    for (auto i = 0u; i < cacheCount; i++) {
+      if (cache[i] != index[0] && cache[i] != index[1] && cache[i] != index[2]) {
+        nextCache[nextCount++] = cache[i];
+      }
+    }
+
+    // update the scores of the vertices which moved or were evicted and of their remaining triangles.
+    for (auto i = 0u; i < nextCount; i++) {
+      auto vertex = nextCache[i];
+      cachePositions[vertex] = i < OPTIMIZER_CACHE_SIZE ? static_cast<int>(i) : -1;
+      auto score = getVertexScore(cachePositions[vertex], valences[vertex]);
+      auto delta = score - vertexScores[vertex];
+      vertexScores[vertex] = score;
+      for (auto j = offsets[vertex]; j < offsets[vertex] + valences[vertex]; j++) {
+        triangleScores[triangles[j]] += delta;
+      }
+    }
+
+    // the next triangle is the best of the remaining triangles of the cached vertices.
+    cacheCount = std::min(nextCount, OPTIMIZER_CACHE_SIZE);
+    best = triangleCount;
+    auto bestScore = -std::numeric_limits<float>::max();
+    for (auto i = 0u; i < cacheCount; i++) {
+      auto vertex = nextCache[i];
+      for (auto j = offsets[vertex]; j < offsets[vertex] + valences[vertex]; j++) {
+        if (triangleScores[triangles[j]] > bestScore) {
+          bestScore = triangleScores[triangles[j]];
+          best = triangles[j];
+        }
+      }
+    }
+    std::copy(nextCache, nextCache + cacheCount, cache);
+  }
+}
+
+// ============================================================================
+
+void optimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold)
+{
+  validateIndices(indices, indexCount, vertexCount);
+  auto triangleCount = indexCount / 3;
+  if (triangleCount == 0) {
+    return;
+  }
+  auto getPosition = [&](uint32_t vertex) {
+    return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * positionStride);
+  };
+  auto getMissCount = [&](FifoCache& cache, size_t triangle) {
+    auto index = indices + triangle * 3;
+    return (cache.access(index[0]) ? 1u : 0u) + (cache.access(index[1]) ? 1u : 0u) + (cache.access(index[2]) ? 1u : 0u);
+  };
+
+  // the hard boundaries are the triangles whose vertices all miss the cache, so the order of the clusters between them
+  // hardly changes the cache efficiency.
+  std::vector<uint32_t> hardClusters;
+  std::vector<uint8_t> missCounts(triangleCount);
+  FifoCache cache(vertexCount, VERTEX_CACHE_SIZE);
+  for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+    missCounts[triangle] = static_cast<uint8_t>(getMissCount(cache, triangle));
+    if (missCounts[triangle] == 3) {
+      hardClusters.push_back(static_cast<uint32_t>(triangle));
+    }
+  }
+  hardClusters.push_back(static_cast<uint32_t>(triangleCount));
+
+  // compute the area-weighted centroid of the whole mesh.
+  float meshCentroid[3] = { 0.f, 0.f, 0.f };
+  auto meshArea = 0.f;
+  std::vector<float> triangleData(triangleCount * 7);
+  for (size_t triangle = 0; triangle < triangleCount; triangle++) {
+    auto p0 = getPosition(indices[triangle * 3]);
+    auto p1 = getPosition(indices[triangle * 3 + 1]);
+    auto p2 = getPosition(indices[triangle * 3 + 2]);
+    float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+    auto area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    auto data = triangleData.data() + triangle * 7;
+    for (auto axis = 0; axis < 3; axis++) {
+      data[axis] = (p0[axis] + p1[axis] + p2[axis]) / 3.f * area;
+      data[3 + axis] = normal[axis];
+      meshCentroid[axis] += data[axis];
+    }
+    data[6] = area;
+    meshArea += area;
+  }
+  for (auto axis = 0; axis < 3; axis++) {
+    meshCentroid[axis] = meshArea > 0.f ? meshCentroid[axis] / meshArea : 0.f;
+  }
+
+  // split the hard clusters further wherever the triangles so far, from an empty cache, are already within the split
+  // threshold of the ACMR of the whole hard cluster in the input order. no cluster is split with a zero threshold.
+  std::vector<uint32_t> clusters;
+  std::vector<float> sortKeys;
+  std::vector<uint32_t> order;
+  auto sortClusters = [&](float splitThreshold) {
+    clusters.clear();
+    for (size_t i = 0; i + 1 < hardClusters.size(); i++) {
+      auto begin = hardClusters[i];
+      auto end = hardClusters[i + 1];
+      auto missCount = 0u;
+      for (auto triangle = begin; triangle < end; triangle++) {
+        missCount += missCounts[triangle];
+      }
+      auto clusterThreshold = splitThreshold * missCount / (end - begin);
+
+      clusters.push_back(begin);
+      cache.flush();
+      auto runningMissCount = 0u;
+      auto runningCount = 0u;
+      for (auto triangle = begin; triangle + 1 < end; triangle++) {
+        runningMissCount += getMissCount(cache, triangle);
+        runningCount++;
+        if (runningMissCount <= clusterThreshold * runningCount) {
+          clusters.push_back(triangle + 1);
+          cache.flush();
+          runningMissCount = 0;
+          runningCount = 0;
+        }
+      }
+    }
+    clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+    // draw the clusters which face away from the center of the mesh first, as they likely occlude the others. the
+    // key is the distance of the cluster centroid from the mesh centroid along the average normal of the cluster.
+    auto clusterCount = clusters.size() - 1;
+    sortKeys.assign(clusterCount, 0.f);
+    order.resize(clusterCount);
+    for (size_t cluster = 0; cluster < clusterCount; cluster++) {
+      float sum[7] = {};
+      for (auto triangle = clusters[cluster]; triangle < clusters[cluster + 1]; triangle++) {
+        for (auto i = 0; i < 7; i++) {
+          sum[i] += triangleData[triangle * 7 + i];
+        }
+      }
+      auto length = std::sqrt(sum[3] * sum[3] + sum[4] * sum[4] + sum[5] * sum[5]);
+      if (sum[6] > 0.f && length > 0.f) {
+        for (auto axis = 0; axis < 3; axis++) {
+          sortKeys[cluster] += (sum[axis] / sum[6] - meshCentroid[axis]) * sum[3 + axis] / length;
+        }
+      }
+      order[cluster] = static_cast<uint32_t>(cluster);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+    auto output = destination;
+    for (auto cluster : order) {
+      auto count = (clusters[cluster + 1] - clusters[cluster]) * 3;
+      memcpy(output, indices + clusters[cluster] * 3, count * sizeof(uint32_t));
+      output += count;
+    }
+  };
+
+  // the clusters lose the vertices which the cache held at their start, so the split threshold is tightened until the
+  // sorted clusters keep the ACMR within the threshold. the input order is kept when even the hard clusters do not.
+  auto inputMissCount = 0ull;
+  for (auto missCount : missCounts) {
+    inputMissCount += missCount;
+  }
+  for (auto attempt = 0u; attempt <= MAX_SPLIT_ATTEMPTS; attempt++) {
+    sortClusters(attempt < MAX_SPLIT_ATTEMPTS ? 1.f + (threshold - 1.f) / (1u << attempt) : 0.f);
+    auto stats = analyzeVertexCache(destination, indexCount, vertexCount);
+    if (stats.transformedCount <= threshold * inputMissCount) {
+      return;
+    }
+  }
+  memcpy(destination, indices, indexCount * sizeof(uint32_t));
+}
+
+// ============================================================================
+
+size_t optimizeVertexFetch(void* destination, uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t vertexStride)
+{
+  validateIndices(indices, indexCount, vertexCount);
+  std::vector<uint32_t> remap(vertexCount, ~0u);
+  size_t count = 0;
+  for (size_t i = 0; i < indexCount; i++) {
+    auto& target = remap[indices[i]];
+    if (target == ~0u) {
+      target = static_cast<uint32_t>(count);
+      memcpy(static_cast<uint8_t*>(destination) + count * vertexStride, static_cast<const uint8_t*>(vertices) + indices[i] * vertexStride, vertexStride);
+      count++;
+    }
+    indices[i] = target;
+  }
+  return count;
+}
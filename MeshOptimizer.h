@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// The optimization of the index and vertex streams of triangle lists.
+//
+// The triangles are first reordered for the post-transform vertex cache with
+// the linear-speed algorithm of Tom Forsyth, which greedily emits the
+// triangle whose vertices score best by their position in a simulated LRU
+// cache and by their remaining triangles. The cache-ordered triangles are
+// then split into clusters, which are sorted so that the clusters facing
+// away from the center of the mesh are drawn first and occlude the rest
+// (Sander et al., "Fast Triangle Reordering for Vertex Locality and Reduced
+// Overdraw"), as long as the clusters keep the cache efficiency within a
+// threshold. Finally, the vertices are reordered by their first use, so the
+// vertex fetch reads the vertex stream mostly sequentially. The analyzers
+// measure each step on a model of the hardware: a FIFO post-transform cache,
+// a cache of the vertex stream lines and an orthographic rasterizer.
+// ============================================================================
+
+// the size of the simulated FIFO post-transform cache of the vertex cache statistics.
+static const unsigned int VERTEX_CACHE_SIZE = 16;
+
+// the post-transform cache efficiency of a triangle list: the transformed vertices per triangle (ACMR, 0.5 at best
+// for large regular meshes and 3 at worst) and per vertex (ATVR, 1 at best).
+struct VertexCacheStats
+{
+  uint64_t transformedCount;
+  double acmr;
+  double atvr;
+};
+
+// simulate the post-transform cache of the given size over the triangle list.
+VertexCacheStats analyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, unsigned int cacheSize = VERTEX_CACHE_SIZE);
+
+// get the bytes read from the vertex stream per byte of the referenced vertices, i.e. 1 when every vertex is read once.
+double analyzeVertexFetch(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t vertexStride);
+
+// get the shaded pixels per covered pixel when the triangle list is rasterized with a depth test and back-face culling
+// from the six axis directions. the positions are three floats at the given stride.
+double analyzeOverdraw(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride);
+
+// reorder the triangles for the post-transform cache. the destination must not be the source.
+void optimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+// reorder the clusters of the cache-ordered triangles to reduce the overdraw while the ACMR stays within the given
+// fraction (e.g. 1.05) of the ACMR of the input. the destination must not be the source.
+void optimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold);
+
+// reorder the vertices by their first use in the triangle list and remap the indices in place. the unreferenced
+// vertices are dropped. returns the amount of vertices written into the destination, which must not be the source.
+size_t optimizeVertexFetch(void* destination, uint32_t* indices, size_t indexCount, const void* vertices, size_t vertexCount, size_t vertexStride);
@@ -0,0 +1,434 @@
+#include "NullBackend.h"
+
+#include <cstring>
+#include <stdexcept>
+
+using namespace std::chrono;
+
+// ============================================================================
+
+NullFence::NullFence() : mCompletedValue(0)
+{
+}
+
+// ============================================================================
+
+uint64_t NullFence::getCompletedValue() const
+{
+  return mCompletedValue.load();
+}
+
+// ============================================================================
+
+bool NullFence::wait(uint64_t value, milliseconds duration)
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  auto reached = [&] { return mCompletedValue.load() >= value; };
+  if (duration == milliseconds::max()) {
+    mCompleted.wait(lock, reached);
+    return true;
+  }
+  return mCompleted.wait_for(lock, duration, reached);
+}
+
+// ============================================================================
+
+void NullFence::setCompletedValue(uint64_t value)
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mCompletedValue.store(value);
+  }
+  mCompleted.notify_all();
+}
+
+// ============================================================================
+
+NullCommandList::NullCommandList(microseconds gpuTime) : mGpuTime(gpuTime)
+{
+}
+
+// ============================================================================
+
+microseconds NullCommandList::getGpuTime() const
+{
+  return mGpuTime;
+}
+
+// ============================================================================
+
+void NullCommandList::setGpuTime(microseconds gpuTime)
+{
+  mGpuTime = gpuTime;
+}
+
+// ============================================================================
+
+void NullCommandList::setRootSignature(const void*)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::setPipelineState(const void*)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::setViewport(const CommandViewport&)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::setScissorRect(const CommandRect&)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::resourceBarrier(unsigned int, const ResourceBarrier*)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::setRenderTarget(uint64_t)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::clearRenderTarget(uint64_t, const float[4])
+{
+}
+
+// ============================================================================
+
+void NullCommandList::setPrimitiveTopology(PrimitiveTopology)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::setVertexBuffer(unsigned int, const CommandVertexBufferView&)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::setIndexBuffer(const CommandIndexBufferView&)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::drawInstanced(uint32_t, uint32_t, uint32_t, uint32_t)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::drawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::endTimestampQuery(const void*, uint32_t)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::resolveTimestampQueries(const void*, uint32_t, uint32_t, const void*, uint64_t)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::setDescriptorHeap(const void*)
+{
+}
+
+// ============================================================================
+
+void NullCommandList::setRootDescriptorTable(uint32_t, uint64_t)
+{
+}
+
+// ============================================================================
+
+NullCommandQueue::NullCommandQueue() : mCommands(MAX_COMMAND_COUNT), mFirstCommand(0), mCommandCount(0), mRunning(true)
+{
+  mThread = std::thread(&NullCommandQueue::run, this);
+}
+
+// ============================================================================
+
+NullCommandQueue::~NullCommandQueue()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRunning = false;
+  }
+  mSubmitted.notify_all();
+  mThread.join();
+}
+
+// ============================================================================
+
+void NullCommandQueue::executeCommandLists(unsigned int count, CommandList* const* commandLists)
+{
+  for (auto i = 0u; i < count; i++) {
+    auto commandList = static_cast<NullCommandList*>(commandLists[i]);
+    submit({ CommandType::EXECUTE, commandList->getGpuTime(), nullptr, 0 });
+  }
+}
+
+// ============================================================================
+
+void NullCommandQueue::signal(Fence& fence, uint64_t value)
+{
+  submit({ CommandType::SIGNAL, microseconds::zero(), static_cast<NullFence*>(&fence), value });
+}
+
+// ============================================================================
+
+void NullCommandQueue::wait(Fence& fence, uint64_t value)
+{
+  submit({ CommandType::WAIT, microseconds::zero(), static_cast<NullFence*>(&fence), value });
+}
+
+// ============================================================================
+
+void NullCommandQueue::submit(const Command& command)
+{
+  {
+    // wait until the simulated GPU has taken a command when the ring is full.
+    std::unique_lock<std::mutex> lock(mMutex);
+    mTaken.wait(lock, [&] { return mCommandCount < mCommands.size(); });
+    mCommands[(mFirstCommand + mCommandCount) % mCommands.size()] = command;
+    mCommandCount++;
+  }
+  mSubmitted.notify_one();
+}
+
+// ============================================================================
+
+void NullCommandQueue::run()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+  while (true) {
+    // wait until there's something to execute or the queue is being destroyed.
+    mSubmitted.wait(lock, [&] { return mCommandCount > 0 || !mRunning; });
+    if (mCommandCount == 0) {
+      return;
+    }
+    auto command = mCommands[mFirstCommand];
+    mFirstCommand = (mFirstCommand + 1) % mCommands.size();
+    mCommandCount--;
+
+    // execute the command outside of the lock so submissions are not blocked.
+    lock.unlock();
+    mTaken.notify_one();
+    switch (command.type) {
+      case CommandType::EXECUTE:
+        busyWait(command.gpuTime);
+        break;
+      case CommandType::SIGNAL:
+        command.fence->setCompletedValue(command.value);
+        break;
+      case CommandType::WAIT:
+        command.fence->wait(command.value, milliseconds::max());
+        break;
+    }
+    lock.lock();
+  }
+}
+
+// ============================================================================
+
+NullSwapChain::NullSwapChain(unsigned int bufferCount, microseconds refreshInterval)
+  : mBufferCount(bufferCount), mBufferIndex(0), mRefreshInterval(refreshInterval), mStartTime(steady_clock::now())
+{
+}
+
+// ============================================================================
+
+unsigned int NullSwapChain::getBufferCount() const
+{
+  return mBufferCount;
+}
+
+// ============================================================================
+
+unsigned int NullSwapChain::getCurrentBackBufferIndex() const
+{
+  return mBufferIndex;
+}
+
+// ============================================================================
+
+void NullSwapChain::waitForNextFrame()
+{
+  // the presents wait for their vertical blank right away, so there is never a queued frame to wait for.
+}
+
+// ============================================================================
+
+void NullSwapChain::present(PresentMode mode)
+{
+  // wait for the next simulated vertical blank.
+  if (mode == PresentMode::VSYNC && mRefreshInterval > microseconds::zero()) {
+    auto interval = duration_cast<steady_clock::duration>(mRefreshInterval);
+    auto elapsed = steady_clock::now() - mStartTime;
+    auto vblank = mStartTime + interval * (elapsed / interval + 1);
+    while (steady_clock::now() < vblank) {
+      std::this_thread::yield();
+    }
+  }
+
+  // proceed to next buffer in a round-robin manner.
+  mBufferIndex = (mBufferIndex + 1) % mBufferCount;
+}
+
+// ============================================================================
+
+bool NullSwapChain::getVblankTiming(VblankTiming& timing)
+{
+  if (mRefreshInterval <= microseconds::zero()) {
+    return false;
+  }
+  timing.time = mStartTime;
+  timing.interval = mRefreshInterval;
+  return true;
+}
+
+// ============================================================================
+
+NullCopyRecorder::NullCopyRecorder(unsigned int commandListCount, uint64_t bytesPerMicrosecond)
+  : mCommandLists(commandListCount, NullCommandList(microseconds::zero())), mCopySizes(commandListCount, 0), mBytesPerMicrosecond(bytesPerMicrosecond)
+{
+}
+
+// ============================================================================
+
+unsigned int NullCopyRecorder::getCommandListCount() const
+{
+  return static_cast<unsigned int>(mCommandLists.size());
+}
+
+// ============================================================================
+
+void NullCopyRecorder::begin(unsigned int index)
+{
+  mCopySizes[index] = 0;
+}
+
+// ============================================================================
+
+void NullCopyRecorder::copyBuffer(unsigned int index, void* destination, uint64_t destinationOffset, const UploadAllocation& source)
+{
+  memcpy(static_cast<uint8_t*>(destination) + destinationOffset, source.cpuAddress, static_cast<size_t>(source.size));
+  mCopySizes[index] += source.size;
+}
+
+// ============================================================================
+
+CommandList& NullCopyRecorder::end(unsigned int index)
+{
+  mCommandLists[index].setGpuTime(microseconds(mCopySizes[index] / mBytesPerMicrosecond));
+  return mCommandLists[index];
+}
+
+// ============================================================================
+
+NullResidencyBackend::NullResidencyBackend(uint64_t budget, uint64_t otherUsage)
+  : mBudget(budget), mUsage(otherUsage)
+{
+}
+
+// ============================================================================
+
+const void* NullResidencyBackend::createObject(uint64_t size)
+{
+  Object object = { size, true };
+  mObjects.push_back(object);
+  mUsage += size;
+  return &mObjects.back();
+}
+
+// ============================================================================
+
+void NullResidencyBackend::setBudget(uint64_t budget)
+{
+  mBudget = budget;
+}
+
+// ============================================================================
+
+bool NullResidencyBackend::isResident(const void* object) const
+{
+  return static_cast<const Object*>(object)->resident;
+}
+
+// ============================================================================
+
+MemoryBudget NullResidencyBackend::queryBudget()
+{
+  return { mBudget, mUsage };
+}
+
+// ============================================================================
+
+void NullResidencyBackend::makeResident(unsigned int count, const void* const* objects)
+{
+  for (auto i = 0u; i < count; i++) {
+    auto object = const_cast<Object*>(static_cast<const Object*>(objects[i]));
+    if (object->resident) {
+      throw new std::runtime_error("Object is already resident");
+    }
+    object->resident = true;
+    mUsage += object->size;
+  }
+}
+
+// ============================================================================
+
+void NullResidencyBackend::evict(unsigned int count, const void* const* objects)
+{
+  for (auto i = 0u; i < count; i++) {
+    auto object = const_cast<Object*>(static_cast<const Object*>(objects[i]));
+    if (!object->resident) {
+      throw new std::runtime_error("Object is already evicted");
+    }
+    object->resident = false;
+    mUsage -= object->size;
+  }
+}
+
+// ============================================================================
+
+std::unique_ptr<CommandQueue> NullDevice::createCommandQueue(CommandListType)
+{
+  return std::unique_ptr<CommandQueue>(new NullCommandQueue());
+}
+
+// ============================================================================
+
+std::unique_ptr<Fence> NullDevice::createFence()
+{
+  return std::unique_ptr<Fence>(new NullFence());
+}
+
+// ============================================================================
+
+void busyWait(microseconds duration)
+{
+  auto deadline = steady_clock::now() + duration;
+  while (steady_clock::now() < deadline) {
+    std::this_thread::yield();
+  }
+}
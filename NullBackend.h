@@ -0,0 +1,217 @@
+#pragma once
+
+#include "Backend.h"
+#include "CommandStream.h"
+#include "ResidencyManager.h"
+#include "UploadQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ============================================================================
+// A CPU-only implementation of the backend.
+//
+// Each queue owns a thread which plays the role of the GPU. Submitted command
+// lists are executed in order by simply spending their simulated GPU time and
+// signals advance the fences only after all previously submitted work, just
+// like ID3D12CommandQueue::Signal does. The submissions go into a ring of a
+// fixed size, which blocks the submitting thread when it is full, like the
+// command buffer of a driver does, so submitting never allocates.
+// ============================================================================
+
+class NullFence : public Fence
+{
+public:
+  NullFence();
+
+  uint64_t getCompletedValue() const override;
+  bool wait(uint64_t value, std::chrono::milliseconds duration) override;
+
+  // set the value that the simulated GPU has reached.
+  void setCompletedValue(uint64_t value);
+
+private:
+  mutable std::mutex mMutex;
+  std::condition_variable mCompleted;
+  std::atomic<uint64_t> mCompletedValue;
+};
+
+// ============================================================================
+
+// the commands issued into the list are ignored, so replaying a command stream into it measures the decoding alone.
+class NullCommandList : public CommandList, public CommandSink
+{
+public:
+  NullCommandList(std::chrono::microseconds gpuTime);
+
+  // get the amount of time the simulated GPU spends when executing the list.
+  std::chrono::microseconds getGpuTime() const;
+
+  // set the amount of time the simulated GPU spends when executing the list.
+  void setGpuTime(std::chrono::microseconds gpuTime);
+
+  void setRootSignature(const void* rootSignature) override;
+  void setPipelineState(const void* pipelineState) override;
+  void setViewport(const CommandViewport& viewport) override;
+  void setScissorRect(const CommandRect& rect) override;
+  void resourceBarrier(unsigned int count, const ResourceBarrier* barriers) override;
+  void setRenderTarget(uint64_t descriptor) override;
+  void clearRenderTarget(uint64_t descriptor, const float color[4]) override;
+  void setPrimitiveTopology(PrimitiveTopology topology) override;
+  void setVertexBuffer(unsigned int slot, const CommandVertexBufferView& view) override;
+  void setIndexBuffer(const CommandIndexBufferView& view) override;
+  void drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance) override;
+  void drawIndexedInstanced(uint32_t indexCountPerInstance, uint32_t instanceCount, uint32_t startIndex, int32_t baseVertex, uint32_t startInstance) override;
+  void endTimestampQuery(const void* queryHeap, uint32_t index) override;
+  void resolveTimestampQueries(const void* queryHeap, uint32_t firstIndex, uint32_t count, const void* destination, uint64_t destinationOffset) override;
+  void setDescriptorHeap(const void* descriptorHeap) override;
+  void setRootDescriptorTable(uint32_t parameter, uint64_t descriptor) override;
+
+  using CommandSink::resourceBarrier;
+
+private:
+  std::chrono::microseconds mGpuTime;
+};
+
+// ============================================================================
+
+class NullCommandQueue : public CommandQueue
+{
+public:
+  // the maximum amount of submitted commands which the simulated GPU has not taken yet.
+  static const unsigned int MAX_COMMAND_COUNT = 1024;
+
+  NullCommandQueue();
+  ~NullCommandQueue();
+
+  NullCommandQueue(const NullCommandQueue&) = delete;
+  NullCommandQueue& operator=(const NullCommandQueue&) = delete;
+
+  void executeCommandLists(unsigned int count, CommandList* const* commandLists) override;
+  void signal(Fence& fence, uint64_t value) override;
+  void wait(Fence& fence, uint64_t value) override;
+
+private:
+  // the types of the operations in the submission queue.
+  enum class CommandType
+  {
+    EXECUTE,
+    SIGNAL,
+    WAIT
+  };
+
+  // a single item in the submission queue.
+  struct Command
+  {
+    CommandType type;
+    std::chrono::microseconds gpuTime;
+    NullFence* fence;
+    uint64_t value;
+  };
+
+  // push a new command into the submission queue. blocks while the queue is full.
+  void submit(const Command& command);
+
+  // the function executed by the simulated GPU thread.
+  void run();
+
+  std::mutex mMutex;
+  std::condition_variable mSubmitted;
+  std::condition_variable mTaken;
+  // the submitted commands in a ring in their submission order.
+  std::vector<Command> mCommands;
+  size_t mFirstCommand;
+  size_t mCommandCount;
+  bool mRunning;
+  std::thread mThread;
+};
+
+// ============================================================================
+
+class NullSwapChain : public SwapChain
+{
+public:
+  NullSwapChain(unsigned int bufferCount, std::chrono::microseconds refreshInterval);
+
+  unsigned int getBufferCount() const override;
+  unsigned int getCurrentBackBufferIndex() const override;
+  void waitForNextFrame() override;
+  void present(PresentMode mode) override;
+  bool getVblankTiming(VblankTiming& timing) override;
+
+private:
+  unsigned int mBufferCount;
+  unsigned int mBufferIndex;
+  std::chrono::microseconds mRefreshInterval;
+  std::chrono::steady_clock::time_point mStartTime;
+};
+
+// ============================================================================
+
+// the copies are made by the CPU right away into the destination memory (the destinations are CPU pointers), and
+// the simulated GPU spends the time of the copies at the given bandwidth when it executes the batch.
+class NullCopyRecorder : public CopyRecorder
+{
+public:
+  NullCopyRecorder(unsigned int commandListCount, uint64_t bytesPerMicrosecond);
+
+  unsigned int getCommandListCount() const override;
+  void begin(unsigned int index) override;
+  void copyBuffer(unsigned int index, void* destination, uint64_t destinationOffset, const UploadAllocation& source) override;
+  CommandList& end(unsigned int index) override;
+
+private:
+  std::vector<NullCommandList> mCommandLists;
+  // the amount of bytes copied by the batch recorded into each command list.
+  std::vector<uint64_t> mCopySizes;
+  uint64_t mBytesPerMicrosecond;
+};
+
+// ============================================================================
+
+// the objects are created by the backend, which counts them resident from their creation like committed resources,
+// and the usage is their resident size plus a fixed usage of the other allocations. the budget is set by the caller.
+class NullResidencyBackend : public ResidencyBackend
+{
+public:
+  NullResidencyBackend(uint64_t budget, uint64_t otherUsage);
+
+  // create a resident object of the given size.
+  const void* createObject(uint64_t size);
+
+  void setBudget(uint64_t budget);
+  bool isResident(const void* object) const;
+
+  MemoryBudget queryBudget() override;
+  void makeResident(unsigned int count, const void* const* objects) override;
+  void evict(unsigned int count, const void* const* objects) override;
+
+private:
+  struct Object
+  {
+    uint64_t size;
+    bool resident;
+  };
+
+  std::deque<Object> mObjects;
+  uint64_t mBudget;
+  uint64_t mUsage;
+};
+
+// ============================================================================
+
+class NullDevice : public Device
+{
+public:
+  std::unique_ptr<CommandQueue> createCommandQueue(CommandListType type) override;
+  std::unique_ptr<Fence> createFence() override;
+};
+
+// ============================================================================
+
+// spend the given amount of time in the calling thread without sleeping.
+void busyWait(std::chrono::microseconds duration);
@@ -0,0 +1,229 @@
+#include "PipelineCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+// ============================================================================
+
+// the FNV-1a 64-bit offset basis and prime.
+static const auto FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+static const auto FNV_PRIME = 0x100000001b3ull;
+
+// the maximum size of a single blob accepted from a library file.
+static const auto MAX_BLOB_SIZE = 64u * 1024 * 1024;
+
+// ============================================================================
+
+// write the given value into the stream in the little-endian byte order.
+template<class T>
+static void writeValue(std::ostream& stream, T value)
+{
+  for (auto i = 0u; i < sizeof(T); i++) {
+    stream.put(static_cast<char>((static_cast<uint64_t>(value) >> (i * 8)) & 0xff));
+  }
+}
+
+// ============================================================================
+
+// read a value from the stream in the little-endian byte order. returns false if the stream ended.
+template<class T>
+static bool readValue(std::istream& stream, T& value)
+{
+  uint8_t bytes[sizeof(T)];
+  if (!stream.read(reinterpret_cast<char*>(bytes), sizeof(T))) {
+    return false;
+  }
+  uint64_t result = 0;
+  for (auto i = 0u; i < sizeof(T); i++) {
+    result |= static_cast<uint64_t>(bytes[i]) << (i * 8);
+  }
+  value = static_cast<T>(result);
+  return true;
+}
+
+// ============================================================================
+
+PipelineHasher::PipelineHasher() : mHash(FNV_OFFSET_BASIS)
+{
+}
+
+// ============================================================================
+
+PipelineHasher& PipelineHasher::addBytes(const void* data, size_t size)
+{
+  auto bytes = static_cast<const uint8_t*>(data);
+  for (auto i = 0u; i < size; i++) {
+    mHash ^= bytes[i];
+    mHash *= FNV_PRIME;
+  }
+  return *this;
+}
+
+// ============================================================================
+
+PipelineHasher& PipelineHasher::addString(const char* string)
+{
+  // include the length so that consecutive strings cannot be confused with each other.
+  auto length = string != nullptr ? strlen(string) : 0;
+  addInteger(length);
+  return addBytes(string, length);
+}
+
+// ============================================================================
+
+PipelineHasher& PipelineHasher::add(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return addInteger(bits);
+}
+
+// ============================================================================
+
+uint64_t PipelineHasher::get() const
+{
+  return mHash;
+}
+
+// ============================================================================
+
+PipelineHasher& PipelineHasher::addInteger(uint64_t value)
+{
+  uint8_t bytes[sizeof(value)];
+  for (auto i = 0u; i < sizeof(value); i++) {
+    bytes[i] = static_cast<uint8_t>(value >> (i * 8));
+  }
+  return addBytes(bytes, sizeof(bytes));
+}
+
+// ============================================================================
+
+uint64_t hashBytes(const void* data, size_t size)
+{
+  return PipelineHasher().addBytes(data, size).get();
+}
+
+// ============================================================================
+
+PipelineLibrary::PipelineLibrary(uint64_t deviceId) : mDeviceId(deviceId), mDirty(false)
+{
+}
+
+// ============================================================================
+
+const std::vector<uint8_t>* PipelineLibrary::find(uint64_t hash) const
+{
+  auto it = mEntries.find(hash);
+  return it != mEntries.end() ? &it->second : nullptr;
+}
+
+// ============================================================================
+
+void PipelineLibrary::store(uint64_t hash, const void* blob, size_t size)
+{
+  auto bytes = static_cast<const uint8_t*>(blob);
+  mEntries[hash].assign(bytes, bytes + size);
+  mDirty = true;
+}
+
+// ============================================================================
+
+bool PipelineLibrary::load(std::istream& stream)
+{
+  mEntries.clear();
+  mDirty = false;
+
+  // reject files of other formats, versions or devices.
+  uint32_t magic, version, entryCount;
+  uint64_t deviceId;
+  if (!readValue(stream, magic) || !readValue(stream, version) || !readValue(stream, deviceId) || !readValue(stream, entryCount)) {
+    return false;
+  }
+  if (magic != MAGIC || version != VERSION || deviceId != mDeviceId) {
+    return false;
+  }
+
+  // read the blobs and discard everything if the file has been truncated or corrupted.
+  for (auto i = 0u; i < entryCount; i++) {
+    uint64_t hash;
+    uint32_t size;
+    if (!readValue(stream, hash) || !readValue(stream, size) || size > MAX_BLOB_SIZE) {
+      mEntries.clear();
+      return false;
+    }
+    auto& blob = mEntries[hash];
+    blob.resize(size);
+    if (size > 0 && !stream.read(reinterpret_cast<char*>(&blob[0]), size)) {
+      mEntries.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+// ============================================================================
+
+bool PipelineLibrary::load(const std::string& path)
+{
+  std::ifstream stream(path, std::ios::binary);
+  return stream && load(stream);
+}
+
+// ============================================================================
+
+void PipelineLibrary::save(std::ostream& stream)
+{
+  writeValue(stream, MAGIC);
+  writeValue(stream, VERSION);
+  writeValue(stream, mDeviceId);
+  writeValue(stream, static_cast<uint32_t>(mEntries.size()));
+  for (auto& entry : mEntries) {
+    writeValue(stream, entry.first);
+    writeValue(stream, static_cast<uint32_t>(entry.second.size()));
+    stream.write(reinterpret_cast<const char*>(entry.second.data()), entry.second.size());
+  }
+
+  // a full disk or an i/o error leaves a truncated library, which must stay dirty instead of reporting success.
+  stream.flush();
+  if (!stream.good()) {
+    std::cout << "std::ostream::write: " << mEntries.size() << " pipelines" << std::endl;
+    throw new std::runtime_error("Failed to write the pipeline library");
+  }
+  mDirty = false;
+}
+
+// ============================================================================
+
+void PipelineLibrary::save(const std::string& path)
+{
+  std::ofstream stream(path, std::ios::binary);
+  if (!stream) {
+    std::cout << "std::ofstream: " << path << std::endl;
+    throw new std::runtime_error("Failed to open the pipeline library file");
+  }
+  save(stream);
+
+  // closing writes the rest of the file buffer, which may still fail.
+  stream.close();
+  if (stream.fail()) {
+    std::cout << "std::ofstream::close: " << path << std::endl;
+    mDirty = true;
+    throw new std::runtime_error("Failed to write the pipeline library file");
+  }
+}
+
+// ============================================================================
+
+size_t PipelineLibrary::getEntryCount() const
+{
+  return mEntries.size();
+}
+
+// ============================================================================
+
+bool PipelineLibrary::isDirty() const
+{
+  return mDirty;
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// ============================================================================
+// A stable 64-bit hash (FNV-1a) for the pipeline state descriptors.
+//
+// The values are fed one field at a time in a fixed byte order, so the hash
+// does not depend on the struct padding, pointers or the compiler and it can
+// be used as a persistent key between the application runs.
+// ============================================================================
+class PipelineHasher
+{
+public:
+  PipelineHasher();
+
+  // add the given raw bytes into the hash.
+  PipelineHasher& addBytes(const void* data, size_t size);
+
+  // add the given null-terminated string (or an empty string for nullptr) into the hash.
+  PipelineHasher& addString(const char* string);
+
+  // add the bit pattern of the given floating point value into the hash.
+  PipelineHasher& add(float value);
+
+  // add the given integer or enumeration value into the hash as a 64-bit little-endian value.
+  template<class T>
+  PipelineHasher& add(T value)
+  {
+    static_assert(std::is_integral<T>::value || std::is_enum<T>::value, "Only integers and enumerations can be hashed by value");
+    return addInteger(static_cast<uint64_t>(value));
+  }
+
+  // get the hash of the values added so far.
+  uint64_t get() const;
+
+private:
+  PipelineHasher& addInteger(uint64_t value);
+
+  uint64_t mHash;
+};
+
+// ============================================================================
+
+// get the stable 64-bit hash of the given bytes (e.g. the shader bytecode).
+uint64_t hashBytes(const void* data, size_t size);
+
+// ============================================================================
+// A persistent library of the driver compiled pipeline state blobs.
+//
+// Works like the ID3D12PipelineLibrary: the blobs are stored by the hash of
+// their descriptor and the whole library is written into a single file. The
+// file is bound to the device identifier (adapter and driver), so a library
+// written with another device or driver is discarded instead of being fed
+// to the driver.
+// ============================================================================
+class PipelineLibrary
+{
+public:
+  // the identifier at the beginning of the library file.
+  static const uint32_t MAGIC = 0x4c4f5350; // "PSOL"
+  // the version of the library file format.
+  static const uint32_t VERSION = 1;
+
+  PipelineLibrary(uint64_t deviceId);
+
+  // find the blob stored with the given hash. returns nullptr if there is no such blob.
+  const std::vector<uint8_t>* find(uint64_t hash) const;
+
+  // store the blob with the given hash. replaces the previous blob with the same hash.
+  void store(uint64_t hash, const void* blob, size_t size);
+
+  // replace the contents with the library read from the stream. returns false if the data is invalid or stale.
+  bool load(std::istream& stream);
+  bool load(const std::string& path);
+
+  // write the library into the stream and mark it as saved, or throw and keep it dirty when the write fails.
+  void save(std::ostream& stream);
+  void save(const std::string& path);
+
+  // get the amount of stored blobs.
+  size_t getEntryCount() const;
+
+  // check whether new blobs have been stored after the library was loaded or saved.
+  bool isDirty() const;
+
+private:
+  uint64_t mDeviceId;
+  std::map<uint64_t, std::vector<uint8_t>> mEntries;
+  bool mDirty;
+};
@@ -0,0 +1,244 @@
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+using namespace std::chrono;
+
+// ============================================================================
+
+// the rings of all threads which have recorded profile events.
+static std::mutex sRingMutex;
+static std::vector<std::unique_ptr<ProfileRing>> sRings;
+
+// ============================================================================
+
+ProfileRing::ProfileRing(unsigned int threadId, const char* name) : mThreadId(threadId), mName(name), mHead(0), mEvents(CAPACITY)
+{
+}
+
+// ============================================================================
+
+unsigned int ProfileRing::getThreadId() const
+{
+  return mThreadId;
+}
+
+// ============================================================================
+
+const char* ProfileRing::getName() const
+{
+  return mName;
+}
+
+// ============================================================================
+
+std::vector<ProfileEvent> ProfileRing::read() const
+{
+  // copy the events which have not yet been overwritten.
+  auto head = mHead.load(std::memory_order_acquire);
+  auto tail = head > CAPACITY ? head - CAPACITY : 0;
+  std::vector<ProfileEvent> events;
+  events.reserve(static_cast<size_t>(head - tail));
+  for (auto i = tail; i < head; i++) {
+    events.push_back(mEvents[i & (CAPACITY - 1)]);
+  }
+
+  // drop the events which the owning thread may have overwritten while copying. the thread may already be writing the
+  // event of the new head, whose slot holds the event of the new head minus the capacity, so that one is dropped too.
+  auto newHead = mHead.load(std::memory_order_acquire);
+  if (newHead >= CAPACITY && newHead - CAPACITY + 1 > tail) {
+    auto overwritten = static_cast<size_t>(std::min(newHead - CAPACITY + 1 - tail, head - tail));
+    events.erase(events.begin(), events.begin() + overwritten);
+  }
+  return events;
+}
+
+// ============================================================================
+
+ProfileRing& getProfileRing()
+{
+  // each thread registers its own ring on the first use.
+  static thread_local ProfileRing* ring = nullptr;
+  if (ring == nullptr) {
+    std::lock_guard<std::mutex> lock(sRingMutex);
+    sRings.push_back(std::unique_ptr<ProfileRing>(new ProfileRing(static_cast<unsigned int>(sRings.size()))));
+    ring = sRings.back().get();
+  }
+  return *ring;
+}
+
+// ============================================================================
+
+ProfileRing& createProfileRing(const char* name)
+{
+  std::lock_guard<std::mutex> lock(sRingMutex);
+  sRings.push_back(std::unique_ptr<ProfileRing>(new ProfileRing(static_cast<unsigned int>(sRings.size()), name)));
+  return *sRings.back();
+}
+
+// ============================================================================
+
+double getProfileTicksPerMicrosecond()
+{
+  // calibrate the timestamp counter against the steady clock once.
+  static const double ticksPerMicrosecond = [] {
+    auto start = steady_clock::now();
+    auto startTicks = getProfileTimestamp();
+    std::this_thread::sleep_for(milliseconds(20));
+    auto endTicks = getProfileTimestamp();
+    auto elapsed = duration_cast<duration<double, std::micro>>(steady_clock::now() - start);
+    return static_cast<double>(endTicks - startTicks) / elapsed.count();
+  }();
+  return ticksPerMicrosecond;
+}
+
+// ============================================================================
+
+// a copy of the events of a ring.
+struct ProfileRingEvents
+{
+  unsigned int threadId;
+  const char* name;
+  std::vector<ProfileEvent> events;
+};
+
+// ============================================================================
+
+// get a copy of the rings and their events.
+static std::vector<ProfileRingEvents> readProfileRings()
+{
+  std::lock_guard<std::mutex> lock(sRingMutex);
+  std::vector<ProfileRingEvents> rings;
+  for (auto& ring : sRings) {
+    rings.push_back({ ring->getThreadId(), ring->getName(), ring->read() });
+  }
+  return rings;
+}
+
+// ============================================================================
+
+// get the value at the given percentile from the sorted values.
+static double getPercentile(const std::vector<double>& values, double percentile)
+{
+  auto index = static_cast<size_t>(percentile / 100.0 * (values.size() - 1) + 0.5);
+  return values[std::min(index, values.size() - 1)];
+}
+
+// ============================================================================
+
+std::vector<ProfileStageStats> getProfileStats()
+{
+  // gather the durations of each stage from all threads.
+  auto ticksPerMicrosecond = getProfileTicksPerMicrosecond();
+  std::map<std::string, std::vector<double>> durations;
+  for (auto& ring : readProfileRings()) {
+    for (auto& event : ring.events) {
+      durations[event.name].push_back((event.end - event.begin) / ticksPerMicrosecond);
+    }
+  }
+
+  // build the statistics from the sorted durations.
+  std::vector<ProfileStageStats> stats;
+  for (auto& stage : durations) {
+    auto& values = stage.second;
+    std::sort(values.begin(), values.end());
+    auto sum = 0.0;
+    for (auto value : values) {
+      sum += value;
+    }
+
+    ProfileStageStats stageStats;
+    stageStats.name = stage.first;
+    stageStats.count = static_cast<unsigned int>(values.size());
+    stageStats.mean = sum / values.size();
+    stageStats.p50 = getPercentile(values, 50.0);
+    stageStats.p95 = getPercentile(values, 95.0);
+    stageStats.p99 = getPercentile(values, 99.0);
+    stageStats.max = values.back();
+    stats.push_back(stageStats);
+  }
+  return stats;
+}
+
+// ============================================================================
+
+void printProfileStats(std::ostream& stream)
+{
+  stream << std::left << std::setw(24) << "stage"
+    << std::right << std::setw(8) << "count"
+    << std::setw(12) << "mean (us)"
+    << std::setw(12) << "p50 (us)"
+    << std::setw(12) << "p95 (us)"
+    << std::setw(12) << "p99 (us)"
+    << std::setw(12) << "max (us)" << std::endl;
+  stream << std::fixed << std::setprecision(2);
+  for (auto& stats : getProfileStats()) {
+    stream << std::left << std::setw(24) << stats.name
+      << std::right << std::setw(8) << stats.count
+      << std::setw(12) << stats.mean
+      << std::setw(12) << stats.p50
+      << std::setw(12) << stats.p95
+      << std::setw(12) << stats.p99
+      << std::setw(12) << stats.max << std::endl;
+  }
+  stream << std::defaultfloat;
+}
+
+// ============================================================================
+
+void writeChromeTrace(std::ostream& stream)
+{
+  auto ticksPerMicrosecond = getProfileTicksPerMicrosecond();
+  auto rings = readProfileRings();
+
+  // use the earliest stored event as the beginning of the trace.
+  auto origin = UINT64_MAX;
+  for (auto& ring : rings) {
+    for (auto& event : ring.events) {
+      origin = std::min(origin, event.begin);
+    }
+  }
+
+  // write each event as a complete event with a duration.
+  stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  stream << std::fixed << std::setprecision(3);
+  auto first = true;
+  for (auto& ring : rings) {
+    // name the tracks of the timelines which are not threads.
+    if (ring.name != nullptr) {
+      stream << (first ? "\n" : ",\n");
+      stream << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring.threadId << ",\"args\":{\"name\":\"" << ring.name << "\"}}";
+      first = false;
+    }
+    for (auto& event : ring.events) {
+      stream << (first ? "\n" : ",\n");
+      stream << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring.threadId
+        << ",\"ts\":" << (event.begin - origin) / ticksPerMicrosecond
+        << ",\"dur\":" << (event.end - event.begin) / ticksPerMicrosecond << "}";
+      first = false;
+    }
+  }
+  stream << "\n]}" << std::endl;
+  stream << std::defaultfloat;
+}
+
+// ============================================================================
+
+void writeChromeTrace(const std::string& path)
+{
+  std::ofstream stream(path);
+  if (!stream) {
+    std::cout << "std::ofstream: " << path << std::endl;
+    throw new std::runtime_error("Failed to open the trace file");
+  }
+  writeChromeTrace(stream);
+}
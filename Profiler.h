@@ -0,0 +1,151 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+// ============================================================================
+// A low-overhead CPU profiler for the frame loop stages.
+//
+// Each thread records the scopes into its own fixed size ring buffer, so the
+// hot path has no locks or allocations: a scope costs two timestamp reads and
+// a single store. Older events are overwritten when the ring wraps around.
+// The statistics and the Chrome trace (chrome://tracing) are built on demand
+// from the events currently stored in the rings. Timelines which are not
+// threads (e.g. the GPU queue) get named rings of their own, so their events
+// are shown as separate tracks of the same trace.
+// ============================================================================
+
+// a single profiled scope.
+struct ProfileEvent
+{
+  const char* name;
+  uint64_t begin;
+  uint64_t end;
+};
+
+// ============================================================================
+
+// the duration statistics of a single profiled stage in microseconds.
+struct ProfileStageStats
+{
+  std::string name;
+  unsigned int count;
+  double mean;
+  double p50;
+  double p95;
+  double p99;
+  double max;
+};
+
+// ============================================================================
+
+// a single-producer ring buffer which stores the events of one thread.
+class ProfileRing
+{
+public:
+  // the amount of events stored by each ring. must be a power of two.
+  static const uint64_t CAPACITY = 1u << 15;
+
+  ProfileRing(unsigned int threadId, const char* name = nullptr);
+
+  // get the identifier of the thread which owns the ring.
+  unsigned int getThreadId() const;
+
+  // get the name of the timeline of the ring or null for the rings of the threads.
+  const char* getName() const;
+
+  // store a new event into the ring. must only be called by the owning thread.
+  void push(const char* name, uint64_t begin, uint64_t end)
+  {
+    auto head = mHead.load(std::memory_order_relaxed);
+    auto& event = mEvents[head & (CAPACITY - 1)];
+    event.name = name;
+    event.begin = begin;
+    event.end = end;
+    mHead.store(head + 1, std::memory_order_release);
+  }
+
+  // get a copy of the events that are currently stored in the ring.
+  std::vector<ProfileEvent> read() const;
+
+private:
+  unsigned int mThreadId;
+  const char* mName;
+  std::atomic<uint64_t> mHead;
+  std::vector<ProfileEvent> mEvents;
+};
+
+// ============================================================================
+
+// get the ring buffer of the calling thread and create it on the first use.
+ProfileRing& getProfileRing();
+
+// create a ring buffer for a named timeline which is not a thread. only one thread may push into it at a time.
+ProfileRing& createProfileRing(const char* name);
+
+// get a timestamp in the profiler ticks.
+inline uint64_t getProfileTimestamp()
+{
+  #if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+  #else
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+  #endif
+}
+
+// get the amount of profiler ticks in a microsecond.
+double getProfileTicksPerMicrosecond();
+
+// get the statistics of each profiled stage sorted by the stage name.
+std::vector<ProfileStageStats> getProfileStats();
+
+// print the statistics of each profiled stage.
+void printProfileStats(std::ostream& stream);
+
+// write the stored events in the Chrome trace event format.
+void writeChromeTrace(std::ostream& stream);
+
+// write the stored events in the Chrome trace event format into the given file.
+void writeChromeTrace(const std::string& path);
+
+// ============================================================================
+
+// a helper which records the lifetime of the object as a profiled event.
+class ProfileScope
+{
+public:
+  ProfileScope(const char* name) : mName(name), mRing(getProfileRing()), mBegin(getProfileTimestamp())
+  {
+  }
+
+  ~ProfileScope()
+  {
+    mRing.push(mName, mBegin, getProfileTimestamp());
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+  const char* mName;
+  ProfileRing& mRing;
+  uint64_t mBegin;
+};
+
+// ============================================================================
+
+// helper macros to declare a uniquely named profile scope for the current block.
+#define PROFILE_CONCAT_IMPL(A, B) A##B
+#define PROFILE_CONCAT(A, B) PROFILE_CONCAT_IMPL(A, B)
+#define PROFILE_SCOPE(NAME) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(NAME)
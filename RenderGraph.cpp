@@ -0,0 +1,380 @@
+#include "RenderGraph.h"
+
+#include "UploadRing.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+// ============================================================================
+
+RenderGraph::RenderGraph() : mTransientHeapSize(0)
+{
+}
+
+// ============================================================================
+
+RenderGraph::RenderGraph(LinearArena& arena)
+  : mResources(ArenaAllocator<Resource>(arena)),
+    mPasses(ArenaAllocator<Pass>(arena)),
+    mFinalBarriers(ArenaAllocator<Barrier>(arena)),
+    mTransientHeapSize(0)
+{
+}
+
+// ============================================================================
+
+RenderGraph::ResourceId RenderGraph::createTransient(const char* name, uint64_t size, uint64_t alignment)
+{
+  if (size == 0) {
+    throw new std::runtime_error("Transient resource size must be greater than zero");
+  }
+  Resource resource = {};
+  resource.name = name;
+  resource.transient = true;
+  resource.size = size;
+  resource.alignment = std::max<uint64_t>(alignment, 1);
+  mResources.push_back(resource);
+  return static_cast<ResourceId>(mResources.size() - 1);
+}
+
+// ============================================================================
+
+RenderGraph::ResourceId RenderGraph::importResource(const char* name, ResourceStates initialState, ResourceStates finalState)
+{
+  Resource resource = {};
+  resource.name = name;
+  resource.initialState = initialState;
+  resource.finalState = finalState;
+  mResources.push_back(resource);
+  return static_cast<ResourceId>(mResources.size() - 1);
+}
+
+// ============================================================================
+
+void RenderGraph::setResourceHandle(ResourceId resource, const void* handle)
+{
+  mResources[resource].handle = handle;
+}
+
+// ============================================================================
+
+RenderGraph::PassId RenderGraph::addPass(const char* name, const ExecuteFunc& execute)
+{
+  auto allocator = mPasses.get_allocator();
+  mPasses.push_back({ name, execute, ArenaVector<Access>(allocator), false, ArenaVector<Barrier>(allocator), ArenaVector<ResourceId>(allocator) });
+  return static_cast<PassId>(mPasses.size() - 1);
+}
+
+// ============================================================================
+
+void RenderGraph::read(PassId pass, ResourceId resource, ResourceStates state)
+{
+  if (pass >= mPasses.size() || resource >= mResources.size()) {
+    throw new std::runtime_error("Unknown render graph pass or resource");
+  }
+  mPasses[pass].accesses.push_back({ resource, state, false });
+}
+
+// ============================================================================
+
+void RenderGraph::write(PassId pass, ResourceId resource, ResourceStates state)
+{
+  if (pass >= mPasses.size() || resource >= mResources.size()) {
+    throw new std::runtime_error("Unknown render graph pass or resource");
+  }
+  mPasses[pass].accesses.push_back({ resource, state, true });
+}
+
+// ============================================================================
+
+void RenderGraph::compile()
+{
+  cullPasses();
+  computeBarriers();
+  placeTransients();
+}
+
+// ============================================================================
+
+void RenderGraph::execute(ResourceStateRegistry* registry, BarrierList& finalBarriers)
+{
+  auto allocator = mPasses.get_allocator();
+  PassContext context = { BarrierList(allocator), ArenaVector<const void*>(allocator) };
+  for (auto& pass : mPasses) {
+    if (pass.culled) {
+      continue;
+    }
+    context.barriers.clear();
+    context.aliasedResources.clear();
+    for (auto& barrier : pass.barriers) {
+      context.barriers.push_back({ mResources[barrier.resource].handle, barrier.before, barrier.after, BarrierSplit::NONE });
+    }
+    for (auto resource : pass.aliasedResources) {
+      context.aliasedResources.push_back(mResources[resource].handle);
+    }
+    pass.execute(context);
+
+    // keep the registry up-to-date so that the passes can resolve their own command lists against it.
+    if (registry != nullptr) {
+      for (auto& barrier : pass.barriers) {
+        auto& resource = mResources[barrier.resource];
+        if (!resource.transient) {
+          registry->setState(resource.handle, barrier.after);
+        }
+      }
+    }
+  }
+
+  for (auto& barrier : mFinalBarriers) {
+    auto& resource = mResources[barrier.resource];
+    finalBarriers.push_back({ resource.handle, barrier.before, barrier.after, BarrierSplit::NONE });
+    if (registry != nullptr && !resource.transient) {
+      registry->setState(resource.handle, barrier.after);
+    }
+  }
+}
+
+// ============================================================================
+
+bool RenderGraph::isPassCulled(PassId pass) const
+{
+  return mPasses[pass].culled;
+}
+
+// ============================================================================
+
+uint64_t RenderGraph::getTransientOffset(ResourceId resource) const
+{
+  return mResources[resource].offset;
+}
+
+// ============================================================================
+
+uint64_t RenderGraph::getTransientHeapSize() const
+{
+  return mTransientHeapSize;
+}
+
+// ============================================================================
+
+uint64_t RenderGraph::getUnaliasedTransientSize() const
+{
+  uint64_t size = 0;
+  for (auto& resource : mResources) {
+    if (resource.transient && resource.used) {
+      size += resource.size;
+    }
+  }
+  return size;
+}
+
+// ============================================================================
+
+unsigned int RenderGraph::getBarrierCount() const
+{
+  auto count = static_cast<unsigned int>(mFinalBarriers.size());
+  for (auto& pass : mPasses) {
+    count += static_cast<unsigned int>(pass.barriers.size());
+  }
+  return count;
+}
+
+// ============================================================================
+
+void RenderGraph::printReport(std::ostream& out) const
+{
+  out << std::left << std::setw(24) << "pass" << std::right
+    << std::setw(12) << "barriers"
+    << std::setw(12) << "aliased" << std::endl;
+  for (auto& pass : mPasses) {
+    out << std::left << std::setw(24) << pass.name << std::right;
+    if (pass.culled) {
+      out << std::setw(12) << "culled" << std::endl;
+      continue;
+    }
+    out << std::setw(12) << pass.barriers.size()
+      << std::setw(12) << pass.aliasedResources.size() << std::endl;
+  }
+  out << std::left << std::setw(24) << "transient" << std::right
+    << std::setw(12) << "passes"
+    << std::setw(12) << "offset (KB)"
+    << std::setw(12) << "size (KB)" << std::endl;
+  for (auto& resource : mResources) {
+    if (!resource.transient || !resource.used) {
+      continue;
+    }
+    out << std::left << std::setw(24) << resource.name << std::right
+      << std::setw(12) << (std::to_string(resource.firstPass) + "-" + std::to_string(resource.lastPass))
+      << std::setw(12) << resource.offset / 1024
+      << std::setw(12) << resource.size / 1024 << std::endl;
+  }
+  out << "barriers: " << getBarrierCount()
+    << " peak transient memory: " << getTransientHeapSize() / 1024 << "KB"
+    << " unaliased: " << getUnaliasedTransientSize() / 1024 << "KB" << std::endl;
+}
+
+// ============================================================================
+
+void RenderGraph::cullPasses()
+{
+  // walk the passes backwards from the imported resources and keep the passes which write the needed resources.
+  ArenaVector<bool> needed(mResources.size(), false, mResources.get_allocator());
+  for (auto i = 0u; i < mResources.size(); i++) {
+    needed[i] = !mResources[i].transient;
+  }
+  for (auto i = mPasses.size(); i-- > 0;) {
+    auto& pass = mPasses[i];
+    pass.culled = true;
+    for (auto& access : pass.accesses) {
+      if (access.write && needed[access.resource]) {
+        pass.culled = false;
+      }
+    }
+    if (!pass.culled) {
+      for (auto& access : pass.accesses) {
+        needed[access.resource] = true;
+      }
+    }
+  }
+}
+
+// ============================================================================
+
+void RenderGraph::computeBarriers()
+{
+  for (auto& resource : mResources) {
+    resource.used = false;
+  }
+
+  // the current state of each resource while walking through the executed passes.
+  ArenaVector<ResourceStates> states(mResources.size(), RESOURCE_STATE_COMMON, mResources.get_allocator());
+  ArenaVector<Access> accesses(mResources.get_allocator());
+  auto passIndex = 0u;
+  for (auto& pass : mPasses) {
+    pass.barriers.clear();
+    pass.aliasedResources.clear();
+    if (pass.culled) {
+      continue;
+    }
+
+    // combine the accesses of the pass into a single state per resource.
+    accesses.clear();
+    for (auto& access : pass.accesses) {
+      auto it = std::find_if(accesses.begin(), accesses.end(), [&](const Access& other) {
+        return other.resource == access.resource;
+      });
+      if (it == accesses.end()) {
+        accesses.push_back(access);
+      } else if (it->state != access.state) {
+        if (it->write || access.write) {
+          throw new std::runtime_error("A pass cannot write a resource in multiple states");
+        }
+        it->state |= access.state;
+      }
+    }
+
+    for (auto& access : accesses) {
+      auto& resource = mResources[access.resource];
+      if (!resource.used) {
+        resource.used = true;
+        resource.firstPass = passIndex;
+        if (resource.transient) {
+          // the transient resource is created in the state of its first use.
+          resource.initialState = access.state;
+          resource.finalState = access.state;
+          states[access.resource] = access.state;
+          pass.aliasedResources.push_back(access.resource);
+        } else {
+          states[access.resource] = resource.initialState;
+        }
+      }
+      resource.lastPass = passIndex;
+      if (!isResourceStateSatisfied(states[access.resource], access.state)) {
+        pass.barriers.push_back({ access.resource, states[access.resource], access.state });
+        states[access.resource] = access.state;
+      }
+    }
+    passIndex++;
+  }
+
+  // leave the imported resources into their final states and the transient resources into their initial states.
+  mFinalBarriers.clear();
+  for (auto i = 0u; i < mResources.size(); i++) {
+    auto& resource = mResources[i];
+    auto state = resource.used ? states[i] : resource.initialState;
+    if (state != resource.finalState) {
+      mFinalBarriers.push_back({ i, state, resource.finalState });
+    }
+  }
+}
+
+// ============================================================================
+
+void RenderGraph::placeTransients()
+{
+  // place the largest resources first, which usually leaves the least amount of holes.
+  ArenaVector<ResourceId> order(mResources.get_allocator());
+  for (auto i = 0u; i < mResources.size(); i++) {
+    mResources[i].offset = 0;
+    mResources[i].aliased = false;
+    if (mResources[i].transient && mResources[i].used) {
+      order.push_back(i);
+    }
+  }
+  // the ties are broken by the declaration order, which keeps the placement deterministic without the temporary
+  // buffer of a stable sort.
+  std::sort(order.begin(), order.end(), [this](ResourceId a, ResourceId b) {
+    return mResources[a].size > mResources[b].size || (mResources[a].size == mResources[b].size && a < b);
+  });
+
+  mTransientHeapSize = 0;
+  ArenaVector<ResourceId> placed(mResources.get_allocator());
+  ArenaVector<ResourceId> overlapping(mResources.get_allocator());
+  for (auto id : order) {
+    auto& resource = mResources[id];
+
+    // only the resources which are alive at the same time must not share memory.
+    overlapping.clear();
+    for (auto other : placed) {
+      auto& placedResource = mResources[other];
+      if (placedResource.firstPass <= resource.lastPass && resource.firstPass <= placedResource.lastPass) {
+        overlapping.push_back(other);
+      }
+    }
+    std::sort(overlapping.begin(), overlapping.end(), [this](ResourceId a, ResourceId b) {
+      return mResources[a].offset < mResources[b].offset;
+    });
+
+    // find the lowest gap between the overlapping resources that fits the resource.
+    uint64_t offset = 0;
+    for (auto other : overlapping) {
+      auto& placedResource = mResources[other];
+      if (alignUp(offset, resource.alignment) + resource.size <= placedResource.offset) {
+        break;
+      }
+      offset = std::max(offset, placedResource.offset + placedResource.size);
+    }
+    resource.offset = alignUp(offset, resource.alignment);
+    mTransientHeapSize = std::max(mTransientHeapSize, resource.offset + resource.size);
+    placed.push_back(id);
+  }
+
+  // the resources which share memory with another resource need an aliasing barrier when they become active.
+  for (auto id : placed) {
+    auto& resource = mResources[id];
+    for (auto other : placed) {
+      auto& otherResource = mResources[other];
+      if (other != id && resource.offset < otherResource.offset + otherResource.size && otherResource.offset < resource.offset + resource.size) {
+        resource.aliased = true;
+        break;
+      }
+    }
+  }
+  for (auto& pass : mPasses) {
+    pass.aliasedResources.erase(std::remove_if(pass.aliasedResources.begin(), pass.aliasedResources.end(), [this](ResourceId id) {
+      return !mResources[id].aliased;
+    }), pass.aliasedResources.end());
+  }
+}
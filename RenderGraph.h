@@ -0,0 +1,139 @@
+#pragma once
+
+#include "LinearArena.h"
+#include "ResourceStateTracker.h"
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+
+// ============================================================================
+// A render graph which schedules the passes of a frame.
+//
+// The passes declare which resources they read and write and in which state.
+// The graph is compiled once on the CPU, which culls the passes whose output
+// is never used, computes the barriers between the passes and places the
+// transient resources into a single heap so that the resources whose
+// lifetimes do not overlap share the same memory. The imported resources
+// (e.g. the back buffer) live outside of the graph and are never aliased.
+// A graph built for a single frame takes its memory from the frame arena,
+// so building, compiling and executing it every frame stays off the heap.
+// ============================================================================
+class RenderGraph
+{
+public:
+  typedef unsigned int ResourceId;
+  typedef unsigned int PassId;
+
+  // the barriers which must be recorded before the pass, and the aliased resources which become active in the pass.
+  struct PassContext
+  {
+    BarrierList barriers;
+    ArenaVector<const void*> aliasedResources;
+  };
+
+  // the callback that records the commands of the pass.
+  typedef std::function<void(const PassContext& context)> ExecuteFunc;
+
+  RenderGraph();
+
+  // create a graph whose passes, resources and compilation state are allocated from the given arena.
+  RenderGraph(LinearArena& arena);
+
+  // create a transient resource which only lives during the frame.
+  ResourceId createTransient(const char* name, uint64_t size, uint64_t alignment);
+
+  // import an external resource, which is in the initial state before and must be left in the final state after the frame.
+  ResourceId importResource(const char* name, ResourceStates initialState, ResourceStates finalState);
+
+  // set the native resource (e.g. the placed resource or the current back buffer) that the barriers refer to.
+  void setResourceHandle(ResourceId resource, const void* handle);
+
+  // add a new pass executed in the declaration order.
+  PassId addPass(const char* name, const ExecuteFunc& execute);
+
+  // declare that the pass reads or writes the resource in the given state.
+  void read(PassId pass, ResourceId resource, ResourceStates state);
+  void write(PassId pass, ResourceId resource, ResourceStates state);
+
+  // cull the unused passes, compute the barriers and place the transient resources.
+  void compile();
+
+  // execute the passes which were not culled and gather the barriers which leave the resources in their final states.
+  // the states of the imported resources are stored into the registry (if any) after each pass.
+  void execute(ResourceStateRegistry* registry, BarrierList& finalBarriers);
+
+  // check whether the pass was culled by the compilation.
+  bool isPassCulled(PassId pass) const;
+
+  // get the offset of the transient resource in the transient heap.
+  uint64_t getTransientOffset(ResourceId resource) const;
+
+  // get the size of the heap needed by the aliased transient resources (i.e. the peak transient memory).
+  uint64_t getTransientHeapSize() const;
+
+  // get the total size of the used transient resources without aliasing.
+  uint64_t getUnaliasedTransientSize() const;
+
+  // get the amount of barriers computed by the compilation.
+  unsigned int getBarrierCount() const;
+
+  // print the passes with their barriers and the placement of the transient resources.
+  void printReport(std::ostream& out) const;
+
+private:
+  struct Resource
+  {
+    const char* name;
+    bool transient;
+    uint64_t size;
+    uint64_t alignment;
+    ResourceStates initialState;
+    ResourceStates finalState;
+    const void* handle;
+    // the first and the last executed pass which use the resource.
+    unsigned int firstPass;
+    unsigned int lastPass;
+    uint64_t offset;
+    bool aliased;
+    bool used;
+  };
+
+  struct Access
+  {
+    ResourceId resource;
+    ResourceStates state;
+    bool write;
+  };
+
+  struct Barrier
+  {
+    ResourceId resource;
+    ResourceStates before;
+    ResourceStates after;
+  };
+
+  struct Pass
+  {
+    const char* name;
+    ExecuteFunc execute;
+    ArenaVector<Access> accesses;
+    bool culled;
+    ArenaVector<Barrier> barriers;
+    ArenaVector<ResourceId> aliasedResources;
+  };
+
+  // mark the passes which do not contribute to the imported resources as culled.
+  void cullPasses();
+
+  // compute the lifetimes, the barriers between the passes and the final barriers.
+  void computeBarriers();
+
+  // place the transient resources into the heap so that the resources with overlapping lifetimes do not overlap in memory.
+  void placeTransients();
+
+  ArenaVector<Resource> mResources;
+  ArenaVector<Pass> mPasses;
+  ArenaVector<Barrier> mFinalBarriers;
+  uint64_t mTransientHeapSize;
+};
@@ -0,0 +1,257 @@
+#include "ResidencyManager.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+// the fraction of the budget which the resources are evicted down to, so the allocations made between the polls
+// and the other processes have some room before the budget is exceeded.
+static const auto BUDGET_HEADROOM = 0.95;
+
+// ============================================================================
+
+ResidencyManager::ResidencyManager(ResidencyBackend& backend)
+  : mBackend(backend),
+    mFirst(INVALID_HANDLE),
+    mLast(INVALID_HANDLE),
+    mFenceValue(0),
+    mBudget(),
+    mResidentSize(0),
+    mTrackedSize(0),
+    mResourceCount(0),
+    mEvictedCount(0),
+    mMadeResidentCount(0),
+    mEvictCallCount(0),
+    mMakeResidentCallCount(0),
+    mOverBudgetCount(0)
+{
+}
+
+// ============================================================================
+
+unsigned int ResidencyManager::add(const void* object, uint64_t size)
+{
+  unsigned int handle;
+  if (mFreeHandles.empty()) {
+    handle = static_cast<unsigned int>(mEntries.size());
+    mEntries.emplace_back();
+  } else {
+    handle = mFreeHandles.back();
+    mFreeHandles.pop_back();
+  }
+
+  // the resource counts as used by the current frame, which keeps the list ordered by the last used values.
+  auto& entry = mEntries[handle];
+  entry.object = object;
+  entry.size = size;
+  entry.lastUsedValue = mFenceValue;
+  entry.tracked = true;
+  entry.resident = true;
+  entry.pending = false;
+  pushBack(handle);
+  mResidentSize += size;
+  mTrackedSize += size;
+  mResourceCount++;
+  return handle;
+}
+
+// ============================================================================
+
+void ResidencyManager::remove(unsigned int handle)
+{
+  if (handle >= mEntries.size() || !mEntries[handle].tracked) {
+    throw new std::runtime_error("Residency handle is not tracked");
+  }
+  auto& entry = mEntries[handle];
+  if (entry.resident) {
+    unlink(handle);
+    mResidentSize -= entry.size;
+  }
+  if (entry.pending) {
+    mPending.erase(std::find(mPending.begin(), mPending.end(), handle));
+  }
+  entry.tracked = false;
+  mTrackedSize -= entry.size;
+  mResourceCount--;
+  mFreeHandles.push_back(handle);
+}
+
+// ============================================================================
+
+void ResidencyManager::beginFrame(uint64_t fenceValue)
+{
+  if (fenceValue < mFenceValue) {
+    throw new std::runtime_error("Residency frames must have increasing fence values");
+  }
+  mFenceValue = fenceValue;
+}
+
+// ============================================================================
+
+void ResidencyManager::use(unsigned int handle)
+{
+  if (handle >= mEntries.size() || !mEntries[handle].tracked) {
+    throw new std::runtime_error("Residency handle is not tracked");
+  }
+  auto& entry = mEntries[handle];
+  entry.lastUsedValue = mFenceValue;
+  if (entry.resident) {
+    unlink(handle);
+    pushBack(handle);
+  } else if (!entry.pending) {
+    entry.pending = true;
+    mPending.push_back(handle);
+  }
+}
+
+// ============================================================================
+
+void ResidencyManager::commit(uint64_t completedValue)
+{
+  // the usage reported by the system includes the resident resources, but not the ones to be made resident.
+  mBudget = mBackend.queryBudget();
+  auto usage = mBudget.usage;
+  for (auto handle : mPending) {
+    usage += mEntries[handle].size;
+  }
+
+  // evict from the least recently used end. the list is ordered by the last used values, so the first resource that
+  // the GPU may still use ends the eviction.
+  auto target = static_cast<uint64_t>(mBudget.budget * BUDGET_HEADROOM);
+  mObjects.clear();
+  while (usage > target && mFirst != INVALID_HANDLE && mEntries[mFirst].lastUsedValue <= completedValue) {
+    auto handle = mFirst;
+    auto& entry = mEntries[handle];
+    unlink(handle);
+    entry.resident = false;
+    mResidentSize -= entry.size;
+    usage -= std::min(usage, entry.size);
+    mObjects.push_back(entry.object);
+  }
+  if (!mObjects.empty()) {
+    mBackend.evict(static_cast<unsigned int>(mObjects.size()), mObjects.data());
+    mEvictedCount += mObjects.size();
+    mEvictCallCount++;
+  }
+  if (usage > mBudget.budget) {
+    mOverBudgetCount++;
+  }
+
+  // the resources used by the frame are made resident even when they do not fit, which pages instead of failing.
+  if (!mPending.empty()) {
+    mObjects.clear();
+    for (auto handle : mPending) {
+      auto& entry = mEntries[handle];
+      entry.resident = true;
+      entry.pending = false;
+      pushBack(handle);
+      mResidentSize += entry.size;
+      mObjects.push_back(entry.object);
+    }
+    mBackend.makeResident(static_cast<unsigned int>(mObjects.size()), mObjects.data());
+    mMadeResidentCount += mObjects.size();
+    mMakeResidentCallCount++;
+    mPending.clear();
+  }
+}
+
+// ============================================================================
+
+bool ResidencyManager::isResident(unsigned int handle) const
+{
+  return handle < mEntries.size() && mEntries[handle].tracked && mEntries[handle].resident;
+}
+
+// ============================================================================
+
+const MemoryBudget& ResidencyManager::getBudget() const
+{
+  return mBudget;
+}
+
+// ============================================================================
+
+uint64_t ResidencyManager::getResidentSize() const
+{
+  return mResidentSize;
+}
+
+// ============================================================================
+
+uint64_t ResidencyManager::getTrackedSize() const
+{
+  return mTrackedSize;
+}
+
+// ============================================================================
+
+unsigned int ResidencyManager::getResourceCount() const
+{
+  return mResourceCount;
+}
+
+// ============================================================================
+
+uint64_t ResidencyManager::getEvictedCount() const
+{
+  return mEvictedCount;
+}
+
+// ============================================================================
+
+uint64_t ResidencyManager::getMadeResidentCount() const
+{
+  return mMadeResidentCount;
+}
+
+// ============================================================================
+
+uint64_t ResidencyManager::getEvictCallCount() const
+{
+  return mEvictCallCount;
+}
+
+// ============================================================================
+
+uint64_t ResidencyManager::getMakeResidentCallCount() const
+{
+  return mMakeResidentCallCount;
+}
+
+// ============================================================================
+
+uint64_t ResidencyManager::getOverBudgetCount() const
+{
+  return mOverBudgetCount;
+}
+
+// ============================================================================
+
+void ResidencyManager::pushBack(unsigned int handle)
+{
+  auto& entry = mEntries[handle];
+  entry.previous = mLast;
+  entry.next = INVALID_HANDLE;
+  if (mLast != INVALID_HANDLE) {
+    mEntries[mLast].next = handle;
+  } else {
+    mFirst = handle;
+  }
+  mLast = handle;
+}
+
+// ============================================================================
+
+void ResidencyManager::unlink(unsigned int handle)
+{
+  auto& entry = mEntries[handle];
+  if (entry.previous != INVALID_HANDLE) {
+    mEntries[entry.previous].next = entry.next;
+  } else {
+    mFirst = entry.next;
+  }
+  if (entry.next != INVALID_HANDLE) {
+    mEntries[entry.next].previous = entry.previous;
+  } else {
+    mLast = entry.previous;
+  }
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+
+// the memory budget of the process in the local memory segment and the amount of it currently in use.
+struct MemoryBudget
+{
+  uint64_t budget;
+  uint64_t usage;
+};
+
+// ============================================================================
+// The residency operations of a device.
+//
+// The backends query the budget which the operating system gives to the
+// process and make the objects (the resources of the device) resident or
+// evict them, each in a single batched call for all given objects.
+// ============================================================================
+class ResidencyBackend
+{
+public:
+  virtual ~ResidencyBackend() {}
+
+  // query the current budget and usage of the local memory.
+  virtual MemoryBudget queryBudget() = 0;
+
+  // make the evicted objects resident again, which blocks until their memory has been paged in.
+  virtual void makeResident(unsigned int count, const void* const* objects) = 0;
+
+  // evict the resident objects, so their memory may be reused by other allocations.
+  virtual void evict(unsigned int count, const void* const* objects) = 0;
+};
+
+// ============================================================================
+// A residency manager which keeps the resources within the memory budget.
+//
+// The manager tracks the size of every resource and the fence value of the
+// last frame which used it, and keeps the resident resources in a list from
+// the least to the most recently used. Once per frame, before the frame is
+// submitted, the budget is polled and the least recently used resources are
+// evicted until the usage, including the evicted resources which the frame
+// has used, fits below the budget with some headroom. Only the resources
+// whose last frame has been completed by the GPU are evicted, so a frame in
+// flight never loses a resource. The evicted resources used by the frame
+// are then made resident again. Both are done with one batched call, and
+// when the used resources alone exceed the budget they are still made
+// resident and the frame is counted as over budget, so a big scene pages
+// instead of failing. The manager is not thread-safe.
+// ============================================================================
+class ResidencyManager
+{
+public:
+  // the handle which is never returned for a tracked resource.
+  static const unsigned int INVALID_HANDLE = ~0u;
+
+  ResidencyManager(ResidencyBackend& backend);
+
+  // track a resident resource (e.g. a newly created one) of the given size. returns the handle of the resource.
+  unsigned int add(const void* object, uint64_t size);
+
+  // stop tracking the resource. the resource must not be used by the GPU anymore when it is destroyed.
+  void remove(unsigned int handle);
+
+  // begin recording the frame which completes with the given fence value.
+  void beginFrame(uint64_t fenceValue);
+
+  // mark the resource as used by the current frame.
+  void use(unsigned int handle);
+
+  // poll the budget, evict the least recently used resources which the GPU has completed as needed and make the
+  // resources used by the current frame resident. must be called before the frame is submitted.
+  void commit(uint64_t completedValue);
+
+  // check whether the resource is resident, which is the case for all resources used by the current frame after the
+  // commit.
+  bool isResident(unsigned int handle) const;
+
+  // get the last polled budget, the size of the resident and of all tracked resources and the amount of resources.
+  const MemoryBudget& getBudget() const;
+  uint64_t getResidentSize() const;
+  uint64_t getTrackedSize() const;
+  unsigned int getResourceCount() const;
+
+  // get the amount of evicted resources and of resources made resident again, and the amount of batched calls.
+  uint64_t getEvictedCount() const;
+  uint64_t getMadeResidentCount() const;
+  uint64_t getEvictCallCount() const;
+  uint64_t getMakeResidentCallCount() const;
+
+  // get the amount of frames whose used resources did not fit into the budget.
+  uint64_t getOverBudgetCount() const;
+
+private:
+  // a tracked resource, which is linked into the list of resident resources while it is resident.
+  struct Entry
+  {
+    const void* object;
+    uint64_t size;
+    uint64_t lastUsedValue;
+    unsigned int previous;
+    unsigned int next;
+    bool tracked;
+    bool resident;
+    bool pending;
+  };
+
+  // link the entry at the most recently used end of the list or unlink it.
+  void pushBack(unsigned int handle);
+  void unlink(unsigned int handle);
+
+  ResidencyBackend& mBackend;
+  std::vector<Entry> mEntries;
+  std::vector<unsigned int> mFreeHandles;
+  // the least and the most recently used resident entries.
+  unsigned int mFirst;
+  unsigned int mLast;
+  // the evicted entries used by the current frame and the objects of the batched calls.
+  std::vector<unsigned int> mPending;
+  std::vector<const void*> mObjects;
+  uint64_t mFenceValue;
+  MemoryBudget mBudget;
+  uint64_t mResidentSize;
+  uint64_t mTrackedSize;
+  unsigned int mResourceCount;
+  uint64_t mEvictedCount;
+  uint64_t mMadeResidentCount;
+  uint64_t mEvictCallCount;
+  uint64_t mMakeResidentCallCount;
+  uint64_t mOverBudgetCount;
+};
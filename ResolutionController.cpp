@@ -0,0 +1,162 @@
+#include "ResolutionController.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std::chrono;
+
+// the fraction of the target that the controller aims for, so the noise of the frame times stays below the target.
+static const auto TARGET_HEADROOM = 0.85;
+
+// the fraction of the target that the smoothed frame time must exceed before the controller lowers the scale.
+static const auto DOWNSCALE_THRESHOLD = 0.95;
+
+// the amount of frames measured at a scale before the controller lowers it.
+static const auto MIN_SAMPLES = 4u;
+
+// the fraction of the target that the predicted frame time must stay below for the given amount of frames before the
+// controller raises the scale.
+static const auto UPSCALE_THRESHOLD = 0.75;
+static const auto UPSCALE_FRAMES = 30u;
+
+// the largest increase of the scale at once.
+static const auto MAX_UPSCALE_STEP = 0.1;
+
+// the smallest change of the scale which is applied, unless it reaches one of the bounds. a frame time above the target
+// always lowers the scale by at least this step.
+static const auto MIN_SCALE_STEP = 0.04;
+
+// ============================================================================
+
+ResolutionController::ResolutionController(microseconds targetFrameTime, double minScale, double maxScale, unsigned int settleFrames)
+  : mTargetFrameTime(targetFrameTime),
+    mMinScale(minScale),
+    mMaxScale(maxScale),
+    mSettleFrames(settleFrames),
+    mScale(maxScale),
+    mFrameTime(),
+    mSampleCount(0),
+    mSkippedFrames(0),
+    mFastFrames(0),
+    mFrameCount(0),
+    mChangeCount(0)
+{
+  if (minScale <= 0.0 || minScale > maxScale) {
+    throw new std::runtime_error("Resolution scale bounds are invalid");
+  }
+}
+
+// ============================================================================
+
+void ResolutionController::setTargetFrameTime(microseconds targetFrameTime)
+{
+  mTargetFrameTime = targetFrameTime;
+  mFastFrames = 0;
+}
+
+// ============================================================================
+
+microseconds ResolutionController::getTargetFrameTime() const
+{
+  return mTargetFrameTime;
+}
+
+// ============================================================================
+
+bool ResolutionController::addFrameTime(microseconds frameTime)
+{
+  mFrameCount++;
+  if (mTargetFrameTime <= microseconds::zero()) {
+    return changeScale(mMaxScale);
+  }
+  if (mSkippedFrames > 0) {
+    mSkippedFrames--;
+    return false;
+  }
+  mFrameTime.addSample(frameTime);
+  mSampleCount++;
+
+  // the scale which brings the frame time below the target, assuming that the time is proportional to the pixels. the
+  // scale is lowered already a bit below the target, so the noise of the frame times rarely misses it.
+  auto target = static_cast<double>(mTargetFrameTime.count());
+  auto average = std::max(1.0, static_cast<double>(mFrameTime.getAverage().count()));
+  auto predicted = std::max(1.0, static_cast<double>(mFrameTime.predict().count()));
+  if (mSampleCount >= MIN_SAMPLES && average > target * DOWNSCALE_THRESHOLD) {
+    mFastFrames = 0;
+    return changeScale(std::min(mScale * std::sqrt(target * TARGET_HEADROOM / average), mScale - MIN_SCALE_STEP));
+  }
+
+  // the prediction includes the deviation of the frame times, so a noisy workload is not raised into the target.
+  if (predicted >= target * UPSCALE_THRESHOLD) {
+    mFastFrames = 0;
+    return false;
+  }
+  if (++mFastFrames < UPSCALE_FRAMES) {
+    return false;
+  }
+  mFastFrames = 0;
+  return changeScale(std::min(mScale * std::sqrt(target * TARGET_HEADROOM / predicted), mScale + MAX_UPSCALE_STEP));
+}
+
+// ============================================================================
+
+double ResolutionController::getScale() const
+{
+  return mScale;
+}
+
+// ============================================================================
+
+void ResolutionController::getRenderSize(unsigned int outputWidth, unsigned int outputHeight, unsigned int& width, unsigned int& height) const
+{
+  // the alignment is copied, as std::max would bind the in-class constant, which has no definition, to a reference.
+  auto align = [this](unsigned int size) {
+    auto alignment = RENDER_SIZE_ALIGNMENT;
+    auto scaled = static_cast<unsigned int>(std::lround(size * mScale / alignment)) * alignment;
+    return std::min(size, std::max(scaled, alignment));
+  };
+  width = align(outputWidth);
+  height = align(outputHeight);
+}
+
+// ============================================================================
+
+microseconds ResolutionController::getAverageFrameTime() const
+{
+  return mFrameTime.getAverage();
+}
+
+// ============================================================================
+
+uint64_t ResolutionController::getFrameCount() const
+{
+  return mFrameCount;
+}
+
+// ============================================================================
+
+uint64_t ResolutionController::getChangeCount() const
+{
+  return mChangeCount;
+}
+
+// ============================================================================
+
+bool ResolutionController::changeScale(double scale)
+{
+  scale = std::min(mMaxScale, std::max(mMinScale, scale));
+  auto bound = scale == mMinScale || scale == mMaxScale;
+  if (scale == mScale || (!bound && std::abs(scale - mScale) < MIN_SCALE_STEP)) {
+    return false;
+  }
+
+  // the frames still in flight ran at the previous scale, and the frame times are measured anew.
+  mScale = scale;
+  mFrameTime = FrameTimePredictor();
+  mSampleCount = 0;
+  mSkippedFrames = mSettleFrames;
+  mFastFrames = 0;
+  mChangeCount++;
+  return true;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include "FramePacer.h"
+
+#include <chrono>
+#include <cstdint>
+
+// ============================================================================
+// A controller of the internal render resolution which holds the GPU time of
+// the frames at a target.
+//
+// The scene is rendered into an offscreen target at a fraction of the output
+// size and upscaled into the back buffer, and the controller picks the
+// fraction from the measured GPU times. The GPU time of a frame is modeled as
+// proportional to its pixels, i.e. to the square of the scale, so the
+// controller computes the scale which brings the smoothed frame time to a
+// safety margin below the target. It reacts to a frame time above the target
+// after a few frames, but raises the scale only after many frames well below
+// the target and by bounded steps, and ignores changes smaller than a minimum
+// step, so the resolution does not oscillate around the target. The frames
+// measured after a change still ran at the previous scale for as long as the
+// frames are in flight, so they are skipped before the next decision.
+//
+// The controller never reads a clock itself, so the frame loop feeds it with
+// the measured times and the simulations with simulated ones.
+// ============================================================================
+class ResolutionController
+{
+public:
+  // the alignment of the render sizes.
+  static const unsigned int RENDER_SIZE_ALIGNMENT = 8;
+
+  // the frames measured after a change of the scale which are skipped before the next decision.
+  ResolutionController(std::chrono::microseconds targetFrameTime, double minScale, double maxScale, unsigned int settleFrames);
+
+  // set the frame time to hold. zero disables the controller, which then renders at the maximum scale.
+  void setTargetFrameTime(std::chrono::microseconds targetFrameTime);
+  std::chrono::microseconds getTargetFrameTime() const;
+
+  // add the measured GPU time of a frame. returns true when the scale has changed.
+  bool addFrameTime(std::chrono::microseconds frameTime);
+
+  // get the current fraction of the output size in each dimension.
+  double getScale() const;
+
+  // get the render size of the given output size at the current scale. it is aligned and within the output size.
+  void getRenderSize(unsigned int outputWidth, unsigned int outputHeight, unsigned int& width, unsigned int& height) const;
+
+  // get the smoothed frame time measured at the current scale.
+  std::chrono::microseconds getAverageFrameTime() const;
+
+  // get the amount of added frame times and the amount of scale changes so far.
+  uint64_t getFrameCount() const;
+  uint64_t getChangeCount() const;
+
+private:
+  // apply the new scale if it differs enough from the current one. returns true when the scale has changed.
+  bool changeScale(double scale);
+
+  std::chrono::microseconds mTargetFrameTime;
+  double mMinScale;
+  double mMaxScale;
+  unsigned int mSettleFrames;
+  double mScale;
+  // the frame times measured at the current scale.
+  FrameTimePredictor mFrameTime;
+  uint64_t mSampleCount;
+  // the frames left to skip after the last change and the consecutive frames well below the target.
+  unsigned int mSkippedFrames;
+  unsigned int mFastFrames;
+  uint64_t mFrameCount;
+  uint64_t mChangeCount;
+};
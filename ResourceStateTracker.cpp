@@ -0,0 +1,199 @@
+#include "ResourceStateTracker.h"
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
+// ============================================================================
+
+void ResourceStateRegistry::setState(const void* resource, ResourceStates state)
+{
+  mStates[resource] = state;
+}
+
+// ============================================================================
+
+void ResourceStateRegistry::removeResource(const void* resource)
+{
+  mStates.erase(resource);
+}
+
+// ============================================================================
+
+bool ResourceStateRegistry::getState(const void* resource, ResourceStates& state) const
+{
+  auto it = mStates.find(resource);
+  if (it == mStates.end()) {
+    return false;
+  }
+  state = it->second;
+  return true;
+}
+
+// ============================================================================
+
+void ResourceStateRegistry::transition(const void* resource, ResourceStates state, BarrierList& barriers)
+{
+  auto it = mStates.find(resource);
+  if (it == mStates.end()) {
+    throw new std::runtime_error("Cannot transition a resource which is not tracked by the registry");
+  }
+  if (it->second != state) {
+    barriers.push_back({ resource, it->second, state, BarrierSplit::NONE });
+    it->second = state;
+  }
+}
+
+// ============================================================================
+
+ResourceStateTracker::ResourceStateTracker() : mDroppedCount(0)
+{
+}
+
+// ============================================================================
+
+void ResourceStateTracker::transition(const void* resource, ResourceStates state)
+{
+  // the state before the first transition is unknown until the submission.
+  auto trackedState = findState(resource);
+  if (trackedState == nullptr) {
+    mStates.push_back({ resource, state, state, state, false });
+    return;
+  }
+
+  // end the begun split transition, which may already reach the required state.
+  auto& tracked = *trackedState;
+  if (tracked.split) {
+    endSplit(resource, tracked);
+  }
+  if (isResourceStateSatisfied(tracked.current, state)) {
+    mDroppedCount++;
+    return;
+  }
+  pushBarrier(resource, tracked.current, state);
+  tracked.current = state;
+}
+
+// ============================================================================
+
+void ResourceStateTracker::beginTransition(const void* resource, ResourceStates state)
+{
+  // the split cannot begin before the state is known, so the first transition is simply left pending.
+  auto trackedState = findState(resource);
+  if (trackedState == nullptr) {
+    transition(resource, state);
+    return;
+  }
+
+  auto& tracked = *trackedState;
+  if (tracked.split) {
+    endSplit(resource, tracked);
+  }
+  if (isResourceStateSatisfied(tracked.current, state)) {
+    mDroppedCount++;
+    return;
+  }
+  mBarriers.push_back({ resource, tracked.current, state, BarrierSplit::BEGIN });
+  tracked.splitState = state;
+  tracked.split = true;
+}
+
+// ============================================================================
+
+void ResourceStateTracker::flush(BarrierList& barriers)
+{
+  barriers.insert(barriers.end(), mBarriers.begin(), mBarriers.end());
+  mBarriers.clear();
+}
+
+// ============================================================================
+
+void ResourceStateTracker::resolve(ResourceStateRegistry& registry, BarrierList& barriers)
+{
+  // transition the resources from their known states into the states required by the first transitions.
+  for (auto& tracked : mStates) {
+    ResourceStates known;
+    if (!registry.getState(tracked.resource, known)) {
+      throw new std::runtime_error("Cannot resolve the state of a resource which is not tracked by the registry");
+    }
+    if (known != tracked.first) {
+      barriers.push_back({ tracked.resource, known, tracked.first, BarrierSplit::NONE });
+    }
+  }
+
+  // store the final states for the following command lists.
+  for (auto& tracked : mStates) {
+    registry.setState(tracked.resource, tracked.current);
+  }
+}
+
+// ============================================================================
+
+void ResourceStateTracker::reset()
+{
+  mStates.clear();
+  mBarriers.clear();
+  mDroppedCount = 0;
+}
+
+// ============================================================================
+
+unsigned int ResourceStateTracker::getDroppedCount() const
+{
+  return mDroppedCount;
+}
+
+// ============================================================================
+
+ResourceStateTracker::TrackedState* ResourceStateTracker::findState(const void* resource)
+{
+  auto it = std::find_if(mStates.begin(), mStates.end(), [resource](const TrackedState& tracked) {
+    return tracked.resource == resource;
+  });
+  return it != mStates.end() ? &*it : nullptr;
+}
+
+// ============================================================================
+
+void ResourceStateTracker::pushBarrier(const void* resource, ResourceStates before, ResourceStates after)
+{
+  // there are no commands between the batched barriers, so A->B and B->C can be merged into A->C unless a split
+  // barrier of the resource was batched after the first one.
+  auto it = std::find_if(mBarriers.rbegin(), mBarriers.rend(), [resource](const ResourceBarrier& barrier) {
+    return barrier.resource == resource;
+  });
+  if (it == mBarriers.rend() || it->split != BarrierSplit::NONE) {
+    mBarriers.push_back({ resource, before, after, BarrierSplit::NONE });
+    return;
+  }
+
+  mDroppedCount++;
+  it->after = after;
+  if (it->before == it->after) {
+    // the merged transitions cancel each other out.
+    mDroppedCount++;
+    mBarriers.erase(std::next(it).base());
+  }
+}
+
+// ============================================================================
+
+void ResourceStateTracker::endSplit(const void* resource, TrackedState& tracked)
+{
+  mBarriers.push_back({ resource, tracked.current, tracked.splitState, BarrierSplit::END });
+  tracked.current = tracked.splitState;
+  tracked.split = false;
+}
+
+// ============================================================================
+
+bool isResourceStateSatisfied(ResourceStates current, ResourceStates required)
+{
+  if (current == required) {
+    return true;
+  }
+
+  // a combination of read-only states satisfies each of its read-only states.
+  auto readOnly = (current & ~RESOURCE_STATE_READ_ONLY_MASK) == 0 && (required & ~RESOURCE_STATE_READ_ONLY_MASK) == 0;
+  return readOnly && required != 0 && (current & required) == required;
+}
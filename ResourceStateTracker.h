@@ -0,0 +1,148 @@
+#pragma once
+
+#include "LinearArena.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// ============================================================================
+
+// a combination of resource states. the values match the D3D12_RESOURCE_STATES.
+typedef uint32_t ResourceStates;
+
+static const ResourceStates RESOURCE_STATE_COMMON = 0;
+static const ResourceStates RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1;
+static const ResourceStates RESOURCE_STATE_INDEX_BUFFER = 0x2;
+static const ResourceStates RESOURCE_STATE_RENDER_TARGET = 0x4;
+static const ResourceStates RESOURCE_STATE_UNORDERED_ACCESS = 0x8;
+static const ResourceStates RESOURCE_STATE_DEPTH_WRITE = 0x10;
+static const ResourceStates RESOURCE_STATE_DEPTH_READ = 0x20;
+static const ResourceStates RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40;
+static const ResourceStates RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80;
+static const ResourceStates RESOURCE_STATE_INDIRECT_ARGUMENT = 0x200;
+static const ResourceStates RESOURCE_STATE_COPY_DEST = 0x400;
+static const ResourceStates RESOURCE_STATE_COPY_SOURCE = 0x800;
+static const ResourceStates RESOURCE_STATE_PRESENT = 0;
+
+// the states which only read the resource and can therefore be combined with each other.
+static const ResourceStates RESOURCE_STATE_READ_ONLY_MASK =
+  RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER |
+  RESOURCE_STATE_INDEX_BUFFER |
+  RESOURCE_STATE_DEPTH_READ |
+  RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE |
+  RESOURCE_STATE_PIXEL_SHADER_RESOURCE |
+  RESOURCE_STATE_INDIRECT_ARGUMENT |
+  RESOURCE_STATE_COPY_SOURCE;
+
+// ============================================================================
+
+// the part of a split barrier. split barriers let the GPU transition the resource while other work is executed.
+enum class BarrierSplit { NONE, BEGIN, END };
+
+// a transition of a resource between two states.
+struct ResourceBarrier
+{
+  const void* resource;
+  ResourceStates before;
+  ResourceStates after;
+  BarrierSplit split;
+};
+
+// a list of barriers. the lists recorded in the frame allocate from the arena of the frame.
+typedef ArenaVector<ResourceBarrier> BarrierList;
+
+// ============================================================================
+// The known states of the resources after all submitted command lists.
+//
+// The registry is only accessed on the submitting thread, where the pending
+// transitions of each command list are resolved in the submission order.
+// ============================================================================
+class ResourceStateRegistry
+{
+public:
+  // set the state of a new or an existing resource.
+  void setState(const void* resource, ResourceStates state);
+
+  // stop tracking the given resource.
+  void removeResource(const void* resource);
+
+  // get the state of the given resource. returns false if the resource is not tracked.
+  bool getState(const void* resource, ResourceStates& state) const;
+
+  // transition the resource directly at the submission time (e.g. in a command list recorded during the submission).
+  void transition(const void* resource, ResourceStates state, BarrierList& barriers);
+
+private:
+  std::unordered_map<const void*, ResourceStates> mStates;
+};
+
+// ============================================================================
+// A resource state tracker for a single command list.
+//
+// The command list only declares the states it needs. The transitions are
+// collected into a batch that is flushed into a single ResourceBarrier call
+// before the resources are used, where transitions into the current state
+// are dropped and consecutive transitions of a resource are merged. As the
+// state of a resource is unknown before the command list is executed, the
+// first transition of each resource is left pending and resolved against
+// the registry when the command list is submitted. A command list touches
+// only a few resources, so they are kept in flat vectors which are searched
+// linearly and keep their capacity over the resets.
+// ============================================================================
+class ResourceStateTracker
+{
+public:
+  ResourceStateTracker();
+
+  // require the resource to be in the given state for the following commands.
+  void transition(const void* resource, ResourceStates state);
+
+  // begin a split transition, which is ended by the next transition of the resource.
+  void beginTransition(const void* resource, ResourceStates state);
+
+  // move the batched barriers into the given vector so that they can be recorded with a single call.
+  void flush(BarrierList& barriers);
+
+  // get the barriers needed before the command list and store the final states into the registry. called in the submission order.
+  void resolve(ResourceStateRegistry& registry, BarrierList& barriers);
+
+  // forget all tracked states and barriers so that the tracker can be used for a new command list.
+  void reset();
+
+  // get the amount of transitions which were dropped or merged since the last reset.
+  unsigned int getDroppedCount() const;
+
+private:
+  struct TrackedState
+  {
+    const void* resource;
+    // the state required by the first transition, which is resolved at the submission.
+    ResourceStates first;
+    // the state after all recorded transitions.
+    ResourceStates current;
+    // the target state of the begun split transition.
+    ResourceStates splitState;
+    bool split;
+  };
+
+  // find the tracked state of the resource or return nullptr if it has not been transitioned since the last reset.
+  TrackedState* findState(const void* resource);
+
+  // push a barrier or merge it with the batched barrier of the same resource.
+  void pushBarrier(const void* resource, ResourceStates before, ResourceStates after);
+
+  // end the begun split transition of the resource.
+  void endSplit(const void* resource, TrackedState& tracked);
+
+  // the tracked resources in the order of their first transitions, which are resolved in the same order.
+  std::vector<TrackedState> mStates;
+  std::vector<ResourceBarrier> mBarriers;
+  unsigned int mDroppedCount;
+};
+
+// ============================================================================
+
+// check whether the current state already satisfies the required state without a transition.
+bool isResourceStateSatisfied(ResourceStates current, ResourceStates required);
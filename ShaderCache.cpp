@@ -0,0 +1,191 @@
+#include "ShaderCache.h"
+#include "PipelineCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+// ============================================================================
+
+uint64_t getShaderKey(const ShaderDesc& desc)
+{
+  PipelineHasher hasher;
+  hasher.add(hashBytes(desc.source, desc.sourceSize));
+  hasher.addString(desc.entryPoint).addString(desc.target);
+  hasher.add(desc.defines.size());
+  for (auto& define : desc.defines) {
+    hasher.addString(define.name.c_str()).addString(define.value.c_str());
+  }
+  return hasher.add(desc.flags).get();
+}
+
+// ============================================================================
+
+ShaderCache::ShaderCache(const std::string& path, CompileFunc compile)
+  : mPath(path), mCompile(compile), mEntries(nullptr), mEntryCount(0), mHitCount(0), mMissCount(0)
+{
+  map();
+}
+
+// ============================================================================
+
+ShaderBlob ShaderCache::getShader(const ShaderDesc& desc)
+{
+  // look up the archive first and then the shaders compiled after it was mapped.
+  auto key = getShaderKey(desc);
+  ShaderBlob blob;
+  if (findMapped(key, blob)) {
+    mHitCount++;
+    return blob;
+  }
+  auto it = mCompiled.find(key);
+  if (it != mCompiled.end()) {
+    mHitCount++;
+    return { it->second.data(), it->second.size() };
+  }
+
+  // compile the shader on a miss.
+  mMissCount++;
+  auto& bytecode = mCompiled[key];
+  bytecode = mCompile(desc);
+  return { bytecode.data(), bytecode.size() };
+}
+
+// ============================================================================
+
+void ShaderCache::save()
+{
+  // gather all blobs sorted by their keys.
+  std::map<uint64_t, ShaderBlob> blobs;
+  for (auto i = 0u; i < mEntryCount; i++) {
+    blobs[mEntries[i].key] = { mFile.getData() + mEntries[i].offset, static_cast<size_t>(mEntries[i].size) };
+  }
+  for (auto& compiled : mCompiled) {
+    blobs[compiled.first] = { compiled.second.data(), compiled.second.size() };
+  }
+
+  // build the table of entries with the aligned blob offsets.
+  std::vector<Entry> entries;
+  auto offset = sizeof(Header) + blobs.size() * sizeof(Entry);
+  for (auto& blob : blobs) {
+    offset = (offset + BLOB_ALIGNMENT - 1) & ~(BLOB_ALIGNMENT - 1);
+    entries.push_back({ blob.first, offset, blob.second.size });
+    offset += blob.second.size;
+  }
+
+  // write the archive into a temporary file, because the current archive is still mapped.
+  auto temporaryPath = mPath + ".tmp";
+  {
+    std::ofstream stream(temporaryPath, std::ios::binary);
+    if (!stream) {
+      std::cout << "std::ofstream: " << temporaryPath << std::endl;
+      throw new std::runtime_error("Failed to open the shader archive file");
+    }
+
+    // the archive is written in the native (little-endian) layout, so it can be used in place.
+    Header header = { MAGIC, VERSION, entries.size() };
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (!entries.empty()) {
+      stream.write(reinterpret_cast<const char*>(&entries[0]), entries.size() * sizeof(Entry));
+    }
+    auto position = sizeof(Header) + entries.size() * sizeof(Entry);
+    auto entry = entries.begin();
+    for (auto& blob : blobs) {
+      static const char padding[BLOB_ALIGNMENT] = {};
+      stream.write(padding, entry->offset - position);
+      stream.write(reinterpret_cast<const char*>(blob.second.data), blob.second.size);
+      position = entry->offset + entry->size;
+      ++entry;
+    }
+    if (!stream) {
+      throw new std::runtime_error("Failed to write the shader archive file");
+    }
+  }
+
+  // replace the archive and map the new one.
+  mFile.close();
+  std::remove(mPath.c_str());
+  if (std::rename(temporaryPath.c_str(), mPath.c_str()) != 0) {
+    std::cout << "std::rename: " << temporaryPath << std::endl;
+    throw new std::runtime_error("Failed to replace the shader archive file");
+  }
+  mCompiled.clear();
+  map();
+}
+
+// ============================================================================
+
+bool ShaderCache::isDirty() const
+{
+  return !mCompiled.empty();
+}
+
+// ============================================================================
+
+unsigned int ShaderCache::getHitCount() const
+{
+  return mHitCount;
+}
+
+// ============================================================================
+
+unsigned int ShaderCache::getMissCount() const
+{
+  return mMissCount;
+}
+
+// ============================================================================
+
+void ShaderCache::map()
+{
+  mEntries = nullptr;
+  mEntryCount = 0;
+  if (!mFile.open(mPath)) {
+    return;
+  }
+
+  // reject archives of other formats or versions.
+  auto data = mFile.getData();
+  auto size = static_cast<uint64_t>(mFile.getSize());
+  Header header;
+  if (size < sizeof(header)) {
+    return;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != MAGIC || header.version != VERSION) {
+    return;
+  }
+
+  // reject truncated archives and entries which point outside of the archive.
+  if (header.entryCount > (size - sizeof(header)) / sizeof(Entry)) {
+    return;
+  }
+  auto entries = reinterpret_cast<const Entry*>(data + sizeof(header));
+  for (auto i = 0u; i < header.entryCount; i++) {
+    if (entries[i].offset > size || entries[i].size > size - entries[i].offset) {
+      return;
+    }
+    if (i > 0 && entries[i - 1].key >= entries[i].key) {
+      return;
+    }
+  }
+  mEntries = entries;
+  mEntryCount = header.entryCount;
+}
+
+// ============================================================================
+
+bool ShaderCache::findMapped(uint64_t key, ShaderBlob& blob) const
+{
+  auto end = mEntries + mEntryCount;
+  auto it = std::lower_bound(mEntries, end, key, [](const Entry& entry, uint64_t key) { return entry.key < key; });
+  if (it == end || it->key != key) {
+    return false;
+  }
+  blob.data = mFile.getData() + it->offset;
+  blob.size = static_cast<size_t>(it->size);
+  return true;
+}
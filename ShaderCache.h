@@ -0,0 +1,112 @@
+#pragma once
+
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+// ============================================================================
+
+// a preprocessor definition passed to the shader compiler.
+struct ShaderDefine
+{
+  std::string name;
+  std::string value;
+};
+
+// the inputs of a single shader compilation.
+struct ShaderDesc
+{
+  const char* source;
+  size_t sourceSize;
+  const char* entryPoint;
+  const char* target;
+  std::vector<ShaderDefine> defines;
+  unsigned int flags;
+};
+
+// a compiled shader bytecode. points either into the archive or into the cache.
+struct ShaderBlob
+{
+  const uint8_t* data;
+  size_t size;
+};
+
+// ============================================================================
+
+// get the key of the shader compilation: the hash of the source, entry point, target, defines and flags.
+uint64_t getShaderKey(const ShaderDesc& desc);
+
+// ============================================================================
+// A content-addressed cache of the compiled shaders.
+//
+// The shaders are stored in a single versioned archive file, which consists
+// of a header, a table of entries sorted by the shader key and the aligned
+// bytecode blobs. The archive is memory mapped and looked up with a binary
+// search, so the cached bytecode is used in place without copying. Only the
+// misses are compiled and they are appended when the archive is saved.
+// ============================================================================
+class ShaderCache
+{
+public:
+  // the identifier at the beginning of the archive file.
+  static const uint32_t MAGIC = 0x41444853; // "SHDA"
+  // the version of the archive file format.
+  static const uint32_t VERSION = 1;
+  // the alignment of the bytecode blobs in the archive.
+  static const uint64_t BLOB_ALIGNMENT = 16;
+
+  // the callback that compiles the shader. throws if the compilation fails.
+  typedef std::function<std::vector<uint8_t>(const ShaderDesc& desc)> CompileFunc;
+
+  ShaderCache(const std::string& path, CompileFunc compile);
+
+  // get the compiled shader from the archive or compile it on a miss.
+  ShaderBlob getShader(const ShaderDesc& desc);
+
+  // write all cached shaders into the archive file and map it again. invalidates the previously returned blobs.
+  void save();
+
+  // check whether shaders have been compiled after the archive was mapped.
+  bool isDirty() const;
+
+  // get the amount of shaders found from the cache and the amount of compiled shaders.
+  unsigned int getHitCount() const;
+  unsigned int getMissCount() const;
+
+private:
+  // the header at the beginning of the archive.
+  struct Header
+  {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t entryCount;
+  };
+
+  // a single entry in the table of the archive.
+  struct Entry
+  {
+    uint64_t key;
+    uint64_t offset;
+    uint64_t size;
+  };
+
+  // map the archive and validate its header and entries. an invalid archive is treated as empty.
+  void map();
+
+  // find the blob with the given key from the mapped archive.
+  bool findMapped(uint64_t key, ShaderBlob& blob) const;
+
+  std::string mPath;
+  CompileFunc mCompile;
+  MappedFile mFile;
+  const Entry* mEntries;
+  uint64_t mEntryCount;
+  std::map<uint64_t, std::vector<uint8_t>> mCompiled;
+  unsigned int mHitCount;
+  unsigned int mMissCount;
+};
@@ -0,0 +1,2513 @@
+#include "Simulation.h"
+#include "CommandStream.h"
+#include "DescriptorAllocator.h"
+#include "DrawQueue.h"
+#include "FenceTimeline.h"
+#include "FrameLoop.h"
+#include "FramePacer.h"
+#include "FrustumCuller.h"
+#include "GpuProfiler.h"
+#include "HeapCounter.h"
+#include "JobSystem.h"
+#include "LinearArena.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+#include "NullBackend.h"
+#include "PipelineCache.h"
+#include "Profiler.h"
+#include "RenderGraph.h"
+#include "ResidencyManager.h"
+#include "ResolutionController.h"
+#include "ResourceStateTracker.h"
+#include "ShaderCache.h"
+#include "SoftwareBackend.h"
+#include "TaskGraph.h"
+#include "UploadQueue.h"
+#include "UploadRing.h"
+#include "VertexFormat.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std::chrono;
+
+// ============================================================================
+
+void simulateFrameLoops(unsigned int bufferCount, unsigned int maxFramesInFlight, std::ostream& out)
+{
+  // simulate a frame loop where the GPU work takes a bit longer than the CPU work.
+  auto cpuTime = microseconds(4000);
+  auto gpuTime = microseconds(6000);
+  auto frameCount = 200u;
+
+  // measure the average frame time with different amount of frames in flight.
+  out << "simulating " << frameCount << " frames (cpu: " << cpuTime.count() << "us, gpu: " << gpuTime.count() << "us)" << std::endl;
+  for (auto framesInFlight = 1u; framesInFlight <= maxFramesInFlight; framesInFlight++) {
+    NullDevice device;
+    auto commandQueue = device.createCommandQueue(CommandListType::DIRECT);
+    auto fence = device.createFence();
+    NullSwapChain swapChain(bufferCount, microseconds::zero());
+    NullCommandList commandList(gpuTime);
+    FrameScheduler frameScheduler(framesInFlight);
+    uint64_t fenceValue = 0u;
+
+    // run the frame loop where the recording only consumes the simulated CPU time.
+    auto frame = 0u;
+    auto stats = runFrameLoop(*commandQueue, *fence, fenceValue, swapChain, frameScheduler, PresentMode::IMMEDIATE,
+      [&] { return frame++ < frameCount; },
+      [&](unsigned int, unsigned int, std::vector<CommandList*>& commandLists) {
+        busyWait(cpuTime);
+        commandLists.push_back(&commandList);
+      });
+    flush(*commandQueue, *fence, fenceValue);
+
+    out << "frames in flight: " << framesInFlight
+      << " frame time: " << getAverageFrameTime(stats).count() << "us"
+      << " (min: " << stats.minFrameTime.count() << "us, max: " << stats.maxFrameTime.count() << "us)" << std::endl;
+  }
+}
+
+// ============================================================================
+
+void simulateParallelRecording(unsigned int drawCount, unsigned int drawsPerCommandList, unsigned int maxThreadCount, microseconds drawTime, std::ostream& out)
+{
+  auto frameCount = 50u;
+  auto commandListCount = (drawCount + drawsPerCommandList - 1) / drawsPerCommandList;
+
+  // measure the recording time with an increasing amount of worker threads.
+  out << "simulating parallel recording of " << drawCount << " draws in " << commandListCount << " command lists (" << drawTime.count() << "us per draw)" << std::endl;
+  auto singleThreadTime = microseconds::zero();
+  for (auto threadCount = 1u; threadCount <= std::max(maxThreadCount, 1u); threadCount++) {
+    JobSystem jobSystem(threadCount);
+    std::vector<NullCommandList> commandLists(commandListCount, NullCommandList(microseconds::zero()));
+
+    auto start = steady_clock::now();
+    for (auto frame = 0u; frame < frameCount; frame++) {
+      PROFILE_SCOPE("record frame");
+
+      // record each range of draws into its own command list with the stub consuming the CPU time of the draws.
+      jobSystem.parallelFor(commandListCount, 1, [&](unsigned int begin, unsigned int end) {
+        for (auto i = begin; i < end; i++) {
+          PROFILE_SCOPE("record command list");
+          auto first = i * drawsPerCommandList;
+          auto count = std::min(drawsPerCommandList, drawCount - first);
+          busyWait(drawTime * count);
+          commandLists[i].setGpuTime(drawTime * count);
+        }
+      });
+    }
+    auto frameTime = duration_cast<microseconds>(steady_clock::now() - start) / frameCount;
+    if (threadCount == 1) {
+      singleThreadTime = frameTime;
+    }
+
+    out << "threads: " << threadCount
+      << " record time: " << frameTime.count() << "us"
+      << " (speedup: " << static_cast<double>(singleThreadTime.count()) / std::max<long long>(frameTime.count(), 1) << "x)" << std::endl;
+  }
+}
+
+// ============================================================================
+
+void simulateInitGraph(unsigned int threadCount, std::ostream& out)
+{
+  // mirror the initialization tasks of the application with their typical costs.
+  TaskGraph graph;
+  auto task = [&](const char* name, unsigned int cost, const std::vector<TaskGraph::TaskId>& dependencies, bool mainThread) {
+    return graph.addTask(name, [cost] { busyWait(microseconds(cost)); }, dependencies, mainThread);
+  };
+  auto window = task("window", 15000, {}, true);
+  auto adapter = task("adapter", 30000, {}, false);
+  auto device = task("device", 60000, { adapter }, false);
+  auto shaders = task("shaders", 50000, {}, false);
+  auto commandQueue = task("command queue", 1000, { device }, false);
+  auto swapChain = task("swap chain", 25000, { window, commandQueue }, true);
+  auto rtvAllocator = task("descriptor heaps", 500, { device }, false);
+  task("render targets", 1000, { swapChain, rtvAllocator }, false);
+  auto commandAllocators = task("command allocators", 2000, { device }, false);
+  auto pipelineCache = task("pipeline library", 3000, { adapter, device }, false);
+  auto rootSignature = task("root signature", 2000, { device }, false);
+  auto pipelineState = task("pipeline state", 40000, { pipelineCache, rootSignature, shaders }, false);
+  task("command lists", 2000, { commandAllocators, pipelineState }, false);
+  task("upload buffer", 3000, { device }, false);
+  task("fence", 500, { device }, false);
+
+  out << "simulating the initialization graph with " << threadCount << " threads" << std::endl;
+  JobSystem jobSystem(threadCount);
+  graph.run(jobSystem);
+  graph.printReport(out);
+}
+
+// ============================================================================
+
+void simulateResourceStateTracking(unsigned int resourceCount, unsigned int transitionCount, std::ostream& out)
+{
+  // the rules of the batch first: the first transition is left pending, consecutive transitions merge, transitions back
+  // into the batched state cancel out without disturbing the other batched barriers, satisfied transitions are dropped,
+  // and a split transition ends with the next transition of the resource without merging into its begin barrier.
+  {
+    char a = 0, b = 0;
+    ResourceStateRegistry checkRegistry;
+    checkRegistry.setState(&a, RESOURCE_STATE_COMMON);
+    checkRegistry.setState(&b, RESOURCE_STATE_COPY_DEST);
+    ResourceStateTracker checkTracker;
+    BarrierList checkBarriers;
+    auto expectBarriers = [&](std::initializer_list<ResourceBarrier> expected, unsigned int droppedCount, const char* message) {
+      checkBarriers.clear();
+      checkTracker.flush(checkBarriers);
+      auto equal = checkBarriers.size() == expected.size() && std::equal(expected.begin(), expected.end(), checkBarriers.begin(),
+        [](const ResourceBarrier& left, const ResourceBarrier& right) {
+          return left.resource == right.resource && left.before == right.before && left.after == right.after && left.split == right.split;
+        });
+      if (!equal || checkTracker.getDroppedCount() != droppedCount) {
+        throw new std::runtime_error(message);
+      }
+    };
+    checkTracker.transition(&a, RESOURCE_STATE_RENDER_TARGET);
+    checkTracker.transition(&b, RESOURCE_STATE_COPY_DEST);
+    expectBarriers({}, 0, "First transitions are not left pending");
+    checkTracker.transition(&a, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    checkTracker.transition(&a, RESOURCE_STATE_COPY_SOURCE);
+    expectBarriers({ { &a, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_COPY_SOURCE, BarrierSplit::NONE } }, 1, "Consecutive transitions are not merged");
+    checkTracker.transition(&a, RESOURCE_STATE_RENDER_TARGET);
+    checkTracker.transition(&b, RESOURCE_STATE_COPY_SOURCE);
+    checkTracker.transition(&a, RESOURCE_STATE_COPY_SOURCE);
+    checkTracker.transition(&b, RESOURCE_STATE_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    checkTracker.transition(&b, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    expectBarriers({ { &b, RESOURCE_STATE_COPY_DEST, RESOURCE_STATE_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, BarrierSplit::NONE } }, 5,
+      "Cancelled transitions are not dropped or the other batched barriers are lost");
+    checkTracker.transition(&a, RESOURCE_STATE_RENDER_TARGET);
+    expectBarriers({ { &a, RESOURCE_STATE_COPY_SOURCE, RESOURCE_STATE_RENDER_TARGET, BarrierSplit::NONE } }, 5, "Transitions are merged across a flush");
+    checkTracker.beginTransition(&a, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    checkTracker.beginTransition(&b, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    checkTracker.transition(&a, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    expectBarriers({ { &a, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_PIXEL_SHADER_RESOURCE, BarrierSplit::BEGIN },
+      { &a, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_PIXEL_SHADER_RESOURCE, BarrierSplit::END } }, 7, "Split transitions are not ended by the next transition");
+    checkTracker.beginTransition(&a, RESOURCE_STATE_COPY_SOURCE);
+    checkTracker.transition(&a, RESOURCE_STATE_COPY_DEST);
+    checkTracker.transition(&a, RESOURCE_STATE_RENDER_TARGET);
+    expectBarriers({ { &a, RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_COPY_SOURCE, BarrierSplit::BEGIN },
+      { &a, RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_COPY_SOURCE, BarrierSplit::END },
+      { &a, RESOURCE_STATE_COPY_SOURCE, RESOURCE_STATE_RENDER_TARGET, BarrierSplit::NONE } }, 8, "Transitions are merged into a split transition");
+
+    // the pending first transitions are resolved against the registry, which receives the final states.
+    checkBarriers.clear();
+    checkTracker.resolve(checkRegistry, checkBarriers);
+    ResourceStates stateA, stateB;
+    if (checkBarriers.size() != 1 || checkBarriers[0].resource != &a || checkBarriers[0].before != RESOURCE_STATE_COMMON || checkBarriers[0].after != RESOURCE_STATE_RENDER_TARGET ||
+        !checkRegistry.getState(&a, stateA) || stateA != RESOURCE_STATE_RENDER_TARGET || !checkRegistry.getState(&b, stateB) || stateB != (RESOURCE_STATE_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)) {
+      throw new std::runtime_error("Pending transitions are not resolved against the registry");
+    }
+  }
+
+  // the resources are only identified by their addresses.
+  std::vector<char> resources(resourceCount);
+  ResourceStateRegistry registry;
+  for (auto& resource : resources) {
+    registry.setState(&resource, RESOURCE_STATE_COMMON);
+  }
+
+  // pick the transitions from a small set of states, so that many of them are redundant.
+  const ResourceStates states[] = {
+    RESOURCE_STATE_RENDER_TARGET,
+    RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+    RESOURCE_STATE_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE,
+    RESOURCE_STATE_UNORDERED_ACCESS,
+    RESOURCE_STATE_COPY_SOURCE
+  };
+  std::mt19937 random(1);
+  std::uniform_int_distribution<unsigned int> resourceDistribution(0, resourceCount - 1);
+  std::uniform_int_distribution<unsigned int> stateDistribution(0, sizeof(states) / sizeof(states[0]) - 1);
+  std::vector<std::pair<unsigned int, ResourceStates>> transitions;
+  for (auto i = 0u; i < transitionCount; i++) {
+    transitions.push_back({ resourceDistribution(random), states[stateDistribution(random)] });
+  }
+
+  // record the transitions into command lists and flush the batch before every simulated draw.
+  auto listCount = 20u;
+  auto transitionsPerDraw = 4u;
+  ResourceStateTracker tracker;
+  BarrierList barriers;
+  auto barrierCount = 0ull;
+  auto flushCount = 0ull;
+  auto droppedCount = 0ull;
+  auto start = steady_clock::now();
+  for (auto list = 0u; list < listCount; list++) {
+    tracker.reset();
+    for (auto i = 0u; i < transitions.size(); i++) {
+      tracker.transition(&resources[transitions[i].first], transitions[i].second);
+      if ((i + 1) % transitionsPerDraw == 0) {
+        barriers.clear();
+        tracker.flush(barriers);
+        barrierCount += barriers.size();
+        flushCount += barriers.empty() ? 0 : 1;
+      }
+    }
+    barriers.clear();
+    tracker.flush(barriers);
+    tracker.resolve(registry, barriers);
+    barrierCount += barriers.size();
+    droppedCount += tracker.getDroppedCount();
+  }
+  auto time = duration_cast<nanoseconds>(steady_clock::now() - start);
+  auto totalTransitions = static_cast<double>(listCount) * transitionCount;
+
+  out << "simulating " << transitionCount << " transitions of " << resourceCount << " resources in " << listCount << " command lists" << std::endl;
+  out << "time per transition: " << time.count() / totalTransitions << "ns"
+    << " barriers: " << barrierCount
+    << " (" << 100.0 * barrierCount / totalTransitions << "% of transitions)"
+    << " dropped or merged: " << droppedCount
+    << " ResourceBarrier calls: " << flushCount << " (instead of " << totalTransitions << ")" << std::endl;
+}
+
+// ============================================================================
+
+// build a render graph of a deferred frame where the passes don't record anything.
+static void buildDeferredFrame(RenderGraph& graph, unsigned int width, unsigned int height)
+{
+  static const auto TEXTURE_ALIGNMENT = 65536ull;
+  auto pixels = static_cast<uint64_t>(width) * height;
+  auto noop = [](const RenderGraph::PassContext&) {};
+
+  auto backBuffer = graph.importResource("back buffer", RESOURCE_STATE_PRESENT, RESOURCE_STATE_PRESENT);
+  auto depth = graph.createTransient("depth", pixels * 4, TEXTURE_ALIGNMENT);
+  auto albedo = graph.createTransient("gbuffer albedo", pixels * 4, TEXTURE_ALIGNMENT);
+  auto normal = graph.createTransient("gbuffer normal", pixels * 8, TEXTURE_ALIGNMENT);
+  auto material = graph.createTransient("gbuffer material", pixels * 4, TEXTURE_ALIGNMENT);
+  auto shadowMap = graph.createTransient("shadow map", 2048ull * 2048 * 4, TEXTURE_ALIGNMENT);
+  auto ssao = graph.createTransient("ssao", pixels, TEXTURE_ALIGNMENT);
+  auto hdr = graph.createTransient("hdr", pixels * 8, TEXTURE_ALIGNMENT);
+  auto bloomHalf = graph.createTransient("bloom half", pixels * 8 / 4, TEXTURE_ALIGNMENT);
+  auto bloomQuarter = graph.createTransient("bloom quarter", pixels * 8 / 16, TEXTURE_ALIGNMENT);
+  auto debugView = graph.createTransient("debug view", pixels * 4, TEXTURE_ALIGNMENT);
+
+  auto pass = graph.addPass("depth prepass", noop);
+  graph.write(pass, depth, RESOURCE_STATE_DEPTH_WRITE);
+
+  pass = graph.addPass("gbuffer", noop);
+  graph.write(pass, depth, RESOURCE_STATE_DEPTH_WRITE);
+  graph.write(pass, albedo, RESOURCE_STATE_RENDER_TARGET);
+  graph.write(pass, normal, RESOURCE_STATE_RENDER_TARGET);
+  graph.write(pass, material, RESOURCE_STATE_RENDER_TARGET);
+
+  pass = graph.addPass("shadows", noop);
+  graph.write(pass, shadowMap, RESOURCE_STATE_DEPTH_WRITE);
+
+  pass = graph.addPass("ssao", noop);
+  graph.read(pass, depth, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+  graph.read(pass, normal, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+  graph.write(pass, ssao, RESOURCE_STATE_UNORDERED_ACCESS);
+
+  pass = graph.addPass("lighting", noop);
+  graph.read(pass, depth, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+  graph.read(pass, albedo, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+  graph.read(pass, normal, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+  graph.read(pass, material, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+  graph.read(pass, shadowMap, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+  graph.read(pass, ssao, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+  graph.write(pass, hdr, RESOURCE_STATE_RENDER_TARGET);
+
+  // the debug view is never read, so the pass is culled.
+  pass = graph.addPass("debug view", noop);
+  graph.read(pass, normal, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+  graph.write(pass, debugView, RESOURCE_STATE_RENDER_TARGET);
+
+  pass = graph.addPass("bloom downsample", noop);
+  graph.read(pass, hdr, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+  graph.write(pass, bloomHalf, RESOURCE_STATE_UNORDERED_ACCESS);
+
+  pass = graph.addPass("bloom blur", noop);
+  graph.read(pass, bloomHalf, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+  graph.write(pass, bloomQuarter, RESOURCE_STATE_UNORDERED_ACCESS);
+
+  pass = graph.addPass("tonemap", noop);
+  graph.read(pass, hdr, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+  graph.read(pass, bloomQuarter, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+  graph.write(pass, backBuffer, RESOURCE_STATE_RENDER_TARGET);
+
+  pass = graph.addPass("ui", noop);
+  graph.write(pass, backBuffer, RESOURCE_STATE_RENDER_TARGET);
+}
+
+// ============================================================================
+
+void simulateRenderGraph(unsigned int width, unsigned int height, unsigned int compileCount, std::ostream& out)
+{
+  // the graph is usually rebuilt every frame, so measure both the building and the compilation.
+  auto start = steady_clock::now();
+  for (auto i = 0u; i < compileCount; i++) {
+    RenderGraph graph;
+    buildDeferredFrame(graph, width, height);
+    graph.compile();
+  }
+  auto time = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+  RenderGraph graph;
+  buildDeferredFrame(graph, width, height);
+  graph.compile();
+  out << "simulating a render graph of a deferred frame at " << width << "x" << height << std::endl;
+  graph.printReport(out);
+  out << "time per build and compile: " << time.count() / 1000.0 / compileCount << "us" << std::endl;
+}
+
+// ============================================================================
+
+void simulateMeshLoading(unsigned int vertexCount, std::ostream& out)
+{
+  static const auto MESH_FILE = "simulated-mesh.bin";
+  static const auto RING_SIZE = 4ull * 1024 * 1024;
+  static const auto CHUNK_SIZE = 1024ull * 1024;
+
+  // build a grid of quads with two triangles each.
+  auto columns = 1024u;
+  auto rows = std::max(vertexCount / columns, 2u);
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+  for (auto y = 0u; y < rows; y++) {
+    for (auto x = 0u; x < columns; x++) {
+      vertices.push_back({ { static_cast<float>(x), static_cast<float>(y), 0.f }, { 1.f, 1.f, 1.f, 1.f } });
+      if (x > 0 && y > 0) {
+        auto corner = y * columns + x;
+        indices.insert(indices.end(), { corner - columns - 1, corner - 1, corner, corner - columns - 1, corner, corner - columns });
+      }
+    }
+  }
+  VertexLayout vertexLayout = { PositionFormat::FLOAT3, ColorFormat::FLOAT4 };
+  writeMeshFile(MESH_FILE, { vertices.data(), vertices.size(), sizeof(Vertex), vertexLayout, indices.data(), indices.size(), 4 });
+  vertices.clear();
+  vertices.shrink_to_fit();
+  indices.clear();
+  indices.shrink_to_fit();
+
+  // the ring memory is released right away, as there's no GPU which would consume the chunks.
+  std::vector<uint8_t> ringMemory(RING_SIZE);
+  UploadRing ring(RING_SIZE, ringMemory.data());
+  auto flushCount = 0ull;
+  auto copyChunk = [](const UploadAllocation&, uint64_t) {};
+  auto flush = [&] {
+    flushCount++;
+    ring.finishFrame(flushCount);
+    ring.reclaim(flushCount);
+  };
+
+  // stream the mapped file straight into the ring.
+  auto start = steady_clock::now();
+  MeshFile meshFile;
+  if (!meshFile.open(MESH_FILE)) {
+    throw new std::runtime_error("Failed to open the simulated mesh file");
+  }
+  auto& mesh = meshFile.getMesh();
+  uploadChunked(ring, mesh.vertices, mesh.vertexCount * mesh.vertexStride, CHUNK_SIZE, copyChunk, flush);
+  uploadChunked(ring, mesh.indices, mesh.indexCount * mesh.indexSize, CHUNK_SIZE, copyChunk, flush);
+  flush();
+  auto mappedTime = duration_cast<microseconds>(steady_clock::now() - start);
+  auto fileSize = meshFile.getFileSize();
+  auto loadedVertexCount = mesh.vertexCount;
+  auto loadedIndexCount = mesh.indexCount;
+  meshFile.close();
+
+  // compare against reading the whole file into the heap before streaming it.
+  start = steady_clock::now();
+  std::vector<char> contents;
+  {
+    std::ifstream stream(MESH_FILE, std::ios::binary);
+    stream.seekg(0, std::ios::end);
+    contents.resize(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0, std::ios::beg);
+    stream.read(contents.data(), contents.size());
+  }
+  uploadChunked(ring, contents.data(), contents.size(), CHUNK_SIZE, copyChunk, flush);
+  flush();
+  auto readTime = duration_cast<microseconds>(steady_clock::now() - start);
+
+  // a mesh without indices (e.g. a point cloud) must have no index stream, both when written directly and when converted.
+  {
+    static const auto OBJ_FILE = "simulated-mesh.obj";
+    Vertex points[] = { { { 0.f, 0.f, 0.f }, { 1.f, 0.f, 0.f, 1.f } }, { { 1.f, 0.f, 0.f }, { 0.f, 1.f, 0.f, 1.f } }, { { 0.f, 1.f, 0.f }, { 0.f, 0.f, 1.f, 1.f } } };
+    auto checkPoints = [&](const char* message) {
+      MeshFile pointFile;
+      if (!pointFile.open(MESH_FILE) || pointFile.getMesh().vertexCount != 3 || pointFile.getMesh().indexCount != 0 ||
+          pointFile.getMesh().indexSize != 0 || pointFile.getMesh().indices != nullptr) {
+        throw new std::runtime_error(message);
+      }
+    };
+    writeMeshFile(MESH_FILE, { points, 3, sizeof(Vertex), vertexLayout, nullptr, 0, 4 });
+    checkPoints("Mesh file without indices cannot be opened");
+    {
+      std::ofstream stream(OBJ_FILE);
+      for (auto& point : points) {
+        stream << "v " << point.position[0] << " " << point.position[1] << " " << point.position[2] << std::endl;
+      }
+    }
+    convertObjToMeshFile(OBJ_FILE, MESH_FILE, { PositionFormat::FLOAT3, ColorFormat::UNORM8 }, out);
+    checkPoints("Converted mesh file without indices cannot be opened");
+    std::remove(OBJ_FILE);
+  }
+  std::remove(MESH_FILE);
+
+  auto megabytes = fileSize / (1024.0 * 1024.0);
+  out << "simulating the loading of a " << megabytes << "MB mesh with " << loadedVertexCount << " vertices and " << loadedIndexCount << " indices" << std::endl;
+  out << "mapped: " << megabytes / (mappedTime.count() / 1e6) << "MB/s"
+    << " read into the heap: " << megabytes / (readTime.count() / 1e6) << "MB/s"
+    << " (the file was just written, so it is likely in the page cache)" << std::endl;
+}
+
+// ============================================================================
+
+void simulateVertexEncoding(unsigned int vertexCount, std::ostream& out)
+{
+  // the positions are in the normalized device coordinates like the vertices of the sandbox.
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> positionDistribution(-1.f, 1.f);
+  std::uniform_real_distribution<float> colorDistribution(0.f, 1.f);
+  std::vector<Vertex> vertices(vertexCount);
+  for (auto& vertex : vertices) {
+    vertex.position = { positionDistribution(random), positionDistribution(random), positionDistribution(random) };
+    vertex.color = { colorDistribution(random), colorDistribution(random), colorDistribution(random), colorDistribution(random) };
+  }
+
+  // the first vertices hold the edge cases of the conversions: the range limits, signed zeros, rounding ties, values which
+  // are clamped and values which are subnormal, rounded to the largest half or overflow in the half format. their amount
+  // is odd, so encoding them alone also runs the tail of the kernels which encode several vertices at once.
+  static const float SPECIAL_VALUES[] = { -1.f, 1.f, 0.f, -0.f, 0.5f, 1.5f, -1.5f, 1e-6f, 6.1e-5f, 2.98023224e-8f, 65519.f, 65520.f, -1e9f };
+  static const auto SPECIAL_COUNT = sizeof(SPECIAL_VALUES) / sizeof(SPECIAL_VALUES[0]);
+  for (size_t i = 0; i < SPECIAL_COUNT && i < vertices.size(); i++) {
+    auto value = SPECIAL_VALUES[i];
+    auto next = SPECIAL_VALUES[(i + 1) % SPECIAL_COUNT];
+    vertices[i].position = { value, -value, next };
+    vertices[i].color = { value, next, -value, 0.5f };
+  }
+
+  out << "simulating the encoding of " << vertexCount << " vertices (" << getSimdLevelName(getSupportedSimdLevel()) << " supported)" << std::endl;
+  std::vector<Vertex> decoded(vertexCount);
+  for (auto name : { "float", "half", "quantized" }) {
+    VertexLayout layout;
+    parseVertexLayout(name, layout);
+    auto stride = getVertexStride(layout);
+    std::vector<uint8_t> packed(static_cast<size_t>(vertexCount) * stride);
+    std::vector<uint8_t> reference;
+    std::vector<uint8_t> specialReference(SPECIAL_COUNT * stride);
+
+    // measure the best of a few runs to leave out the page faults of the first run. the kernels must produce exactly the
+    // output of the scalar kernel, as the inputs have no NaNs whose payloads could differ.
+    out << name << ": " << stride << " bytes per vertex (" << static_cast<float>(sizeof(Vertex)) / stride << "x smaller)";
+    for (auto level : { SimdLevel::SCALAR, SimdLevel::SSE41, SimdLevel::AVX2 }) {
+      if (level > getSupportedSimdLevel()) {
+        continue;
+      }
+      auto bestTime = nanoseconds::max();
+      for (auto run = 0; run < 5; run++) {
+        auto start = steady_clock::now();
+        encodeVertices(vertices.data(), vertices.size(), layout, packed.data(), level);
+        bestTime = std::min(bestTime, duration_cast<nanoseconds>(steady_clock::now() - start));
+      }
+      out << " " << getSimdLevelName(level) << ": " << vertexCount / (bestTime.count() / 1e3) << "M vertices/s";
+
+      std::vector<uint8_t> special(SPECIAL_COUNT * stride);
+      encodeVertices(vertices.data(), std::min<size_t>(SPECIAL_COUNT, vertexCount), layout, special.data(), level);
+      if (level == SimdLevel::SCALAR) {
+        reference = packed;
+        specialReference = special;
+      } else if (packed != reference || special != specialReference) {
+        throw new std::runtime_error("Vertex encoding kernel does not match the scalar kernel");
+      }
+    }
+    out << std::endl;
+
+    // measure the largest error of the decoded attributes, which must stay within half of a unit in the last place of
+    // each format: zero for the floats, 2^-12 for the halves within [-1, 1], 1/65534 for SNORM16 and 1/510 for UNORM8.
+    decodeVertices(packed.data(), vertexCount, layout, decoded.data());
+    auto positionError = 0.f;
+    auto colorError = 0.f;
+    for (auto i = static_cast<unsigned int>(std::min<size_t>(SPECIAL_COUNT, vertexCount)); i < vertexCount; i++) {
+      for (auto j = 0; j < 3; j++) {
+        positionError = std::max(positionError, std::abs(decoded[i].position[j] - vertices[i].position[j]));
+      }
+      for (auto j = 0; j < 4; j++) {
+        colorError = std::max(colorError, std::abs(decoded[i].color[j] - vertices[i].color[j]));
+      }
+    }
+    out << "  max error of the positions: " << positionError << " colors: " << colorError << std::endl;
+
+    // the quantized bounds have a slack of a float epsilon for the rounding of the scaling in the encoding and decoding.
+    auto slack = std::numeric_limits<float>::epsilon();
+    auto maxPositionError = layout.position == PositionFormat::FLOAT3 ? 0.f : layout.position == PositionFormat::HALF4 ? 1.f / 4096 : 0.5f / 32767 + slack;
+    auto maxColorError = layout.color == ColorFormat::FLOAT4 ? 0.f : 0.5f / 255 + slack;
+    if (positionError > maxPositionError || colorError > maxColorError) {
+      throw new std::runtime_error("Vertex decoding error exceeds the precision of the format");
+    }
+  }
+}
+
+// ============================================================================
+
+void simulateMeshOptimizer(unsigned int latticeSize, std::ostream& out)
+{
+  static const auto RINGS = 16u;
+  static const auto SEGMENTS = 32u;
+  static const auto RADIUS = 0.4f;
+  static const auto OVERDRAW_THRESHOLD = 1.05f;
+
+  // build a lattice of spheres, which occlude each other from every side, with outward facing triangles.
+  std::vector<Vertex> vertices;
+  std::vector<uint32_t> indices;
+  for (auto sphere = 0u; sphere < latticeSize * latticeSize * latticeSize; sphere++) {
+    float center[3] = { static_cast<float>(sphere % latticeSize), static_cast<float>(sphere / latticeSize % latticeSize),
+      static_cast<float>(sphere / latticeSize / latticeSize) };
+    auto addTriangle = [&](uint32_t a, uint32_t b, uint32_t c) {
+      auto& p0 = vertices[a].position;
+      auto& p1 = vertices[b].position;
+      auto& p2 = vertices[c].position;
+      float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+      float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+      auto facing = (e1[1] * e2[2] - e1[2] * e2[1]) * (p0[0] - center[0]) + (e1[2] * e2[0] - e1[0] * e2[2]) * (p0[1] - center[1])
+        + (e1[0] * e2[1] - e1[1] * e2[0]) * (p0[2] - center[2]);
+      indices.insert(indices.end(), { a, facing >= 0.f ? b : c, facing >= 0.f ? c : b });
+    };
+    auto first = static_cast<uint32_t>(vertices.size());
+    for (auto ring = 0u; ring <= RINGS; ring++) {
+      auto theta = 3.14159265f * ring / RINGS;
+      for (auto segment = 0u; segment <= SEGMENTS; segment++) {
+        auto phi = 2.f * 3.14159265f * segment / SEGMENTS;
+        vertices.push_back({ { center[0] + RADIUS * std::sin(theta) * std::cos(phi), center[1] + RADIUS * std::cos(theta),
+          center[2] + RADIUS * std::sin(theta) * std::sin(phi) }, { 1.f, 1.f, 1.f, 1.f } });
+      }
+    }
+    // the quads next to the poles have a degenerate half, which is skipped.
+    for (auto ring = 0u; ring < RINGS; ring++) {
+      for (auto segment = 0u; segment < SEGMENTS; segment++) {
+        auto corner = first + ring * (SEGMENTS + 1) + segment;
+        if (ring > 0) {
+          addTriangle(corner, corner + 1, corner + SEGMENTS + 1);
+        }
+        if (ring + 1 < RINGS) {
+          addTriangle(corner + 1, corner + SEGMENTS + 2, corner + SEGMENTS + 1);
+        }
+      }
+    }
+  }
+
+  // shuffle the triangles and the vertices like an exporter without any optimization.
+  std::mt19937 random(1);
+  auto triangleCount = indices.size() / 3;
+  std::vector<uint32_t> triangleOrder(triangleCount);
+  for (size_t i = 0; i < triangleCount; i++) {
+    triangleOrder[i] = static_cast<uint32_t>(i);
+  }
+  std::shuffle(triangleOrder.begin(), triangleOrder.end(), random);
+  std::vector<uint32_t> vertexOrder(vertices.size());
+  for (size_t i = 0; i < vertices.size(); i++) {
+    vertexOrder[i] = static_cast<uint32_t>(i);
+  }
+  std::shuffle(vertexOrder.begin(), vertexOrder.end(), random);
+  std::vector<Vertex> shuffledVertices(vertices.size());
+  for (size_t i = 0; i < vertices.size(); i++) {
+    shuffledVertices[vertexOrder[i]] = vertices[i];
+  }
+  std::vector<uint32_t> shuffledIndices;
+  for (auto triangle : triangleOrder) {
+    for (auto corner = 0u; corner < 3; corner++) {
+      shuffledIndices.push_back(vertexOrder[indices[triangle * 3 + corner]]);
+    }
+  }
+
+  // each step must keep the triangles with their winding, i.e. the same set of triangles after rotating their corners.
+  auto getTriangles = [](const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices) {
+    std::vector<std::array<float, 9>> triangles(indices.size() / 3);
+    for (size_t i = 0; i < triangles.size(); i++) {
+      auto first = 0u;
+      for (auto corner = 1u; corner < 3; corner++) {
+        if (vertices[indices[i * 3 + corner]].position < vertices[indices[i * 3 + first]].position) {
+          first = corner;
+        }
+      }
+      for (auto corner = 0u; corner < 3; corner++) {
+        auto& position = vertices[indices[i * 3 + (first + corner) % 3]].position;
+        std::copy(position.begin(), position.end(), triangles[i].begin() + corner * 3);
+      }
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+  };
+  auto inputTriangles = getTriangles(shuffledIndices, shuffledVertices);
+
+  out << "simulating the optimization of " << latticeSize * latticeSize * latticeSize << " spheres with " << triangleCount
+    << " triangles and " << vertices.size() << " vertices:" << std::endl;
+  auto report = [&](const char* step, const std::vector<uint32_t>& indices, const std::vector<Vertex>& vertices, nanoseconds time) {
+    auto cacheStats = analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+    auto overfetch = analyzeVertexFetch(indices.data(), indices.size(), vertices.size(), sizeof(Vertex));
+    auto overdraw = analyzeOverdraw(indices.data(), indices.size(), vertices[0].position.data(), vertices.size(), sizeof(Vertex));
+    out << "  " << step << ": ACMR " << cacheStats.acmr << ", ATVR " << cacheStats.atvr << ", overfetch " << overfetch << ", overdraw " << overdraw;
+    if (time.count() > 0) {
+      out << " (" << time.count() / 1e6 << "ms, " << triangleCount * 1e3 / time.count() << "M triangles/s)";
+    }
+    out << std::endl;
+    if (getTriangles(indices, vertices) != inputTriangles) {
+      throw new std::runtime_error("Mesh optimizer changed the triangles");
+    }
+    struct Stats { double acmr; double overfetch; double overdraw; };
+    Stats stats = { cacheStats.acmr, overfetch, overdraw };
+    return stats;
+  };
+  auto input = report("input", shuffledIndices, shuffledVertices, nanoseconds::zero());
+
+  std::vector<uint32_t> cacheIndices(shuffledIndices.size());
+  auto start = steady_clock::now();
+  optimizeVertexCache(cacheIndices.data(), shuffledIndices.data(), shuffledIndices.size(), shuffledVertices.size());
+  auto cache = report("vertex cache", cacheIndices, shuffledVertices, duration_cast<nanoseconds>(steady_clock::now() - start));
+
+  std::vector<uint32_t> overdrawIndices(cacheIndices.size());
+  start = steady_clock::now();
+  optimizeOverdraw(overdrawIndices.data(), cacheIndices.data(), cacheIndices.size(), shuffledVertices[0].position.data(), shuffledVertices.size(), sizeof(Vertex), OVERDRAW_THRESHOLD);
+  auto overdraw = report("overdraw", overdrawIndices, shuffledVertices, duration_cast<nanoseconds>(steady_clock::now() - start));
+
+  std::vector<Vertex> fetchVertices(shuffledVertices.size());
+  auto fetchIndices = overdrawIndices;
+  start = steady_clock::now();
+  auto fetchVertexCount = optimizeVertexFetch(fetchVertices.data(), fetchIndices.data(), fetchIndices.size(), shuffledVertices.data(), shuffledVertices.size(), sizeof(Vertex));
+  auto fetchTime = duration_cast<nanoseconds>(steady_clock::now() - start);
+  fetchVertices.resize(fetchVertexCount);
+  auto fetch = report("vertex fetch", fetchIndices, fetchVertices, fetchTime);
+
+  // each step must improve its own metric, and the overdraw step may give up only a bit of the cache efficiency.
+  if (cache.acmr >= input.acmr * 0.5 || overdraw.overdraw >= cache.overdraw || overdraw.acmr > cache.acmr * OVERDRAW_THRESHOLD
+    || fetch.overfetch >= overdraw.overfetch || fetch.acmr != overdraw.acmr) {
+    throw new std::runtime_error("Mesh optimizer did not improve the mesh");
+  }
+}
+
+// ============================================================================
+
+void simulateDrawQueue(unsigned int drawCount, std::ostream& out)
+{
+  // the draws are instances of a fixed set of object types, each with its own pass, pipeline state, material and mesh.
+  static const auto OBJECT_TYPE_COUNT = 2048u;
+  std::mt19937 random(1);
+  std::uniform_int_distribution<unsigned int> passDistribution(0, 2);
+  std::uniform_int_distribution<unsigned int> pipelineDistribution(0, 31);
+  std::uniform_int_distribution<unsigned int> materialDistribution(0, 511);
+  std::uniform_int_distribution<unsigned int> meshDistribution(0, 255);
+  std::uniform_int_distribution<unsigned int> objectTypeDistribution(0, OBJECT_TYPE_COUNT - 1);
+  std::uniform_real_distribution<float> depthDistribution(0.1f, 1000.f);
+  std::vector<uint64_t> objectTypes;
+  for (auto i = 0u; i < OBJECT_TYPE_COUNT; i++) {
+    objectTypes.push_back(makeDrawKey(passDistribution(random), pipelineDistribution(random), materialDistribution(random), meshDistribution(random), 0.f));
+  }
+  std::vector<uint64_t> keys;
+  for (auto i = 0u; i < drawCount; i++) {
+    keys.push_back(objectTypes[objectTypeDistribution(random)] | makeDrawKey(0, 0, 0, 0, depthDistribution(random)));
+  }
+
+  // measure the best of a few runs of pushing, sorting and batching the draws.
+  DrawQueue drawQueue;
+  auto bestTime = nanoseconds::max();
+  for (auto run = 0; run < 5; run++) {
+    auto start = steady_clock::now();
+    drawQueue.clear();
+    for (auto i = 0u; i < drawCount; i++) {
+      drawQueue.push(keys[i], i);
+    }
+    drawQueue.sort();
+    bestTime = std::min(bestTime, duration_cast<nanoseconds>(steady_clock::now() - start));
+  }
+
+  // compare against a comparison sort of the same items.
+  std::vector<DrawItem> items;
+  for (auto i = 0u; i < drawCount; i++) {
+    items.push_back({ keys[i], i });
+  }
+  auto start = steady_clock::now();
+  std::stable_sort(items.begin(), items.end(), [](const DrawItem& a, const DrawItem& b) { return a.key < b.key; });
+  auto comparisonTime = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+  // count the state changes needed by the batches, which would be one per draw without the sorting.
+  auto pipelineChanges = 0u;
+  auto materialChanges = 0u;
+  auto meshChanges = 0u;
+  auto previous = ~0ull;
+  for (auto& batch : drawQueue.getBatches()) {
+    pipelineChanges += previous == ~0ull || getDrawKeyPipeline(batch.key) != getDrawKeyPipeline(previous) ? 1 : 0;
+    materialChanges += previous == ~0ull || getDrawKeyMaterial(batch.key) != getDrawKeyMaterial(previous) ? 1 : 0;
+    meshChanges += previous == ~0ull || getDrawKeyMesh(batch.key) != getDrawKeyMesh(previous) ? 1 : 0;
+    previous = batch.key;
+  }
+
+  out << "simulating the sorting of " << drawCount << " draws of " << OBJECT_TYPE_COUNT << " object types" << std::endl;
+  out << "radix sort and batching: " << bestTime.count() / 1e6 << "ms (" << static_cast<double>(bestTime.count()) / drawCount << "ns per draw)"
+    << " std::stable_sort: " << comparisonTime.count() / 1e6 << "ms" << std::endl;
+  out << "instanced draws: " << drawQueue.getBatches().size()
+    << " pipeline changes: " << pipelineChanges
+    << " material changes: " << materialChanges
+    << " mesh changes: " << meshChanges << std::endl;
+}
+
+// ============================================================================
+
+void simulateFrustumCulling(unsigned int objectCount, std::ostream& out)
+{
+  // scatter the objects around a camera at the origin which looks along the z-axis.
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> positionDistribution(-500.f, 500.f);
+  std::uniform_real_distribution<float> sizeDistribution(0.5f, 5.f);
+  FrustumCuller culler;
+  for (auto i = 0u; i < objectCount; i++) {
+    auto x = positionDistribution(random);
+    auto y = positionDistribution(random);
+    auto z = positionDistribution(random);
+    culler.addBox(x, y, z, sizeDistribution(random), sizeDistribution(random), sizeDistribution(random));
+  }
+
+  // build a left-handed perspective projection with a vertical field of view of 60 degrees.
+  auto nearZ = 0.1f;
+  auto farZ = 1000.f;
+  auto scaleY = 1.f / std::tan(3.14159265f / 6.f);
+  auto scaleX = scaleY * 9.f / 16.f;
+  float projection[16] = {
+    scaleX, 0.f, 0.f, 0.f,
+    0.f, scaleY, 0.f, 0.f,
+    0.f, 0.f, farZ / (farZ - nearZ), -nearZ * farZ / (farZ - nearZ),
+    0.f, 0.f, 1.f, 0.f
+  };
+  auto frustum = makeFrustum(projection);
+
+  JobSystem jobSystem;
+  out << "simulating the culling of " << objectCount << " objects (" << getSimdLevelName(getSupportedSimdLevel()) << " supported, "
+    << jobSystem.getWorkerCount() << " threads)" << std::endl;
+  for (auto type : { BoundsType::SPHERE, BoundsType::BOX }) {
+    // the scalar kernel on a single thread is the reference for the others.
+    culler.cull(frustum, type, nullptr, SimdLevel::SCALAR);
+    std::vector<uint32_t> reference(culler.getVisibleIndices(), culler.getVisibleIndices() + culler.getVisibleCount());
+
+    out << (type == BoundsType::SPHERE ? "spheres" : "boxes") << ": " << reference.size() << " visible";
+    for (auto threaded : { false, true }) {
+      for (auto level : { SimdLevel::SCALAR, SimdLevel::SSE41, SimdLevel::AVX2 }) {
+        if (level > getSupportedSimdLevel()) {
+          continue;
+        }
+
+        // measure the best of a few runs to leave out the page faults of the first run.
+        auto bestTime = nanoseconds::max();
+        for (auto run = 0; run < 5; run++) {
+          auto start = steady_clock::now();
+          culler.cull(frustum, type, threaded ? &jobSystem : nullptr, level);
+          bestTime = std::min(bestTime, duration_cast<nanoseconds>(steady_clock::now() - start));
+        }
+        if (culler.getVisibleCount() != reference.size() || !std::equal(reference.begin(), reference.end(), culler.getVisibleIndices())) {
+          throw new std::runtime_error("Culling kernel does not match the scalar reference");
+        }
+        out << " " << getSimdLevelName(level) << (threaded ? " threaded: " : ": ") << bestTime.count() / 1e6 << "ms";
+      }
+    }
+    out << std::endl;
+  }
+}
+
+// ============================================================================
+
+void simulateSoftwareRasterizer(unsigned int width, unsigned int height, unsigned int triangleCount, std::ostream& out)
+{
+  // scatter small triangles with both windings over the screen and a few large ones which need to be clipped.
+  std::mt19937 random(1);
+  std::uniform_real_distribution<float> centerDistribution(-1.1f, 1.1f);
+  std::uniform_real_distribution<float> offsetDistribution(-0.03f, 0.03f);
+  std::uniform_real_distribution<float> largeDistribution(-20.f, 20.f);
+  std::uniform_real_distribution<float> depthDistribution(-0.1f, 1.1f);
+  std::uniform_real_distribution<float> colorDistribution(0.f, 1.f);
+  std::vector<Vertex> vertices(triangleCount * 3);
+  for (auto i = 0u; i < triangleCount; i++) {
+    auto large = i % 10000 == 0;
+    auto centerX = centerDistribution(random);
+    auto centerY = centerDistribution(random);
+    for (auto j = 0u; j < 3; j++) {
+      auto& vertex = vertices[i * 3 + j];
+      vertex.position[0] = large ? largeDistribution(random) : centerX + offsetDistribution(random);
+      vertex.position[1] = large ? largeDistribution(random) : centerY + offsetDistribution(random);
+      vertex.position[2] = depthDistribution(random);
+      vertex.color = { colorDistribution(random), colorDistribution(random), colorDistribution(random), 1.f };
+    }
+  }
+  VertexLayout layout;
+  parseVertexLayout("float", layout);
+  std::vector<uint8_t> packedVertices(vertices.size() * getVertexStride(layout));
+  encodeVertices(vertices.data(), vertices.size(), layout, packedVertices.data());
+
+  // record the same operations as the application.
+  SoftwareImage image(width, height);
+  SoftwareCommandList commandList;
+  float clearColor[] = { 0.5f, 0.5f, 0.5f, 0.5f };
+  commandList.setViewport({ 0.f, 0.f, static_cast<float>(width), static_cast<float>(height) });
+  commandList.setScissorRect({ 0, 0, INT32_MAX, INT32_MAX });
+  commandList.setRasterizerState(CullMode::BACK, false);
+  commandList.setRenderTarget(&image);
+  commandList.clearRenderTarget(&image, clearColor);
+  commandList.setVertexBuffer(packedVertices.data(), static_cast<uint32_t>(vertices.size()), layout);
+  commandList.drawInstanced(static_cast<uint32_t>(vertices.size()), 1, 0, 0);
+
+  JobSystem jobSystem;
+  out << "simulating the software rasterization of " << triangleCount << " triangles at " << width << "x" << height
+    << " (" << getSimdLevelName(getSupportedSimdLevel()) << " supported, " << jobSystem.getWorkerCount() << " threads)" << std::endl;
+  auto referenceHash = 0ull;
+  for (auto threaded : { false, true }) {
+    for (auto level : { SimdLevel::SCALAR, SimdLevel::SSE41, SimdLevel::AVX2 }) {
+      if (level > getSupportedSimdLevel()) {
+        continue;
+      }
+
+      // measure the best of a few frames.
+      SoftwareDevice device(threaded ? &jobSystem : nullptr, level);
+      auto commandQueue = device.createCommandQueue(CommandListType::DIRECT);
+      CommandList* commandLists[] = { &commandList };
+      auto bestTime = nanoseconds::max();
+      auto runCount = 3u;
+      for (auto run = 0u; run < runCount; run++) {
+        auto start = steady_clock::now();
+        commandQueue->executeCommandLists(1, commandLists);
+        bestTime = std::min(bestTime, duration_cast<nanoseconds>(steady_clock::now() - start));
+      }
+
+      // all kernels and thread counts have to produce exactly the same image.
+      if (referenceHash == 0) {
+        referenceHash = image.getHash();
+      } else if (image.getHash() != referenceHash) {
+        throw new std::runtime_error("Software rasterizer kernels produced different images");
+      }
+      auto drawnCount = static_cast<SoftwareCommandQueue*>(commandQueue.get())->getTriangleCount() / runCount;
+      out << getSimdLevelName(level) << (threaded ? " threaded: " : ": ") << bestTime.count() / 1e6 << "ms ("
+        << triangleCount / (bestTime.count() / 1e3) << "M triangles/s, " << drawnCount << " drawn after culling and clipping)" << std::endl;
+    }
+  }
+  out << "image hash: " << std::hex << referenceHash << std::dec << std::endl;
+}
+
+// ============================================================================
+
+void renderSoftwareFrame(const std::vector<Vertex>& vertices, const VertexLayout& layout, unsigned int instanceCount, unsigned int width, unsigned int height, const std::string& path, std::ostream& out)
+{
+  std::vector<uint8_t> packedVertices(vertices.size() * getVertexStride(layout));
+  encodeVertices(vertices.data(), vertices.size(), layout, packedVertices.data());
+
+  // record the frame like the application does with the same clear color and rasterizer state.
+  JobSystem jobSystem;
+  SoftwareDevice device(&jobSystem);
+  auto commandQueue = device.createCommandQueue(CommandListType::DIRECT);
+  SoftwareImage image(width, height);
+  SoftwareCommandList commandList;
+  float clearColor[] = { 0.5f, 0.5f, 0.5f, 0.5f };
+  commandList.setViewport({ 0.f, 0.f, static_cast<float>(width), static_cast<float>(height) });
+  commandList.setScissorRect({ 0, 0, INT32_MAX, INT32_MAX });
+  commandList.setRasterizerState(CullMode::BACK, false);
+  commandList.setRenderTarget(&image);
+  commandList.clearRenderTarget(&image, clearColor);
+  commandList.setVertexBuffer(packedVertices.data(), static_cast<uint32_t>(vertices.size()), layout);
+  commandList.drawInstanced(static_cast<uint32_t>(vertices.size()), instanceCount, 0, 0);
+
+  auto start = steady_clock::now();
+  CommandList* commandLists[] = { &commandList };
+  commandQueue->executeCommandLists(1, commandLists);
+  auto time = duration_cast<microseconds>(steady_clock::now() - start);
+  if (!image.write(path)) {
+    throw new std::runtime_error("Failed to write the rendered image");
+  }
+  out << "rendered " << path << " (" << width << "x" << height << ") in " << time.count() / 1e3 << "ms, image hash: " << std::hex << image.getHash() << std::dec << std::endl;
+}
+
+// ============================================================================
+
+void simulateFrameAllocations(unsigned int drawCount, unsigned int drawsPerCommandList, unsigned int framesInFlight, std::ostream& out)
+{
+  NullDevice device;
+  auto commandQueue = device.createCommandQueue(CommandListType::DIRECT);
+  auto fence = device.createFence();
+  NullSwapChain swapChain(framesInFlight + 1, microseconds::zero());
+  FrameScheduler frameScheduler(framesInFlight);
+  uint64_t fenceValue = 0u;
+  FenceTimeline frameTimeline(*commandQueue, *fence, fenceValue);
+  JobSystem jobSystem;
+
+  // the arenas start small on purpose, so the first frames overflow into the heap and grow them.
+  std::vector<std::vector<LinearArena>> frameArenas(framesInFlight);
+  for (auto& workerArenas : frameArenas) {
+    for (auto worker = 0u; worker < jobSystem.getWorkerCount(); worker++) {
+      workerArenas.emplace_back(1024);
+    }
+  }
+
+  // the draws are culled against the clip space and half of them lies outside of it.
+  static const float CLIP_SPACE[16] = { 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f };
+  auto clipFrustum = makeFrustum(CLIP_SPACE);
+  FrustumCuller culler;
+  for (auto draw = 0u; draw < drawCount; draw++) {
+    culler.addBox(draw % 2 == 0 ? 0.f : 4.f, 0.f, 0.f, 0.5f, 0.5f, 0.f);
+  }
+  DrawQueue drawQueue;
+
+  // the resources are only compared by their addresses.
+  std::vector<int> backBuffers(swapChain.getBufferCount());
+  int sceneTarget;
+  int rootSignature;
+  ResourceStateRegistry resourceStates;
+  for (auto& backBuffer : backBuffers) {
+    resourceStates.setState(&backBuffer, RESOURCE_STATE_PRESENT);
+  }
+  resourceStates.setState(&sceneTarget, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+  // the clear list, the draw lists, the upscale list and the end list, and the lists of the barrier fixups, which are
+  // recorded into command streams and replayed into the null command lists.
+  auto drawCommandListCount = (drawCount + drawsPerCommandList - 1) / drawsPerCommandList;
+  auto commandListCount = drawCommandListCount + 3;
+  std::vector<CommandRecorder> recorders(commandListCount + drawCommandListCount + 1);
+  std::vector<NullCommandList> commandLists(recorders.size(), NullCommandList(microseconds::zero()));
+  std::vector<ResourceStateTracker> resourceStateTrackers(drawCommandListCount);
+  BarrierList barriers;
+  std::vector<uint8_t> uploadMemory(64 * 1024);
+  UploadRing uploadRing(uploadMemory.size(), uploadMemory.data());
+  static const float TRIANGLE[] = { 0.f, 0.5f, 0.f, 0.5f, -0.5f, 0.f, -0.5f, -0.5f, 0.f };
+
+  // each frame in flight keeps an entry in the timeline and its memory in the upload ring until the GPU completes it,
+  // so their bookkeeping is reserved for all of them, however far the GPU falls behind.
+  frameTimeline.reserve(framesInFlight);
+  uploadRing.reserveFrames(framesInFlight);
+
+  // record the frame like the application does: the draws are culled and sorted, the passes of an arena-backed
+  // render graph record the lists, the draw lists are recorded in parallel by the jobs and their states are
+  // resolved at the submission. the callbacks are passed by reference, so the std::functions do not allocate.
+  auto recordFrame = [&](unsigned int frameIndex, unsigned int bufferIndex, std::vector<CommandList*>& submission) {
+    auto& workerArenas = frameArenas[frameIndex];
+    for (auto& arena : workerArenas) {
+      arena.reset();
+    }
+    frameTimeline.poll();
+
+    UploadAllocation vertexAllocation;
+    if (!uploadRing.allocate(sizeof(TRIANGLE), sizeof(float), vertexAllocation)) {
+      throw new std::runtime_error("Upload ring is full");
+    }
+    memcpy(vertexAllocation.cpuAddress, TRIANGLE, sizeof(TRIANGLE));
+
+    auto visibleCount = culler.cull(clipFrustum, BoundsType::BOX, &jobSystem);
+    drawQueue.clear();
+    auto visibleIndices = culler.getVisibleIndices();
+    for (auto i = 0u; i < visibleCount; i++) {
+      drawQueue.push(makeDrawKey(0, 0, 0, 0, 0.f), visibleIndices[i]);
+    }
+    drawQueue.sort();
+    auto& batches = drawQueue.getBatches();
+
+    auto submit = [&](unsigned int index) {
+      replayCommandStream(recorders[index].getData(), recorders[index].getSize(), commandLists[index]);
+      submission.push_back(&commandLists[index]);
+    };
+    auto fixupCount = 0u;
+    auto submitBarriers = [&](const BarrierList& barriers) {
+      auto index = commandListCount + fixupCount++;
+      recorders[index].reset();
+      recorders[index].resourceBarrier(barriers);
+      submit(index);
+    };
+
+    auto backBuffer = &backBuffers[bufferIndex];
+    RenderGraph frameGraph(workerArenas[jobSystem.getWorkerIndex()]);
+    auto backBufferResource = frameGraph.importResource("back buffer", RESOURCE_STATE_PRESENT, RESOURCE_STATE_PRESENT);
+    frameGraph.setResourceHandle(backBufferResource, backBuffer);
+    auto sceneResource = frameGraph.importResource("scene", RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraph.setResourceHandle(sceneResource, &sceneTarget);
+
+    auto recordClear = [&](const RenderGraph::PassContext& context) {
+      PROFILE_SCOPE("record begin commands");
+      static const float CLEAR_COLOR[] = { 0.f, 0.f, 0.f, 1.f };
+      auto& recorder = recorders[0];
+      recorder.reset();
+      recorder.resourceBarrier(context.barriers);
+      recorder.clearRenderTarget(1, CLEAR_COLOR);
+      submit(0);
+    };
+    auto clearPass = frameGraph.addPass("clear", std::ref(recordClear));
+    frameGraph.write(clearPass, sceneResource, RESOURCE_STATE_RENDER_TARGET);
+
+    auto recordDraws = [&](unsigned int begin, unsigned int end) {
+      BarrierList drawBarriers(workerArenas[jobSystem.getWorkerIndex()]);
+      for (auto i = begin; i < end; i++) {
+        PROFILE_SCOPE("record draw commands");
+        auto& recorder = recorders[1 + i];
+        recorder.reset();
+        auto& resourceStateTracker = resourceStateTrackers[i];
+        resourceStateTracker.reset();
+        resourceStateTracker.transition(&sceneTarget, RESOURCE_STATE_RENDER_TARGET);
+        drawBarriers.clear();
+        resourceStateTracker.flush(drawBarriers);
+        recorder.resourceBarrier(drawBarriers);
+        recorder.setRootSignature(&rootSignature);
+        recorder.setRenderTarget(1);
+        recorder.setPrimitiveTopology(PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+        recorder.setVertexBuffer(0, { vertexAllocation.gpuAddress, static_cast<uint32_t>(sizeof(TRIANGLE)), 3 * sizeof(float) });
+        auto first = i * batches.size() / drawCommandListCount;
+        auto last = (i + 1) * batches.size() / drawCommandListCount;
+        for (auto batch = first; batch < last; batch++) {
+          recorder.drawInstanced(3, batches[batch].instanceCount, 0, batches[batch].firstInstance);
+        }
+      }
+    };
+    auto submitDraws = [&](const RenderGraph::PassContext& context) {
+      if (!context.barriers.empty()) {
+        submitBarriers(context.barriers);
+      }
+      jobSystem.parallelFor(drawCommandListCount, 1, std::ref(recordDraws));
+      PROFILE_SCOPE("resolve resource states");
+      for (auto i = 0u; i < drawCommandListCount; i++) {
+        barriers.clear();
+        resourceStateTrackers[i].resolve(resourceStates, barriers);
+        if (!barriers.empty()) {
+          submitBarriers(barriers);
+        }
+        submit(1 + i);
+      }
+    };
+    auto drawPass = frameGraph.addPass("draw", std::ref(submitDraws));
+    frameGraph.write(drawPass, sceneResource, RESOURCE_STATE_RENDER_TARGET);
+
+    auto recordUpscale = [&](const RenderGraph::PassContext& context) {
+      PROFILE_SCOPE("record upscale commands");
+      auto index = drawCommandListCount + 1;
+      auto& recorder = recorders[index];
+      recorder.reset();
+      recorder.resourceBarrier(context.barriers);
+      recorder.setRenderTarget(2);
+      recorder.drawInstanced(3, 1, 0, 0);
+      submit(index);
+    };
+    auto upscalePass = frameGraph.addPass("upscale", std::ref(recordUpscale));
+    frameGraph.read(upscalePass, sceneResource, RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    frameGraph.write(upscalePass, backBufferResource, RESOURCE_STATE_RENDER_TARGET);
+
+    frameGraph.compile();
+    BarrierList finalBarriers(workerArenas[jobSystem.getWorkerIndex()]);
+    frameGraph.execute(&resourceStates, finalBarriers);
+    auto index = drawCommandListCount + 2;
+    recorders[index].reset();
+    recorders[index].resourceBarrier(finalBarriers);
+    submit(index);
+  };
+
+  // release the upload memory of the frame through the fence timeline, like the application does.
+  auto endFrame = [&](uint64_t frameFenceValue) {
+    uploadRing.finishFrame(frameFenceValue);
+    frameTimeline.onCompleted(frameFenceValue, [&uploadRing, frameFenceValue] { uploadRing.reclaim(frameFenceValue); });
+  };
+
+  // warm the arenas, pools, containers and queues up before the measured frames.
+  static const auto WARMUP_FRAME_COUNT = 10u;
+  static const auto FRAME_COUNT = 200u;
+  auto frame = 0u;
+  runFrameLoop(*commandQueue, *fence, fenceValue, swapChain, frameScheduler, PresentMode::IMMEDIATE, [&] { return frame++ < WARMUP_FRAME_COUNT; }, recordFrame, endFrame);
+  frame = 0;
+  auto stats = runFrameLoop(*commandQueue, *fence, fenceValue, swapChain, frameScheduler, PresentMode::IMMEDIATE, [&] { return frame++ < FRAME_COUNT; }, recordFrame, endFrame);
+  frameTimeline.flush();
+
+  // the scene target has to rest in the state of the upscaling and the draws must have been recorded.
+  ResourceStates sceneState;
+  if (!resourceStates.getState(&sceneTarget, sceneState) || sceneState != RESOURCE_STATE_PIXEL_SHADER_RESOURCE) {
+    throw new std::runtime_error("Scene target was left in a wrong state");
+  }
+  if (drawQueue.getItemCount() != drawCount / 2 || recorders[1].getCommandCount() == 0) {
+    throw new std::runtime_error("Frame did not record the visible draws");
+  }
+
+  out << "simulating " << FRAME_COUNT << " frames of " << drawCount << " draws in " << drawCommandListCount << " command lists on "
+    << jobSystem.getWorkerCount() << " threads with " << framesInFlight << " frame arenas: "
+    << getAverageFrameHeapAllocations(stats) << " heap allocations per frame (max: " << stats.maxFrameHeapAllocations << "), arena: "
+    << frameArenas[0][0].getCapacity() / 1024 << "KB after " << frameArenas[0][0].getOverflowCount() << " overflows" << std::endl;
+  if (stats.maxFrameHeapAllocations > 0) {
+    throw new std::runtime_error("Frame loop allocates from the heap");
+  }
+}
+
+// ============================================================================
+
+void simulateFramePacing(unsigned int framesInFlight, std::ostream& out)
+{
+  // a 60Hz display and a workload which fits into its refresh interval, except for the occasional GPU spikes.
+  static const auto REFRESH_INTERVAL = microseconds(16667);
+  static const auto FRAME_COUNT = 3000u;
+  std::mt19937 random(1);
+  std::uniform_int_distribution<int> cpuDistribution(3000, 4500);
+  std::uniform_int_distribution<int> gpuDistribution(7000, 9000);
+  std::uniform_int_distribution<int> spikeDistribution(0, 49);
+  std::vector<microseconds> cpuTimes(FRAME_COUNT);
+  std::vector<microseconds> gpuTimes(FRAME_COUNT);
+  for (auto frame = 0u; frame < FRAME_COUNT; frame++) {
+    cpuTimes[frame] = microseconds(cpuDistribution(random));
+    gpuTimes[frame] = microseconds(gpuDistribution(random) + (spikeDistribution(random) == 0 ? 5000 : 0));
+  }
+
+  // the swap chain configurations without and with the pacing. the DXGI default frame latency is 3.
+  struct PacingCase
+  {
+    const char* name;
+    bool vsync;
+    unsigned int bufferCount;
+    unsigned int maxFrameLatency;
+    bool pacing;
+  };
+  static const PacingCase CASES[] = {
+    { "vsync, 3 buffers", true, 3, 3, false },
+    { "vsync, 3 buffers, latency 1", true, 3, 1, false },
+    { "vsync, 3 buffers, latency 1, paced", true, 3, 1, true },
+    { "tearing, 2 buffers", false, 2, 3, false },
+    { "tearing, 2 buffers, paced", false, 2, 3, true }
+  };
+
+  // the results of the configurations in their order.
+  struct PacingResult
+  {
+    microseconds averageLatency;
+    microseconds averageFrameTime;
+    unsigned int repeatedVblanks;
+  };
+  std::vector<PacingResult> results;
+
+  out << "simulating the pacing of " << FRAME_COUNT << " frames (cpu: 3000-4500us, gpu: 7000-9000us with 2% of +5000us, refresh: "
+    << REFRESH_INTERVAL.count() << "us, frames in flight: " << framesInFlight << ")" << std::endl;
+  for (auto& pacingCase : CASES) {
+    // the frames are simulated in discrete time: the CPU records them one after another on a single thread, the GPU
+    // executes them in order and the display shows them at the vertical blanks (or right away with tearing). the
+    // pacer learns the completions at their exact times, where the frame loop polls the fence for them.
+    FramePacer framePacer;
+    if (pacingCase.vsync) {
+      framePacer.setVblankTiming(microseconds::zero(), REFRESH_INTERVAL);
+    }
+    std::vector<microseconds> gpuEndTimes(FRAME_COUNT);
+    std::vector<microseconds> flipTimes(FRAME_COUNT);
+    auto cpuEndTime = microseconds::zero();
+    auto completedFrameCount = 0u;
+    auto totalLatency = microseconds::zero();
+    auto repeatedVblanks = 0u;
+    for (auto frame = 0u; frame < FRAME_COUNT; frame++) {
+      // the frame starts when the CPU is free, its frame slot has been completed and the swap chain accepts it.
+      auto readyTime = cpuEndTime;
+      if (frame >= framesInFlight) {
+        readyTime = std::max(readyTime, gpuEndTimes[frame - framesInFlight]);
+      }
+      if (frame >= pacingCase.maxFrameLatency) {
+        readyTime = std::max(readyTime, flipTimes[frame - pacingCase.maxFrameLatency]);
+      }
+      auto startTime = readyTime;
+      if (pacingCase.pacing) {
+        for (; completedFrameCount < frame && gpuEndTimes[completedFrameCount] <= readyTime; completedFrameCount++) {
+          framePacer.completeFrames(completedFrameCount + 1, gpuEndTimes[completedFrameCount]);
+        }
+        startTime = framePacer.planFrame(readyTime);
+      }
+      cpuEndTime = startTime + cpuTimes[frame];
+      if (pacingCase.pacing) {
+        framePacer.submitFrame(frame + 1, cpuTimes[frame], cpuEndTime);
+      }
+
+      // the GPU renders the frame after the previous one into a back buffer which is no longer shown.
+      auto gpuStartTime = cpuEndTime;
+      if (frame > 0) {
+        gpuStartTime = std::max(gpuStartTime, gpuEndTimes[frame - 1]);
+      }
+      if (frame + 1 >= pacingCase.bufferCount) {
+        gpuStartTime = std::max(gpuStartTime, flipTimes[frame + 1 - pacingCase.bufferCount]);
+      }
+      gpuEndTimes[frame] = gpuStartTime + gpuTimes[frame];
+
+      // show the frame at the first vertical blank after it has been rendered and the previous frame has been shown.
+      auto flipTime = gpuEndTimes[frame];
+      if (frame > 0) {
+        flipTime = std::max(flipTime, flipTimes[frame - 1] + (pacingCase.vsync ? REFRESH_INTERVAL : microseconds::zero()));
+      }
+      if (pacingCase.vsync) {
+        flipTime = REFRESH_INTERVAL * ((flipTime.count() + REFRESH_INTERVAL.count() - 1) / REFRESH_INTERVAL.count());
+        if (frame > 0) {
+          repeatedVblanks += static_cast<unsigned int>((flipTime - flipTimes[frame - 1]) / REFRESH_INTERVAL - 1);
+        }
+      }
+      flipTimes[frame] = flipTime;
+      totalLatency += flipTime - startTime;
+    }
+
+    PacingResult result = {};
+    result.averageLatency = totalLatency / FRAME_COUNT;
+    result.averageFrameTime = (flipTimes.back() - flipTimes.front()) / (FRAME_COUNT - 1);
+    result.repeatedVblanks = repeatedVblanks;
+    results.push_back(result);
+    out << pacingCase.name << ": latency: " << result.averageLatency.count() << "us frame time: " << result.averageFrameTime.count() << "us";
+    if (pacingCase.vsync) {
+      out << " repeated vblanks: " << repeatedVblanks;
+    }
+    if (pacingCase.pacing) {
+      out << " (predicted cpu: " << framePacer.getPredictedCpuTime().count() << "us gpu: " << framePacer.getPredictedGpuTime().count()
+        << "us margin: " << framePacer.getMargin().count() << "us missed: " << framePacer.getMissedFrameCount() << ")";
+    }
+    out << std::endl;
+  }
+
+  // the paced frames must have a lower latency than the unpaced ones of the same swap chain. with v-sync, the delays
+  // must not make any more spikes miss their vertical blanks, and without it a slightly longer frame time is accepted.
+  auto& waitable = results[1];
+  auto& pacedVsync = results[2];
+  auto& tearing = results[3];
+  auto& pacedTearing = results[4];
+  if (pacedVsync.averageLatency >= waitable.averageLatency || pacedVsync.repeatedVblanks > waitable.repeatedVblanks) {
+    throw new std::runtime_error("Frame pacing did not reduce the latency with v-sync");
+  }
+  if (pacedTearing.averageLatency >= tearing.averageLatency || pacedTearing.averageFrameTime > tearing.averageFrameTime * 21 / 20) {
+    throw new std::runtime_error("Frame pacing did not reduce the latency with tearing");
+  }
+}
+
+// ============================================================================
+
+void simulateDescriptorAllocator(unsigned int operationCount, std::ostream& out)
+{
+  static const auto PAGE_SIZE = 256u;
+  static const auto DESCRIPTOR_SIZE = 32u;
+  static const auto MAX_RANGE_SIZE = 64u;
+  static const auto MAX_LIVE_COUNT = 256u;
+
+  // the pages are shader-visible, with distinct ranges of numbers as their CPU and GPU handles.
+  struct Page
+  {
+    uint64_t cpuHandle;
+    unsigned int size;
+    std::vector<bool> used;
+  };
+  std::vector<Page> pages;
+  auto createPage = [&pages](unsigned int count) {
+    auto cpuHandle = 0x100000000ull * (pages.size() + 1);
+    pages.push_back({ cpuHandle, count, std::vector<bool>(count) });
+    return DescriptorPage{ cpuHandle, cpuHandle + 0x80000000ull };
+  };
+
+  // the basic cases: the smaller ranges split the blocks of a single page, the released ranges coalesce into the whole
+  // page again, and new pages are only created when no free block is large enough.
+  {
+    DescriptorAllocator allocator(PAGE_SIZE, DESCRIPTOR_SIZE, createPage);
+    auto first = allocator.allocate(1);
+    auto second = allocator.allocate(100);
+    auto third = allocator.allocate(64);
+    if (allocator.getPageCount() != 1 || first.cpuHandle != pages[0].cpuHandle || second.cpuHandle != pages[0].cpuHandle + 128 * DESCRIPTOR_SIZE ||
+        third.cpuHandle != pages[0].cpuHandle + 64 * DESCRIPTOR_SIZE || allocator.getAllocatedCount() != 193) {
+      throw new std::runtime_error("Descriptor allocator does not split the free blocks of a page");
+    }
+    if (allocator.getGpuHandle(second, 1) != pages[0].cpuHandle + 0x80000000ull + 129 * DESCRIPTOR_SIZE) {
+      throw new std::runtime_error("Descriptor allocator returns the wrong GPU handle");
+    }
+    allocator.free(second);
+    allocator.free(first);
+    allocator.free(third);
+    if (allocator.getFreeBlockCount() != 1 || allocator.getAllocatedCount() != 0) {
+      throw new std::runtime_error("Descriptor allocator does not coalesce the released ranges");
+    }
+    auto whole = allocator.allocate(PAGE_SIZE);
+    auto grown = allocator.allocate(1);
+    auto large = allocator.allocate(PAGE_SIZE + 1);
+    if (whole.cpuHandle != pages[0].cpuHandle || allocator.getPageCount() != 3 || grown.page != 1 || large.page != 2 || pages[2].size != 2 * PAGE_SIZE) {
+      throw new std::runtime_error("Descriptor allocator does not grow by a page when the free blocks are too small");
+    }
+    allocator.free(whole);
+    allocator.free(grown);
+    allocator.free(large);
+    if (allocator.getFreeBlockCount() != 3) {
+      throw new std::runtime_error("Descriptor allocator does not coalesce the released ranges");
+    }
+  }
+
+  // then random ranges are allocated and released, and the live ranges must never overlap.
+  pages.clear();
+  DescriptorAllocator allocator(PAGE_SIZE, DESCRIPTOR_SIZE, createPage);
+  std::vector<DescriptorRange> ranges;
+  std::mt19937 random(1);
+  auto maxAllocatedCount = 0u;
+  auto markRange = [&](const DescriptorRange& range, bool used) {
+    auto& page = pages[range.page];
+    auto offset = static_cast<unsigned int>((range.cpuHandle - page.cpuHandle) / DESCRIPTOR_SIZE);
+    if (range.cpuHandle % DESCRIPTOR_SIZE != 0 || offset + range.count > page.size || range.gpuHandle != range.cpuHandle + 0x80000000ull) {
+      throw new std::runtime_error("Descriptor range is outside of its page");
+    }
+    for (auto i = offset; i < offset + range.count; i++) {
+      if (page.used[i] == used) {
+        throw new std::runtime_error("Descriptor ranges overlap");
+      }
+      page.used[i] = used;
+    }
+  };
+  for (auto operation = 0u; operation < operationCount; operation++) {
+    if (!ranges.empty() && (ranges.size() >= MAX_LIVE_COUNT || random() % 2 == 0)) {
+      auto index = random() % ranges.size();
+      markRange(ranges[index], false);
+      allocator.free(ranges[index]);
+      ranges[index] = ranges.back();
+      ranges.pop_back();
+    } else {
+      ranges.push_back(allocator.allocate(1 + random() % MAX_RANGE_SIZE));
+      markRange(ranges.back(), true);
+    }
+    maxAllocatedCount = std::max(maxAllocatedCount, allocator.getAllocatedCount());
+  }
+  for (auto& range : ranges) {
+    allocator.free(range);
+  }
+  if (allocator.getAllocatedCount() != 0 || allocator.getFreeBlockCount() != allocator.getPageCount()) {
+    throw new std::runtime_error("Descriptor allocator does not coalesce the released ranges");
+  }
+
+  out << "descriptor allocator: " << operationCount << " operations, " << allocator.getPageCount() << " pages of " << PAGE_SIZE
+    << " descriptors for at most " << maxAllocatedCount << " allocated descriptors" << std::endl;
+}
+
+// ============================================================================
+
+void simulateFenceTimeline(unsigned int framesInFlight, std::ostream& out)
+{
+  static const auto FRAME_COUNT = 200u;
+  static const auto RETIRES_PER_FRAME = 64u;
+  NullDevice device;
+  auto commandQueue = device.createCommandQueue(CommandListType::DIRECT);
+  auto fence = device.createFence();
+  NullSwapChain swapChain(framesInFlight + 1, microseconds::zero());
+  NullCommandList commandList(microseconds(1000));
+  FrameScheduler frameScheduler(framesInFlight);
+  uint64_t fenceValue = 0u;
+  FenceTimeline timeline(*commandQueue, *fence, fenceValue);
+
+  // a simulated resource which counts whether it was destroyed before the GPU completed the frame using it.
+  struct RetiredResource
+  {
+    Fence* fence;
+    uint64_t fenceValue;
+    uint64_t* destroyedCount;
+    uint64_t* earlyCount;
+
+    ~RetiredResource()
+    {
+      if (fence->getCompletedValue() < fenceValue) {
+        (*earlyCount)++;
+      }
+      (*destroyedCount)++;
+    }
+  };
+
+  // the descriptor pages are only counted, so their handles are just distinct ranges of numbers.
+  auto nextPageHandle = 0ull;
+  DescriptorAllocator descriptorAllocator(256, 1, [&](unsigned int count) {
+    DescriptorPage page = { nextPageHandle, 0 };
+    nextPageHandle += count;
+    return page;
+  });
+
+  // each frame retires resources, descriptor ranges and callbacks with the value signaled after the frame. each frame
+  // also registers a callback for the next frame first, so the entries of the next frame are inserted before it.
+  uint64_t destroyedCount = 0;
+  uint64_t earlyCount = 0;
+  uint64_t lastCallbackValue = 0;
+  uint64_t callbackCount = 0;
+  auto checkCallback = [&](uint64_t value) {
+    if (value < lastCallbackValue || fence->getCompletedValue() < value) {
+      throw new std::runtime_error("Completion callback invoked out of order or too early");
+    }
+    lastCallbackValue = value;
+    callbackCount++;
+  };
+  size_t maxPendingCount = 0;
+  microseconds pollTime(0);
+  auto frame = 0u;
+  auto stats = runFrameLoop(*commandQueue, *fence, fenceValue, swapChain, frameScheduler, PresentMode::IMMEDIATE,
+    [&] {
+      auto start = steady_clock::now();
+      timeline.poll();
+      pollTime += duration_cast<microseconds>(steady_clock::now() - start);
+      return frame++ < FRAME_COUNT;
+    },
+    [&](unsigned int, unsigned int, std::vector<CommandList*>& commandLists) {
+      auto value = timeline.getNextValue();
+      timeline.onCompleted(value + 1, [&checkCallback, value] { checkCallback(value + 1); });
+      for (auto i = 0u; i < RETIRES_PER_FRAME; i++) {
+        switch (i % 3) {
+          case 0:
+            timeline.release(value, std::unique_ptr<RetiredResource>(new RetiredResource{ fence.get(), value, &destroyedCount, &earlyCount }));
+            break;
+          case 1: {
+            auto range = descriptorAllocator.allocate(1 + i % 4);
+            timeline.onCompleted(value, [&descriptorAllocator, range] { descriptorAllocator.free(range); });
+            break;
+          }
+          default:
+            timeline.onCompleted(value, [&checkCallback, value] { checkCallback(value); });
+            break;
+        }
+      }
+      maxPendingCount = std::max(maxPendingCount, timeline.getPendingCount());
+      commandLists.push_back(&commandList);
+    });
+  timeline.flush();
+
+  if (earlyCount > 0) {
+    throw new std::runtime_error("Resource released before the GPU completed it");
+  }
+  if (timeline.getPendingCount() > 0 || destroyedCount != FRAME_COUNT * ((RETIRES_PER_FRAME + 2) / 3) || descriptorAllocator.getAllocatedCount() > 0) {
+    throw new std::runtime_error("Fence timeline did not retire all entries");
+  }
+  out << "simulating " << FRAME_COUNT << " frames retiring " << RETIRES_PER_FRAME << " entries each through the fence timeline: "
+    << timeline.getRetiredCount() << " retired, " << callbackCount << " callbacks in order, at most " << maxPendingCount << " pending, "
+    << descriptorAllocator.getPageCount() << " descriptor pages, poll: " << pollTime.count() * 1000 / std::max<uint64_t>(timeline.getRetiredCount(), 1) << "ns per entry, "
+    << "frame time: " << getAverageFrameTime(stats).count() << "us" << std::endl;
+}
+
+// ============================================================================
+
+// a sink which executes the commands on a simulated GPU clock, where each clear and draw advances the clock by its
+// cost and the timestamp queries store the clock.
+class TimestampSink : public CommandSink
+{
+public:
+  TimestampSink(unsigned int queryCount, uint64_t* readbackData, uint64_t clearCost, uint64_t drawCost)
+    : mQueries(queryCount), mReadbackData(readbackData), mClearCost(clearCost), mDrawCost(drawCost), mClock(0)
+  {
+  }
+
+  uint64_t getClock() const
+  {
+    return mClock;
+  }
+
+  void setRootSignature(const void*) override {}
+  void setPipelineState(const void*) override {}
+  void setViewport(const CommandViewport&) override {}
+  void setScissorRect(const CommandRect&) override {}
+  void resourceBarrier(unsigned int, const ResourceBarrier*) override {}
+  void setRenderTarget(uint64_t) override {}
+  void setPrimitiveTopology(PrimitiveTopology) override {}
+  void setVertexBuffer(unsigned int, const CommandVertexBufferView&) override {}
+  void setIndexBuffer(const CommandIndexBufferView&) override {}
+  void setDescriptorHeap(const void*) override {}
+  void setRootDescriptorTable(uint32_t, uint64_t) override {}
+
+  void clearRenderTarget(uint64_t, const float[4]) override
+  {
+    mClock += mClearCost;
+  }
+
+  void drawInstanced(uint32_t, uint32_t, uint32_t, uint32_t) override
+  {
+    mClock += mDrawCost;
+  }
+
+  void drawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t) override
+  {
+    mClock += mDrawCost;
+  }
+
+  void endTimestampQuery(const void*, uint32_t index) override
+  {
+    mQueries.at(index) = mClock;
+  }
+
+  void resolveTimestampQueries(const void*, uint32_t firstIndex, uint32_t count, const void*, uint64_t destinationOffset) override
+  {
+    std::copy(mQueries.begin() + firstIndex, mQueries.begin() + firstIndex + count, mReadbackData + destinationOffset / sizeof(uint64_t));
+  }
+
+  using CommandSink::resourceBarrier;
+
+private:
+  std::vector<uint64_t> mQueries;
+  uint64_t* mReadbackData;
+  uint64_t mClearCost;
+  uint64_t mDrawCost;
+  uint64_t mClock;
+};
+
+// ============================================================================
+
+void simulateProfiler(unsigned int scopeCount, std::ostream& out)
+{
+  static const auto MAX_SCOPE_COST = 50.0;
+  static const auto RUN_COUNT = 5u;
+  static const char* EVENT_NAMES[] = { "a", "b", "c", "d" };
+
+  // measure the scopes on a thread of their own, so they fill a ring of their own. the best run is taken, as the runs
+  // are preempted at times.
+  auto bestCost = std::numeric_limits<double>::max();
+  std::thread([&] {
+    for (auto run = 0u; run < RUN_COUNT; run++) {
+      auto start = steady_clock::now();
+      for (auto i = 0u; i < scopeCount; i++) {
+        PROFILE_SCOPE("simulated scope");
+      }
+      auto time = duration_cast<nanoseconds>(steady_clock::now() - start);
+      bestCost = std::min(bestCost, static_cast<double>(time.count()) / scopeCount);
+    }
+  }).join();
+
+  // read a ring while a thread keeps wrapping it around. each event is written with consistent fields, so an event
+  // which was read while it was being overwritten shows up as inconsistent. the writer yields from time to time, so
+  // the reads interleave with the writes even on a single core.
+  ProfileRing ring(0, "simulated");
+  std::atomic<bool> writing(true);
+  std::thread writer([&] {
+    for (uint64_t i = 0; i < ProfileRing::CAPACITY * 64; i++) {
+      ring.push(EVENT_NAMES[i % 4], i, i + 1);
+      if (i % 1024 == 0) {
+        std::this_thread::yield();
+      }
+    }
+    writing = false;
+  });
+  auto readCount = 0u;
+  auto tornCount = 0u;
+  while (writing) {
+    auto events = ring.read();
+    if (events.empty() || events.back().begin < ProfileRing::CAPACITY) {
+      std::this_thread::yield();
+      continue;
+    }
+    for (auto& event : events) {
+      if (event.end != event.begin + 1 || event.name != EVENT_NAMES[event.begin % 4]) {
+        tornCount++;
+      }
+    }
+    readCount++;
+  }
+  writer.join();
+
+  out << "simulating " << scopeCount << " profile scopes: " << bestCost << "ns per scope, " << readCount
+    << " reads of a wrapping ring with " << tornCount << " torn events" << std::endl;
+  if (bestCost > MAX_SCOPE_COST) {
+    throw new std::runtime_error("Profile scopes exceed their cost budget");
+  }
+  if (readCount == 0 || tornCount > 0) {
+    throw new std::runtime_error("Profile ring returned torn events");
+  }
+}
+
+// ============================================================================
+
+void simulateGpuProfiler(unsigned int framesInFlight, std::ostream& out)
+{
+  static const auto FRAME_COUNT = 1000u;
+  static const auto MAX_REGIONS = 4u;
+  // the simulated timestamps tick at 10MHz, where a clear takes 50us and a draw 2us.
+  static const auto GPU_FREQUENCY = 10000000ull;
+  static const auto CLEAR_COST = 500ull;
+  static const auto DRAW_COST = 20ull;
+
+  // the query heap and the readback buffer are only identified by their pointers.
+  int queryHeap;
+  std::vector<uint64_t> readbackData(static_cast<size_t>(GpuProfiler::getReadbackSize(framesInFlight, MAX_REGIONS) / sizeof(uint64_t)));
+  GpuProfiler profiler(framesInFlight, MAX_REGIONS, &queryHeap, readbackData.data(), readbackData.data());
+  TimestampSink gpu(GpuProfiler::getQueryCount(framesInFlight, MAX_REGIONS), readbackData.data(), CLEAR_COST, DRAW_COST);
+  profiler.calibrate(GPU_FREQUENCY, gpu.getClock(), getProfileTimestamp());
+
+  // the frames are recorded into command streams, and the GPU executes each frame only while the following frames are
+  // recorded, so the profiler reads each slot after the GPU has written it and before it is resolved again.
+  std::vector<CommandRecorder> recorders(framesInFlight);
+  std::vector<unsigned int> drawCounts(FRAME_COUNT);
+  auto expectedDropCount = 0ull;
+  nanoseconds recordTime(0);
+  for (auto frame = 0u; frame < FRAME_COUNT + framesInFlight; frame++) {
+    if (frame >= framesInFlight - 1 && frame - (framesInFlight - 1) < FRAME_COUNT) {
+      auto& executed = recorders[(frame - (framesInFlight - 1)) % framesInFlight];
+      replayCommandStream(executed.getData(), executed.getSize(), gpu);
+    }
+    if (frame >= FRAME_COUNT) {
+      continue;
+    }
+
+    // the results of the previous frame of the slot are checked against the simulated costs.
+    auto slot = frame % framesInFlight;
+    auto start = steady_clock::now();
+    profiler.beginFrame(slot);
+    recordTime += duration_cast<nanoseconds>(steady_clock::now() - start);
+    if (frame >= framesInFlight) {
+      auto& regions = profiler.getLastFrameRegions();
+      auto drawCount = drawCounts[frame - framesInFlight];
+      double expected[] = { static_cast<double>(CLEAR_COST + drawCount * DRAW_COST), static_cast<double>(CLEAR_COST), static_cast<double>(drawCount * DRAW_COST) };
+      if (regions.size() != ((frame - framesInFlight) % 10 == 0 ? 4u : 3u)) {
+        throw new std::runtime_error("GPU profiler did not read the regions of the frame");
+      }
+      for (auto i = 0u; i < 3; i++) {
+        auto time = (regions[i].end - regions[i].begin) / getProfileTicksPerMicrosecond();
+        if (std::abs(time - expected[i] * 1e6 / GPU_FREQUENCY) > 1.0) {
+          throw new std::runtime_error("GPU profiler region time does not match the timestamps");
+        }
+      }
+    }
+
+    // record the frame, whose draw count changes every frame. every tenth frame also records an empty region and tries
+    // one more region than the slot holds.
+    auto& recorder = recorders[slot];
+    recorder.reset();
+    drawCounts[frame] = 100 + (frame % 7) * 10;
+    start = steady_clock::now();
+    auto frameRegion = profiler.beginRegion(recorder, "gpu frame");
+    auto clearRegion = profiler.beginRegion(recorder, "gpu clear");
+    float clearColor[] = { 0.f, 0.f, 0.f, 0.f };
+    recorder.clearRenderTarget(0, clearColor);
+    profiler.endRegion(recorder, clearRegion);
+    auto drawRegion = profiler.beginRegion(recorder, "gpu draws");
+    recordTime += duration_cast<nanoseconds>(steady_clock::now() - start);
+    for (auto draw = 0u; draw < drawCounts[frame]; draw++) {
+      recorder.drawInstanced(3, 1, 0, draw);
+    }
+    start = steady_clock::now();
+    profiler.endRegion(recorder, drawRegion);
+    if (frame % 10 == 0) {
+      profiler.endRegion(recorder, profiler.beginRegion(recorder, "gpu empty"));
+      profiler.endRegion(recorder, profiler.beginRegion(recorder, "gpu dropped"));
+      expectedDropCount++;
+    }
+    profiler.endRegion(recorder, frameRegion);
+    profiler.resolve(recorder);
+    recordTime += duration_cast<nanoseconds>(steady_clock::now() - start);
+  }
+
+  auto frameCount = static_cast<uint64_t>(FRAME_COUNT - framesInFlight);
+  if (profiler.getReadCount() < frameCount * 3 || profiler.getDroppedCount() != expectedDropCount) {
+    throw new std::runtime_error("GPU profiler lost or dropped regions");
+  }
+  out << "simulating " << FRAME_COUNT << " frames with " << framesInFlight << " readback slots through the GPU profiler: "
+    << profiler.getReadCount() << " regions read, " << profiler.getDroppedCount() << " dropped, last frame: "
+    << profiler.getLastFrameTime().count() << "us, CPU cost: " << recordTime.count() / FRAME_COUNT << "ns per frame" << std::endl;
+}
+
+// ============================================================================
+
+void simulateDynamicResolution(unsigned int framesInFlight, std::ostream& out)
+{
+  static const auto OUTPUT_WIDTH = 1920u;
+  static const auto OUTPUT_HEIGHT = 1080u;
+  static const auto TARGET_FRAME_TIME = microseconds(16667);
+  static const auto MIN_SCALE = 0.5;
+  static const auto MAX_SCALE = 1.0;
+  // the simulated GPU time of a frame is a fixed cost plus a cost per pixel, which exceeds the target at the output
+  // size, and varies by a few percent from frame to frame.
+  static const auto FIXED_COST = 2000.0;
+  static const auto PIXEL_COST = 20000.0 / (OUTPUT_WIDTH * OUTPUT_HEIGHT);
+  static const auto NOISE = 0.05;
+  // the scene load of the phases and the frames at the beginning of a phase in which the controller may miss the target.
+  static const double PHASE_LOADS[] = { 1.0, 2.0, 1.0, 0.4 };
+  static const auto PHASE_COUNT = sizeof(PHASE_LOADS) / sizeof(PHASE_LOADS[0]);
+  static const auto PHASE_FRAMES = 400u;
+  static const auto SETTLE_FRAMES = 60u;
+
+  // the statistics of a phase after its settling frames.
+  struct PhaseStats
+  {
+    double scaleSum;
+    double timeSum;
+    unsigned int frameCount;
+    unsigned int missCount;
+  };
+
+  // the frame times are measured when the GPU has completed the frames, i.e. as many frames later as are in flight.
+  auto run = [&](ResolutionController* controller, std::vector<PhaseStats>& phases) {
+    std::mt19937 random(1);
+    std::uniform_real_distribution<double> noise(1.0 - NOISE, 1.0 + NOISE);
+    std::deque<microseconds> pendingTimes;
+    phases.assign(PHASE_COUNT, PhaseStats());
+    for (auto frame = 0u; frame < PHASE_COUNT * PHASE_FRAMES; frame++) {
+      auto width = OUTPUT_WIDTH;
+      auto height = OUTPUT_HEIGHT;
+      if (controller) {
+        controller->getRenderSize(OUTPUT_WIDTH, OUTPUT_HEIGHT, width, height);
+      }
+      auto& phase = phases[frame / PHASE_FRAMES];
+      auto time = (FIXED_COST + PIXEL_COST * width * height * PHASE_LOADS[frame / PHASE_FRAMES]) * noise(random);
+      if (frame % PHASE_FRAMES >= SETTLE_FRAMES) {
+        phase.scaleSum += static_cast<double>(width) / OUTPUT_WIDTH;
+        phase.timeSum += time;
+        phase.frameCount++;
+        phase.missCount += time > TARGET_FRAME_TIME.count() ? 1 : 0;
+      }
+      pendingTimes.push_back(microseconds(static_cast<microseconds::rep>(time)));
+      if (pendingTimes.size() > framesInFlight) {
+        if (controller) {
+          controller->addFrameTime(pendingTimes.front());
+        }
+        pendingTimes.pop_front();
+      }
+    }
+  };
+
+  std::vector<PhaseStats> fixedPhases;
+  run(nullptr, fixedPhases);
+  ResolutionController controller(TARGET_FRAME_TIME, MIN_SCALE, MAX_SCALE, framesInFlight);
+  std::vector<PhaseStats> dynamicPhases;
+  nanoseconds controlTime(0);
+  auto start = steady_clock::now();
+  run(&controller, dynamicPhases);
+  controlTime = duration_cast<nanoseconds>(steady_clock::now() - start);
+
+  out << "simulating the dynamic resolution of " << OUTPUT_WIDTH << "x" << OUTPUT_HEIGHT << " at a target of "
+    << TARGET_FRAME_TIME.count() << "us with " << framesInFlight << " frames in flight:" << std::endl;
+  auto fixedMissCount = 0u;
+  auto dynamicMissCount = 0u;
+  auto frameCount = 0u;
+  for (auto i = 0u; i < PHASE_COUNT; i++) {
+    auto& fixed = fixedPhases[i];
+    auto& dynamic = dynamicPhases[i];
+    out << "  load " << PHASE_LOADS[i] << ": fixed " << static_cast<uint64_t>(fixed.timeSum / fixed.frameCount) << "us, "
+      << fixed.missCount << " missed, dynamic " << static_cast<uint64_t>(dynamic.timeSum / dynamic.frameCount) << "us at scale "
+      << dynamic.scaleSum / dynamic.frameCount << ", " << dynamic.missCount << " missed" << std::endl;
+    fixedMissCount += fixed.missCount;
+    dynamicMissCount += dynamic.missCount;
+    frameCount += dynamic.frameCount;
+  }
+  out << "  " << controller.getChangeCount() << " scale changes, " << controlTime.count() / controller.getFrameCount()
+    << "ns per frame" << std::endl;
+
+  // the controller must hold the target after settling, without oscillating, and return to the full resolution when
+  // the load allows it.
+  if (dynamicMissCount * 100 > frameCount || dynamicMissCount >= fixedMissCount) {
+    throw new std::runtime_error("Dynamic resolution did not hold the target frame time");
+  }
+  if (controller.getChangeCount() > PHASE_COUNT * 6) {
+    throw new std::runtime_error("Dynamic resolution oscillated");
+  }
+  if (controller.getScale() != MAX_SCALE || dynamicPhases[1].scaleSum >= dynamicPhases[0].scaleSum) {
+    throw new std::runtime_error("Dynamic resolution did not follow the load");
+  }
+}
+
+// ============================================================================
+
+void simulateResidency(unsigned int framesInFlight, std::ostream& out)
+{
+  static const auto MEGABYTE = 1024ull * 1024;
+  static const auto RESOURCE_COUNT = 512u;
+  static const auto MIN_RESOURCE_SIZE = 4 * MEGABYTE;
+  static const auto MAX_RESOURCE_SIZE = 16 * MEGABYTE;
+  static const auto OTHER_USAGE = 256 * MEGABYTE;
+  // each frame uses a window of the resources which moves on by a few resources every few frames, like a camera which
+  // moves into the next cells of a streamed world.
+  static const auto WORKING_SET = 96u;
+  static const auto STEP_RESOURCES = 12u;
+  static const auto STEP_FRAMES = 12u;
+  // the budget of the phases, where the working set does not fit into the third one.
+  static const uint64_t PHASE_BUDGETS[] = { 3072 * MEGABYTE, 1536 * MEGABYTE, 1024 * MEGABYTE, 3072 * MEGABYTE };
+  static const auto PHASE_COUNT = sizeof(PHASE_BUDGETS) / sizeof(PHASE_BUDGETS[0]);
+  static const auto PHASE_FRAMES = 500u;
+
+  // the statistics of a phase.
+  struct PhaseStats
+  {
+    uint64_t residentSum;
+    uint64_t evictedCount;
+    uint64_t madeResidentCount;
+    uint64_t overBudgetCount;
+  };
+
+  // all resources are created resident up front, which exceeds every budget.
+  NullResidencyBackend backend(PHASE_BUDGETS[0], OTHER_USAGE);
+  ResidencyManager manager(backend);
+  std::mt19937 random(1);
+  std::uniform_int_distribution<uint64_t> sizeDistribution(MIN_RESOURCE_SIZE / (64 * 1024), MAX_RESOURCE_SIZE / (64 * 1024));
+  std::vector<const void*> objects(RESOURCE_COUNT);
+  std::vector<uint64_t> sizes(RESOURCE_COUNT);
+  std::vector<unsigned int> handles(RESOURCE_COUNT);
+  for (auto i = 0u; i < RESOURCE_COUNT; i++) {
+    sizes[i] = sizeDistribution(random) * 64 * 1024;
+    objects[i] = backend.createObject(sizes[i]);
+    handles[i] = manager.add(objects[i], sizes[i]);
+  }
+
+  // the frame with the index f completes with the fence value f + 1, once the following frames are in flight.
+  std::vector<PhaseStats> phases(PHASE_COUNT, PhaseStats());
+  nanoseconds commitTime(0);
+  for (auto frame = 0u; frame < PHASE_COUNT * PHASE_FRAMES; frame++) {
+    auto& phase = phases[frame / PHASE_FRAMES];
+    backend.setBudget(PHASE_BUDGETS[frame / PHASE_FRAMES]);
+    auto evictedCount = manager.getEvictedCount();
+    auto madeResidentCount = manager.getMadeResidentCount();
+    auto overBudgetCount = manager.getOverBudgetCount();
+
+    auto start = steady_clock::now();
+    manager.beginFrame(frame + 1);
+    auto windowStart = frame / STEP_FRAMES * STEP_RESOURCES;
+    for (auto i = 0u; i < WORKING_SET; i++) {
+      manager.use(handles[(windowStart + i) % RESOURCE_COUNT]);
+    }
+    manager.commit(frame + 1 > framesInFlight ? frame + 1 - framesInFlight : 0);
+    commitTime += duration_cast<nanoseconds>(steady_clock::now() - start);
+
+    // every resource of the frames in flight must be resident, and the usage may exceed the budget only when they do
+    // not fit into it.
+    uint64_t inFlightSize = 0;
+    auto firstFrame = frame + 1 > framesInFlight ? frame + 1 - framesInFlight : 0;
+    auto firstStart = firstFrame / STEP_FRAMES * STEP_RESOURCES;
+    for (auto i = 0u; i < windowStart - firstStart + WORKING_SET; i++) {
+      auto resource = (firstStart + i) % RESOURCE_COUNT;
+      if (!backend.isResident(objects[resource])) {
+        throw new std::runtime_error("Residency manager evicted a resource of a frame in flight");
+      }
+      inFlightSize += sizes[resource];
+    }
+    auto budget = backend.queryBudget();
+    if (budget.usage > std::max<uint64_t>(budget.budget, OTHER_USAGE + inFlightSize)) {
+      throw new std::runtime_error("Residency manager exceeded a budget which fits the frames in flight");
+    }
+
+    phase.residentSum += manager.getResidentSize();
+    phase.evictedCount += manager.getEvictedCount() - evictedCount;
+    phase.madeResidentCount += manager.getMadeResidentCount() - madeResidentCount;
+    phase.overBudgetCount += manager.getOverBudgetCount() - overBudgetCount;
+  }
+
+  out << "simulating the residency of " << RESOURCE_COUNT << " resources (" << manager.getTrackedSize() / MEGABYTE << "MB) with a working set of "
+    << WORKING_SET << " and " << framesInFlight << " frames in flight:" << std::endl;
+  for (auto i = 0u; i < PHASE_COUNT; i++) {
+    auto& phase = phases[i];
+    out << "  budget " << PHASE_BUDGETS[i] / MEGABYTE << "MB: " << phase.residentSum / PHASE_FRAMES / MEGABYTE << "MB resident, "
+      << phase.evictedCount << " evicted, " << phase.madeResidentCount << " made resident, " << phase.overBudgetCount
+      << " frames over budget" << std::endl;
+  }
+  auto frameCount = PHASE_COUNT * PHASE_FRAMES;
+  out << "  " << manager.getEvictedCount() << " evicted in " << manager.getEvictCallCount() << " calls, " << manager.getMadeResidentCount()
+    << " made resident in " << manager.getMakeResidentCallCount() << " calls, " << commitTime.count() / frameCount << "ns per frame" << std::endl;
+
+  // the resources are paged in batches, and only the phase whose budget does not fit the working set exceeds it.
+  if (manager.getEvictCallCount() > frameCount || manager.getMakeResidentCallCount() > frameCount
+    || manager.getEvictedCount() <= manager.getEvictCallCount() || manager.getMadeResidentCount() <= manager.getMakeResidentCallCount()) {
+    throw new std::runtime_error("Residency manager did not batch its calls");
+  }
+  if (phases[0].overBudgetCount != 0 || phases[1].overBudgetCount != 0 || phases[2].overBudgetCount == 0 || phases[3].overBudgetCount != 0) {
+    throw new std::runtime_error("Residency manager did not follow the budget");
+  }
+}
+
+// ============================================================================
+
+void simulateUploadRing(unsigned int framesInFlight, std::ostream& out)
+{
+  static const auto RING_SIZE = 64ull * 1024;
+  static const auto FRAME_COUNT = 10000u;
+  static const auto MAX_ALLOCATIONS_PER_FRAME = 16u;
+  static const auto MAX_ALLOCATION_SIZE = 4096u;
+  static const uint64_t ALIGNMENTS[] = { 1, 4, 16, 256 };
+
+  // the basic cases: the padding of an aligned allocation counts as used memory, a full ring refuses the allocations
+  // without changing, and the frames are only reclaimed once their fence values have been completed.
+  {
+    UploadRing ring(1024);
+    UploadAllocation first, second, refused;
+    if (!ring.allocate(10, 1, first) || !ring.allocate(16, 256, second) || first.offset != 0 || second.offset != 256 || ring.getUsedSize() != 272) {
+      throw new std::runtime_error("Upload ring does not pad the aligned allocations");
+    }
+    ring.finishFrame(1);
+    if (!ring.allocate(512, 256, first) || first.offset != 512 || ring.allocate(1, 1, refused) || ring.getUsedSize() != 1024) {
+      throw new std::runtime_error("Upload ring does not refuse the allocations when it is full");
+    }
+    ring.finishFrame(2);
+    ring.reclaim(0);
+    if (ring.getUsedSize() != 1024 || ring.allocate(1, 1, refused)) {
+      throw new std::runtime_error("Upload ring reclaims a frame before its fence value");
+    }
+    ring.reclaim(1);
+    if (ring.getUsedSize() != 752 || !ring.allocate(200, 16, first) || first.offset != 0 || ring.allocate(100, 1, refused)) {
+      throw new std::runtime_error("Upload ring does not wrap around into the reclaimed memory");
+    }
+    ring.finishFrame(3);
+    ring.reclaim(3);
+    if (ring.getUsedSize() != 0) {
+      throw new std::runtime_error("Upload ring does not reclaim all completed frames");
+    }
+  }
+
+  // then a frame loop allocates random sizes with random alignments while the fence completes the frames with a delay,
+  // and waits for the oldest frame in flight whenever the ring is full. the allocations of the frames in flight must
+  // never overlap and must be reclaimed in the order of their fence values.
+  struct Range
+  {
+    uint64_t offset;
+    uint64_t size;
+  };
+  std::deque<std::pair<uint64_t, std::vector<Range>>> frames;
+  std::vector<Range> frameRanges;
+  std::vector<uint8_t> ringMemory(RING_SIZE);
+  UploadRing ring(RING_SIZE, ringMemory.data(), 0x10000000);
+  NullFence fence;
+  uint64_t fenceValue = 0;
+  std::mt19937 random(1);
+  uint64_t allocationCount = 0;
+  uint64_t wrapCount = 0;
+  uint64_t fullCount = 0;
+  uint64_t lastReclaimedValue = 0;
+  uint64_t lastOffset = 0;
+
+  auto overlapsInFlight = [&](const UploadAllocation& allocation) {
+    auto overlaps = [&](const Range& range) {
+      return allocation.offset < range.offset + range.size && range.offset < allocation.offset + allocation.size;
+    };
+    for (auto& frame : frames) {
+      if (std::any_of(frame.second.begin(), frame.second.end(), overlaps)) {
+        return true;
+      }
+    }
+    return std::any_of(frameRanges.begin(), frameRanges.end(), overlaps);
+  };
+  auto reclaim = [&] {
+    auto completedValue = fence.getCompletedValue();
+    ring.reclaim(completedValue);
+    while (!frames.empty() && frames.front().first <= completedValue) {
+      if (frames.front().first < lastReclaimedValue) {
+        throw new std::runtime_error("Upload ring frames reclaimed out of fence order");
+      }
+      lastReclaimedValue = frames.front().first;
+      frames.pop_front();
+    }
+  };
+
+  for (auto frame = 0u; frame < FRAME_COUNT; frame++) {
+    // the GPU completes the frames which are more than the frames in flight behind.
+    if (fenceValue > framesInFlight) {
+      fence.setCompletedValue(std::max(fence.getCompletedValue(), fenceValue - framesInFlight));
+    }
+    reclaim();
+
+    auto count = random() % MAX_ALLOCATIONS_PER_FRAME;
+    for (auto i = 0u; i < count; i++) {
+      auto size = 1 + random() % MAX_ALLOCATION_SIZE;
+      auto alignment = ALIGNMENTS[random() % 4];
+      UploadAllocation allocation;
+      while (!ring.allocate(size, alignment, allocation)) {
+        // wait for the oldest frame in flight, which is the first one to give the ring memory back.
+        if (frames.empty()) {
+          throw new std::runtime_error("Upload ring refuses an allocation which fits into the free ring");
+        }
+        fullCount++;
+        fence.setCompletedValue(frames.front().first);
+        reclaim();
+      }
+      if (allocation.offset % alignment != 0 || allocation.offset + size > RING_SIZE || allocation.gpuAddress != 0x10000000 + allocation.offset ||
+          allocation.cpuAddress != ringMemory.data() + allocation.offset || overlapsInFlight(allocation)) {
+        throw new std::runtime_error("Upload ring allocation overlaps the memory of a frame in flight");
+      }
+      if (allocation.offset < lastOffset) {
+        wrapCount++;
+      }
+      lastOffset = allocation.offset;
+      frameRanges.push_back({ allocation.offset, allocation.size });
+      allocationCount++;
+    }
+
+    fenceValue++;
+    ring.finishFrame(fenceValue);
+    if (!frameRanges.empty()) {
+      frames.emplace_back(fenceValue, std::move(frameRanges));
+      frameRanges.clear();
+    }
+  }
+  fence.setCompletedValue(fenceValue);
+  reclaim();
+  if (ring.getUsedSize() != 0 || !frames.empty()) {
+    throw new std::runtime_error("Upload ring does not reclaim all completed frames");
+  }
+  if (wrapCount == 0 || fullCount == 0) {
+    throw new std::runtime_error("Upload ring simulation never wrapped around or filled the ring");
+  }
+
+  out << "upload ring: " << allocationCount << " allocations in " << FRAME_COUNT << " frames, " << wrapCount << " wrap-arounds, "
+    << fullCount << " waits for a full ring" << std::endl;
+}
+
+// ============================================================================
+
+void simulateUploadQueue(unsigned int framesInFlight, std::ostream& out)
+{
+  static const auto RING_SIZE = 8ull * 1024 * 1024;
+  static const auto CHUNK_SIZE = 1024ull * 1024;
+  static const auto ASSET_SIZE = 2ull * 1024 * 1024;
+  static const auto COMMAND_LIST_COUNT = 4u;
+  // the simulated copy bandwidth, so an asset takes about 10ms to copy.
+  static const auto BYTES_PER_MICROSECOND = 200ull;
+  // an asset is streamed every few frames and drawn a few frames after it was streamed.
+  static const auto STREAM_INTERVAL = 8u;
+  static const auto CONSUME_DELAY = 2u;
+  static const auto FRAME_COUNT = 96u;
+  auto cpuTime = microseconds(2000);
+  auto gpuTime = microseconds(3000);
+
+  std::vector<uint8_t> asset(ASSET_SIZE);
+  std::mt19937 random(1);
+  for (auto& value : asset) {
+    value = static_cast<uint8_t>(random());
+  }
+
+  out << "simulating the streaming of a " << ASSET_SIZE / 1024 << "KB asset every " << STREAM_INTERVAL << " frames (cpu: "
+    << cpuTime.count() << "us, gpu: " << gpuTime.count() << "us, copy: " << ASSET_SIZE / BYTES_PER_MICROSECOND << "us)" << std::endl;
+  microseconds maxFrameTimes[2];
+  for (auto async = 0u; async < 2; async++) {
+    NullDevice device;
+    auto commandQueue = device.createCommandQueue(CommandListType::DIRECT);
+    auto fence = device.createFence();
+    NullSwapChain swapChain(framesInFlight + 1, microseconds::zero());
+    NullCommandList commandList(gpuTime);
+    FrameScheduler frameScheduler(framesInFlight);
+    uint64_t fenceValue = 0u;
+
+    // the synchronous uploads go through the direct queue and wait for the copies on the CPU, like the mesh upload
+    // of the application did before the copy queue.
+    auto copyQueue = device.createCommandQueue(CommandListType::COPY);
+    auto copyFence = device.createFence();
+    uint64_t copyFenceValue = 0u;
+    FenceTimeline copyTimeline(async ? *copyQueue : *commandQueue, *copyFence, copyFenceValue);
+    std::vector<uint8_t> ringMemory(RING_SIZE);
+    UploadRing ring(RING_SIZE, ringMemory.data());
+    NullCopyRecorder recorder(COMMAND_LIST_COUNT, BYTES_PER_MICROSECOND);
+    UploadQueue uploadQueue(copyTimeline, ring, recorder, CHUNK_SIZE);
+
+    // each streamed asset has a destination of its own, which is drawn by a frame a few frames later.
+    struct StreamedAsset
+    {
+      std::vector<uint8_t> destination;
+      UploadTicket ticket;
+      unsigned int consumeFrame;
+      uint64_t consumeFenceValue;
+    };
+    std::vector<StreamedAsset> assets;
+    assets.reserve(FRAME_COUNT / STREAM_INTERVAL + 1);
+
+    auto frame = 0u;
+    auto stats = runFrameLoop(*commandQueue, *fence, fenceValue, swapChain, frameScheduler, PresentMode::IMMEDIATE,
+      [&] { return frame < FRAME_COUNT; },
+      [&](unsigned int, unsigned int, std::vector<CommandList*>& commandLists) {
+        if (frame % STREAM_INTERVAL == 0) {
+          assets.push_back({ std::vector<uint8_t>(ASSET_SIZE), {}, frame + CONSUME_DELAY, 0 });
+          auto& streamed = assets.back();
+          streamed.ticket = uploadQueue.upload(streamed.destination.data(), 0, asset.data(), ASSET_SIZE);
+          if (async) {
+            uploadQueue.submit();
+          } else {
+            uploadQueue.flush();
+          }
+        }
+        for (auto& streamed : assets) {
+          if (streamed.consumeFrame == frame) {
+            uploadQueue.wait(*commandQueue, streamed.ticket);
+          }
+        }
+        busyWait(cpuTime);
+        commandLists.push_back(&commandList);
+      },
+      [&](uint64_t frameFenceValue) {
+        for (auto& streamed : assets) {
+          if (streamed.consumeFrame == frame) {
+            streamed.consumeFenceValue = frameFenceValue;
+          }
+        }
+        frame++;
+
+        // the frames which draw an asset must never be completed before its upload.
+        for (auto& streamed : assets) {
+          if (streamed.consumeFenceValue != 0 && fence->getCompletedValue() >= streamed.consumeFenceValue && !uploadQueue.isComplete(streamed.ticket)) {
+            throw new std::runtime_error("Frame completed before the upload it waits for");
+          }
+        }
+      });
+    flush(*commandQueue, *fence, fenceValue);
+    uploadQueue.flush();
+
+    for (auto& streamed : assets) {
+      if (!uploadQueue.isComplete(streamed.ticket) || streamed.destination != asset) {
+        throw new std::runtime_error("Streamed asset does not match its source");
+      }
+    }
+    maxFrameTimes[async] = stats.maxFrameTime;
+    out << (async ? "copy queue: " : "direct queue with a CPU wait: ")
+      << "frame time: " << getAverageFrameTime(stats).count() << "us"
+      << " (min: " << stats.minFrameTime.count() << "us, max: " << stats.maxFrameTime.count() << "us), "
+      << uploadQueue.getBatchCount() << " batches, " << uploadQueue.getStallCount() << " stalls" << std::endl;
+  }
+  if (maxFrameTimes[1] >= maxFrameTimes[0]) {
+    throw new std::runtime_error("Copy queue does not reduce the frame time spikes of the uploads");
+  }
+}
+
+// ============================================================================
+
+// a simulated pipeline description, which is hashed field by field like hashDXPipelineState does.
+struct SimulatedPipelineDesc
+{
+  const char* vertexShader;
+  const char* pixelShader;
+  unsigned int blendEnable;
+  unsigned int cullMode;
+  float depthBias;
+  const char* semanticNames[2];
+  unsigned int formats[2];
+};
+
+// ============================================================================
+
+static uint64_t hashSimulatedPipeline(const SimulatedPipelineDesc& descriptor)
+{
+  PipelineHasher hasher;
+  hasher.add(hashBytes(descriptor.vertexShader, strlen(descriptor.vertexShader)));
+  hasher.add(hashBytes(descriptor.pixelShader, strlen(descriptor.pixelShader)));
+  hasher.add(descriptor.blendEnable).add(descriptor.cullMode).add(descriptor.depthBias);
+  for (auto i = 0u; i < 2; i++) {
+    hasher.addString(descriptor.semanticNames[i]).add(descriptor.formats[i]);
+  }
+  return hasher.get();
+}
+
+// ============================================================================
+
+void simulatePipelineLibrary(unsigned int entryCount, std::ostream& out)
+{
+  static const auto DEVICE_ID = 0x10de000100000001ull;
+
+  // the hash is a persistent key, so it must match the reference FNV-1a values and the values of known descriptions.
+  if (hashBytes("", 0) != 0xcbf29ce484222325ull || hashBytes("a", 1) != 0xaf63dc4c8601ec8cull || hashBytes("foobar", 6) != 0x85944171f73967e8ull) {
+    throw new std::runtime_error("Pipeline hash does not match the reference FNV-1a values");
+  }
+  SimulatedPipelineDesc descriptor = { "vs_main", "ps_main", 0, 3, 0.f, { "POSITION", "COLOR" }, { 6, 2 } };
+  SimulatedPipelineDesc biased = descriptor;
+  biased.depthBias = 1.f;
+  SimulatedPipelineDesc renamed = descriptor;
+  renamed.semanticNames[0] = "POSITIONC";
+  renamed.semanticNames[1] = "OLOR";
+  if (hashSimulatedPipeline(descriptor) != 0x1232e2c11b4f7246ull || hashSimulatedPipeline(biased) != 0xdfd73448074b0125ull ||
+      hashSimulatedPipeline(renamed) == hashSimulatedPipeline(descriptor)) {
+    throw new std::runtime_error("Pipeline hash of a known description has changed");
+  }
+
+  // store blobs of random sizes.
+  std::mt19937 random(1);
+  PipelineLibrary library(DEVICE_ID);
+  for (auto i = 0u; i < entryCount; i++) {
+    std::vector<uint8_t> blob(random() % 4096);
+    for (auto& value : blob) {
+      value = static_cast<uint8_t>(random());
+    }
+    library.store(PipelineHasher().add(i).get(), blob.data(), blob.size());
+  }
+
+  // a stream without room for the library, like a full disk, must fail the save and keep the library dirty.
+  struct FullStreamBuffer : std::streambuf {
+    int_type overflow(int_type) override { return traits_type::eof(); }
+  } fullBuffer;
+  std::ostream fullStream(&fullBuffer);
+  auto saved = true;
+  try {
+    library.save(fullStream);
+  } catch (std::runtime_error* error) {
+    delete error;
+    saved = false;
+  }
+  if (saved || !library.isDirty()) {
+    throw new std::runtime_error("Pipeline library reports a save into a full stream as successful");
+  }
+
+  // write the library.
+  std::ostringstream stream;
+  library.save(stream);
+  auto data = stream.str();
+  if (library.isDirty()) {
+    throw new std::runtime_error("Pipeline library is dirty after saving");
+  }
+
+  // the library read back must have the same blobs.
+  auto load = [](PipelineLibrary& loaded, const std::string& data) {
+    std::istringstream stream(data);
+    return loaded.load(stream);
+  };
+  PipelineLibrary loaded(DEVICE_ID);
+  if (!load(loaded, data) || loaded.getEntryCount() != entryCount || loaded.isDirty()) {
+    throw new std::runtime_error("Pipeline library does not survive a save and load round trip");
+  }
+  for (auto i = 0u; i < entryCount; i++) {
+    auto hash = PipelineHasher().add(i).get();
+    if (loaded.find(hash) == nullptr || *loaded.find(hash) != *library.find(hash)) {
+      throw new std::runtime_error("Pipeline library does not survive a save and load round trip");
+    }
+  }
+
+  // every truncation, a wrong magic and a library of another device must be rejected without keeping any blob.
+  auto rejectedCount = 0u;
+  auto checkRejected = [&](PipelineLibrary& rejecting, const std::string& data, const char* message) {
+    if (load(rejecting, data) || rejecting.getEntryCount() != 0) {
+      throw new std::runtime_error(message);
+    }
+    rejectedCount++;
+  };
+  for (size_t size = 0; size < data.size(); size += 1 + size / 64) {
+    checkRejected(loaded, data.substr(0, size), "Pipeline library accepts a truncated file");
+  }
+  auto wrongMagic = data;
+  wrongMagic[0] ^= 1;
+  checkRejected(loaded, wrongMagic, "Pipeline library accepts a file with a wrong magic");
+  auto wrongVersion = data;
+  wrongVersion[4] ^= 1;
+  checkRejected(loaded, wrongVersion, "Pipeline library accepts a file of another version");
+  PipelineLibrary otherDevice(DEVICE_ID + 1);
+  checkRejected(otherDevice, data, "Pipeline library accepts a file of another device");
+
+  out << "pipeline library: " << entryCount << " blobs (" << data.size() / 1024 << "KB) saved and loaded, "
+    << rejectedCount << " invalid files rejected" << std::endl;
+}
+
+// ============================================================================
+
+void simulateShaderCache(unsigned int shaderCount, std::ostream& out)
+{
+  static const auto ARCHIVE_FILE = "simulated-shader-cache.bin";
+
+  // the shaders differ by their sources, entry points and defines, and the stub compiler derives the bytecode from the
+  // key of the shader, so a blob returned for the wrong shader is detected.
+  std::vector<std::string> sources;
+  std::vector<ShaderDesc> descs;
+  for (auto i = 0u; i < shaderCount; i++) {
+    sources.push_back("float4 main() : SV_TARGET { return " + std::to_string(i % 7) + "; }");
+  }
+  for (auto i = 0u; i < shaderCount; i++) {
+    ShaderDesc desc = { sources[i].c_str(), sources[i].size(), i % 2 ? "vs_main" : "ps_main", i % 2 ? "vs_5_0" : "ps_5_0", {}, 0 };
+    desc.defines.push_back({ "VARIANT", std::to_string(i) });
+    descs.push_back(desc);
+  }
+  auto compileCount = 0u;
+  auto compile = [&compileCount](const ShaderDesc& desc) {
+    compileCount++;
+    auto key = getShaderKey(desc);
+    std::vector<uint8_t> bytecode(1 + key % 1000);
+    for (size_t i = 0; i < bytecode.size(); i++) {
+      bytecode[i] = static_cast<uint8_t>(key >> (i % 8 * 8));
+    }
+    return bytecode;
+  };
+  auto getAll = [&](ShaderCache& cache) {
+    for (auto& desc : descs) {
+      auto blob = cache.getShader(desc);
+      auto expected = compile(desc);
+      compileCount--;
+      if (blob.size != expected.size() || memcmp(blob.data, expected.data(), blob.size) != 0) {
+        throw new std::runtime_error("Shader cache returns the bytecode of another shader");
+      }
+    }
+  };
+  auto checkCounts = [&](ShaderCache& cache, unsigned int hitCount, unsigned int missCount, const char* message) {
+    if (cache.getHitCount() != hitCount || cache.getMissCount() != missCount || compileCount != missCount) {
+      throw new std::runtime_error(message);
+    }
+  };
+
+  // a cache without an archive compiles every shader once and then finds the compiled ones.
+  std::remove(ARCHIVE_FILE);
+  {
+    ShaderCache cache(ARCHIVE_FILE, compile);
+    getAll(cache);
+    getAll(cache);
+    checkCounts(cache, shaderCount, shaderCount, "Shader cache does not count the compiled shaders as misses and then as hits");
+    if (!cache.isDirty()) {
+      throw new std::runtime_error("Shader cache is not dirty after compiling");
+    }
+    cache.save();
+    if (cache.isDirty()) {
+      throw new std::runtime_error("Shader cache is dirty after saving");
+    }
+
+    // the saved shaders are found from the mapped archive, and a shader with other defines is still compiled.
+    getAll(cache);
+    auto variant = descs[0];
+    variant.defines[0].value = "other";
+    cache.getShader(variant);
+    checkCounts(cache, 2 * shaderCount, shaderCount + 1, "Shader cache does not find the saved shaders from the archive");
+    cache.save();
+  }
+
+  // a new cache maps the saved archive and compiles nothing.
+  {
+    compileCount = 0;
+    ShaderCache cache(ARCHIVE_FILE, compile);
+    getAll(cache);
+    checkCounts(cache, shaderCount, 0, "Shader cache does not find the shaders of a saved archive");
+  }
+
+  // a corrupt or truncated archive is ignored and the shaders are compiled again.
+  std::string archive;
+  {
+    std::ifstream stream(ARCHIVE_FILE, std::ios::binary);
+    archive.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+  }
+  std::vector<std::string> invalidArchives;
+  for (auto size : { size_t(0), size_t(8), size_t(24), size_t(40), archive.size() / 2, archive.size() - 1 }) {
+    invalidArchives.push_back(archive.substr(0, size));
+  }
+  auto wrongMagic = archive;
+  wrongMagic[0] ^= 1;
+  invalidArchives.push_back(wrongMagic);
+  auto wrongOffset = archive;
+  wrongOffset[16 + 8 + 7] = 0x7f;
+  invalidArchives.push_back(wrongOffset);
+  for (auto& invalidArchive : invalidArchives) {
+    {
+      std::ofstream stream(ARCHIVE_FILE, std::ios::binary);
+      stream.write(invalidArchive.data(), invalidArchive.size());
+    }
+    compileCount = 0;
+    ShaderCache cache(ARCHIVE_FILE, compile);
+    getAll(cache);
+    checkCounts(cache, 0, shaderCount, "Shader cache does not compile the shaders of an invalid archive");
+  }
+  std::remove(ARCHIVE_FILE);
+
+  out << "shader cache: " << shaderCount << " shaders compiled, saved and found from the archive (" << archive.size() / 1024 << "KB), "
+    << invalidArchives.size() << " invalid archives ignored" << std::endl;
+}
+
+// ============================================================================
+
+void simulateCommandStream(unsigned int drawCount, unsigned int drawsPerCommandList, std::ostream& out)
+{
+  // the objects are only identified by their addresses, so any distinct addresses will do.
+  int rootSignature, backBuffer;
+  uint64_t rtvDescriptor = 0x1000;
+  uint64_t vertexBufferAddress = 0x100000;
+  CommandViewport viewport = { 0.f, 0.f, 1920.f, 1080.f, 0.f, 1.f };
+  CommandRect scissorRect = { 0, 0, INT32_MAX, INT32_MAX };
+  ResourceBarrier toRenderTarget = { &backBuffer, RESOURCE_STATE_PRESENT, RESOURCE_STATE_RENDER_TARGET, BarrierSplit::NONE };
+  ResourceBarrier toPresent = { &backBuffer, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_PRESENT, BarrierSplit::NONE };
+
+  // record the lists of a frame like the application does, but with a separate draw (and a new mesh every 16 draws) for each object.
+  auto listCount = (drawCount + drawsPerCommandList - 1) / drawsPerCommandList;
+  std::vector<CommandRecorder> recorders(listCount + 2);
+  auto recordFrame = [&] {
+    for (auto& recorder : recorders) {
+      recorder.reset();
+    }
+    float clearColor[] = { 0.5f, 0.5f, 0.5f, 0.5f };
+    recorders.front().resourceBarrier(1, &toRenderTarget);
+    recorders.front().clearRenderTarget(rtvDescriptor, clearColor);
+    for (auto list = 0u; list < listCount; list++) {
+      auto& recorder = recorders[1 + list];
+      recorder.setRootSignature(&rootSignature);
+      recorder.setViewport(viewport);
+      recorder.setScissorRect(scissorRect);
+      recorder.setRenderTarget(rtvDescriptor);
+      recorder.setPrimitiveTopology(PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+      auto last = std::min(drawCount, (list + 1) * drawsPerCommandList);
+      for (auto draw = list * drawsPerCommandList; draw < last; draw++) {
+        if (draw % 16 == 0) {
+          recorder.setVertexBuffer(0, { vertexBufferAddress + (draw / 16) * 4096, 4096, 16 });
+        }
+        recorder.drawInstanced(3 * (1 + draw % 4), 1, 0, draw);
+      }
+    }
+    recorders.back().resourceBarrier(1, &toPresent);
+  };
+
+  // the first frame grows the stream buffers, the following ones must reuse them.
+  recordFrame();
+  std::vector<const uint8_t*> buffers;
+  for (auto& recorder : recorders) {
+    buffers.push_back(recorder.getData());
+  }
+  static const auto RUN_COUNT = 100;
+  auto start = steady_clock::now();
+  for (auto run = 0; run < RUN_COUNT; run++) {
+    recordFrame();
+  }
+  auto recordTime = duration_cast<nanoseconds>(steady_clock::now() - start) / RUN_COUNT;
+  CommandCapture capture;
+  auto commandCount = 0u;
+  for (auto i = 0u; i < recorders.size(); i++) {
+    if (recorders[i].getData() != buffers[i]) {
+      throw new std::runtime_error("Command recorder reallocated its stream for the same frame");
+    }
+    capture.addStream(recorders[i]);
+    commandCount += recorders[i].getCommandCount();
+  }
+
+  // re-encoding the replayed commands must reproduce the streams byte by byte.
+  CommandRecorder reencoded;
+  for (auto i = 0u; i < capture.getStreamCount(); i++) {
+    reencoded.reset();
+    replayCommandStream(capture.getStreamData(i), capture.getStreamSize(i), reencoded);
+    if (reencoded.getSize() != capture.getStreamSize(i) || !std::equal(capture.getStreamData(i), capture.getStreamData(i) + capture.getStreamSize(i), reencoded.getData())) {
+      throw new std::runtime_error("Replayed command stream does not match the recorded stream");
+    }
+  }
+
+  // the capture must be read back from its file, and a file whose data is truncated or whose last stream ends far past
+  // the end of the file must be rejected without allocating the data.
+  {
+    static const auto CAPTURE_FILE = "simulated-capture.bin";
+    capture.write(CAPTURE_FILE);
+    std::string contents;
+    {
+      std::ifstream stream(CAPTURE_FILE, std::ios::binary);
+      contents.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
+    CommandCapture readCapture;
+    if (!readCapture.read(CAPTURE_FILE) || readCapture.getStreamCount() != capture.getStreamCount() || readCapture.getSize() != capture.getSize()) {
+      throw new std::runtime_error("Command capture does not survive a write and read round trip");
+    }
+    auto corruptEnd = contents;
+    uint64_t hugeEnd = 1ull << 50;
+    memcpy(&corruptEnd[3 * sizeof(uint32_t) + (capture.getStreamCount() - 1) * sizeof(uint64_t)], &hugeEnd, sizeof(hugeEnd));
+    for (auto& invalid : { contents.substr(0, contents.size() - 1), corruptEnd }) {
+      {
+        std::ofstream stream(CAPTURE_FILE, std::ios::binary);
+        stream.write(invalid.data(), invalid.size());
+      }
+      if (readCapture.read(CAPTURE_FILE) || readCapture.getStreamCount() != 0) {
+        throw new std::runtime_error("Command capture accepts a truncated or corrupt file");
+      }
+    }
+    std::remove(CAPTURE_FILE);
+  }
+
+  // measure the replay into the null backend without and with the timing of each command.
+  NullCommandList commandList(microseconds(0));
+  start = steady_clock::now();
+  for (auto run = 0; run < RUN_COUNT; run++) {
+    capture.replay(commandList);
+  }
+  auto replayTime = duration_cast<nanoseconds>(steady_clock::now() - start) / RUN_COUNT;
+  CommandReplayStats stats = {};
+  capture.replay(commandList, &stats);
+
+  out << "simulating the command streams of " << drawCount << " draws in " << recorders.size() << " command lists: "
+    << commandCount << " commands, " << capture.getSize() << " bytes (" << static_cast<double>(capture.getSize()) / commandCount << " bytes per command), "
+    << "record: " << recordTime.count() / commandCount << "ns per command, replay: " << replayTime.count() / commandCount << "ns per command" << std::endl;
+  printCommandReplayStats(stats, out);
+}
+
+// ============================================================================
+
+bool replayCommandCapture(const std::string& path, unsigned int replayCount, std::ostream& out)
+{
+  CommandCapture capture;
+  if (!capture.read(path)) {
+    out << "failed to read the command capture: " << path << std::endl;
+    return false;
+  }
+
+  // the captured handles are only valid in the capturing process, so the null backend is the only sink that can take them.
+  NullCommandList commandList(microseconds(0));
+  CommandReplayStats stats = {};
+  auto start = steady_clock::now();
+  for (auto i = 0u; i < replayCount; i++) {
+    capture.replay(commandList, &stats);
+  }
+  auto time = duration_cast<microseconds>(steady_clock::now() - start);
+  out << "replayed " << path << " (" << capture.getStreamCount() << " command lists, " << capture.getSize() << " bytes) "
+    << replayCount << " times in " << time.count() / 1e3 << "ms" << std::endl;
+  printCommandReplayStats(stats, out);
+  return true;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "VertexFormat.h"
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// Headless simulations that measure the frame loop and recording throughput.
+//
+// The simulations run against the null backend, so they can be executed on
+// machines without a GPU (or even without Windows) to compare different
+// scheduling strategies in isolation.
+// ============================================================================
+
+// measure the average frame time with one up to the given maximum amount of frames in flight.
+void simulateFrameLoops(unsigned int bufferCount, unsigned int maxFramesInFlight, std::ostream& out);
+
+// measure how the parallel recording of the given amount of draws scales from one up to the given amount of threads.
+void simulateParallelRecording(unsigned int drawCount, unsigned int drawsPerCommandList, unsigned int maxThreadCount, std::chrono::microseconds drawTime, std::ostream& out);
+
+// run a task graph which mirrors the application initialization with simulated task costs and report its critical path.
+void simulateInitGraph(unsigned int threadCount, std::ostream& out);
+
+// verify the merging, dropping and split barrier rules of the resource state tracker, then measure the CPU cost of tracking
+// random transitions of the given amount of resources and report the emitted barriers.
+void simulateResourceStateTracking(unsigned int resourceCount, unsigned int transitionCount, std::ostream& out);
+
+// build and compile a render graph of a deferred frame with the given resolution and report its barriers and transient memory.
+void simulateRenderGraph(unsigned int width, unsigned int height, unsigned int compileCount, std::ostream& out);
+
+// write a grid mesh with the given amount of vertices into a mesh file and measure how fast it streams through an upload ring.
+// also verify that meshes without indices are written and converted without an index stream.
+void simulateMeshLoading(unsigned int vertexCount, std::ostream& out);
+
+// measure the throughput of the vertex encoding kernels and the accuracy of the packed vertex layouts, and verify that the
+// kernels match the scalar kernel bit for bit and that the errors stay within the precision of each format.
+void simulateVertexEncoding(unsigned int vertexCount, std::ostream& out);
+
+// optimize a shuffled mesh of a lattice of spheres for the vertex cache, the overdraw and the vertex fetch, report the
+// speed of each step and the ACMR, ATVR, overfetch and overdraw after it, and verify that the steps keep the triangles.
+void simulateMeshOptimizer(unsigned int latticeSize, std::ostream& out);
+
+// measure the sorting and batching of the given amount of random draws and report the state changes left after it.
+void simulateDrawQueue(unsigned int drawCount, std::ostream& out);
+
+// measure the culling of the given amount of random objects against a perspective frustum with each of the kernels and threads.
+void simulateFrustumCulling(unsigned int objectCount, std::ostream& out);
+
+// render random triangles with the software backend using each of the kernels and threads and compare the images.
+void simulateSoftwareRasterizer(unsigned int width, unsigned int height, unsigned int triangleCount, std::ostream& out);
+
+// render the frame of the application (a clear and the instanced draw of the vertices) with the software backend,
+// write it into a TGA file and report the hash of the image.
+void renderSoftwareFrame(const std::vector<Vertex>& vertices, const VertexLayout& layout, unsigned int instanceCount, unsigned int width, unsigned int height, const std::string& path, std::ostream& out);
+
+// run a frame loop on the null backend which records the frame like the application does (culling, sorting, a render
+// graph in the frame arenas, parallel recording into command streams and the reclamation of the uploads), and verify
+// that the frames stop allocating from the heap after warming up.
+void simulateFrameAllocations(unsigned int drawCount, unsigned int drawsPerCommandList, unsigned int framesInFlight, std::ostream& out);
+
+// simulate the latency and the frame rate of a jittery workload with v-sync and tearing, with the default and the minimal
+// frame latency of the swap chain and with the frame pacer, and verify that the pacer reduces the latency.
+void simulateFramePacing(unsigned int framesInFlight, std::ostream& out);
+
+// allocate and release random descriptor ranges from shader-visible pages, and verify that the ranges never overlap, that
+// the free blocks are split and coalesced and that the allocator only grows by a page when no free block is large enough.
+void simulateDescriptorAllocator(unsigned int operationCount, std::ostream& out);
+
+// run a frame loop on the null backend whose frames retire resources, descriptor ranges and callbacks through a fence
+// timeline, and verify that they are retired in order, never before the GPU has completed them and all by the end.
+void simulateFenceTimeline(unsigned int framesInFlight, std::ostream& out);
+
+// measure the cost of a profile scope against its budget and read a profile ring while another thread wraps it around,
+// and verify that no event is returned while it is being overwritten.
+void simulateProfiler(unsigned int scopeCount, std::ostream& out);
+
+// profile the regions of frames with synthetic GPU timestamps through the readback slots of the GPU profiler and verify
+// that the converted region times match the timestamps.
+void simulateGpuProfiler(unsigned int framesInFlight, std::ostream& out);
+
+// control the render resolution of a simulated workload whose GPU time depends on its pixels and whose load changes
+// between phases, and verify that the controller holds the target frame time without oscillating.
+void simulateDynamicResolution(unsigned int framesInFlight, std::ostream& out);
+
+// keep a sliding working set of resources within a simulated memory budget which drops between phases, and verify that
+// the residency manager never evicts a resource of a frame in flight and exceeds the budget only when those do not fit.
+void simulateResidency(unsigned int framesInFlight, std::ostream& out);
+
+// allocate random sizes and alignments from an upload ring in a frame loop whose fence completes the frames with a delay,
+// and verify the padding, the wrap-around, the refusal of a full ring and that the frames are reclaimed in fence order.
+void simulateUploadRing(unsigned int framesInFlight, std::ostream& out);
+
+// stream an asset every few frames of a frame loop on the null backend through an upload queue, once synchronously on the
+// direct queue and once on a copy queue, verify the uploaded data and that the copy queue reduces the frame time spikes.
+void simulateUploadQueue(unsigned int framesInFlight, std::ostream& out);
+
+// verify the pipeline hash against reference values, save and load a pipeline library of the given amount of random
+// blobs and verify that truncated files, files with a wrong magic and files of another device are rejected.
+void simulatePipelineLibrary(unsigned int entryCount, std::ostream& out);
+
+// get the given amount of shaders through a shader cache with a stub compiler, save and map the archive again, and verify
+// the hit and miss counts, the returned bytecode and that corrupt and truncated archives fall back to compiling.
+void simulateShaderCache(unsigned int shaderCount, std::ostream& out);
+
+// record a frame of the given amount of draws into command streams like the application does, verify that the streams
+// replay into identical streams, that the capture file is read back and rejected when it is truncated or corrupt, and
+// measure the cost of the recording and the replay.
+void simulateCommandStream(unsigned int drawCount, unsigned int drawsPerCommandList, std::ostream& out);
+
+// replay a captured frame the given amount of times against the null backend and report the cost of each command type.
+// the capture stores the native pointers, descriptor handles and GPU addresses of the capturing process, which no other
+// backend can resolve, so the replay is limited to the null backend. returns false if the capture cannot be read.
+bool replayCommandCapture(const std::string& path, unsigned int replayCount, std::ostream& out);
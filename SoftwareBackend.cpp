@@ -0,0 +1,820 @@
+#include "SoftwareBackend.h"
+#include "JobSystem.h"
+#include "NullBackend.h"
+#include "PipelineCache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+// ============================================================================
+
+// the maximum amount of vertices in a triangle clipped by the six clipping planes.
+static const auto MAX_CLIP_VERTICES = 9;
+
+// ============================================================================
+
+// a triangle prepared for the pixels of a single tile, where the values are relative to the first pixel.
+struct TileSpan
+{
+  // the edge functions, which are non-negative for the covered pixels.
+  int32_t edge[3];
+  int32_t edgeStepX[3];
+  int32_t edgeStepY[3];
+  float color[4];
+  float colorStepX[4];
+  float colorStepY[4];
+  int width;
+  int height;
+};
+
+// ============================================================================
+
+static uint32_t toUnorm8(float value)
+{
+  // clamp like the SSE max and min, which also maps NaN to zero.
+  value = value > 0.f ? value : 0.f;
+  value = value < 1.f ? value : 1.f;
+  return static_cast<uint32_t>(static_cast<int32_t>(value * 255.f + 0.5f));
+}
+
+// ============================================================================
+
+static uint32_t packColor(const float color[4])
+{
+  return toUnorm8(color[0]) | (toUnorm8(color[1]) << 8) | (toUnorm8(color[2]) << 16) | (toUnorm8(color[3]) << 24);
+}
+
+// ============================================================================
+
+static void getRowStart(const TileSpan& span, int y, int32_t edge[3], float color[4])
+{
+  for (auto i = 0; i < 3; i++) {
+    edge[i] = span.edge[i] + span.edgeStepY[i] * y;
+  }
+  for (auto i = 0; i < 4; i++) {
+    color[i] = span.color[i] + span.colorStepY[i] * static_cast<float>(y);
+  }
+}
+
+// ============================================================================
+
+static void rasterizeRowScalar(const TileSpan& span, const int32_t edge[3], const float color[4], int begin, int end, uint32_t* row)
+{
+  for (auto x = begin; x < end; x++) {
+    auto edge0 = edge[0] + span.edgeStepX[0] * x;
+    auto edge1 = edge[1] + span.edgeStepX[1] * x;
+    auto edge2 = edge[2] + span.edgeStepX[2] * x;
+    if ((edge0 | edge1 | edge2) < 0) {
+      continue;
+    }
+    auto fx = static_cast<float>(x);
+    float pixel[4];
+    for (auto i = 0; i < 4; i++) {
+      pixel[i] = color[i] + span.colorStepX[i] * fx;
+    }
+    row[x] = packColor(pixel);
+  }
+}
+
+// ============================================================================
+
+static void rasterizeSpanScalar(const TileSpan& span, uint32_t* pixels, unsigned int pitch)
+{
+  for (auto y = 0; y < span.height; y++) {
+    int32_t edge[3];
+    float color[4];
+    getRowStart(span, y, edge, color);
+    rasterizeRowScalar(span, edge, color, 0, span.width, pixels + static_cast<size_t>(y) * pitch);
+  }
+}
+
+// ============================================================================
+
+#if defined(SIMD_X86)
+
+TARGET_SSE41 static __m128i toUnorm8SSE41(__m128 value)
+{
+  value = _mm_min_ps(_mm_max_ps(value, _mm_setzero_ps()), _mm_set1_ps(1.f));
+  return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(255.f)), _mm_set1_ps(0.5f)));
+}
+
+// ============================================================================
+
+TARGET_SSE41 static void shadeSSE41(const TileSpan& span, const float color[4], __m128i x, __m128i inside, uint32_t* output)
+{
+  auto fx = _mm_cvtepi32_ps(x);
+  __m128i channels[4];
+  for (auto i = 0; i < 4; i++) {
+    channels[i] = toUnorm8SSE41(_mm_add_ps(_mm_set1_ps(color[i]), _mm_mul_ps(_mm_set1_ps(span.colorStepX[i]), fx)));
+  }
+  auto packed = _mm_or_si128(
+    _mm_or_si128(channels[0], _mm_slli_epi32(channels[1], 8)),
+    _mm_or_si128(_mm_slli_epi32(channels[2], 16), _mm_slli_epi32(channels[3], 24)));
+  auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(output));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(output), _mm_blendv_epi8(pixels, packed, inside));
+}
+
+// ============================================================================
+
+TARGET_SSE41 static void rasterizeSpanSSE41(const TileSpan& span, uint32_t* pixels, unsigned int pitch)
+{
+  auto lanes = _mm_setr_epi32(0, 1, 2, 3);
+  for (auto y = 0; y < span.height; y++) {
+    int32_t edge[3];
+    float color[4];
+    getRowStart(span, y, edge, color);
+    auto row = pixels + static_cast<size_t>(y) * pitch;
+
+    // test eight pixels per iteration as two halves of four.
+    __m128i edges[3];
+    __m128i steps[3];
+    for (auto i = 0; i < 3; i++) {
+      edges[i] = _mm_add_epi32(_mm_set1_epi32(edge[i]), _mm_mullo_epi32(_mm_set1_epi32(span.edgeStepX[i]), lanes));
+      steps[i] = _mm_set1_epi32(span.edgeStepX[i] * 4);
+    }
+    auto x = 0;
+    for (; x + 8 <= span.width; x += 8) {
+      for (auto half = 0; half < 2; half++) {
+        // the sign bit is set for the pixels outside any of the edges.
+        auto outside = _mm_or_si128(_mm_or_si128(edges[0], edges[1]), edges[2]);
+        auto inside = _mm_cmpgt_epi32(outside, _mm_set1_epi32(-1));
+        if (!_mm_testz_si128(inside, inside)) {
+          shadeSSE41(span, color, _mm_add_epi32(_mm_set1_epi32(x + half * 4), lanes), inside, row + x + half * 4);
+        }
+        for (auto i = 0; i < 3; i++) {
+          edges[i] = _mm_add_epi32(edges[i], steps[i]);
+        }
+      }
+    }
+    rasterizeRowScalar(span, edge, color, x, span.width, row);
+  }
+}
+
+// ============================================================================
+
+TARGET_AVX2 static __m256i toUnorm8AVX2(__m256 value)
+{
+  value = _mm256_min_ps(_mm256_max_ps(value, _mm256_setzero_ps()), _mm256_set1_ps(1.f));
+  return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, _mm256_set1_ps(255.f)), _mm256_set1_ps(0.5f)));
+}
+
+// ============================================================================
+
+TARGET_AVX2 static void rasterizeSpanAVX2(const TileSpan& span, uint32_t* pixels, unsigned int pitch)
+{
+  auto lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+  for (auto y = 0; y < span.height; y++) {
+    // the row start and the remaining pixels are evaluated by the shared SSE code, so the upper halves of the
+    // registers are cleared before calling it to avoid the AVX-SSE transition penalty.
+    int32_t edge[3];
+    float color[4];
+    _mm256_zeroupper();
+    getRowStart(span, y, edge, color);
+    auto row = pixels + static_cast<size_t>(y) * pitch;
+
+    __m256i edges[3];
+    __m256i steps[3];
+    for (auto i = 0; i < 3; i++) {
+      edges[i] = _mm256_add_epi32(_mm256_set1_epi32(edge[i]), _mm256_mullo_epi32(_mm256_set1_epi32(span.edgeStepX[i]), lanes));
+      steps[i] = _mm256_set1_epi32(span.edgeStepX[i] * 8);
+    }
+    auto x = 0;
+    for (; x + 8 <= span.width; x += 8) {
+      // the sign bit is set for the pixels outside any of the edges.
+      auto outside = _mm256_or_si256(_mm256_or_si256(edges[0], edges[1]), edges[2]);
+      auto inside = _mm256_cmpgt_epi32(outside, _mm256_set1_epi32(-1));
+      if (!_mm256_testz_si256(inside, inside)) {
+        auto fx = _mm256_cvtepi32_ps(_mm256_add_epi32(_mm256_set1_epi32(x), lanes));
+        __m256i channels[4];
+        for (auto i = 0; i < 4; i++) {
+          channels[i] = toUnorm8AVX2(_mm256_add_ps(_mm256_set1_ps(color[i]), _mm256_mul_ps(_mm256_set1_ps(span.colorStepX[i]), fx)));
+        }
+        auto packed = _mm256_or_si256(
+          _mm256_or_si256(channels[0], _mm256_slli_epi32(channels[1], 8)),
+          _mm256_or_si256(_mm256_slli_epi32(channels[2], 16), _mm256_slli_epi32(channels[3], 24)));
+        auto output = reinterpret_cast<__m256i*>(row + x);
+        _mm256_storeu_si256(output, _mm256_blendv_epi8(_mm256_loadu_si256(output), packed, inside));
+      }
+      for (auto i = 0; i < 3; i++) {
+        edges[i] = _mm256_add_epi32(edges[i], steps[i]);
+      }
+    }
+    _mm256_zeroupper();
+    rasterizeRowScalar(span, edge, color, x, span.width, row);
+  }
+}
+
+#endif
+
+// ============================================================================
+
+SoftwareImage::SoftwareImage(unsigned int width, unsigned int height)
+  : mWidth(width), mHeight(height), mPixels(static_cast<size_t>(width) * height)
+{
+}
+
+// ============================================================================
+
+unsigned int SoftwareImage::getWidth() const
+{
+  return mWidth;
+}
+
+// ============================================================================
+
+unsigned int SoftwareImage::getHeight() const
+{
+  return mHeight;
+}
+
+// ============================================================================
+
+uint32_t* SoftwareImage::getPixels()
+{
+  return mPixels.data();
+}
+
+// ============================================================================
+
+const uint32_t* SoftwareImage::getPixels() const
+{
+  return mPixels.data();
+}
+
+// ============================================================================
+
+uint64_t SoftwareImage::getHash() const
+{
+  return hashBytes(mPixels.data(), mPixels.size() * sizeof(uint32_t));
+}
+
+// ============================================================================
+
+bool SoftwareImage::write(const std::string& path) const
+{
+  std::ofstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  // an uncompressed true color image with eight bits of alpha and the origin at the top left corner.
+  uint8_t header[18] = {};
+  header[2] = 2;
+  header[12] = static_cast<uint8_t>(mWidth & 0xff);
+  header[13] = static_cast<uint8_t>(mWidth >> 8);
+  header[14] = static_cast<uint8_t>(mHeight & 0xff);
+  header[15] = static_cast<uint8_t>(mHeight >> 8);
+  header[16] = 32;
+  header[17] = 0x28;
+  file.write(reinterpret_cast<const char*>(header), sizeof(header));
+
+  // the TGA pixels are stored in the BGRA order.
+  std::vector<uint8_t> row(static_cast<size_t>(mWidth) * 4);
+  for (auto y = 0u; y < mHeight; y++) {
+    for (auto x = 0u; x < mWidth; x++) {
+      auto pixel = mPixels[static_cast<size_t>(y) * mWidth + x];
+      row[x * 4 + 0] = static_cast<uint8_t>(pixel >> 16);
+      row[x * 4 + 1] = static_cast<uint8_t>(pixel >> 8);
+      row[x * 4 + 2] = static_cast<uint8_t>(pixel);
+      row[x * 4 + 3] = static_cast<uint8_t>(pixel >> 24);
+    }
+    file.write(reinterpret_cast<const char*>(row.data()), row.size());
+  }
+  return static_cast<bool>(file);
+}
+
+// ============================================================================
+
+void SoftwareCommandList::reset()
+{
+  mCommands.clear();
+}
+
+// ============================================================================
+
+void SoftwareCommandList::setViewport(const SoftwareViewport& viewport)
+{
+  push(CommandType::SET_VIEWPORT).viewport = viewport;
+}
+
+// ============================================================================
+
+void SoftwareCommandList::setScissorRect(const SoftwareRect& rect)
+{
+  push(CommandType::SET_SCISSOR_RECT).rect = rect;
+}
+
+// ============================================================================
+
+void SoftwareCommandList::setRasterizerState(CullMode cullMode, bool frontCounterClockwise)
+{
+  auto& command = push(CommandType::SET_RASTERIZER_STATE);
+  command.cullMode = cullMode;
+  command.frontCounterClockwise = frontCounterClockwise;
+}
+
+// ============================================================================
+
+void SoftwareCommandList::setRenderTarget(SoftwareImage* renderTarget)
+{
+  push(CommandType::SET_RENDER_TARGET).renderTarget = renderTarget;
+}
+
+// ============================================================================
+
+void SoftwareCommandList::clearRenderTarget(SoftwareImage* renderTarget, const float color[4])
+{
+  auto& command = push(CommandType::CLEAR_RENDER_TARGET);
+  command.renderTarget = renderTarget;
+  std::copy(color, color + 4, command.color);
+}
+
+// ============================================================================
+
+void SoftwareCommandList::setVertexBuffer(const void* vertices, uint32_t vertexCount, const VertexLayout& layout)
+{
+  auto& command = push(CommandType::SET_VERTEX_BUFFER);
+  command.vertices = vertices;
+  command.vertexCount = vertexCount;
+  command.vertexLayout = layout;
+}
+
+// ============================================================================
+
+void SoftwareCommandList::drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance)
+{
+  auto& command = push(CommandType::DRAW_INSTANCED);
+  command.vertexCountPerInstance = vertexCountPerInstance;
+  command.instanceCount = instanceCount;
+  command.startVertex = startVertex;
+  command.startInstance = startInstance;
+}
+
+// ============================================================================
+
+const std::vector<SoftwareCommandList::Command>& SoftwareCommandList::getCommands() const
+{
+  return mCommands;
+}
+
+// ============================================================================
+
+SoftwareCommandList::Command& SoftwareCommandList::push(CommandType type)
+{
+  Command command = {};
+  command.type = type;
+  mCommands.push_back(command);
+  return mCommands.back();
+}
+
+// ============================================================================
+
+SoftwareRasterizer::SoftwareRasterizer(JobSystem* jobSystem, SimdLevel level)
+  : mJobSystem(jobSystem),
+    mLevel(level),
+    mTriangleCount(0),
+    mViewport({ 0.f, 0.f, 0.f, 0.f }),
+    mScissorRect({ INT32_MIN, INT32_MIN, INT32_MAX, INT32_MAX }),
+    mCullMode(CullMode::BACK),
+    mFrontCounterClockwise(false),
+    mRenderTarget(nullptr),
+    mVertices(nullptr),
+    mVertexCount(0),
+    mVertexLayout({ PositionFormat::FLOAT3, ColorFormat::FLOAT4 }),
+    mTileCountX(0),
+    mTileCountY(0)
+{
+}
+
+// ============================================================================
+
+void SoftwareRasterizer::execute(const SoftwareCommandList& commandList)
+{
+  for (auto& command : commandList.getCommands()) {
+    switch (command.type) {
+    case SoftwareCommandList::CommandType::SET_VIEWPORT:
+      mViewport = command.viewport;
+      break;
+    case SoftwareCommandList::CommandType::SET_SCISSOR_RECT:
+      mScissorRect = command.rect;
+      break;
+    case SoftwareCommandList::CommandType::SET_RASTERIZER_STATE:
+      mCullMode = command.cullMode;
+      mFrontCounterClockwise = command.frontCounterClockwise;
+      break;
+    case SoftwareCommandList::CommandType::SET_RENDER_TARGET:
+      flush();
+      mRenderTarget = command.renderTarget;
+      mTileCountX = mRenderTarget != nullptr ? (mRenderTarget->getWidth() + TILE_SIZE - 1) / TILE_SIZE : 0;
+      mTileCountY = mRenderTarget != nullptr ? (mRenderTarget->getHeight() + TILE_SIZE - 1) / TILE_SIZE : 0;
+      mBins.resize(mTileCountX * mTileCountY);
+      break;
+    case SoftwareCommandList::CommandType::CLEAR_RENDER_TARGET: {
+      flush();
+      auto pixels = command.renderTarget->getPixels();
+      std::fill(pixels, pixels + static_cast<size_t>(command.renderTarget->getWidth()) * command.renderTarget->getHeight(), packColor(command.color));
+      break;
+    }
+    case SoftwareCommandList::CommandType::SET_VERTEX_BUFFER:
+      mVertices = command.vertices;
+      mVertexCount = command.vertexCount;
+      mVertexLayout = command.vertexLayout;
+      break;
+    case SoftwareCommandList::CommandType::DRAW_INSTANCED:
+      draw(command);
+      break;
+    }
+  }
+  flush();
+}
+
+// ============================================================================
+
+uint64_t SoftwareRasterizer::getTriangleCount() const
+{
+  return mTriangleCount;
+}
+
+// ============================================================================
+
+void SoftwareRasterizer::draw(const SoftwareCommandList::Command& command)
+{
+  if (mRenderTarget == nullptr || mVertices == nullptr) {
+    throw new std::runtime_error("Cannot draw without a render target and a vertex buffer");
+  }
+  if (static_cast<uint64_t>(command.startVertex) + command.vertexCountPerInstance > mVertexCount) {
+    std::cout << "drawInstanced: " << command.startVertex << " + " << command.vertexCountPerInstance << " > " << mVertexCount << std::endl;
+    throw new std::runtime_error("Draw reads past the end of the vertex buffer");
+  }
+  if (command.instanceCount == 0 || !(mViewport.width > 0.f) || !(mViewport.height > 0.f)) {
+    return;
+  }
+
+  // the vertex shader passes the positions through, so they are already in the normalized device coordinates.
+  mDecodedVertices.resize(command.vertexCountPerInstance);
+  auto stride = getVertexStride(mVertexLayout);
+  decodeVertices(static_cast<const uint8_t*>(mVertices) + static_cast<size_t>(command.startVertex) * stride, command.vertexCountPerInstance, mVertexLayout, mDecodedVertices.data());
+
+  // the clipping planes as the axis and the sign and offset of the distance, i.e. sign * position[axis] + offset >= 0.
+  // the guard band keeps the fixed point screen coordinates and the edge functions within their ranges.
+  auto scaleX = 2.f / mViewport.width;
+  auto scaleY = 2.f / mViewport.height;
+  struct ClipPlane { int axis; float sign; float offset; };
+  const ClipPlane planes[6] = {
+    { 2, 1.f, 0.f },
+    { 2, -1.f, 1.f },
+    { 0, 1.f, (GUARD_BAND + mViewport.topLeftX) * scaleX + 1.f },
+    { 0, -1.f, (GUARD_BAND - mViewport.topLeftX) * scaleX - 1.f },
+    { 1, 1.f, (GUARD_BAND - mViewport.topLeftY) * scaleY - 1.f },
+    { 1, -1.f, (GUARD_BAND + mViewport.topLeftY) * scaleY + 1.f }
+  };
+
+  for (auto first = 0u; first + 3 <= command.vertexCountPerInstance; first += 3) {
+    auto& v0 = mDecodedVertices[first];
+    auto& v1 = mDecodedVertices[first + 1];
+    auto& v2 = mDecodedVertices[first + 2];
+    auto finite = true;
+    for (auto i = 0; i < 3; i++) {
+      finite = finite && std::isfinite(v0.position[i]) && std::isfinite(v1.position[i]) && std::isfinite(v2.position[i]);
+    }
+    if (!finite) {
+      continue;
+    }
+
+    // clip the triangle with the Sutherland-Hodgman algorithm.
+    Vertex polygons[2][MAX_CLIP_VERTICES];
+    polygons[0][0] = v0;
+    polygons[0][1] = v1;
+    polygons[0][2] = v2;
+    auto count = 3;
+    auto input = 0;
+    for (auto& plane : planes) {
+      auto& source = polygons[input];
+      auto& target = polygons[1 - input];
+      auto clippedCount = 0;
+      for (auto i = 0; i < count; i++) {
+        auto& a = source[i];
+        auto& b = source[(i + 1) % count];
+        auto distanceA = plane.sign * a.position[plane.axis] + plane.offset;
+        auto distanceB = plane.sign * b.position[plane.axis] + plane.offset;
+        if (distanceA >= 0.f) {
+          target[clippedCount++] = a;
+        }
+        if ((distanceA >= 0.f) != (distanceB >= 0.f)) {
+          auto t = distanceA / (distanceA - distanceB);
+          auto& vertex = target[clippedCount++];
+          for (auto j = 0; j < 3; j++) {
+            vertex.position[j] = a.position[j] + (b.position[j] - a.position[j]) * t;
+          }
+          for (auto j = 0; j < 4; j++) {
+            vertex.color[j] = a.color[j] + (b.color[j] - a.color[j]) * t;
+          }
+        }
+      }
+      count = clippedCount;
+      input = 1 - input;
+      if (count < 3) {
+        break;
+      }
+    }
+
+    // split the clipped polygon into a triangle fan.
+    for (auto i = 1; i + 1 < count; i++) {
+      setupTriangle(polygons[input][0], polygons[input][i], polygons[input][i + 1], command.instanceCount);
+    }
+  }
+}
+
+// ============================================================================
+
+void SoftwareRasterizer::setupTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, uint32_t instanceCount)
+{
+  // snap the vertices to the fixed point screen coordinates where the y-axis points down.
+  static const auto SUBPIXEL_SCALE = static_cast<double>(1 << SUBPIXEL_BITS);
+  const Vertex* vertices[3] = { &v0, &v1, &v2 };
+  Triangle triangle;
+  for (auto i = 0; i < 3; i++) {
+    auto x = mViewport.topLeftX + (vertices[i]->position[0] + 1.0) * 0.5 * mViewport.width;
+    auto y = mViewport.topLeftY + (1.0 - vertices[i]->position[1]) * 0.5 * mViewport.height;
+    triangle.x[i] = std::llround(x * SUBPIXEL_SCALE);
+    triangle.y[i] = std::llround(y * SUBPIXEL_SCALE);
+  }
+
+  // the area is positive for the triangles which are clockwise on the screen.
+  auto area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+  if (area == 0) {
+    return;
+  }
+  auto front = mFrontCounterClockwise ? area < 0 : area > 0;
+  if ((mCullMode == CullMode::BACK && !front) || (mCullMode == CullMode::FRONT && front)) {
+    return;
+  }
+  if (area < 0) {
+    std::swap(triangle.x[1], triangle.x[2]);
+    std::swap(triangle.y[1], triangle.y[2]);
+    std::swap(vertices[1], vertices[2]);
+  }
+
+  // find the pixels whose centers may be covered and limit them to the viewport, scissor rectangle and render target.
+  static const auto HALF_PIXEL = 1 << (SUBPIXEL_BITS - 1);
+  auto minX = std::min({ triangle.x[0], triangle.x[1], triangle.x[2] }) - HALF_PIXEL;
+  auto minY = std::min({ triangle.y[0], triangle.y[1], triangle.y[2] }) - HALF_PIXEL;
+  auto maxX = std::max({ triangle.x[0], triangle.x[1], triangle.x[2] }) - HALF_PIXEL;
+  auto maxY = std::max({ triangle.y[0], triangle.y[1], triangle.y[2] }) - HALF_PIXEL;
+  auto viewportLeft = static_cast<int64_t>(std::ceil(mViewport.topLeftX - 0.5f));
+  auto viewportTop = static_cast<int64_t>(std::ceil(mViewport.topLeftY - 0.5f));
+  auto viewportRight = static_cast<int64_t>(std::ceil(mViewport.topLeftX + mViewport.width - 0.5f));
+  auto viewportBottom = static_cast<int64_t>(std::ceil(mViewport.topLeftY + mViewport.height - 0.5f));
+  triangle.minX = static_cast<int32_t>(std::max({ -((-minX) >> SUBPIXEL_BITS), viewportLeft, static_cast<int64_t>(mScissorRect.left), int64_t(0) }));
+  triangle.minY = static_cast<int32_t>(std::max({ -((-minY) >> SUBPIXEL_BITS), viewportTop, static_cast<int64_t>(mScissorRect.top), int64_t(0) }));
+  triangle.maxX = static_cast<int32_t>(std::min({ (maxX >> SUBPIXEL_BITS) + 1, viewportRight, static_cast<int64_t>(mScissorRect.right), static_cast<int64_t>(mRenderTarget->getWidth()) }));
+  triangle.maxY = static_cast<int32_t>(std::min({ (maxY >> SUBPIXEL_BITS) + 1, viewportBottom, static_cast<int64_t>(mScissorRect.bottom), static_cast<int64_t>(mRenderTarget->getHeight()) }));
+  if (triangle.minX >= triangle.maxX || triangle.minY >= triangle.maxY) {
+    return;
+  }
+
+  // solve the color gradients from the snapped vertices.
+  double x[3];
+  double y[3];
+  for (auto i = 0; i < 3; i++) {
+    x[i] = triangle.x[i] / SUBPIXEL_SCALE;
+    y[i] = triangle.y[i] / SUBPIXEL_SCALE;
+  }
+  auto screenArea = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+  for (auto i = 0; i < 4; i++) {
+    double delta1 = vertices[1]->color[i] - vertices[0]->color[i];
+    double delta2 = vertices[2]->color[i] - vertices[0]->color[i];
+    triangle.color[i] = vertices[0]->color[i];
+    triangle.colorStepX[i] = (delta1 * (y[2] - y[0]) - delta2 * (y[1] - y[0])) / screenArea;
+    triangle.colorStepY[i] = (delta2 * (x[1] - x[0]) - delta1 * (x[2] - x[0])) / screenArea;
+  }
+
+  // the instances share the triangle, so each of them only adds its index into the bins.
+  auto index = static_cast<uint32_t>(mTriangles.size());
+  mTriangles.push_back(triangle);
+  for (auto tileY = triangle.minY / TILE_SIZE; tileY <= (triangle.maxY - 1) / TILE_SIZE; tileY++) {
+    for (auto tileX = triangle.minX / TILE_SIZE; tileX <= (triangle.maxX - 1) / TILE_SIZE; tileX++) {
+      auto& bin = mBins[tileY * mTileCountX + tileX];
+      bin.insert(bin.end(), instanceCount, index);
+    }
+  }
+  mTriangleCount += instanceCount;
+}
+
+// ============================================================================
+
+void SoftwareRasterizer::flush()
+{
+  if (mTriangles.empty()) {
+    return;
+  }
+
+  // each tile is rasterized by a single job, so the tiles do not need any synchronization.
+  auto tileCount = static_cast<unsigned int>(mTileCountX * mTileCountY);
+  auto rasterize = [&](unsigned int begin, unsigned int end) {
+    for (auto tile = begin; tile < end; tile++) {
+      rasterizeTile(tile % mTileCountX, tile / mTileCountX);
+    }
+  };
+  if (mJobSystem != nullptr) {
+    mJobSystem->parallelFor(tileCount, 1, rasterize);
+  } else {
+    rasterize(0, tileCount);
+  }
+
+  for (auto& bin : mBins) {
+    bin.clear();
+  }
+  mTriangles.clear();
+}
+
+// ============================================================================
+
+void SoftwareRasterizer::rasterizeTile(int tileX, int tileY)
+{
+  static const auto SUBPIXEL_SCALE = 1 << SUBPIXEL_BITS;
+  static const auto HALF_PIXEL = SUBPIXEL_SCALE / 2;
+  auto tileLeft = tileX * TILE_SIZE;
+  auto tileTop = tileY * TILE_SIZE;
+  auto tileRight = std::min(tileLeft + TILE_SIZE, static_cast<int>(mRenderTarget->getWidth()));
+  auto tileBottom = std::min(tileTop + TILE_SIZE, static_cast<int>(mRenderTarget->getHeight()));
+  auto pitch = mRenderTarget->getWidth();
+  for (auto index : mBins[tileY * mTileCountX + tileX]) {
+    auto& triangle = mTriangles[index];
+    auto left = std::max(tileLeft, static_cast<int>(triangle.minX));
+    auto top = std::max(tileTop, static_cast<int>(triangle.minY));
+    auto right = std::min(tileRight, static_cast<int>(triangle.maxX));
+    auto bottom = std::min(tileBottom, static_cast<int>(triangle.maxY));
+    if (left >= right || top >= bottom) {
+      continue;
+    }
+
+    // evaluate the edge functions at the center of the first pixel. the edge opposite to each vertex is
+    // non-negative inside the triangle, and the pixels exactly on the edge are only covered by the top and
+    // left edges (the top-left rule of D3D).
+    TileSpan span;
+    span.width = right - left;
+    span.height = bottom - top;
+    auto pixelX = static_cast<int64_t>(left) * SUBPIXEL_SCALE + HALF_PIXEL;
+    auto pixelY = static_cast<int64_t>(top) * SUBPIXEL_SCALE + HALF_PIXEL;
+    auto covered = true;
+    for (auto i = 0; i < 3 && covered; i++) {
+      auto a = (i + 1) % 3;
+      auto b = (i + 2) % 3;
+      auto stepX = triangle.y[a] - triangle.y[b];
+      auto stepY = triangle.x[b] - triangle.x[a];
+      auto bias = stepX > 0 || (stepX == 0 && stepY > 0) ? 0 : -1;
+      auto edge = stepX * (pixelX - triangle.x[a]) + stepY * (pixelY - triangle.y[a]) + bias;
+      stepX *= SUBPIXEL_SCALE;
+      stepY *= SUBPIXEL_SCALE;
+
+      // reject the whole span when it is outside the edge and ignore the edge when the whole span is inside it.
+      // the remaining edges cross the span, so their values fit into 32 bits.
+      auto rangeX = stepX * (span.width - 1);
+      auto rangeY = stepY * (span.height - 1);
+      auto minEdge = edge + std::min<int64_t>(rangeX, 0) + std::min<int64_t>(rangeY, 0);
+      auto maxEdge = edge + std::max<int64_t>(rangeX, 0) + std::max<int64_t>(rangeY, 0);
+      covered = maxEdge >= 0;
+      auto inside = minEdge >= 0;
+      span.edge[i] = inside ? 0 : static_cast<int32_t>(edge);
+      span.edgeStepX[i] = inside ? 0 : static_cast<int32_t>(stepX);
+      span.edgeStepY[i] = inside ? 0 : static_cast<int32_t>(stepY);
+    }
+    if (!covered) {
+      continue;
+    }
+
+    // evaluate the colors at the center of the first pixel.
+    auto centerX = left + 0.5 - triangle.x[0] / static_cast<double>(SUBPIXEL_SCALE);
+    auto centerY = top + 0.5 - triangle.y[0] / static_cast<double>(SUBPIXEL_SCALE);
+    for (auto i = 0; i < 4; i++) {
+      span.color[i] = static_cast<float>(triangle.color[i] + triangle.colorStepX[i] * centerX + triangle.colorStepY[i] * centerY);
+      span.colorStepX[i] = static_cast<float>(triangle.colorStepX[i]);
+      span.colorStepY[i] = static_cast<float>(triangle.colorStepY[i]);
+    }
+
+    auto pixels = mRenderTarget->getPixels() + static_cast<size_t>(top) * pitch + left;
+    #if defined(SIMD_X86)
+    if (mLevel == SimdLevel::AVX2) {
+      rasterizeSpanAVX2(span, pixels, pitch);
+      continue;
+    }
+    if (mLevel == SimdLevel::SSE41) {
+      rasterizeSpanSSE41(span, pixels, pitch);
+      continue;
+    }
+    #endif
+    rasterizeSpanScalar(span, pixels, pitch);
+  }
+}
+
+// ============================================================================
+
+SoftwareCommandQueue::SoftwareCommandQueue(JobSystem* jobSystem, SimdLevel level) : mRasterizer(jobSystem, level)
+{
+}
+
+// ============================================================================
+
+void SoftwareCommandQueue::executeCommandLists(unsigned int count, CommandList* const* commandLists)
+{
+  for (auto i = 0u; i < count; i++) {
+    mRasterizer.execute(*static_cast<SoftwareCommandList*>(commandLists[i]));
+  }
+}
+
+// ============================================================================
+
+void SoftwareCommandQueue::signal(Fence& fence, uint64_t value)
+{
+  // the work has already been completed when the signal is submitted.
+  static_cast<NullFence&>(fence).setCompletedValue(value);
+}
+
+// ============================================================================
+
+void SoftwareCommandQueue::wait(Fence& fence, uint64_t value)
+{
+  fence.wait(value, std::chrono::milliseconds::max());
+}
+
+// ============================================================================
+
+uint64_t SoftwareCommandQueue::getTriangleCount() const
+{
+  return mRasterizer.getTriangleCount();
+}
+
+// ============================================================================
+
+SoftwareSwapChain::SoftwareSwapChain(unsigned int bufferCount, unsigned int width, unsigned int height) : mBufferIndex(0)
+{
+  for (auto i = 0u; i < bufferCount; i++) {
+    mBuffers.push_back(std::unique_ptr<SoftwareImage>(new SoftwareImage(width, height)));
+  }
+}
+
+// ============================================================================
+
+unsigned int SoftwareSwapChain::getBufferCount() const
+{
+  return static_cast<unsigned int>(mBuffers.size());
+}
+
+// ============================================================================
+
+unsigned int SoftwareSwapChain::getCurrentBackBufferIndex() const
+{
+  return mBufferIndex;
+}
+
+// ============================================================================
+
+void SoftwareSwapChain::waitForNextFrame()
+{
+}
+
+// ============================================================================
+
+void SoftwareSwapChain::present(PresentMode)
+{
+  mBufferIndex = (mBufferIndex + 1) % getBufferCount();
+}
+
+// ============================================================================
+
+bool SoftwareSwapChain::getVblankTiming(VblankTiming&)
+{
+  // the images are not shown on any display.
+  return false;
+}
+
+// ============================================================================
+
+SoftwareImage& SoftwareSwapChain::getBuffer(unsigned int index)
+{
+  return *mBuffers[index];
+}
+
+// ============================================================================
+
+SoftwareDevice::SoftwareDevice(JobSystem* jobSystem, SimdLevel level) : mJobSystem(jobSystem), mLevel(level)
+{
+}
+
+// ============================================================================
+
+std::unique_ptr<CommandQueue> SoftwareDevice::createCommandQueue(CommandListType)
+{
+  return std::unique_ptr<CommandQueue>(new SoftwareCommandQueue(mJobSystem, mLevel));
+}
+
+// ============================================================================
+
+std::unique_ptr<Fence> SoftwareDevice::createFence()
+{
+  return std::unique_ptr<Fence>(new NullFence());
+}
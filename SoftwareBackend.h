@@ -0,0 +1,258 @@
+#pragma once
+
+#include "Backend.h"
+#include "CpuFeatures.h"
+#include "VertexFormat.h"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+class JobSystem;
+
+// ============================================================================
+// A CPU implementation of the backend which actually renders.
+//
+// The command lists record the same operations that the application records
+// with Direct3D 12 (viewport, scissor, clear, triangle list draws with vertex
+// colors and back-face culling) and the queue executes them immediately with
+// a tiled rasterizer. The triangles are binned into 64x64 pixel tiles and the
+// tiles are rasterized in parallel with SIMD edge functions. The rasterizer
+// only uses integer edge functions and evaluates the colors in the same order
+// in every kernel, so the images are pixel-exact regardless of the thread count
+// and the instruction set, which makes them usable as golden images.
+// ============================================================================
+
+// an R8G8B8A8 image used as a render target. the pixels are stored row by row with the red channel in the lowest byte.
+class SoftwareImage
+{
+public:
+  SoftwareImage(unsigned int width, unsigned int height);
+
+  unsigned int getWidth() const;
+  unsigned int getHeight() const;
+
+  // get the pixels of the image.
+  uint32_t* getPixels();
+  const uint32_t* getPixels() const;
+
+  // get a stable FNV-1a hash of the pixels which identifies the image in the regression runs.
+  uint64_t getHash() const;
+
+  // write the image into an uncompressed 32-bit TGA file.
+  bool write(const std::string& path) const;
+
+private:
+  unsigned int mWidth;
+  unsigned int mHeight;
+  std::vector<uint32_t> mPixels;
+};
+
+// ============================================================================
+
+// the faces which are culled by the rasterizer (see D3D12_CULL_MODE).
+enum class CullMode { NONE, FRONT, BACK };
+
+// the viewport in pixels (see D3D12_VIEWPORT).
+struct SoftwareViewport
+{
+  float topLeftX;
+  float topLeftY;
+  float width;
+  float height;
+};
+
+// the scissor rectangle in pixels, where the right and bottom edges are exclusive (see D3D12_RECT).
+struct SoftwareRect
+{
+  int32_t left;
+  int32_t top;
+  int32_t right;
+  int32_t bottom;
+};
+
+// ============================================================================
+
+class SoftwareCommandList : public CommandList
+{
+public:
+  // the types of the recorded commands.
+  enum class CommandType
+  {
+    SET_VIEWPORT,
+    SET_SCISSOR_RECT,
+    SET_RASTERIZER_STATE,
+    SET_RENDER_TARGET,
+    CLEAR_RENDER_TARGET,
+    SET_VERTEX_BUFFER,
+    DRAW_INSTANCED
+  };
+
+  // a single recorded command with the arguments of its type.
+  struct Command
+  {
+    CommandType type;
+    SoftwareViewport viewport;
+    SoftwareRect rect;
+    CullMode cullMode;
+    bool frontCounterClockwise;
+    SoftwareImage* renderTarget;
+    float color[4];
+    const void* vertices;
+    uint32_t vertexCount;
+    VertexLayout vertexLayout;
+    uint32_t vertexCountPerInstance;
+    uint32_t instanceCount;
+    uint32_t startVertex;
+    uint32_t startInstance;
+  };
+
+  // remove the recorded commands.
+  void reset();
+
+  void setViewport(const SoftwareViewport& viewport);
+  void setScissorRect(const SoftwareRect& rect);
+  void setRasterizerState(CullMode cullMode, bool frontCounterClockwise);
+  void setRenderTarget(SoftwareImage* renderTarget);
+  void clearRenderTarget(SoftwareImage* renderTarget, const float color[4]);
+
+  // bind the packed vertices. the vertex data must remain valid until the command list has been executed.
+  void setVertexBuffer(const void* vertices, uint32_t vertexCount, const VertexLayout& layout);
+
+  // draw triangle lists. like the vertex shader of the application, the instances do not transform the vertices.
+  void drawInstanced(uint32_t vertexCountPerInstance, uint32_t instanceCount, uint32_t startVertex, uint32_t startInstance);
+
+  // get the recorded commands.
+  const std::vector<Command>& getCommands() const;
+
+private:
+  // append a new command of the given type.
+  Command& push(CommandType type);
+
+  std::vector<Command> mCommands;
+};
+
+// ============================================================================
+
+class SoftwareRasterizer
+{
+public:
+  // the size of the tiles that the triangles are binned into.
+  static const int TILE_SIZE = 64;
+  // the amount of fractional bits in the fixed point vertex positions.
+  static const int SUBPIXEL_BITS = 4;
+  // the distance from the origin of the render target in pixels where the triangles are clipped.
+  static const int GUARD_BAND = 8192;
+
+  SoftwareRasterizer(JobSystem* jobSystem, SimdLevel level);
+
+  // execute the commands of the command list. the binned triangles are rasterized before each clear,
+  // render target change and at the end of the list.
+  void execute(const SoftwareCommandList& commandList);
+
+  // get the amount of triangles that have been rasterized (i.e. not culled or clipped away) since the creation.
+  uint64_t getTriangleCount() const;
+
+private:
+  // a triangle in the fixed point screen space with a positive area and its color gradients.
+  struct Triangle
+  {
+    int64_t x[3];
+    int64_t y[3];
+    // the rectangle of the pixels that the triangle may cover.
+    int32_t minX;
+    int32_t minY;
+    int32_t maxX;
+    int32_t maxY;
+    // the color at the first vertex and its change per pixel.
+    double color[4];
+    double colorStepX[4];
+    double colorStepY[4];
+  };
+
+  // clip the triangles of a draw against the depth range and the guard band and bin them into the tiles.
+  void draw(const SoftwareCommandList::Command& command);
+
+  // set up a clipped triangle and bin it into the tiles with the given amount of instances.
+  void setupTriangle(const Vertex& v0, const Vertex& v1, const Vertex& v2, uint32_t instanceCount);
+
+  // rasterize and release the binned triangles.
+  void flush();
+
+  // rasterize the binned triangles of a single tile.
+  void rasterizeTile(int tileX, int tileY);
+
+  JobSystem* mJobSystem;
+  SimdLevel mLevel;
+  uint64_t mTriangleCount;
+  SoftwareViewport mViewport;
+  SoftwareRect mScissorRect;
+  CullMode mCullMode;
+  bool mFrontCounterClockwise;
+  SoftwareImage* mRenderTarget;
+  const void* mVertices;
+  uint32_t mVertexCount;
+  VertexLayout mVertexLayout;
+  std::vector<Vertex> mDecodedVertices;
+  std::vector<Triangle> mTriangles;
+  // the indices of the triangles binned into each of the tiles in the submission order.
+  std::vector<std::vector<uint32_t>> mBins;
+  int mTileCountX;
+  int mTileCountY;
+};
+
+// ============================================================================
+
+class SoftwareCommandQueue : public CommandQueue
+{
+public:
+  SoftwareCommandQueue(JobSystem* jobSystem, SimdLevel level);
+
+  // execute the command lists immediately on the calling thread and the job system.
+  void executeCommandLists(unsigned int count, CommandList* const* commandLists) override;
+  void signal(Fence& fence, uint64_t value) override;
+  void wait(Fence& fence, uint64_t value) override;
+
+  // get the amount of triangles that have been rasterized.
+  uint64_t getTriangleCount() const;
+
+private:
+  SoftwareRasterizer mRasterizer;
+};
+
+// ============================================================================
+
+class SoftwareSwapChain : public SwapChain
+{
+public:
+  SoftwareSwapChain(unsigned int bufferCount, unsigned int width, unsigned int height);
+
+  unsigned int getBufferCount() const override;
+  unsigned int getCurrentBackBufferIndex() const override;
+  void waitForNextFrame() override;
+  void present(PresentMode mode) override;
+  bool getVblankTiming(VblankTiming& timing) override;
+
+  // get the image of the back buffer with the given index.
+  SoftwareImage& getBuffer(unsigned int index);
+
+private:
+  std::vector<std::unique_ptr<SoftwareImage>> mBuffers;
+  unsigned int mBufferIndex;
+};
+
+// ============================================================================
+
+class SoftwareDevice : public Device
+{
+public:
+  // the queues rasterize on the given job system (or on the calling thread without one) with the given instruction set.
+  SoftwareDevice(JobSystem* jobSystem, SimdLevel level = getSupportedSimdLevel());
+
+  std::unique_ptr<CommandQueue> createCommandQueue(CommandListType type) override;
+  std::unique_ptr<Fence> createFence() override;
+
+private:
+  JobSystem* mJobSystem;
+  SimdLevel mLevel;
+};
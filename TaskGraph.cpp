@@ -0,0 +1,208 @@
+#include "TaskGraph.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <stdexcept>
+#include <thread>
+
+using namespace std::chrono;
+
+// ============================================================================
+
+TaskGraph::TaskGraph() : mJobSystem(nullptr), mPendingTasks(0), mFailed(false)
+{
+}
+
+// ============================================================================
+
+TaskGraph::TaskId TaskGraph::addTask(const char* name, const std::function<void()>& function, const std::vector<TaskId>& dependencies, bool mainThread)
+{
+  // only allowing the dependencies to earlier tasks keeps the graph acyclic and the tasks in a topological order.
+  auto id = static_cast<TaskId>(mTasks.size());
+  for (auto dependency : dependencies) {
+    if (dependency >= id) {
+      throw new std::runtime_error("Task can only depend on the earlier added tasks");
+    }
+    mTasks[dependency]->dependents.push_back(id);
+  }
+
+  std::unique_ptr<Task> task(new Task());
+  task->name = name;
+  task->function = function;
+  task->dependencies = dependencies;
+  task->mainThread = mainThread;
+  mTasks.push_back(std::move(task));
+  return id;
+}
+
+// ============================================================================
+
+void TaskGraph::run(JobSystem& jobSystem)
+{
+  mJobSystem = &jobSystem;
+  mPendingTasks = static_cast<unsigned int>(mTasks.size());
+  mException = nullptr;
+  mFailed = false;
+  mStart = steady_clock::now();
+
+  // start the tasks without any dependencies.
+  for (auto& task : mTasks) {
+    task->remainingDependencies = static_cast<unsigned int>(task->dependencies.size());
+  }
+  for (auto id = 0u; id < mTasks.size(); id++) {
+    if (mTasks[id]->dependencies.empty()) {
+      schedule(id);
+    }
+  }
+
+  // execute the main thread tasks and help the workers until all tasks have finished.
+  while (mPendingTasks.load() > 0) {
+    auto id = 0u;
+    auto found = false;
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (!mMainThreadTasks.empty()) {
+        id = mMainThreadTasks.front();
+        mMainThreadTasks.pop_front();
+        found = true;
+      }
+    }
+    if (found) {
+      execute(id);
+    } else if (!jobSystem.runPendingJob()) {
+      std::this_thread::yield();
+    }
+  }
+  mEnd = steady_clock::now();
+
+  if (mException) {
+    std::rethrow_exception(mException);
+  }
+}
+
+// ============================================================================
+
+std::vector<TaskGraph::TaskId> TaskGraph::getCriticalPath() const
+{
+  if (mTasks.empty()) {
+    return {};
+  }
+
+  // find the longest chain of task durations ending at each task. the tasks are already in a topological order.
+  std::vector<steady_clock::duration> finish(mTasks.size());
+  std::vector<TaskId> previous(mTasks.size());
+  for (auto id = 0u; id < mTasks.size(); id++) {
+    auto& task = *mTasks[id];
+    auto longest = steady_clock::duration::zero();
+    previous[id] = id;
+    for (auto dependency : task.dependencies) {
+      if (finish[dependency] > longest) {
+        longest = finish[dependency];
+        previous[id] = dependency;
+      }
+    }
+    finish[id] = longest + (task.end - task.start);
+  }
+
+  // walk back from the task which finishes last.
+  auto id = static_cast<TaskId>(std::max_element(finish.begin(), finish.end()) - finish.begin());
+  std::vector<TaskId> path = { id };
+  while (previous[id] != id) {
+    id = previous[id];
+    path.push_back(id);
+  }
+  std::reverse(path.begin(), path.end());
+  return path;
+}
+
+// ============================================================================
+
+microseconds TaskGraph::getCriticalPathTime() const
+{
+  auto time = steady_clock::duration::zero();
+  for (auto id : getCriticalPath()) {
+    time += mTasks[id]->end - mTasks[id]->start;
+  }
+  return duration_cast<microseconds>(time);
+}
+
+// ============================================================================
+
+microseconds TaskGraph::getSerialTime() const
+{
+  auto time = steady_clock::duration::zero();
+  for (auto& task : mTasks) {
+    time += task->end - task->start;
+  }
+  return duration_cast<microseconds>(time);
+}
+
+// ============================================================================
+
+microseconds TaskGraph::getTotalTime() const
+{
+  return duration_cast<microseconds>(mEnd - mStart);
+}
+
+// ============================================================================
+
+void TaskGraph::printReport(std::ostream& out) const
+{
+  auto criticalPath = getCriticalPath();
+  out << std::left << std::setw(24) << "task" << std::right
+    << std::setw(12) << "start (us)"
+    << std::setw(12) << "time (us)" << std::endl;
+  for (auto id = 0u; id < mTasks.size(); id++) {
+    auto& task = *mTasks[id];
+    auto critical = std::find(criticalPath.begin(), criticalPath.end(), id) != criticalPath.end();
+    out << std::left << std::setw(24) << task.name << std::right
+      << std::setw(12) << duration_cast<microseconds>(task.start - mStart).count()
+      << std::setw(12) << duration_cast<microseconds>(task.end - task.start).count()
+      << (critical ? " *" : "") << std::endl;
+  }
+  out << "total: " << getTotalTime().count() << "us"
+    << " serial: " << getSerialTime().count() << "us"
+    << " critical path (*): " << getCriticalPathTime().count() << "us" << std::endl;
+}
+
+// ============================================================================
+
+void TaskGraph::schedule(TaskId id)
+{
+  if (mTasks[id]->mainThread) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mMainThreadTasks.push_back(id);
+  } else {
+    mJobSystem->run([this, id] { execute(id); }, nullptr);
+  }
+}
+
+// ============================================================================
+
+void TaskGraph::execute(TaskId id)
+{
+  // skip the remaining tasks after a failure, but still release their dependents so that the graph finishes.
+  auto& task = *mTasks[id];
+  task.start = steady_clock::now();
+  if (!mFailed.load()) {
+    try {
+      PROFILE_SCOPE(task.name);
+      task.function();
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      if (!mFailed.exchange(true)) {
+        mException = std::current_exception();
+      }
+    }
+  }
+  task.end = steady_clock::now();
+
+  // schedule the dependents before marking this task finished, so the graph cannot finish too early.
+  for (auto dependent : task.dependents) {
+    if (mTasks[dependent]->remainingDependencies.fetch_sub(1) == 1) {
+      schedule(dependent);
+    }
+  }
+  mPendingTasks.fetch_sub(1);
+}
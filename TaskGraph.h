@@ -0,0 +1,81 @@
+#pragma once
+
+#include "JobSystem.h"
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// ============================================================================
+// A graph of dependent tasks executed on the job system.
+//
+// Each task is started as soon as all of its dependencies have finished, so
+// independent tasks run in parallel on the workers. Tasks which must run on
+// the thread that runs the graph (e.g. the window creation) are executed by
+// that thread between the jobs. The duration of each task is measured, which
+// is used to find the critical path: the chain of dependent tasks that bounds
+// the total time of the graph no matter how many workers there are.
+// ============================================================================
+class TaskGraph
+{
+public:
+  typedef unsigned int TaskId;
+
+  TaskGraph();
+
+  // add a new task which depends on the given earlier added tasks. the name must outlive the graph.
+  TaskId addTask(const char* name, const std::function<void()>& function, const std::vector<TaskId>& dependencies = {}, bool mainThread = false);
+
+  // execute all tasks and wait for them to finish. rethrows the first exception thrown by a task.
+  void run(JobSystem& jobSystem);
+
+  // get the tasks of the critical path from the first to the last task.
+  std::vector<TaskId> getCriticalPath() const;
+
+  // get the sum of the task durations along the critical path.
+  std::chrono::microseconds getCriticalPathTime() const;
+
+  // get the sum of all task durations (i.e. the time of a sequential execution).
+  std::chrono::microseconds getSerialTime() const;
+
+  // get the time it took to execute the whole graph.
+  std::chrono::microseconds getTotalTime() const;
+
+  // print the start time and duration of each task and mark the tasks on the critical path.
+  void printReport(std::ostream& out) const;
+
+private:
+  struct Task
+  {
+    const char* name;
+    std::function<void()> function;
+    std::vector<TaskId> dependencies;
+    std::vector<TaskId> dependents;
+    bool mainThread;
+    std::atomic<unsigned int> remainingDependencies;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+  };
+
+  // schedule the task either for a worker or for the thread running the graph.
+  void schedule(TaskId id);
+
+  // execute the task and schedule the dependents that became ready.
+  void execute(TaskId id);
+
+  std::vector<std::unique_ptr<Task>> mTasks;
+  JobSystem* mJobSystem;
+  std::atomic<unsigned int> mPendingTasks;
+  std::mutex mMutex;
+  std::deque<TaskId> mMainThreadTasks;
+  std::exception_ptr mException;
+  std::atomic<bool> mFailed;
+  std::chrono::steady_clock::time_point mStart;
+  std::chrono::steady_clock::time_point mEnd;
+};
@@ -0,0 +1,135 @@
+#include "UploadQueue.h"
+
+#include <stdexcept>
+
+// ============================================================================
+
+UploadQueue::UploadQueue(FenceTimeline& timeline, UploadRing& ring, CopyRecorder& recorder, uint64_t chunkSize)
+  : mTimeline(timeline),
+    mRing(ring),
+    mRecorder(recorder),
+    mChunkSize(chunkSize),
+    mCommandListFenceValues(recorder.getCommandListCount(), 0),
+    mCommandListIndex(0),
+    mRecording(false),
+    mBatchCount(0),
+    mUploadedSize(0),
+    mStallCount(0)
+{
+  if (mCommandListFenceValues.empty()) {
+    throw new std::runtime_error("Upload queue requires at least one command list");
+  }
+}
+
+// ============================================================================
+
+UploadTicket UploadQueue::upload(void* destination, uint64_t destinationOffset, const void* data, uint64_t size)
+{
+  // release the ring memory of the completed batches and record into the current batch.
+  mTimeline.poll();
+  beginBatch();
+
+  // when the ring is full, the batch is submitted and the CPU waits for the copy queue to release the memory.
+  uploadChunked(mRing, data, size, mChunkSize, [&](const UploadAllocation& allocation, uint64_t offset) {
+    mRecorder.copyBuffer(mCommandListIndex, destination, destinationOffset + offset, allocation);
+  }, [&] {
+    stall(submit().fenceValue);
+    beginBatch();
+  });
+  mUploadedSize += size;
+
+  // the batch being recorded is completed by the next signal of the fence.
+  return { mTimeline.getNextValue() };
+}
+
+// ============================================================================
+
+UploadTicket UploadQueue::submit()
+{
+  if (!mRecording) {
+    return { mTimeline.getLastValue() };
+  }
+
+  // execute the batch and tag its ring memory and its command list with the signaled fence value.
+  CommandList* commandLists[] = { &mRecorder.end(mCommandListIndex) };
+  mTimeline.getQueue().executeCommandLists(1, commandLists);
+  auto fenceValue = mTimeline.signal();
+  mRing.finishFrame(fenceValue);
+  auto& ring = mRing;
+  mTimeline.onCompleted(fenceValue, [&ring, fenceValue] { ring.reclaim(fenceValue); });
+  mCommandListFenceValues[mCommandListIndex] = fenceValue;
+  mCommandListIndex = (mCommandListIndex + 1) % mCommandListFenceValues.size();
+  mRecording = false;
+  mBatchCount++;
+  return { fenceValue };
+}
+
+// ============================================================================
+
+void UploadQueue::wait(CommandQueue& queue, const UploadTicket& ticket)
+{
+  if (ticket.fenceValue > mTimeline.getLastValue()) {
+    submit();
+  }
+  queue.wait(mTimeline.getFence(), ticket.fenceValue);
+}
+
+// ============================================================================
+
+bool UploadQueue::isComplete(const UploadTicket& ticket) const
+{
+  return mTimeline.isCompleted(ticket.fenceValue);
+}
+
+// ============================================================================
+
+void UploadQueue::flush()
+{
+  submit();
+  mTimeline.wait(mTimeline.getLastValue());
+}
+
+// ============================================================================
+
+uint64_t UploadQueue::getBatchCount() const
+{
+  return mBatchCount;
+}
+
+// ============================================================================
+
+uint64_t UploadQueue::getUploadedSize() const
+{
+  return mUploadedSize;
+}
+
+// ============================================================================
+
+uint64_t UploadQueue::getStallCount() const
+{
+  return mStallCount;
+}
+
+// ============================================================================
+
+void UploadQueue::beginBatch()
+{
+  if (mRecording) {
+    return;
+  }
+
+  // the command list can be recorded again only after the GPU has executed its previous batch.
+  stall(mCommandListFenceValues[mCommandListIndex]);
+  mRecorder.begin(mCommandListIndex);
+  mRecording = true;
+}
+
+// ============================================================================
+
+void UploadQueue::stall(uint64_t fenceValue)
+{
+  if (!mTimeline.isCompleted(fenceValue)) {
+    mStallCount++;
+  }
+  mTimeline.wait(fenceValue);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "FenceTimeline.h"
+#include "UploadRing.h"
+
+#include <cstdint>
+#include <vector>
+
+// ============================================================================
+
+// the handle of a submitted upload. the upload has been completed when the fence of the upload queue has reached
+// the value of its ticket.
+struct UploadTicket
+{
+  uint64_t fenceValue;
+};
+
+// ============================================================================
+// The recording of buffer copies into the command lists of a copy queue.
+//
+// The backends implement it with their own command lists (and allocators),
+// one for each batch of copies that may be in flight at once. The upload
+// queue only begins a command list again after the GPU has finished its
+// previous batch.
+// ============================================================================
+class CopyRecorder
+{
+public:
+  virtual ~CopyRecorder() {}
+
+  // get the amount of command lists that the batches can be recorded into.
+  virtual unsigned int getCommandListCount() const = 0;
+
+  // begin recording a batch into the command list with the given index.
+  virtual void begin(unsigned int index) = 0;
+
+  // record the copy of an upload ring allocation into the destination buffer at the given offset.
+  virtual void copyBuffer(unsigned int index, void* destination, uint64_t destinationOffset, const UploadAllocation& source) = 0;
+
+  // finish recording the batch and get the command list to submit.
+  virtual CommandList& end(unsigned int index) = 0;
+};
+
+// ============================================================================
+// An asynchronous upload service on a dedicated copy queue.
+//
+// The uploads are written into an upload ring of their own and their copies
+// are recorded into a batch, which is submitted to the copy queue with a
+// signal of its fence timeline. The ring memory of a batch is released by a
+// callback on the timeline, which runs when the timeline is polled. Each upload returns the ticket of
+// its batch, and the queue which consumes the uploaded data waits for the
+// ticket on the GPU, so the render loop never waits for the copies on the
+// CPU and the copies overlap with the rendering. The CPU only waits when
+// the ring or all command lists are still in use by the copy queue, which
+// is counted as a stall. The buffers are expected in the common state,
+// because a copy queue cannot transition them: they are promoted to the
+// copy destination implicitly and decay back when the copies are completed.
+// The upload queue is not thread-safe.
+// ============================================================================
+class UploadQueue
+{
+public:
+  UploadQueue(FenceTimeline& timeline, UploadRing& ring, CopyRecorder& recorder, uint64_t chunkSize);
+
+  // write the data into the ring and record its copy into the destination buffer. data larger than the chunk size is
+  // split into chunks, so it may be larger than the ring. returns the ticket of the batch with the last chunk.
+  UploadTicket upload(void* destination, uint64_t destinationOffset, const void* data, uint64_t size);
+
+  // submit the recorded copies to the copy queue. returns the ticket which completes all uploads so far.
+  UploadTicket submit();
+
+  // make the given queue wait on the GPU until the upload of the ticket has been completed. the batch of the ticket is
+  // submitted first if it has not been submitted yet.
+  void wait(CommandQueue& queue, const UploadTicket& ticket);
+
+  // check whether the upload of the ticket has been completed.
+  bool isComplete(const UploadTicket& ticket) const;
+
+  // submit the recorded copies and wait on the CPU until all uploads have been completed.
+  void flush();
+
+  // get the amount of submitted batches, the amount of uploaded bytes and the amount of the CPU waits for the copy queue.
+  uint64_t getBatchCount() const;
+  uint64_t getUploadedSize() const;
+  uint64_t getStallCount() const;
+
+private:
+  // begin a new batch in the next command list unless a batch is already being recorded.
+  void beginBatch();
+
+  // wait on the CPU until the fence has reached the given value.
+  void stall(uint64_t fenceValue);
+
+  FenceTimeline& mTimeline;
+  UploadRing& mRing;
+  CopyRecorder& mRecorder;
+  uint64_t mChunkSize;
+  // the fence value which completes the last batch recorded into each command list.
+  std::vector<uint64_t> mCommandListFenceValues;
+  unsigned int mCommandListIndex;
+  bool mRecording;
+  uint64_t mBatchCount;
+  uint64_t mUploadedSize;
+  uint64_t mStallCount;
+};
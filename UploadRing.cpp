@@ -0,0 +1,128 @@
+#include "UploadRing.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// ============================================================================
+
+UploadRing::UploadRing(uint64_t capacity, uint8_t* cpuBase, uint64_t gpuBase)
+  : mCapacity(capacity), mCpuBase(cpuBase), mGpuBase(gpuBase), mHead(0), mTail(0), mUsedSize(0), mFrameSize(0)
+{
+}
+
+// ============================================================================
+
+bool UploadRing::allocate(uint64_t size, uint64_t alignment, UploadAllocation& allocation)
+{
+  if (size == 0 || size > mCapacity) {
+    return false;
+  }
+
+  // start from the beginning when the whole ring is free to avoid needless wrapping.
+  if (mUsedSize == 0 && mFrames.empty()) {
+    mHead = 0;
+    mTail = 0;
+  }
+
+  // find an aligned position either after the head or from the beginning of the ring.
+  auto start = alignUp(mHead, alignment);
+  auto consumed = 0ull;
+  if (mHead >= mTail) {
+    if (start + size <= mCapacity) {
+      consumed = start + size - mHead;
+    } else if (size <= mTail) {
+      // skip the remaining space at the end of the ring and wrap around.
+      consumed = (mCapacity - mHead) + size;
+      start = 0;
+    } else {
+      return false;
+    }
+  } else if (start + size <= mTail) {
+    consumed = start + size - mHead;
+  } else {
+    return false;
+  }
+
+  // make sure that we don't overwrite the memory which is still in use.
+  if (consumed > mCapacity - mUsedSize) {
+    return false;
+  }
+
+  mHead = start + size;
+  mUsedSize += consumed;
+  mFrameSize += consumed;
+
+  allocation.cpuAddress = mCpuBase != nullptr ? mCpuBase + start : nullptr;
+  allocation.gpuAddress = mGpuBase + start;
+  allocation.offset = start;
+  allocation.size = size;
+  return true;
+}
+
+// ============================================================================
+
+void UploadRing::reserveFrames(unsigned int frameCount)
+{
+  mFrames.reserve(frameCount);
+}
+
+// ============================================================================
+
+void UploadRing::finishFrame(uint64_t fenceValue)
+{
+  // frames without any allocations do not hold any memory.
+  if (mFrameSize > 0) {
+    mFrames.push_back({ fenceValue, mHead, mFrameSize });
+    mFrameSize = 0;
+  }
+}
+
+// ============================================================================
+
+void UploadRing::reclaim(uint64_t completedFenceValue)
+{
+  auto frame = mFrames.begin();
+  while (frame != mFrames.end() && frame->fenceValue <= completedFenceValue) {
+    mTail = frame->head;
+    mUsedSize -= frame->size;
+    frame++;
+  }
+  mFrames.erase(mFrames.begin(), frame);
+}
+
+// ============================================================================
+
+uint64_t UploadRing::getCapacity() const
+{
+  return mCapacity;
+}
+
+// ============================================================================
+
+uint64_t UploadRing::getUsedSize() const
+{
+  return mUsedSize;
+}
+
+// ============================================================================
+
+void uploadChunked(UploadRing& ring, const void* data, uint64_t size, uint64_t chunkSize, const UploadChunkFunc& copyChunk, const UploadFlushFunc& flush)
+{
+  static const auto CHUNK_ALIGNMENT = 16ull;
+  auto source = static_cast<const uint8_t*>(data);
+  for (uint64_t offset = 0; offset < size;) {
+    auto chunk = std::min(chunkSize, size - offset);
+    UploadAllocation allocation;
+    if (!ring.allocate(chunk, CHUNK_ALIGNMENT, allocation)) {
+      // wait for the previous chunks to release the ring memory.
+      flush();
+      if (!ring.allocate(chunk, CHUNK_ALIGNMENT, allocation)) {
+        throw new std::runtime_error("Upload chunk does not fit into the upload ring");
+      }
+    }
+    memcpy(allocation.cpuAddress, source + offset, static_cast<size_t>(chunk));
+    copyChunk(allocation, offset);
+    offset += chunk;
+  }
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// ============================================================================
+
+// a sub-allocation from the upload ring.
+struct UploadAllocation
+{
+  // the CPU address where the data should be written.
+  uint8_t* cpuAddress;
+  // the GPU virtual address of the allocation.
+  uint64_t gpuAddress;
+  // the offset of the allocation from the beginning of the ring.
+  uint64_t offset;
+  // the size of the allocation in bytes.
+  uint64_t size;
+};
+
+// ============================================================================
+// A ring allocator over a persistently mapped upload buffer.
+//
+// Allocations are aligned pointer bumps from the head of the ring. At the end
+// of each frame the allocations made during the frame are tagged with the
+// fence value signaled after the frame, and the memory is reclaimed from the
+// tail of the ring once the GPU has reached that fence value. The ring does
+// not touch the GPU itself, so the bookkeeping can be driven with any fence.
+// The frames in flight are kept in a vector which keeps its capacity and can
+// be reserved for the frames in flight up front, so the bookkeeping of a
+// frame does not allocate even when the GPU falls behind.
+// ============================================================================
+class UploadRing
+{
+public:
+  UploadRing(uint64_t capacity, uint8_t* cpuBase = nullptr, uint64_t gpuBase = 0);
+
+  // try to allocate the given amount of aligned memory. returns false if there's no room.
+  bool allocate(uint64_t size, uint64_t alignment, UploadAllocation& allocation);
+
+  // reserve the bookkeeping of the given amount of frames which have not been reclaimed yet, so finishing them does
+  // not allocate.
+  void reserveFrames(unsigned int frameCount);
+
+  // tag the allocations made since the previous call with the given fence value.
+  void finishFrame(uint64_t fenceValue);
+
+  // release the memory of the frames whose fence values have been completed.
+  void reclaim(uint64_t completedFenceValue);
+
+  // get the total size of the ring in bytes.
+  uint64_t getCapacity() const;
+
+  // get the amount of bytes currently in use (including alignment padding).
+  uint64_t getUsedSize() const;
+
+private:
+  // the end of the ring memory used by a frame and the fence value which releases it.
+  struct Frame
+  {
+    uint64_t fenceValue;
+    uint64_t head;
+    uint64_t size;
+  };
+
+  uint64_t mCapacity;
+  uint8_t* mCpuBase;
+  uint64_t mGpuBase;
+  uint64_t mHead;
+  uint64_t mTail;
+  uint64_t mUsedSize;
+  uint64_t mFrameSize;
+  std::vector<Frame> mFrames;
+};
+
+// ============================================================================
+
+// align the given value up to the next multiple of the alignment (a power of two).
+inline uint64_t alignUp(uint64_t value, uint64_t alignment)
+{
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// ============================================================================
+
+// the callback that copies an uploaded chunk from the ring into its destination at the given offset.
+typedef std::function<void(const UploadAllocation& allocation, uint64_t offset)> UploadChunkFunc;
+
+// the callback that submits the copies and waits for them so that the ring memory can be reclaimed.
+typedef std::function<void()> UploadFlushFunc;
+
+// copy the data into the ring chunk by chunk and flush whenever the ring is full. the data is copied
+// straight from the source (e.g. a mapped file) into the ring, so large uploads need no extra copy.
+void uploadChunked(UploadRing& ring, const void* data, uint64_t size, uint64_t chunkSize, const UploadChunkFunc& copyChunk, const UploadFlushFunc& flush);
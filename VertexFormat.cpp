@@ -0,0 +1,350 @@
+#include "VertexFormat.h"
+#include "CpuFeatures.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+// ============================================================================
+
+static const auto SNORM16_SCALE = 32767.f;
+static const auto UNORM8_SCALE = 255.f;
+
+// ============================================================================
+
+static uint32_t getPositionSize(PositionFormat format)
+{
+  return format == PositionFormat::FLOAT3 ? 12 : 8;
+}
+
+// ============================================================================
+
+static uint32_t getColorSize(ColorFormat format)
+{
+  return format == ColorFormat::FLOAT4 ? 16 : 4;
+}
+
+// ============================================================================
+
+uint32_t getVertexStride(const VertexLayout& layout)
+{
+  return getPositionSize(layout.position) + getColorSize(layout.color);
+}
+
+// ============================================================================
+
+std::vector<VertexElement> getVertexElements(const VertexLayout& layout)
+{
+  static const uint32_t POSITION_FORMATS[] = { VERTEX_FORMAT_R32G32B32_FLOAT, VERTEX_FORMAT_R16G16B16A16_FLOAT, VERTEX_FORMAT_R16G16B16A16_SNORM };
+  static const uint32_t COLOR_FORMATS[] = { VERTEX_FORMAT_R32G32B32A32_FLOAT, VERTEX_FORMAT_R8G8B8A8_UNORM };
+  return {
+    { "POSITION", POSITION_FORMATS[static_cast<uint32_t>(layout.position)], 0 },
+    { "COLOR", COLOR_FORMATS[static_cast<uint32_t>(layout.color)], getPositionSize(layout.position) }
+  };
+}
+
+// ============================================================================
+
+bool parseVertexLayout(const std::string& name, VertexLayout& layout)
+{
+  if (name == "float") {
+    layout = { PositionFormat::FLOAT3, ColorFormat::FLOAT4 };
+  } else if (name == "half") {
+    layout = { PositionFormat::HALF4, ColorFormat::UNORM8 };
+  } else if (name == "quantized") {
+    layout = { PositionFormat::SNORM16, ColorFormat::UNORM8 };
+  } else {
+    return false;
+  }
+  return true;
+}
+
+// ============================================================================
+
+uint16_t floatToHalf(float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  auto sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+  auto exponent = static_cast<int32_t>((bits >> 23) & 0xff) - 127 + 15;
+  auto mantissa = bits & 0x7fffff;
+
+  // keep the infinities and the NaNs (as quiet NaNs).
+  if (exponent == 0xff - 127 + 15) {
+    return sign | 0x7c00 | (mantissa != 0 ? 0x200 : 0);
+  }
+  if (exponent >= 31) {
+    return sign | 0x7c00;
+  }
+
+  // shift the values below the normal range into the subnormals.
+  auto shift = 13u;
+  auto half = 0u;
+  if (exponent <= 0) {
+    if (exponent < -10) {
+      return sign;
+    }
+    mantissa |= 0x800000;
+    shift = static_cast<uint32_t>(14 - exponent);
+  } else {
+    half = static_cast<uint32_t>(exponent) << 10;
+  }
+  half |= mantissa >> shift;
+
+  // round to the nearest even. a carry into the exponent is the correct result.
+  auto remainder = mantissa & ((1u << shift) - 1);
+  auto halfway = 1u << (shift - 1);
+  if (remainder > halfway || (remainder == halfway && (half & 1) != 0)) {
+    half++;
+  }
+  return static_cast<uint16_t>(sign | half);
+}
+
+// ============================================================================
+
+float halfToFloat(uint16_t value)
+{
+  auto sign = static_cast<uint32_t>(value & 0x8000) << 16;
+  auto exponent = (value >> 10) & 0x1f;
+  auto mantissa = static_cast<uint32_t>(value & 0x3ff);
+  uint32_t bits;
+  if (exponent == 0) {
+    // the subnormals are exactly representable as normal floats.
+    auto result = std::ldexp(static_cast<float>(mantissa), -24);
+    return sign != 0 ? -result : result;
+  } else if (exponent == 31) {
+    bits = sign | 0x7f800000 | (mantissa << 13);
+  } else {
+    bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+  }
+  float result;
+  memcpy(&result, &bits, sizeof(result));
+  return result;
+}
+
+// ============================================================================
+
+// clamp the value into the range. NaNs become the lower bound like with the SSE max and min.
+static float clampFloat(float value, float low, float high)
+{
+  value = value > low ? value : low;
+  return value < high ? value : high;
+}
+
+// ============================================================================
+
+static int16_t floatToSnorm16(float value)
+{
+  return static_cast<int16_t>(std::lrint(clampFloat(value, -1.f, 1.f) * SNORM16_SCALE));
+}
+
+// ============================================================================
+
+static uint8_t floatToUnorm8(float value)
+{
+  return static_cast<uint8_t>(std::lrint(clampFloat(value, 0.f, 1.f) * UNORM8_SCALE));
+}
+
+// ============================================================================
+
+static void encodeVertexScalar(const Vertex& vertex, const VertexLayout& layout, uint8_t* output)
+{
+  switch (layout.position) {
+  case PositionFormat::FLOAT3:
+    memcpy(output, vertex.position.data(), 12);
+    break;
+  case PositionFormat::HALF4: {
+    uint16_t position[] = { floatToHalf(vertex.position[0]), floatToHalf(vertex.position[1]), floatToHalf(vertex.position[2]), floatToHalf(1.f) };
+    memcpy(output, position, sizeof(position));
+    break;
+  }
+  case PositionFormat::SNORM16: {
+    int16_t position[] = { floatToSnorm16(vertex.position[0]), floatToSnorm16(vertex.position[1]), floatToSnorm16(vertex.position[2]), floatToSnorm16(1.f) };
+    memcpy(output, position, sizeof(position));
+    break;
+  }
+  }
+
+  output += getPositionSize(layout.position);
+  if (layout.color == ColorFormat::FLOAT4) {
+    memcpy(output, vertex.color.data(), 16);
+  } else {
+    uint8_t color[] = { floatToUnorm8(vertex.color[0]), floatToUnorm8(vertex.color[1]), floatToUnorm8(vertex.color[2]), floatToUnorm8(vertex.color[3]) };
+    memcpy(output, color, sizeof(color));
+  }
+}
+
+#if defined(SIMD_X86)
+
+// ============================================================================
+
+// encode one vertex per iteration with 128-bit vectors.
+template <PositionFormat POSITION, ColorFormat COLOR>
+TARGET_SSE41 static void encodeVerticesSse41(const Vertex* vertices, size_t count, uint8_t* output)
+{
+  auto stride = getPositionSize(POSITION) + getColorSize(COLOR);
+  auto zero = _mm_setzero_ps();
+  auto one = _mm_set1_ps(1.f);
+  auto minusOne = _mm_set1_ps(-1.f);
+  auto snormScale = _mm_set1_ps(SNORM16_SCALE);
+  auto unormScale = _mm_set1_ps(UNORM8_SCALE);
+  for (size_t i = 0; i < count; i++, output += stride) {
+    // the position is loaded together with the first color component, which is replaced with the w of one.
+    auto& vertex = vertices[i];
+    auto position = _mm_blend_ps(_mm_loadu_ps(vertex.position.data()), one, 0x8);
+    if (POSITION == PositionFormat::FLOAT3) {
+      memcpy(output, vertex.position.data(), 12);
+    } else if (POSITION == PositionFormat::HALF4) {
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(output), _mm_cvtps_ph(position, _MM_FROUND_TO_NEAREST_INT));
+    } else {
+      auto snorm = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(position, minusOne), one), snormScale));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(output), _mm_packs_epi32(snorm, snorm));
+    }
+
+    auto colorOutput = output + getPositionSize(POSITION);
+    auto color = _mm_loadu_ps(vertex.color.data());
+    if (COLOR == ColorFormat::FLOAT4) {
+      _mm_storeu_ps(reinterpret_cast<float*>(colorOutput), color);
+    } else {
+      auto unorm = _mm_cvtps_epi32(_mm_mul_ps(_mm_min_ps(_mm_max_ps(color, zero), one), unormScale));
+      unorm = _mm_packus_epi32(unorm, unorm);
+      auto packed = _mm_cvtsi128_si32(_mm_packus_epi16(unorm, unorm));
+      memcpy(colorOutput, &packed, sizeof(packed));
+    }
+  }
+}
+
+// ============================================================================
+
+// encode two vertices per iteration with 256-bit vectors, where each 128-bit lane holds one vertex.
+template <PositionFormat POSITION, ColorFormat COLOR>
+TARGET_AVX2 static void encodeVerticesAvx2(const Vertex* vertices, size_t count, uint8_t* output)
+{
+  auto stride = getPositionSize(POSITION) + getColorSize(COLOR);
+  auto zero = _mm256_setzero_ps();
+  auto one = _mm256_set1_ps(1.f);
+  auto minusOne = _mm256_set1_ps(-1.f);
+  auto snormScale = _mm256_set1_ps(SNORM16_SCALE);
+  auto unormScale = _mm256_set1_ps(UNORM8_SCALE);
+  size_t i = 0;
+  for (; i + 2 <= count; i += 2, output += 2 * stride) {
+    auto& first = vertices[i];
+    auto& second = vertices[i + 1];
+    auto position = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(first.position.data())), _mm_loadu_ps(second.position.data()), 1);
+    position = _mm256_blend_ps(position, one, 0x88);
+    if (POSITION == PositionFormat::FLOAT3) {
+      memcpy(output, first.position.data(), 12);
+      memcpy(output + stride, second.position.data(), 12);
+    } else if (POSITION == PositionFormat::HALF4) {
+      auto half = _mm256_cvtps_ph(position, _MM_FROUND_TO_NEAREST_INT);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(output), half);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(output + stride), _mm_unpackhi_epi64(half, half));
+    } else {
+      auto snorm = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(position, minusOne), one), snormScale));
+      snorm = _mm256_packs_epi32(snorm, snorm);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(output), _mm256_castsi256_si128(snorm));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(output + stride), _mm256_extracti128_si256(snorm, 1));
+    }
+
+    auto colorOutput = output + getPositionSize(POSITION);
+    auto color = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(first.color.data())), _mm_loadu_ps(second.color.data()), 1);
+    if (COLOR == ColorFormat::FLOAT4) {
+      _mm_storeu_ps(reinterpret_cast<float*>(colorOutput), _mm256_castps256_ps128(color));
+      _mm_storeu_ps(reinterpret_cast<float*>(colorOutput + stride), _mm256_extractf128_ps(color, 1));
+    } else {
+      auto unorm = _mm256_cvtps_epi32(_mm256_mul_ps(_mm256_min_ps(_mm256_max_ps(color, zero), one), unormScale));
+      unorm = _mm256_packus_epi32(unorm, unorm);
+      unorm = _mm256_packus_epi16(unorm, unorm);
+      auto firstPacked = _mm_cvtsi128_si32(_mm256_castsi256_si128(unorm));
+      auto secondPacked = _mm_cvtsi128_si32(_mm256_extracti128_si256(unorm, 1));
+      memcpy(colorOutput, &firstPacked, sizeof(firstPacked));
+      memcpy(colorOutput + stride, &secondPacked, sizeof(secondPacked));
+    }
+  }
+  if (i < count) {
+    encodeVertexScalar(vertices[i], { POSITION, COLOR }, output);
+  }
+}
+
+#endif
+
+// ============================================================================
+
+void encodeVertices(const Vertex* vertices, size_t count, const VertexLayout& layout, void* output, SimdLevel level)
+{
+  auto bytes = static_cast<uint8_t*>(output);
+  #if defined(SIMD_X86)
+  if (level != SimdLevel::SCALAR && level > getSupportedSimdLevel()) {
+    throw new std::runtime_error("The instruction set is not supported by the CPU");
+  }
+  typedef void (*KernelFunc)(const Vertex*, size_t, uint8_t*);
+  static const KernelFunc SSE41_KERNELS[3][2] = {
+    { encodeVerticesSse41<PositionFormat::FLOAT3, ColorFormat::FLOAT4>, encodeVerticesSse41<PositionFormat::FLOAT3, ColorFormat::UNORM8> },
+    { encodeVerticesSse41<PositionFormat::HALF4, ColorFormat::FLOAT4>, encodeVerticesSse41<PositionFormat::HALF4, ColorFormat::UNORM8> },
+    { encodeVerticesSse41<PositionFormat::SNORM16, ColorFormat::FLOAT4>, encodeVerticesSse41<PositionFormat::SNORM16, ColorFormat::UNORM8> }
+  };
+  static const KernelFunc AVX2_KERNELS[3][2] = {
+    { encodeVerticesAvx2<PositionFormat::FLOAT3, ColorFormat::FLOAT4>, encodeVerticesAvx2<PositionFormat::FLOAT3, ColorFormat::UNORM8> },
+    { encodeVerticesAvx2<PositionFormat::HALF4, ColorFormat::FLOAT4>, encodeVerticesAvx2<PositionFormat::HALF4, ColorFormat::UNORM8> },
+    { encodeVerticesAvx2<PositionFormat::SNORM16, ColorFormat::FLOAT4>, encodeVerticesAvx2<PositionFormat::SNORM16, ColorFormat::UNORM8> }
+  };
+  auto position = static_cast<uint32_t>(layout.position);
+  auto color = static_cast<uint32_t>(layout.color);
+  if (level == SimdLevel::AVX2) {
+    AVX2_KERNELS[position][color](vertices, count, bytes);
+    return;
+  } else if (level == SimdLevel::SSE41) {
+    SSE41_KERNELS[position][color](vertices, count, bytes);
+    return;
+  }
+  #else
+  if (level != SimdLevel::SCALAR) {
+    throw new std::runtime_error("The instruction set is not supported by the CPU");
+  }
+  #endif
+
+  auto stride = getVertexStride(layout);
+  for (size_t i = 0; i < count; i++) {
+    encodeVertexScalar(vertices[i], layout, bytes + i * stride);
+  }
+}
+
+// ============================================================================
+
+void decodeVertices(const void* input, size_t count, const VertexLayout& layout, Vertex* vertices)
+{
+  auto bytes = static_cast<const uint8_t*>(input);
+  auto stride = getVertexStride(layout);
+  for (size_t i = 0; i < count; i++, bytes += stride) {
+    auto& vertex = vertices[i];
+    switch (layout.position) {
+    case PositionFormat::FLOAT3:
+      memcpy(vertex.position.data(), bytes, 12);
+      break;
+    case PositionFormat::HALF4: {
+      uint16_t position[4];
+      memcpy(position, bytes, sizeof(position));
+      vertex.position = { halfToFloat(position[0]), halfToFloat(position[1]), halfToFloat(position[2]) };
+      break;
+    }
+    case PositionFormat::SNORM16: {
+      int16_t position[4];
+      memcpy(position, bytes, sizeof(position));
+      for (auto j = 0; j < 3; j++) {
+        vertex.position[j] = std::max(position[j] / SNORM16_SCALE, -1.f);
+      }
+      break;
+    }
+    }
+
+    auto colorInput = bytes + getPositionSize(layout.position);
+    if (layout.color == ColorFormat::FLOAT4) {
+      memcpy(vertex.color.data(), colorInput, 16);
+    } else {
+      for (auto j = 0; j < 4; j++) {
+        vertex.color[j] = colorInput[j] / UNORM8_SCALE;
+      }
+    }
+  }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "CpuFeatures.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// ============================================================================
+
+// the uncompressed vertex format of the sandbox meshes.
+struct Vertex
+{
+  std::array<float, 3> position;
+  std::array<float, 4> color;
+};
+
+// the formats of the vertex positions. the quantized positions cover the range [-1, 1].
+enum class PositionFormat : uint32_t { FLOAT3, HALF4, SNORM16 };
+
+// the formats of the vertex colors.
+enum class ColorFormat : uint32_t { FLOAT4, UNORM8 };
+
+// the layout of the packed vertices, where the position is followed by the color.
+struct VertexLayout
+{
+  PositionFormat position;
+  ColorFormat color;
+};
+
+// the attribute formats. the values match the DXGI_FORMAT.
+static const uint32_t VERTEX_FORMAT_R32G32B32A32_FLOAT = 2;
+static const uint32_t VERTEX_FORMAT_R32G32B32_FLOAT = 6;
+static const uint32_t VERTEX_FORMAT_R16G16B16A16_FLOAT = 10;
+static const uint32_t VERTEX_FORMAT_R16G16B16A16_SNORM = 13;
+static const uint32_t VERTEX_FORMAT_R8G8B8A8_UNORM = 28;
+
+// a single attribute of the packed vertex.
+struct VertexElement
+{
+  const char* semantic;
+  uint32_t format;
+  uint32_t offset;
+};
+
+// ============================================================================
+
+// get the size of a packed vertex in bytes.
+uint32_t getVertexStride(const VertexLayout& layout);
+
+// get the attributes of the packed vertex, which describe the input layout of the pipeline.
+std::vector<VertexElement> getVertexElements(const VertexLayout& layout);
+
+// parse the name ("float", "half" or "quantized") of a vertex layout. returns false for unknown names.
+bool parseVertexLayout(const std::string& name, VertexLayout& layout);
+
+// pack the float vertices into the given layout with the given instruction set (which must be supported).
+void encodeVertices(const Vertex* vertices, size_t count, const VertexLayout& layout, void* output, SimdLevel level = getSupportedSimdLevel());
+
+// unpack the vertices of the given layout back into float vertices.
+void decodeVertices(const void* input, size_t count, const VertexLayout& layout, Vertex* vertices);
+
+// convert between 32-bit and 16-bit floats. the conversion rounds to the nearest even value like the hardware.
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);